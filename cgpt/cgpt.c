@@ -38,6 +38,7 @@ struct {
   {"prioritize", cmd_prioritize,
    "Reorder the priority of all kernel partitions"},
   {"legacy", cmd_legacy, "Switch between GPT and Legacy GPT"},
+  {"zero", cmd_zero, "Zero or discard the contents of a partition"},
 };
 
 static void Usage(void) {
@@ -48,6 +48,7 @@ struct drive {
   GptData gpt;
   struct pmbr pmbr;
   int fd;       /* file descriptor */
+  struct drive_index *index;  /* built on first DriveIndexFind() */
 };
 
 // Opens a block device or file, loads raw GPT data from it.
@@ -135,6 +136,39 @@ void EntryDetails(GptEntry *entry, uint32_t index, int raw);
 uint32_t GetNumberOfEntries(const struct drive *drive);
 GptEntry *GetEntry(GptData *gpt, int secondary, uint32_t entry_index);
 
+/* Keys of the partition index. */
+enum drive_index_key {
+  DRIVE_INDEX_UNIQUE,   /* unique GUID, value is a Guid */
+  DRIVE_INDEX_TYPE,     /* type GUID, value is a Guid */
+  DRIVE_INDEX_LABEL,    /* label, value is a UTF-16 name (see below) */
+  DRIVE_INDEX_COUNT
+};
+
+/* Size in UTF-16 units of a label converted by DriveIndexLabel(); room for a
+ * full entry name, one more unit to catch longer labels, and the terminator. */
+#define DRIVE_INDEX_NAME_UNITS 38
+
+/* Finds partitions by key without scanning the entry table. The index is
+ * built from the valid entries (ANY_VALID) on first use, so the GPT must have
+ * been checked with GptValidityCheck() already.
+ *
+ * Pass prev = -1 to get the first matching entry, then the previous result to
+ * get the next one; matches come back in ascending order.
+ *
+ * Returns the entry index (partition number - 1), or -1 if there are no more
+ * matches. Callers that change GUIDs or labels must DriveIndexReset() before
+ * looking up again; DriveClose() frees the index. */
+int DriveIndexFind(struct drive *drive, enum drive_index_key key,
+                   const void *value, int prev);
+void DriveIndexReset(struct drive *drive);
+
+/* Converts a UTF-8 label to the value to look up with DRIVE_INDEX_LABEL.
+ *
+ * Return: CGPT_OK --- converted successfully.
+ *         CGPT_FAILED --- invalid UTF-8, or too long to be any entry's label.
+ */
+int DriveIndexLabel(const char *label, uint16_t *name);
+
 void SetRequired(struct drive *drive, int secondary, uint32_t entry_index,
                  int required);
 int GetRequired(struct drive *drive, int secondary, uint32_t entry_index);
@@ -190,6 +224,7 @@ int cmd_find(int argc, char *argv[]);
 int cmd_edit(int argc, char *argv[]);
 int cmd_prioritize(int argc, char *argv[]);
 int cmd_legacy(int argc, char *argv[]);
+int cmd_zero(int argc, char *argv[]);
 
 #define ARRAY_COUNT(array) (sizeof(array)/sizeof((array)[0]))
 const char *GptError(int errnum);
@@ -215,17 +215,13 @@ int CgptGetPartitionDetails(CgptAddParams *params) {
       Error("either partition or unique_id must be specified\n");
       goto bad;
     }
-    for (index = 0; index < max_part; index++) {
-      GptEntry *entry = GetEntry(&drive.gpt, PRIMARY, index);
-      if (GuidEqual(&entry->unique, &params->unique_guid)) {
-        params->partition = index + 1;
-        break;
-      }
-    }
-    if (index >= max_part) {
+    index = DriveIndexFind(&drive, DRIVE_INDEX_UNIQUE, &params->unique_guid,
+                           -1);
+    if (index < 0) {
       Error("no partitions with the given unique id available\n");
       goto bad;
     }
+    params->partition = index + 1;
   }
   index = params->partition - 1;
 
@@ -41,16 +41,11 @@ int CgptGetBootPartitionNumber(CgptBootParams *params) {
   char buf[GUID_STRLEN];
   GuidToStr(&drive.pmbr.boot_guid, buf, sizeof(buf));
 
-  int numEntries = GetNumberOfEntries(&drive);
-  int i;
-  for(i = 0; i < numEntries; i++) {
-      GptEntry *entry = GetEntry(&drive.gpt, ANY_VALID, i);
-
-      if (GuidEqual(&entry->unique, &drive.pmbr.boot_guid)) {
-        params->partition = i + 1;
-        retval = CGPT_OK;
-        goto done;
-      }
+  int i = DriveIndexFind(&drive, DRIVE_INDEX_UNIQUE, &drive.pmbr.boot_guid, -1);
+  if (i >= 0) {
+    params->partition = i + 1;
+    retval = CGPT_OK;
+    goto done;
   }
 
   Error("Didn't find any boot partition\n");
@@ -373,6 +373,7 @@ int DriveClose(struct drive *drive, int update_as_needed) {
     }
   }
 
+  DriveIndexReset(drive);
   free(drive->gpt.primary_header);
   drive->gpt.primary_header = NULL;
   free(drive->gpt.primary_entries);
@@ -9,16 +9,17 @@
 #include "cgptlib_internal.h"
 #include "vboot_host.h"
 
-static void AllocAndClear(uint8_t **buf, uint64_t size) {
+static int AllocAndClear(uint8_t **buf, uint64_t size) {
   if (*buf) {
     memset(*buf, 0, size);
   } else {
     *buf = calloc(1, size);
     if (!*buf) {
       Error("Cannot allocate %" PRIu64 " bytes.\n", size);
-      abort();
+      return -1;
     }
   }
+  return 0;
 }
 
 static int GptCreate(struct drive *drive, CgptCreateParams *params) {
@@ -38,10 +39,11 @@ static int GptCreate(struct drive *drive, CgptCreateParams *params) {
   // Allocate and/or erase the data.
   // We cannot assume the GPT headers or entry arrays have been allocated
   // by GptLoad() because those fields might have failed validation checks.
-  AllocAndClear(&drive->gpt.primary_header,
-                drive->gpt.sector_bytes * GPT_HEADER_SECTORS);
-  AllocAndClear(&drive->gpt.secondary_header,
-                drive->gpt.sector_bytes * GPT_HEADER_SECTORS);
+  if (AllocAndClear(&drive->gpt.primary_header,
+                    drive->gpt.sector_bytes * GPT_HEADER_SECTORS) ||
+      AllocAndClear(&drive->gpt.secondary_header,
+                    drive->gpt.sector_bytes * GPT_HEADER_SECTORS))
+    return -1;
 
   drive->gpt.modified |= (GPT_MODIFIED_HEADER1 | GPT_MODIFIED_ENTRIES1 |
                          GPT_MODIFIED_HEADER2 | GPT_MODIFIED_ENTRIES2);
@@ -105,8 +107,9 @@ static int GptCreate(struct drive *drive, CgptCreateParams *params) {
     }
 
     size_t entries_size = h->number_of_entries * h->size_of_entry;
-    AllocAndClear(&drive->gpt.primary_entries, entries_size);
-    AllocAndClear(&drive->gpt.secondary_entries, entries_size);
+    if (AllocAndClear(&drive->gpt.primary_entries, entries_size) ||
+        AllocAndClear(&drive->gpt.secondary_entries, entries_size))
+      return -1;
 
     // Copy to secondary
     RepairHeader(&drive->gpt, MASK_PRIMARY);
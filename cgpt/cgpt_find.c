@@ -102,36 +102,48 @@ static void showmatch(CgptFindParams *params, const char *filename,
 // could have multiple hits.
 static int gpt_search(CgptFindParams *params, struct drive *drive,
                       const char *filename) {
-  int i;
+  int i, k;
   GptEntry *entry;
   int retval = 0;
-  char partlabel[GPT_PARTNAME_LEN];
+  uint16_t label[DRIVE_INDEX_NAME_UNITS];
+  const void *key[DRIVE_INDEX_COUNT] = { NULL };
+  int next[DRIVE_INDEX_COUNT];
 
   if (GPT_SUCCESS != GptValidityCheck(&drive->gpt)) {
     return 0;
   }
 
-  for (i = 0; i < GetNumberOfEntries(drive); ++i) {
+  if (params->set_unique)
+    key[DRIVE_INDEX_UNIQUE] = &params->unique_guid;
+  if (params->set_type)
+    key[DRIVE_INDEX_TYPE] = &params->type_guid;
+  // Convert the label once; if it can't be an entry's label, nothing matches.
+  if (params->set_label && CGPT_OK == DriveIndexLabel(params->label, label))
+    key[DRIVE_INDEX_LABEL] = label;
+
+  for (k = 0; k < DRIVE_INDEX_COUNT; k++)
+    next[k] = key[k] ? DriveIndexFind(drive, k, key[k], -1) : -1;
+
+  // Merge the matches for each key, in partition order.
+  while (1) {
+    i = -1;
+    for (k = 0; k < DRIVE_INDEX_COUNT; k++) {
+      if (next[k] >= 0 && (i < 0 || next[k] < i))
+        i = next[k];
+    }
+    if (i < 0)
+      break;
+    for (k = 0; k < DRIVE_INDEX_COUNT; k++) {
+      if (next[k] == i)
+        next[k] = DriveIndexFind(drive, k, key[k], i);
+    }
+
     entry = GetEntry(&drive->gpt, ANY_VALID, i);
 
     if (GuidIsZero(&entry->type))
       continue;
 
-    int found = 0;
-    if ((params->set_unique && GuidEqual(&params->unique_guid, &entry->unique))
-        || (params->set_type && GuidEqual(&params->type_guid, &entry->type))) {
-      found = 1;
-    } else if (params->set_label) {
-      if (CGPT_OK != UTF16ToUTF8(entry->name,
-                                 sizeof(entry->name) / sizeof(entry->name[0]),
-                                 (uint8_t *)partlabel, sizeof(partlabel))) {
-        Error("The label cannot be converted from UTF16, so abort.\n");
-        return 0;
-      }
-      if (!strncmp(params->label, partlabel, sizeof(partlabel)))
-        found = 1;
-    }
-    if (found && match_content(params, drive, entry)) {
+    if (match_content(params, drive, entry)) {
       params->hits++;
       retval++;
       showmatch(params, filename, i+1, entry);
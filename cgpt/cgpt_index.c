@@ -0,0 +1,168 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Lookup index over the partition entries of a drive, so that partitions can
+ * be found by unique GUID, type GUID or label without scanning and converting
+ * every entry for each query.
+ */
+
+#include <string.h>
+
+#include "cgpt.h"
+#include "cgptlib_internal.h"
+#include "vboot_host.h"
+
+#define NAME_UNITS ARRAY_COUNT(((GptEntry *)0)->name)
+
+// One hash table per key. Each bucket is a chain of entry indices in
+// ascending order, so entries sharing a key (e.g. all kernels for the type
+// table) are returned in partition order.
+struct index_table {
+  int *head;    // bucket -> first entry index, -1 if empty
+  int *next;    // entry index -> next entry index in the same bucket, or -1
+};
+
+struct drive_index {
+  uint32_t num_entries;
+  uint32_t mask;              // number of buckets - 1
+  struct index_table table[DRIVE_INDEX_COUNT];
+};
+
+// FNV-1a
+static uint32_t HashBytes(const void *data, size_t size) {
+  const uint8_t *p = data;
+  uint32_t hash = 2166136261u;
+
+  while (size--) {
+    hash ^= *p++;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// Number of UTF-16 units in a possibly unterminated partition name.
+static size_t NameLength(const uint16_t *name) {
+  size_t len = 0;
+
+  while (len < NAME_UNITS && name[len])
+    len++;
+  return len;
+}
+
+static int NameEqual(const uint16_t *a, const uint16_t *b) {
+  size_t len = NameLength(a);
+
+  return len == NameLength(b) && !memcmp(a, b, len * sizeof(uint16_t));
+}
+
+static uint32_t HashKey(enum drive_index_key key, const void *value) {
+  if (key == DRIVE_INDEX_LABEL)
+    return HashBytes(value, NameLength(value) * sizeof(uint16_t));
+  return HashBytes(value, sizeof(Guid));
+}
+
+static const void *EntryKey(const GptEntry *entry, enum drive_index_key key) {
+  switch (key) {
+    case DRIVE_INDEX_UNIQUE:
+      return &entry->unique;
+    case DRIVE_INDEX_TYPE:
+      return &entry->type;
+    default:
+      return entry->name;
+  }
+}
+
+static int KeyEqual(enum drive_index_key key, const GptEntry *entry,
+                    const void *value) {
+  if (key == DRIVE_INDEX_LABEL)
+    return NameEqual(entry->name, value);
+  return GuidEqual(EntryKey(entry, key), value);
+}
+
+static struct drive_index *BuildIndex(struct drive *drive) {
+  struct drive_index *index;
+  uint32_t num_entries = GetNumberOfEntries(drive);
+  uint32_t num_buckets = 1;
+  int *ints;
+  int i, k;
+
+  // Keep the load factor at or below one half.
+  while (num_buckets < 2 * num_entries)
+    num_buckets <<= 1;
+
+  index = malloc(sizeof(*index) + DRIVE_INDEX_COUNT *
+                 (num_buckets + num_entries) * sizeof(int));
+  if (!index)
+    return NULL;
+  index->num_entries = num_entries;
+  index->mask = num_buckets - 1;
+
+  ints = (int *)(index + 1);
+  for (k = 0; k < DRIVE_INDEX_COUNT; k++) {
+    index->table[k].head = ints;
+    ints += num_buckets;
+    index->table[k].next = ints;
+    ints += num_entries;
+    memset(index->table[k].head, 0xff, num_buckets * sizeof(int));
+  }
+
+  // Insert backwards so that each chain ends up in ascending order.
+  for (i = num_entries - 1; i >= 0; i--) {
+    GptEntry *entry = GetEntry(&drive->gpt, ANY_VALID, i);
+
+    for (k = 0; k < DRIVE_INDEX_COUNT; k++) {
+      struct index_table *t = &index->table[k];
+      uint32_t bucket = HashKey(k, EntryKey(entry, k)) & index->mask;
+
+      t->next[i] = t->head[bucket];
+      t->head[bucket] = i;
+    }
+  }
+
+  return index;
+}
+
+int DriveIndexFind(struct drive *drive, enum drive_index_key key,
+                   const void *value, int prev) {
+  struct index_table *t;
+  int i;
+
+  if (!drive->index) {
+    drive->index = BuildIndex(drive);
+    if (!drive->index) {
+      Error("Unable to allocate partition index\n");
+      return -1;
+    }
+  }
+  t = &drive->index->table[key];
+
+  if (prev < 0)
+    i = t->head[HashKey(key, value) & drive->index->mask];
+  else if ((uint32_t)prev < drive->index->num_entries)
+    i = t->next[prev];
+  else
+    return -1;
+
+  for (; i >= 0; i = t->next[i]) {
+    if (KeyEqual(key, GetEntry(&drive->gpt, ANY_VALID, i), value))
+      return i;
+  }
+  return -1;
+}
+
+int DriveIndexLabel(const char *label, uint16_t *name) {
+  memset(name, 0, DRIVE_INDEX_NAME_UNITS * sizeof(uint16_t));
+  // UTF8ToUTF16() stops quietly when the output is full, so a label is too
+  // long if anything spilled past the size of an entry name.
+  if (CGPT_OK != UTF8ToUTF16((const uint8_t *)label, name,
+                             DRIVE_INDEX_NAME_UNITS) ||
+      name[NAME_UNITS])
+    return CGPT_FAILED;
+  return CGPT_OK;
+}
+
+void DriveIndexReset(struct drive *drive) {
+  free(drive->index);
+  drive->index = NULL;
+}
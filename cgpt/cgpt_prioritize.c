@@ -141,18 +141,19 @@ int CgptPrioritize(CgptPrioritizeParams *params) {
 
   // How many kernel partitions do I have?
   num_kernels = 0;
-  for (i = 0; i < max_part; i++) {
-    if (IsKernel(&drive, PRIMARY, i))
-      num_kernels++;
-  }
+  for (i = DriveIndexFind(&drive, DRIVE_INDEX_TYPE, &guid_chromeos_kernel, -1);
+       i >= 0;
+       i = DriveIndexFind(&drive, DRIVE_INDEX_TYPE, &guid_chromeos_kernel, i))
+    num_kernels++;
 
   if (num_kernels) {
     // Determine the current priority groups
     groups = NewGroupList(num_kernels);
-    for (i = 0; i < max_part; i++) {
-      if (!IsKernel(&drive, PRIMARY, i))
-        continue;
-
+    for (i = DriveIndexFind(&drive, DRIVE_INDEX_TYPE, &guid_chromeos_kernel,
+                            -1);
+         i >= 0;
+         i = DriveIndexFind(&drive, DRIVE_INDEX_TYPE, &guid_chromeos_kernel,
+                            i)) {
       priority = GetPriority(&drive, PRIMARY, i);
 
       // Is this partition special?
@@ -0,0 +1,166 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#if !defined(HAVE_MACOS) && !defined(__FreeBSD__) && !defined(__OpenBSD__)
+#include <linux/falloc.h>
+#include <linux/fs.h>
+#define HAVE_PUNCH_HOLE
+#endif
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cgpt.h"
+#include "cgptlib_internal.h"
+#include "vboot_host.h"
+
+// Chunk size for zeroing by hand; also the alignment of those writes.
+#define ZERO_CHUNK_BYTES (1024 * 1024)
+
+// Write zeros over [offset, offset + len), reading first so that chunks which
+// are already zero (e.g. holes in a sparse image) are left alone.
+static int WriteZeros(int fd, uint64_t offset, uint64_t len) {
+  uint8_t *zeros, *buf;
+  int ret = CGPT_FAILED;
+
+  zeros = calloc(1, ZERO_CHUNK_BYTES);
+  buf = malloc(ZERO_CHUNK_BYTES);
+  if (!zeros || !buf) {
+    Error("Can't allocate zero buffer\n");
+    goto out;
+  }
+
+  while (len) {
+    // Stop at the next chunk boundary so later writes stay aligned.
+    uint64_t n = ZERO_CHUNK_BYTES - offset % ZERO_CHUNK_BYTES;
+    if (n > len)
+      n = len;
+
+    if (pread(fd, buf, n, offset) != (ssize_t)n || memcmp(buf, zeros, n)) {
+      if (pwrite(fd, zeros, n, offset) != (ssize_t)n) {
+        Error("Can't write zeros at %llu: %s\n",
+              (unsigned long long)offset, strerror(errno));
+        goto out;
+      }
+    }
+    offset += n;
+    len -= n;
+  }
+  ret = CGPT_OK;
+
+out:
+  free(zeros);
+  free(buf);
+  return ret;
+}
+
+static int ZeroRange(CgptZeroParams *params, int fd, uint64_t offset,
+                     uint64_t len) {
+#ifdef HAVE_PUNCH_HOLE
+  struct stat st;
+
+  if (fstat(fd, &st)) {
+    Error("Can't stat %s: %s\n", params->drive_name, strerror(errno));
+    return CGPT_FAILED;
+  }
+
+  if (S_ISBLK(st.st_mode)) {
+    uint64_t range[2] = {offset, len};
+
+    if (params->discard) {
+      if (!ioctl(fd, BLKDISCARD, range)) {
+        if (params->verbose)
+          printf("Discarded with BLKDISCARD\n");
+        return CGPT_OK;
+      }
+      if (params->verbose)
+        printf("BLKDISCARD failed (%s), zeroing\n", strerror(errno));
+    }
+    if (!ioctl(fd, BLKZEROOUT, range)) {
+      if (params->verbose)
+        printf("Zeroed with BLKZEROOUT\n");
+      return CGPT_OK;
+    }
+    if (params->verbose)
+      printf("BLKZEROOUT failed (%s), writing zeros\n", strerror(errno));
+  } else if (S_ISREG(st.st_mode)) {
+    // Holes read back as zeros, and free the space in the image.
+    if (!fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                   offset, len)) {
+      if (params->verbose)
+        printf("Punched a hole\n");
+      return CGPT_OK;
+    }
+    if (params->verbose)
+      printf("Punching a hole failed (%s), writing zeros\n", strerror(errno));
+  }
+#endif
+
+  return WriteZeros(fd, offset, len);
+}
+
+int CgptZero(CgptZeroParams *params) {
+  struct drive drive;
+  int gpt_retval;
+  GptEntry *entry;
+  uint64_t offset, len;
+  uint32_t index;
+
+  if (params == NULL)
+    return CGPT_FAILED;
+
+  if (params->drive_size) {
+    Error("Partitions aren't on %s, can't zero them\n", params->drive_name);
+    return CGPT_FAILED;
+  }
+
+  if (CGPT_OK != DriveOpen(params->drive_name, &drive, O_RDWR,
+                           params->drive_size))
+    return CGPT_FAILED;
+
+  if (GPT_SUCCESS != (gpt_retval = GptValidityCheck(&drive.gpt))) {
+    Error("GptValidityCheck() returned %d: %s\n",
+          gpt_retval, GptError(gpt_retval));
+    goto bad;
+  }
+
+  if (params->partition == 0 ||
+      params->partition > GetNumberOfEntries(&drive)) {
+    Error("invalid partition number: %d\n", params->partition);
+    goto bad;
+  }
+  index = params->partition - 1;
+  if (IsUnused(&drive, ANY_VALID, index)) {
+    Error("partition %d is unused\n", params->partition);
+    goto bad;
+  }
+
+  entry = GetEntry(&drive.gpt, ANY_VALID, index);
+  offset = entry->starting_lba * drive.gpt.sector_bytes;
+  len = (entry->ending_lba - entry->starting_lba + 1) *
+      drive.gpt.sector_bytes;
+  if (entry->ending_lba < entry->starting_lba ||
+      offset + len > drive.size) {
+    Error("partition %d is outside the drive\n", params->partition);
+    goto bad;
+  }
+
+  if (params->verbose)
+    printf("Zeroing partition %d: %llu bytes at %llu\n", params->partition,
+           (unsigned long long)len, (unsigned long long)offset);
+
+  if (CGPT_OK != ZeroRange(params, drive.fd, offset, len))
+    goto bad;
+
+  // The GPT itself is untouched.
+  return DriveClose(&drive, 0);
+
+bad:
+  (void) DriveClose(&drive, 0);
+  return CGPT_FAILED;
+}
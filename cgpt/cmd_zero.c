@@ -0,0 +1,93 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <getopt.h>
+#include <string.h>
+
+#include "cgpt.h"
+#include "vboot_host.h"
+
+extern const char* progname;
+
+static void Usage(void)
+{
+  printf("\nUsage: %s zero [OPTIONS] DRIVE\n\n"
+         "Zero the contents of a partition, leaving the GPT unchanged.\n\n"
+         "Image files get a hole punched through the partition, so they stay\n"
+         "sparse. Block devices are zeroed (or discarded) by the kernel where\n"
+         "it can, otherwise zeros are written.\n\n"
+         "Options:\n"
+         "  -D NUM       Size (in bytes) of the disk where partitions reside;\n"
+         "                 default 0, meaning partitions and GPT structs are\n"
+         "                 both on DRIVE. Zeroing needs them on DRIVE.\n"
+         "  -i NUM       Specify partition\n"
+         "  -d           Discard instead of zeroing on block devices; the\n"
+         "                 contents read back afterwards are undefined\n"
+         "  -v           Verbose\n"
+         "\n", progname);
+}
+
+int cmd_zero(int argc, char *argv[]) {
+  CgptZeroParams params;
+  memset(&params, 0, sizeof(params));
+
+  int c;
+  char* e = 0;
+  int errorcnt = 0;
+
+  opterr = 0;                     // quiet, you
+  while ((c=getopt(argc, argv, ":hi:dvD:")) != -1)
+  {
+    switch (c)
+    {
+    case 'D':
+      params.drive_size = strtoull(optarg, &e, 0);
+      errorcnt += check_int_parse(c, e);
+      break;
+    case 'i':
+      params.partition = (uint32_t)strtoul(optarg, &e, 0);
+      errorcnt += check_int_parse(c, e);
+      break;
+    case 'd':
+      params.discard = 1;
+      break;
+    case 'v':
+      params.verbose++;
+      break;
+    case 'h':
+      Usage();
+      return CGPT_OK;
+    case '?':
+      Error("unrecognized option: -%c\n", optopt);
+      errorcnt++;
+      break;
+    case ':':
+      Error("missing argument to -%c\n", optopt);
+      errorcnt++;
+      break;
+    default:
+      errorcnt++;
+      break;
+    }
+  }
+  if (!params.partition) {
+    Error("-i must be specified\n");
+    errorcnt++;
+  }
+  if (errorcnt)
+  {
+    Usage();
+    return CGPT_FAILED;
+  }
+
+  if (optind >= argc) {
+    Usage();
+    return CGPT_FAILED;
+  }
+
+  params.drive_name = argv[optind];
+
+  return CgptZero(&params);
+}
@@ -348,8 +348,9 @@ vb2_error_t vb2api_check_hash_get_digest(struct vb2_context *ctx,
 	key.allow_hwcrypto = vb2_hwcrypto_allowed(ctx);
 
 	/*
-	 * Check digest vs. signature.  Note that this destroys the signature.
-	 * That's ok, because we only check each signature once per boot.
+	 * Check digest vs. signature.  Note that this may destroy the
+	 * signature.  That's ok, because we only check each signature once
+	 * per boot.
 	 */
 	VB2_TRY(vb2_verify_digest(&key, &pre->body_signature, digest, &wb),
 		ctx, VB2_RECOVERY_FW_BODY);
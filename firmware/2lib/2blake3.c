@@ -0,0 +1,274 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * BLAKE3 implementation, following the reference implementation in the
+ * BLAKE3 specification (https://github.com/BLAKE3-team/BLAKE3-specs).
+ * Only the default hash mode with a 256-bit output is supported; there is no
+ * keyed hashing, key derivation or extended output.
+ */
+
+#include "2common.h"
+#include "2sha.h"
+#include "2sha_private.h"
+#include "2sysincludes.h"
+
+const uint32_t vb2_blake3_iv[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+/* Message word order for each round; each row is the previous permuted. */
+const uint8_t vb2_blake3_msg_schedule[7][16] = {
+	{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+	{2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8},
+	{3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1},
+	{10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6},
+	{12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4},
+	{9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7},
+	{11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13},
+};
+
+static inline uint32_t ror32(uint32_t x, int n)
+{
+	return (x >> n) | (x << (32 - n));
+}
+
+static inline uint32_t load32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+		((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store32(uint8_t *p, uint32_t x)
+{
+	p[0] = (uint8_t)x;
+	p[1] = (uint8_t)(x >> 8);
+	p[2] = (uint8_t)(x >> 16);
+	p[3] = (uint8_t)(x >> 24);
+}
+
+#define G(a, b, c, d, x, y)					\
+	do {							\
+		s[a] = s[a] + s[b] + (x);			\
+		s[d] = ror32(s[d] ^ s[a], 16);			\
+		s[c] = s[c] + s[d];				\
+		s[b] = ror32(s[b] ^ s[c], 12);			\
+		s[a] = s[a] + s[b] + (y);			\
+		s[d] = ror32(s[d] ^ s[a], 8);			\
+		s[c] = s[c] + s[d];				\
+		s[b] = ror32(s[b] ^ s[c], 7);			\
+	} while (0)
+
+/*
+ * Compress one block into the chaining value cv.  Only the first half of the
+ * output is kept, since that is all the 256-bit hash ever needs.
+ */
+static void blake3_compress(uint32_t cv[8], const uint8_t *block,
+			    uint32_t block_len, uint64_t counter,
+			    uint32_t flags)
+{
+	uint32_t m[16];
+	uint32_t s[16];
+	int i;
+
+	for (i = 0; i < 16; i++)
+		m[i] = load32(block + 4 * i);
+
+	for (i = 0; i < 8; i++)
+		s[i] = cv[i];
+	for (i = 0; i < 4; i++)
+		s[8 + i] = vb2_blake3_iv[i];
+	s[12] = (uint32_t)counter;
+	s[13] = (uint32_t)(counter >> 32);
+	s[14] = block_len;
+	s[15] = flags;
+
+	for (i = 0; i < 7; i++) {
+		const uint8_t *w = vb2_blake3_msg_schedule[i];
+
+		G(0, 4, 8, 12, m[w[0]], m[w[1]]);
+		G(1, 5, 9, 13, m[w[2]], m[w[3]]);
+		G(2, 6, 10, 14, m[w[4]], m[w[5]]);
+		G(3, 7, 11, 15, m[w[6]], m[w[7]]);
+		G(0, 5, 10, 15, m[w[8]], m[w[9]]);
+		G(1, 6, 11, 12, m[w[10]], m[w[11]]);
+		G(2, 7, 8, 13, m[w[12]], m[w[13]]);
+		G(3, 4, 9, 14, m[w[14]], m[w[15]]);
+	}
+
+	for (i = 0; i < 8; i++)
+		cv[i] = s[i] ^ s[i + 8];
+}
+
+/* Chaining value of a parent node, computed in place over left. */
+static void blake3_parent(uint32_t left[8], const uint32_t right[8],
+			  uint32_t flags)
+{
+	uint8_t block[VB2_BLAKE3_BLOCK_SIZE];
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		store32(block + 4 * i, left[i]);
+		store32(block + 32 + 4 * i, right[i]);
+		left[i] = vb2_blake3_iv[i];
+	}
+	blake3_compress(left, block, sizeof(block), 0, BLAKE3_PARENT | flags);
+}
+
+#ifndef BLAKE3_SIMD
+/* Weak so that tests can link in 2blake3_simd.c without BLAKE3_SIMD set. */
+__attribute__((weak))
+void vb2_blake3_hash_chunks(const uint8_t *input, uint32_t num_chunks,
+			    uint64_t chunk_counter, uint32_t cvs[][8])
+{
+	uint32_t i, j;
+
+	for (i = 0; i < num_chunks; i++) {
+		memcpy(cvs[i], vb2_blake3_iv, sizeof(cvs[i]));
+		for (j = 0; j < VB2_BLAKE3_CHUNK_SIZE;
+		     j += VB2_BLAKE3_BLOCK_SIZE) {
+			uint32_t flags = 0;
+
+			if (j == 0)
+				flags |= BLAKE3_CHUNK_START;
+			if (j == VB2_BLAKE3_CHUNK_SIZE - VB2_BLAKE3_BLOCK_SIZE)
+				flags |= BLAKE3_CHUNK_END;
+			blake3_compress(cvs[i], input + j,
+					VB2_BLAKE3_BLOCK_SIZE,
+					chunk_counter + i, flags);
+		}
+		input += VB2_BLAKE3_CHUNK_SIZE;
+	}
+}
+#endif  /* BLAKE3_SIMD */
+
+static inline uint32_t chunk_len(const struct vb2_blake3_context *ctx)
+{
+	return ctx->blocks_compressed * VB2_BLAKE3_BLOCK_SIZE + ctx->block_len;
+}
+
+static void chunk_reset(struct vb2_blake3_context *ctx)
+{
+	memcpy(ctx->cv, vb2_blake3_iv, sizeof(ctx->cv));
+	ctx->blocks_compressed = 0;
+	ctx->block_len = 0;
+}
+
+/*
+ * Push the chaining value of a completed chunk, first merging it with every
+ * subtree it completes.  The number of trailing zero bits in the chunk count
+ * is the number of subtrees to merge.
+ */
+static void push_chunk_cv(struct vb2_blake3_context *ctx, uint32_t cv[8])
+{
+	uint64_t total_chunks = ++ctx->chunk_counter;
+
+	while (!(total_chunks & 1)) {
+		uint32_t *left = ctx->cv_stack[--ctx->cv_stack_len];
+
+		blake3_parent(left, cv, 0);
+		memcpy(cv, left, sizeof(ctx->cv));
+		total_chunks >>= 1;
+	}
+	memcpy(ctx->cv_stack[ctx->cv_stack_len++], cv, sizeof(ctx->cv));
+}
+
+void vb2_blake3_init(struct vb2_blake3_context *ctx)
+{
+	chunk_reset(ctx);
+	ctx->chunk_counter = 0;
+	ctx->cv_stack_len = 0;
+}
+
+void vb2_blake3_update(struct vb2_blake3_context *ctx,
+		       const uint8_t *data,
+		       uint32_t size)
+{
+	uint32_t cvs[BLAKE3_MAX_CHUNKS][8];
+	uint32_t len, i;
+
+	while (size) {
+		/*
+		 * A full chunk is only finished once more data arrives, since
+		 * the last chunk has to be compressed as the root if it is the
+		 * only one.
+		 */
+		if (chunk_len(ctx) == VB2_BLAKE3_CHUNK_SIZE) {
+			uint32_t flags = BLAKE3_CHUNK_END;
+
+			if (!ctx->blocks_compressed)
+				flags |= BLAKE3_CHUNK_START;
+			blake3_compress(ctx->cv, ctx->block, ctx->block_len,
+					ctx->chunk_counter, flags);
+			push_chunk_cv(ctx, ctx->cv);
+			chunk_reset(ctx);
+		}
+
+		/* Hash whole chunks straight from the input, several at once */
+		if (!chunk_len(ctx) && size > VB2_BLAKE3_CHUNK_SIZE) {
+			len = (size - 1) / VB2_BLAKE3_CHUNK_SIZE;
+			if (len > BLAKE3_MAX_CHUNKS)
+				len = BLAKE3_MAX_CHUNKS;
+			vb2_blake3_hash_chunks(data, len, ctx->chunk_counter,
+					       cvs);
+			for (i = 0; i < len; i++)
+				push_chunk_cv(ctx, cvs[i]);
+			data += len * VB2_BLAKE3_CHUNK_SIZE;
+			size -= len * VB2_BLAKE3_CHUNK_SIZE;
+			continue;
+		}
+
+		/* Compress the buffered block if more data follows it */
+		if (ctx->block_len == VB2_BLAKE3_BLOCK_SIZE) {
+			blake3_compress(ctx->cv, ctx->block, ctx->block_len,
+					ctx->chunk_counter,
+					ctx->blocks_compressed ?
+					0 : BLAKE3_CHUNK_START);
+			ctx->blocks_compressed++;
+			ctx->block_len = 0;
+		}
+
+		len = VB2_BLAKE3_BLOCK_SIZE - ctx->block_len;
+		if (len > size)
+			len = size;
+		memcpy(ctx->block + ctx->block_len, data, len);
+		ctx->block_len += len;
+		data += len;
+		size -= len;
+	}
+}
+
+void vb2_blake3_finalize(struct vb2_blake3_context *ctx, uint8_t *digest)
+{
+	uint32_t flags = BLAKE3_CHUNK_END;
+	uint32_t cv[8];
+	int i;
+
+	if (!ctx->blocks_compressed)
+		flags |= BLAKE3_CHUNK_START;
+	memset(ctx->block + ctx->block_len, 0,
+	       VB2_BLAKE3_BLOCK_SIZE - ctx->block_len);
+
+	/* The last chunk is the root only if it is the only chunk */
+	if (!ctx->cv_stack_len) {
+		memcpy(cv, ctx->cv, sizeof(cv));
+		blake3_compress(cv, ctx->block, ctx->block_len, 0,
+				flags | BLAKE3_ROOT);
+	} else {
+		blake3_compress(ctx->cv, ctx->block, ctx->block_len,
+				ctx->chunk_counter, flags);
+		memcpy(cv, ctx->cv, sizeof(cv));
+
+		/* Fold the stack from the right, the last merge is the root */
+		for (i = ctx->cv_stack_len - 1; i >= 0; i--) {
+			uint32_t *left = ctx->cv_stack[i];
+
+			blake3_parent(left, cv, i ? 0 : BLAKE3_ROOT);
+			memcpy(cv, left, sizeof(cv));
+		}
+	}
+
+	for (i = 0; i < 8; i++)
+		store32(digest + 4 * i, cv[i]);
+}
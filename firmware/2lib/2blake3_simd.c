@@ -0,0 +1,104 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * BLAKE3 chunk hashing, four chunks at a time.  Each 32-bit lane of a vector
+ * holds the state of one chunk, so no shuffles are needed.  This uses generic
+ * GCC/clang vector types, which compile to SSE2 on x86 and NEON on ARM.
+ */
+
+#include "2common.h"
+#include "2sha.h"
+#include "2sha_private.h"
+#include "2sysincludes.h"
+
+typedef uint32_t vb2_u32x4 __attribute__ ((vector_size(16)));
+
+_Static_assert(BLAKE3_MAX_CHUNKS == 4, "Lane count must match");
+
+static inline vb2_u32x4 ror(vb2_u32x4 x, int n)
+{
+	return (x >> n) | (x << (32 - n));
+}
+
+static inline uint32_t load32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+		((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+#define G(a, b, c, d, x, y)					\
+	do {							\
+		v[a] = v[a] + v[b] + (x);			\
+		v[d] = ror(v[d] ^ v[a], 16);			\
+		v[c] = v[c] + v[d];				\
+		v[b] = ror(v[b] ^ v[c], 12);			\
+		v[a] = v[a] + v[b] + (y);			\
+		v[d] = ror(v[d] ^ v[a], 8);			\
+		v[c] = v[c] + v[d];				\
+		v[b] = ror(v[b] ^ v[c], 7);			\
+	} while (0)
+
+void vb2_blake3_hash_chunks(const uint8_t *input, uint32_t num_chunks,
+			    uint64_t chunk_counter, uint32_t cvs[][8])
+{
+	const uint8_t *chunk[4];
+	vb2_u32x4 cv[8], v[16], m[16];
+	vb2_u32x4 counter_lo, counter_hi;
+	uint32_t block, flags;
+	int i, j;
+
+	/* Spare lanes just repeat the last chunk */
+	for (i = 0; i < 4; i++) {
+		j = i < num_chunks ? i : num_chunks - 1;
+		chunk[i] = input + j * VB2_BLAKE3_CHUNK_SIZE;
+		counter_lo[i] = (uint32_t)(chunk_counter + j);
+		counter_hi[i] = (uint32_t)((chunk_counter + j) >> 32);
+	}
+
+	for (i = 0; i < 8; i++)
+		cv[i] = (vb2_u32x4){0} + vb2_blake3_iv[i];
+
+	for (block = 0; block < VB2_BLAKE3_CHUNK_SIZE;
+	     block += VB2_BLAKE3_BLOCK_SIZE) {
+		flags = 0;
+		if (block == 0)
+			flags |= BLAKE3_CHUNK_START;
+		if (block == VB2_BLAKE3_CHUNK_SIZE - VB2_BLAKE3_BLOCK_SIZE)
+			flags |= BLAKE3_CHUNK_END;
+
+		/* Transpose the message so word i of every chunk is in m[i] */
+		for (i = 0; i < 16; i++)
+			for (j = 0; j < 4; j++)
+				m[i][j] = load32(chunk[j] + block + 4 * i);
+
+		for (i = 0; i < 8; i++)
+			v[i] = cv[i];
+		for (i = 0; i < 4; i++)
+			v[8 + i] = (vb2_u32x4){0} + vb2_blake3_iv[i];
+		v[12] = counter_lo;
+		v[13] = counter_hi;
+		v[14] = (vb2_u32x4){0} + VB2_BLAKE3_BLOCK_SIZE;
+		v[15] = (vb2_u32x4){0} + flags;
+
+		for (i = 0; i < 7; i++) {
+			const uint8_t *w = vb2_blake3_msg_schedule[i];
+
+			G(0, 4, 8, 12, m[w[0]], m[w[1]]);
+			G(1, 5, 9, 13, m[w[2]], m[w[3]]);
+			G(2, 6, 10, 14, m[w[4]], m[w[5]]);
+			G(3, 7, 11, 15, m[w[6]], m[w[7]]);
+			G(0, 5, 10, 15, m[w[8]], m[w[9]]);
+			G(1, 6, 11, 12, m[w[10]], m[w[11]]);
+			G(2, 7, 8, 13, m[w[12]], m[w[13]]);
+			G(3, 4, 9, 14, m[w[14]], m[w[15]]);
+		}
+
+		for (i = 0; i < 8; i++)
+			cv[i] = v[i] ^ v[i + 8];
+	}
+
+	for (i = 0; i < num_chunks; i++)
+		for (j = 0; j < 8; j++)
+			cvs[i][j] = cv[j][i];
+}
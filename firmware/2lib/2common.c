@@ -151,7 +151,10 @@ vb2_error_t vb2_verify_digest(const struct vb2_public_key *key,
 			      struct vb2_signature *sig, const uint8_t *digest,
 			      const struct vb2_workbuf *wb)
 {
-	/* A signature is destroyed in the process of being verified. */
+	/*
+	 * A signature is destroyed in the process of being verified if
+	 * hardware modexp is used, so it must never be verified in a mapping.
+	 */
 	uint8_t *sig_data = vb2_signature_data_mutable(sig);
 
 	if (sig->sig_size != vb2_rsa_sig_size(key->sig_alg)) {
@@ -229,3 +232,93 @@ vb2_error_t vb2_verify_data(const uint8_t *data, uint32_t size,
 
 	return vb2_verify_digest(key, sig, digest, &wblocal);
 }
+
+vb2_error_t vb2_tree_digest(const uint8_t *data, uint32_t size,
+			    uint32_t chunk_size,
+			    enum vb2_hash_algorithm hash_alg,
+			    int allow_hwcrypto, uint8_t *digest,
+			    uint32_t digest_size, const struct vb2_workbuf *wb)
+{
+	struct vb2_workbuf wblocal = *wb;
+	struct vb2_digest_context *dc;
+	uint8_t *chunk_digests;
+	uint32_t chunk_digest_size = vb2_digest_size(hash_alg);
+	uint32_t offs, len, count, i;
+	uint64_t batch_size = (uint64_t)chunk_size * VB2_TREE_HASH_BATCH;
+	vb2_error_t rv;
+
+	if (!chunk_digest_size)
+		return VB2_ERROR_VDATA_DIGEST_SIZE;
+	if (!chunk_size)
+		return VB2_ERROR_VDATA_CHUNK_SIZE;
+
+	dc = vb2_workbuf_alloc(&wblocal, sizeof(*dc));
+	chunk_digests = vb2_workbuf_alloc(&wblocal, VB2_TREE_HASH_BATCH *
+					  chunk_digest_size);
+	if (!dc || !chunk_digests)
+		return VB2_ERROR_VDATA_WORKBUF_CHUNKS;
+
+	VB2_TRY(vb2_digest_init(dc, hash_alg));
+
+	for (offs = 0; offs < size; offs += len) {
+		len = VB2_MIN(size - offs, batch_size);
+		count = (uint32_t)(((uint64_t)len + chunk_size - 1) /
+				   chunk_size);
+
+		rv = VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
+		if (allow_hwcrypto)
+			rv = vb2ex_hwcrypto_digest_chunks(
+				hash_alg, data + offs, len, chunk_size,
+				chunk_digests, count * chunk_digest_size);
+		if (rv == VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED) {
+			for (i = 0; i < count; i++) {
+				uint32_t coffs = i * chunk_size;
+
+				VB2_TRY(vb2_digest_buffer(
+					data + offs + coffs,
+					VB2_MIN(chunk_size, len - coffs),
+					hash_alg,
+					chunk_digests + i * chunk_digest_size,
+					chunk_digest_size));
+			}
+		} else if (rv) {
+			VB2_DEBUG("HW chunk hashing error: %#x\n", rv);
+			return rv;
+		}
+
+		VB2_TRY(vb2_digest_extend(dc, chunk_digests,
+					  count * chunk_digest_size));
+	}
+
+	return vb2_digest_finalize(dc, digest, digest_size);
+}
+
+vb2_error_t vb2_verify_data_tree(const uint8_t *data, uint32_t size,
+				 struct vb2_signature *sig,
+				 const struct vb2_public_key *key,
+				 uint32_t chunk_size,
+				 const struct vb2_workbuf *wb)
+{
+	struct vb2_workbuf wblocal = *wb;
+	uint8_t *digest;
+	uint32_t digest_size;
+
+	if (sig->data_size > size) {
+		VB2_DEBUG("Data buffer smaller than length of signed data.\n");
+		return VB2_ERROR_VDATA_NOT_ENOUGH_DATA;
+	}
+
+	digest_size = vb2_digest_size(key->hash_alg);
+	if (!digest_size)
+		return VB2_ERROR_VDATA_DIGEST_SIZE;
+
+	digest = vb2_workbuf_alloc(&wblocal, digest_size);
+	if (!digest)
+		return VB2_ERROR_VDATA_WORKBUF_DIGEST;
+
+	VB2_TRY(vb2_tree_digest(data, sig->data_size, chunk_size,
+				key->hash_alg, key->allow_hwcrypto, digest,
+				digest_size, &wblocal));
+
+	return vb2_verify_digest(key, sig, digest, &wblocal);
+}
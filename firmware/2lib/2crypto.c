@@ -17,10 +17,20 @@
  * there is no C language way to guarantee that, so we have to manually force
  * the compiler to place them in .rodata. Also inject custom section flags so
  * they are only allocatable (a) but not writeable (w).
+ *
+ * Host code is position independent, so the pointers need relocating at load
+ * time. Forcing them into .rodata there gives libvboot_host.so text
+ * relocations; leave them to the compiler (.data.rel.ro) instead.
  */
+#ifdef CHROMEOS_ENVIRONMENT
+#define VB2_NAMES_RODATA(name)
+#else
+#define VB2_NAMES_RODATA(name) \
+	__attribute__((section(".rodata." #name ",\"a\"\n# ")))
+#endif
 
-__attribute__((section(".rodata.vb2_sig_names,\"a\"\n# ")))
-const char *vb2_sig_names[VB2_SIG_ALG_COUNT] = {
+VB2_NAMES_RODATA(vb2_sig_names)
+const char *const vb2_sig_names[VB2_SIG_ALG_COUNT] = {
 	[VB2_SIG_NONE]		= "none",
 	[VB2_SIG_RSA1024]	= "RSA1024",
 	[VB2_SIG_RSA2048]	= "RSA2048",
@@ -30,8 +40,8 @@ const char *vb2_sig_names[VB2_SIG_ALG_COUNT] = {
 	[VB2_SIG_RSA3072_EXP3]	= "RSA3072EXP3",
 };
 
-__attribute__((section(".rodata.vb2_hash_names,\"a\"\n# ")))
-const char *vb2_hash_names[VB2_HASH_ALG_COUNT] = {
+VB2_NAMES_RODATA(vb2_hash_names)
+const char *const vb2_hash_names[VB2_HASH_ALG_COUNT] = {
 	[VB2_HASH_NONE]		= "none",
 #if VB2_SUPPORT_SHA1
 	[VB2_HASH_SHA1]		= VB2_SHA1_ALG_NAME,
@@ -44,6 +54,9 @@ const char *vb2_hash_names[VB2_HASH_ALG_COUNT] = {
 	[VB2_HASH_SHA384]	= VB2_SHA384_ALG_NAME,
 	[VB2_HASH_SHA512]	= VB2_SHA512_ALG_NAME,
 #endif
+#if VB2_SUPPORT_BLAKE3
+	[VB2_HASH_BLAKE3]	= VB2_BLAKE3_ALG_NAME,
+#endif
 };
 
 /* The others are internal to this file. */
@@ -20,52 +20,86 @@ vb2_error_t vb2_load_fw_keyblock(struct vb2_context *ctx)
 	struct vb2_gbb_header *gbb = vb2_get_gbb(ctx);
 	struct vb2_workbuf wb;
 
-	uint8_t *key_data;
+	const uint8_t *key_data;
 	uint32_t key_size;
 	struct vb2_public_key root_key;
 
+	/* Data key goes at the start of the unused work buffer */
+	uint8_t *data_key;
+
 	struct vb2_keyblock *kb;
 	uint32_t block_size;
+	const struct vb2_keyblock *mapped;
 
 	vb2_error_t rv = VB2_SUCCESS;
 
 	vb2_workbuf_from_ctx(ctx, &wb);
+	data_key = wb.buf;
 
-	/* Read the root key */
+	/* Read the root key, unless the GBB is mapped */
 	key_size = gbb->rootkey_size;
-	key_data = vb2_workbuf_alloc(&wb, key_size);
-	if (!key_data)
-		return VB2_ERROR_FW_KEYBLOCK_WORKBUF_ROOT_KEY;
-
-	VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_GBB, gbb->rootkey_offset,
-				    key_data, key_size));
+	key_data = vb2_map_resource(ctx, VB2_RES_GBB, gbb->rootkey_offset,
+				    key_size);
+	if (!key_data) {
+		uint8_t *buf = vb2_workbuf_alloc(&wb, key_size);
+		if (!buf)
+			return VB2_ERROR_FW_KEYBLOCK_WORKBUF_ROOT_KEY;
+
+		VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_GBB,
+					    gbb->rootkey_offset,
+					    buf, key_size));
+		key_data = buf;
+	}
 
 	/* Unpack the root key */
 	VB2_TRY(vb2_unpack_key_buffer(&root_key, key_data, key_size));
 
 	root_key.allow_hwcrypto = vb2_hwcrypto_allowed(ctx);
 
-	/* Load the firmware keyblock header after the root key */
-	kb = vb2_workbuf_alloc(&wb, sizeof(*kb));
-	if (!kb)
-		return VB2_ERROR_FW_KEYBLOCK_WORKBUF_HEADER;
-
-	VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_FW_VBLOCK, 0,
-				    kb, sizeof(*kb)));
-
-	block_size = kb->keyblock_size;
-
 	/*
-	 * Load the entire keyblock, now that we know how big it is.  Note that
-	 * we're loading the entire keyblock instead of just the piece after
-	 * the header.  That means we re-read the header.  But that's a tiny
-	 * amount of data, and it makes the code much more straightforward.
+	 * The keyblock is always verified and used from a copy in the work
+	 * buffer, even if the vblock is mapped.  Flash can change between the
+	 * signature check and the reads after it, so the bytes we trust must
+	 * be the bytes we checked.  Mapping just lets us copy it in one go.
 	 */
-	kb = vb2_workbuf_realloc(&wb, sizeof(*kb), block_size);
-	if (!kb)
-		return VB2_ERROR_FW_KEYBLOCK_WORKBUF;
-
-	VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_FW_VBLOCK, 0, kb, block_size));
+	mapped = vb2_map_resource(ctx, VB2_RES_FW_VBLOCK, 0, sizeof(*kb));
+	if (mapped) {
+		block_size = mapped->keyblock_size;
+		mapped = vb2_map_resource(ctx, VB2_RES_FW_VBLOCK, 0,
+					  block_size);
+		if (!mapped)
+			return VB2_ERROR_FW_KEYBLOCK_MAP;
+
+		kb = vb2_workbuf_alloc(&wb, block_size);
+		if (!kb)
+			return VB2_ERROR_FW_KEYBLOCK_WORKBUF;
+
+		memcpy(kb, mapped, block_size);
+	} else {
+		/* Load the firmware keyblock header after the root key */
+		kb = vb2_workbuf_alloc(&wb, sizeof(*kb));
+		if (!kb)
+			return VB2_ERROR_FW_KEYBLOCK_WORKBUF_HEADER;
+
+		VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_FW_VBLOCK, 0,
+					    kb, sizeof(*kb)));
+
+		block_size = kb->keyblock_size;
+
+		/*
+		 * Load the entire keyblock, now that we know how big it is.
+		 * Note that we're loading the entire keyblock instead of just
+		 * the piece after the header.  That means we re-read the
+		 * header.  But that's a tiny amount of data, and it makes the
+		 * code much more straightforward.
+		 */
+		kb = vb2_workbuf_realloc(&wb, sizeof(*kb), block_size);
+		if (!kb)
+			return VB2_ERROR_FW_KEYBLOCK_WORKBUF;
+
+		VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_FW_VBLOCK, 0,
+					    kb, block_size));
+	}
 
 	/* Verify the keyblock */
 	VB2_TRY(vb2_verify_keyblock(kb, block_size, &root_key, &wb),
@@ -92,15 +126,15 @@ vb2_error_t vb2_load_fw_keyblock(struct vb2_context *ctx)
 
 	/*
 	 * Save the data key in the work buffer.  We'll overwrite the root key
-	 * we read above.  That's ok, because now that we have the data key we
-	 * no longer need the root key.  First, let's double-check that it is
-	 * well-formed though (although the keyblock was signed anyway).
+	 * if we read it above.  That's ok, because now that we have the data
+	 * key we no longer need the root key.  First, let's double-check that
+	 * it is well-formed though (although the keyblock was signed anyway).
 	 */
 	VB2_TRY(vb2_verify_packed_key_inside(kb, block_size, &kb->data_key));
 
 	/* Save the future offset and size while kb->data_key is still valid.
 	   The check above made sure that key_offset and key_size are valid. */
-	sd->data_key_offset = vb2_offset_of(sd, key_data);
+	sd->data_key_offset = vb2_offset_of(sd, data_key);
 	sd->data_key_size = kb->data_key.key_offset + kb->data_key.key_size;
 
 	/*
@@ -110,7 +144,7 @@ vb2_error_t vb2_load_fw_keyblock(struct vb2_context *ctx)
 	 * being paranoid.  Make sure we immediately invalidate 'kb' after the
 	 * move to guarantee we won't try to access it anymore.
 	 */
-	memmove(key_data, &kb->data_key, sd->data_key_size);
+	memmove(data_key, &kb->data_key, sd->data_key_size);
 	kb = NULL;
 
 	/*
@@ -138,6 +172,7 @@ vb2_error_t vb2_load_fw_preamble(struct vb2_context *ctx)
 	/* Preamble goes in the next unused chunk of work buffer */
 	struct vb2_fw_preamble *pre;
 	uint32_t pre_size;
+	const struct vb2_fw_preamble *mapped;
 
 	vb2_error_t rv = VB2_SUCCESS;
 
@@ -151,25 +186,47 @@ vb2_error_t vb2_load_fw_preamble(struct vb2_context *ctx)
 
 	data_key.allow_hwcrypto = vb2_hwcrypto_allowed(ctx);
 
-	/* Load the firmware preamble header */
-	pre = vb2_workbuf_alloc(&wb, sizeof(*pre));
-	if (!pre)
-		return VB2_ERROR_FW_PREAMBLE2_WORKBUF_HEADER;
-
-	VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_FW_VBLOCK,
-				    sd->vblock_preamble_offset,
-				    pre, sizeof(*pre)));
-
-	pre_size = pre->preamble_size;
-
-	/* Load the entire firmware preamble, now that we know how big it is */
-	pre = vb2_workbuf_realloc(&wb, sizeof(*pre), pre_size);
-	if (!pre)
-		return VB2_ERROR_FW_PREAMBLE2_WORKBUF;
-
-	VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_FW_VBLOCK,
-				    sd->vblock_preamble_offset,
-				    pre, pre_size));
+	/*
+	 * The preamble persists after we return, so it is copied to the work
+	 * buffer even if the vblock is mapped.  Mapping just lets us do that
+	 * with a single copy.
+	 */
+	mapped = vb2_map_resource(ctx, VB2_RES_FW_VBLOCK,
+				  sd->vblock_preamble_offset, sizeof(*pre));
+	if (mapped) {
+		pre_size = mapped->preamble_size;
+		mapped = vb2_map_resource(ctx, VB2_RES_FW_VBLOCK,
+					  sd->vblock_preamble_offset,
+					  pre_size);
+		if (!mapped)
+			return VB2_ERROR_FW_PREAMBLE2_MAP;
+
+		pre = vb2_workbuf_alloc(&wb, pre_size);
+		if (!pre)
+			return VB2_ERROR_FW_PREAMBLE2_WORKBUF;
+
+		memcpy(pre, mapped, pre_size);
+	} else {
+		/* Load the firmware preamble header */
+		pre = vb2_workbuf_alloc(&wb, sizeof(*pre));
+		if (!pre)
+			return VB2_ERROR_FW_PREAMBLE2_WORKBUF_HEADER;
+
+		VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_FW_VBLOCK,
+					    sd->vblock_preamble_offset,
+					    pre, sizeof(*pre)));
+
+		pre_size = pre->preamble_size;
+
+		/* Load the entire preamble, now that we know how big it is */
+		pre = vb2_workbuf_realloc(&wb, sizeof(*pre), pre_size);
+		if (!pre)
+			return VB2_ERROR_FW_PREAMBLE2_WORKBUF;
+
+		VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_FW_VBLOCK,
+					    sd->vblock_preamble_offset,
+					    pre, pre_size));
+	}
 
 	/* Work buffer now contains the data subkey data and the preamble */
 
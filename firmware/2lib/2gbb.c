@@ -14,6 +14,7 @@ static vb2_error_t vb2_gbb_read_key(struct vb2_context *ctx, uint32_t offset,
 				    struct vb2_workbuf *wb)
 {
 	struct vb2_workbuf wblocal = *wb;
+	const struct vb2_packed_key *mapped;
 
 	/* Check offset and size. */
 	if (offset < sizeof(struct vb2_gbb_header))
@@ -21,6 +22,29 @@ static vb2_error_t vb2_gbb_read_key(struct vb2_context *ctx, uint32_t offset,
 	if (*size < sizeof(**keyp))
 		return VB2_ERROR_GBB_INVALID;
 
+	/*
+	 * Keys are handed back to the caller, so are always copied to the
+	 * work buffer.  If the GBB is mapped, copy just the real size of the
+	 * key, then check the copy.
+	 */
+	mapped = vb2_map_resource(ctx, VB2_RES_GBB, offset, *size);
+	if (mapped) {
+		VB2_TRY(vb2_verify_packed_key_inside(mapped, *size, mapped));
+
+		/* Deal with a zero-size key (used in testing). */
+		*size = mapped->key_offset + mapped->key_size;
+		*size = VB2_MAX(*size, sizeof(**keyp));
+
+		*keyp = vb2_workbuf_alloc(&wblocal, *size);
+		if (!*keyp)
+			return VB2_ERROR_GBB_WORKBUF;
+		memcpy(*keyp, mapped, *size);
+
+		VB2_TRY(vb2_verify_packed_key_inside(*keyp, *size, *keyp));
+		*wb = wblocal;
+		return VB2_SUCCESS;
+	}
+
 	/* GBB header might be padded.  Retrieve the vb2_packed_key
 	   header so we can find out what the real size is. */
 	*keyp = vb2_workbuf_alloc(&wblocal, sizeof(**keyp));
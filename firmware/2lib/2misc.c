@@ -76,6 +76,32 @@ vb2_error_t vb2_read_gbb_header(struct vb2_context *ctx,
 	return VB2_SUCCESS;
 }
 
+const void *vb2_map_resource(struct vb2_context *ctx,
+			     enum vb2_resource_index index,
+			     uint32_t offset, uint32_t size)
+{
+	const void *buf;
+	uint32_t buf_size;
+
+	if (vb2ex_map_resource(ctx, index, &buf, &buf_size))
+		return NULL;
+
+	if (offset > buf_size || size > buf_size - offset) {
+		VB2_DEBUG("Resource %d too small to map %#x bytes at %#x\n",
+			  index, size, offset);
+		return NULL;
+	}
+
+	/* Structures are parsed in place, so need their natural alignment */
+	buf = (const uint8_t *)buf + offset;
+	if (!vb2_aligned(buf, sizeof(uint32_t))) {
+		VB2_DEBUG("Resource %d unaligned at %#x\n", index, offset);
+		return NULL;
+	}
+
+	return buf;
+}
+
 test_mockable
 void vb2api_fail(struct vb2_context *ctx, uint8_t reason, uint8_t subcode)
 {
@@ -100,14 +126,14 @@ void vb2api_fail(struct vb2_context *ctx, uint8_t reason, uint8_t subcode)
 			 * between slots, which may help if one or both slots
 			 * is flaky.
 			 */
-			vb2_nv_set(ctx, VB2_NV_TRY_NEXT, 1 - fw_slot);
+			vb2_nv_set(ctx, VB2_NV_TRY_NEXT, 1 - sd->fw_slot);
 
 			/*
 			 * If we didn't try the other slot last boot, or we
 			 * tried it and it didn't fail, try it next boot.
 			 */
-			if (last_fw_slot != 1 - fw_slot ||
-			    last_fw_result != VB2_FW_RESULT_FAILURE)
+			if (sd->last_fw_slot != 1 - sd->fw_slot ||
+			    sd->last_fw_result != VB2_FW_RESULT_FAILURE)
 				return;
 		}
 	}
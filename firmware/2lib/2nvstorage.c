@@ -217,6 +217,13 @@ uint32_t vb2_nv_get(struct vb2_context *ctx, enum vb2_nv_param param)
 	case VB2_NV_MINIOS_PRIORITY:
 		return GETBIT(VB2_NV_OFFS_MISC, VB2_NV_MISC_MINIOS_PRIORITY);
 
+	case VB2_NV_KERNEL_LAST_GOOD_PARTITION:
+		/* Field only present in V2 */
+		if (!(ctx->flags & VB2_CONTEXT_NVDATA_V2))
+			return 0;
+
+		return p[VB2_NV_OFFS_KERNEL_LAST_GOOD];
+
 	case VB2_NV_DEPRECATED_DEV_BOOT_FASTBOOT_FULL_CAP:
 	case VB2_NV_DEPRECATED_FASTBOOT_UNLOCK_IN_FW:
 	case VB2_NV_DEPRECATED_ENABLE_ALT_OS_REQUEST:
@@ -428,6 +435,17 @@ void vb2_nv_set(struct vb2_context *ctx,
 		SETBIT(VB2_NV_OFFS_MISC, VB2_NV_MISC_MINIOS_PRIORITY);
 		break;
 
+	case VB2_NV_KERNEL_LAST_GOOD_PARTITION:
+		/* Field only present in V2 */
+		if (!(ctx->flags & VB2_CONTEXT_NVDATA_V2))
+			return;
+
+		/* Map values outside the valid range to no hint. */
+		if (value > 0xFF)
+			value = 0;
+		p[VB2_NV_OFFS_KERNEL_LAST_GOOD] = (uint8_t)value;
+		break;
+
 	case VB2_NV_DEPRECATED_DEV_BOOT_FASTBOOT_FULL_CAP:
 	case VB2_NV_DEPRECATED_FASTBOOT_UNLOCK_IN_FW:
 	case VB2_NV_DEPRECATED_ENABLE_ALT_OS_REQUEST:
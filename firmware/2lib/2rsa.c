@@ -126,16 +126,19 @@ static void montMul1(const struct vb2_public_key *key,
 }
 
 /**
- * In-place public exponentiation.
+ * Public exponentiation.
  *
  * @param key		Key to use in signing
- * @param inout		Input and output big-endian byte array
+ * @param in		Input big-endian byte array
+ * @param out		Output big-endian byte array.  May be the same as in,
+ *			or the start of workbuf32, but must not overlap
+ *			anything else in workbuf32.
  * @param workbuf32	Work buffer; caller must verify this is
  *			(3 * key->arrsize) elements long.
  * @param exp		RSA public exponent: either 65537 (F4) or 3
  */
-static void modpow(const struct vb2_public_key *key, uint8_t *inout,
-		uint32_t *workbuf32, int exp)
+static void modpow(const struct vb2_public_key *key, const uint8_t *in,
+		   uint8_t *out, uint32_t *workbuf32, int exp)
 {
 	uint32_t *a = workbuf32;
 	uint32_t *aR = a + key->arrsize;
@@ -146,11 +149,11 @@ static void modpow(const struct vb2_public_key *key, uint8_t *inout,
 	/* Convert from big endian byte array to little endian word array. */
 	for (i = 0; i < (int)key->arrsize; ++i) {
 		uint32_t tmp =
-			((uint32_t)inout[((key->arrsize - 1 - i) * 4) + 0]
+			((uint32_t)in[((key->arrsize - 1 - i) * 4) + 0]
 				<< 24) |
-			(inout[((key->arrsize - 1 - i) * 4) + 1] << 16) |
-			(inout[((key->arrsize - 1 - i) * 4) + 2] << 8) |
-			(inout[((key->arrsize - 1 - i) * 4) + 3] << 0);
+			(in[((key->arrsize - 1 - i) * 4) + 1] << 16) |
+			(in[((key->arrsize - 1 - i) * 4) + 2] << 8) |
+			(in[((key->arrsize - 1 - i) * 4) + 3] << 0);
 		a[i] = tmp;
 	}
 
@@ -176,10 +179,10 @@ static void modpow(const struct vb2_public_key *key, uint8_t *inout,
 	/* Convert to bigendian byte array */
 	for (i = (int)key->arrsize - 1; i >= 0; --i) {
 		uint32_t tmp = aaa[i];
-		*inout++ = (uint8_t)(tmp >> 24);
-		*inout++ = (uint8_t)(tmp >> 16);
-		*inout++ = (uint8_t)(tmp >>  8);
-		*inout++ = (uint8_t)(tmp >>  0);
+		*out++ = (uint8_t)(tmp >> 24);
+		*out++ = (uint8_t)(tmp >> 16);
+		*out++ = (uint8_t)(tmp >>  8);
+		*out++ = (uint8_t)(tmp >>  0);
 	}
 }
 
@@ -202,6 +205,12 @@ uint32_t vb2_rsa_sig_size(enum vb2_signature_algorithm sig_alg)
 	}
 }
 
+uint32_t vb2_rsa_verify_scratch_size(enum vb2_signature_algorithm sig_alg)
+{
+	/* modpow() needs three word arrays the size of the key */
+	return 3 * vb2_rsa_sig_size(sig_alg);
+}
+
 /**
  * Return the exponent used by an RSA algorithm
  *
@@ -333,36 +342,118 @@ vb2_error_t vb2_check_padding(const uint8_t *sig,
 	return result ? VB2_ERROR_RSA_PADDING : VB2_SUCCESS;
 }
 
+/**
+ * Check the padding and digest of a decrypted signature.
+ *
+ * @param key		Key the signature was decrypted with
+ * @param sig		Decrypted signature
+ * @param digest	Digest of signed data
+ * @return VB2_SUCCESS, or non-zero if error.
+ */
+static vb2_error_t check_decrypted_sig(const struct vb2_public_key *key,
+				       const uint8_t *sig,
+				       const uint8_t *digest)
+{
+	uint32_t sig_size = vb2_rsa_sig_size(key->sig_alg);
+	uint32_t pad_size;
+	vb2_error_t rv;
+
+	/*
+	 * Check padding.  Only fail immediately if the padding size is bad.
+	 * Otherwise, continue on to check the digest to reduce the risk of
+	 * timing based attacks.
+	 */
+	rv = vb2_check_padding(sig, key);
+	if (rv == VB2_ERROR_RSA_PADDING_SIZE)
+		return rv;
+
+	/*
+	 * Check digest.  Even though there are probably no timing issues here,
+	 * use vb2_safe_memcmp() just to be on the safe side.  (That's also why
+	 * we don't return before this check if the padding check failed.)
+	 */
+	pad_size = sig_size - vb2_digest_size(key->hash_alg);
+	if (vb2_safe_memcmp(sig + pad_size, digest, sig_size - pad_size)) {
+		VB2_DEBUG("Digest check failed!\n");
+		if (!rv)
+			rv = VB2_ERROR_RSA_VERIFY_DIGEST;
+	}
+
+	return rv;
+}
+
+/**
+ * Check the key and signature algorithm are usable for verification.
+ *
+ * @param key		Key to use in signature verification
+ * @param exp		Destination for the RSA public exponent
+ * @return VB2_SUCCESS, or non-zero if error.
+ */
+static vb2_error_t check_verify_key(const struct vb2_public_key *key,
+				    int *exp)
+{
+	uint32_t sig_size = vb2_rsa_sig_size(key->sig_alg);
+
+	*exp = vb2_rsa_exponent(key->sig_alg);
+	if (!sig_size || !*exp) {
+		VB2_DEBUG("Invalid signature type!\n");
+		return VB2_ERROR_RSA_VERIFY_ALGORITHM;
+	}
+
+	/* Signature length should be same as key length */
+	if (key->arrsize * sizeof(uint32_t) != sig_size) {
+		VB2_DEBUG("Signature is of incorrect length!\n");
+		return VB2_ERROR_RSA_VERIFY_SIG_LEN;
+	}
+
+	return VB2_SUCCESS;
+}
+
+vb2_error_t vb2_rsa_verify_digest_inplace(const struct vb2_public_key *key,
+					  const uint8_t *sig,
+					  const uint8_t *digest,
+					  void *scratch, uint32_t scratch_size)
+{
+	uint8_t *decrypted = scratch;
+	int exp;
+
+	if (!key || !sig || !digest || !scratch)
+		return VB2_ERROR_RSA_VERIFY_PARAM;
+
+	VB2_TRY(check_verify_key(key, &exp));
+
+	if (scratch_size < vb2_rsa_verify_scratch_size(key->sig_alg)) {
+		VB2_DEBUG("ERROR - RSA scratch buffer too small!\n");
+		return VB2_ERROR_RSA_VERIFY_WORKBUF;
+	}
+
+	/*
+	 * Exponentiate straight from the caller's signature.  The result
+	 * lands at the start of the scratch buffer, which modpow() no longer
+	 * needs by the time it writes its output.
+	 */
+	modpow(key, sig, decrypted, scratch, exp);
+
+	return check_decrypted_sig(key, decrypted, digest);
+}
+
 vb2_error_t vb2_rsa_verify_digest(const struct vb2_public_key *key,
 				  uint8_t *sig, const uint8_t *digest,
 				  const struct vb2_workbuf *wb)
 {
 	struct vb2_workbuf wblocal = *wb;
 	uint32_t *workbuf32;
-	uint32_t key_bytes;
-	int sig_size;
-	int pad_size;
+	uint32_t scratch_size;
 	int exp;
 	vb2_error_t rv = VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
 
 	if (!key || !sig || !digest)
 		return VB2_ERROR_RSA_VERIFY_PARAM;
 
-	sig_size = vb2_rsa_sig_size(key->sig_alg);
-	exp = vb2_rsa_exponent(key->sig_alg);
-	if (!sig_size || !exp) {
-		VB2_DEBUG("Invalid signature type!\n");
-		return VB2_ERROR_RSA_VERIFY_ALGORITHM;
-	}
-
-	/* Signature length should be same as key length */
-	key_bytes = key->arrsize * sizeof(uint32_t);
-	if (key_bytes != sig_size) {
-		VB2_DEBUG("Signature is of incorrect length!\n");
-		return VB2_ERROR_RSA_VERIFY_SIG_LEN;
-	}
+	VB2_TRY(check_verify_key(key, &exp));
 
-	workbuf32 = vb2_workbuf_alloc(&wblocal, 3 * key_bytes);
+	scratch_size = vb2_rsa_verify_scratch_size(key->sig_alg);
+	workbuf32 = vb2_workbuf_alloc(&wblocal, scratch_size);
 	if (!workbuf32) {
 		VB2_DEBUG("ERROR - vboot2 work buffer too small!\n");
 		return VB2_ERROR_RSA_VERIFY_WORKBUF;
@@ -381,32 +472,10 @@ vb2_error_t vb2_rsa_verify_digest(const struct vb2_public_key *key,
 		VB2_DEBUG("HW modexp forbidden, using SW\n");
 	}
 
-	if (rv != VB2_SUCCESS) {
-		modpow(key, sig, workbuf32, exp);
-	}
-
-	vb2_workbuf_free(&wblocal, 3 * key_bytes);
-
-	/*
-	 * Check padding.  Only fail immediately if the padding size is bad.
-	 * Otherwise, continue on to check the digest to reduce the risk of
-	 * timing based attacks.
-	 */
-	rv = vb2_check_padding(sig, key);
-	if (rv == VB2_ERROR_RSA_PADDING_SIZE)
-		return rv;
-
-	/*
-	 * Check digest.  Even though there are probably no timing issues here,
-	 * use vb2_safe_memcmp() just to be on the safe side.  (That's also why
-	 * we don't return before this check if the padding check failed.)
-	 */
-	pad_size = sig_size - vb2_digest_size(key->hash_alg);
-	if (vb2_safe_memcmp(sig + pad_size, digest, key_bytes - pad_size)) {
-		VB2_DEBUG("Digest check failed!\n");
-		if (!rv)
-			rv = VB2_ERROR_RSA_VERIFY_DIGEST;
-	}
+	/* HW modexp decrypts in place; SW leaves the signature intact */
+	if (rv == VB2_SUCCESS)
+		return check_decrypted_sig(key, sig, digest);
 
-	return rv;
+	return vb2_rsa_verify_digest_inplace(key, sig, digest,
+					     workbuf32, scratch_size);
 }
@@ -0,0 +1,216 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * SHA256 implementation using the ARMv8 Cryptography Extensions.
+ */
+#include "2common.h"
+#include "2sha.h"
+#include "2sha_private.h"
+#include "2api.h"
+
+static struct vb2_sha256_context sha_ctx;
+
+typedef uint32_t vb2_uint32x4 __attribute__ ((vector_size(16)));
+
+static inline vb2_uint32x4 vb2_loadu_u32x4(const void *ptr)
+{
+	vb2_uint32x4 result;
+	memcpy(&result, ptr, sizeof(result));
+	return result;
+}
+
+static inline vb2_uint32x4 vb2_rev32(vb2_uint32x4 value)
+{
+	asm ("rev32 %0.16b, %0.16b" : "+w"(value));
+	return value;
+}
+
+static inline vb2_uint32x4 vb2_sha256h(vb2_uint32x4 abcd, vb2_uint32x4 efgh,
+				       vb2_uint32x4 wk)
+{
+	asm ("sha256h %q0, %q1, %2.4s" : "+w"(abcd) : "w"(efgh), "w"(wk));
+	return abcd;
+}
+
+static inline vb2_uint32x4 vb2_sha256h2(vb2_uint32x4 efgh, vb2_uint32x4 abcd,
+					vb2_uint32x4 wk)
+{
+	asm ("sha256h2 %q0, %q1, %2.4s" : "+w"(efgh) : "w"(abcd), "w"(wk));
+	return efgh;
+}
+
+static inline vb2_uint32x4 vb2_sha256su0(vb2_uint32x4 w0_3, vb2_uint32x4 w4_7)
+{
+	asm ("sha256su0 %0.4s, %1.4s" : "+w"(w0_3) : "w"(w4_7));
+	return w0_3;
+}
+
+static inline vb2_uint32x4 vb2_sha256su1(vb2_uint32x4 w0_3,
+					 vb2_uint32x4 w8_11,
+					 vb2_uint32x4 w12_15)
+{
+	asm ("sha256su1 %0.4s, %1.4s, %2.4s"
+	     : "+w"(w0_3) : "w"(w8_11), "w"(w12_15));
+	return w0_3;
+}
+
+static void vb2_sha256_transform_armv8ce(const uint8_t *message,
+					 unsigned int block_nb)
+{
+	vb2_uint32x4 state0, state1, abcd_save, efgh_save;
+	vb2_uint32x4 msg[4];
+	vb2_uint32x4 wk, tmp;
+	int i, j;
+
+	state0 = vb2_loadu_u32x4(&sha_ctx.h[0]);
+	state1 = vb2_loadu_u32x4(&sha_ctx.h[4]);
+	for (i = 0; i < (int) block_nb; i++) {
+		abcd_save = state0;
+		efgh_save = state1;
+
+		for (j = 0; j < 4; j++)
+			msg[j] = vb2_rev32(vb2_loadu_u32x4(message +
+							   (i << 6) + j * 16));
+
+		/*
+		 * Each step does four rounds; while doing them, msg[j & 3]
+		 * moves on to the message schedule words for four steps later.
+		 */
+		for (j = 0; j < 16; j++) {
+			wk = msg[j & 3] + vb2_loadu_u32x4(&vb2_sha256_k[j * 4]);
+			if (j < 12) {
+				msg[j & 3] = vb2_sha256su0(msg[j & 3],
+							   msg[(j + 1) & 3]);
+				msg[j & 3] = vb2_sha256su1(msg[j & 3],
+							   msg[(j + 2) & 3],
+							   msg[(j + 3) & 3]);
+			}
+			tmp = state0;
+			state0 = vb2_sha256h(state0, state1, wk);
+			state1 = vb2_sha256h2(state1, tmp, wk);
+		}
+
+		state0 += abcd_save;
+		state1 += efgh_save;
+	}
+
+	memcpy(&sha_ctx.h[0], &state0, sizeof(state0));
+	memcpy(&sha_ctx.h[4], &state1, sizeof(state1));
+}
+
+/**
+ * Check the transform against the FIPS 180-2 "abc" known answer.
+ *
+ * @return 1 if the transform gives the right answer, 0 if not.
+ */
+static int vb2_sha256_armv8ce_selftest(void)
+{
+	static const uint32_t expect[8] = {
+		0xba7816bf, 0x8f01cfea, 0x414140de, 0x5dae2223,
+		0xb00361a3, 0x96177a9c, 0xb410ff61, 0xf20015ad,
+	};
+	uint8_t block[VB2_SHA256_BLOCK_SIZE] = {
+		'a', 'b', 'c', SHA256_PAD_BEGIN,
+		[VB2_SHA256_BLOCK_SIZE - 1] = 3 * 8,
+	};
+
+	memcpy(sha_ctx.h, vb2_sha256_h0, sizeof(sha_ctx.h));
+	vb2_sha256_transform_armv8ce(block, 1);
+
+	return !memcmp(sha_ctx.h, expect, sizeof(expect));
+}
+
+vb2_error_t vb2ex_hwcrypto_digest_init(enum vb2_hash_algorithm hash_alg,
+				       uint32_t data_size)
+{
+	/* 0 = not checked yet, 1 = good, -1 = bad */
+	static int selftest_result;
+
+	if (hash_alg != VB2_HASH_SHA256)
+		return VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
+
+	/*
+	 * If the transform ever gets a known answer wrong, stop using it so
+	 * vboot falls back to software SHA-256 instead of failing to boot.
+	 */
+	if (!selftest_result)
+		selftest_result = vb2_sha256_armv8ce_selftest() ? 1 : -1;
+	if (selftest_result < 0) {
+		VB2_DEBUG("ARMv8 SHA-256 self-test failed, using SW\n");
+		return VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
+	}
+
+	memcpy(sha_ctx.h, vb2_sha256_h0, sizeof(sha_ctx.h));
+	sha_ctx.size = 0;
+	sha_ctx.total_size = 0;
+	memset(sha_ctx.block, 0, sizeof(sha_ctx.block));
+
+	return VB2_SUCCESS;
+}
+
+vb2_error_t vb2ex_hwcrypto_digest_extend(const uint8_t *buf, uint32_t size)
+{
+	unsigned int remaining_blocks;
+	unsigned int new_size, rem_size, tmp_size;
+	const uint8_t *shifted_data;
+
+	tmp_size = VB2_SHA256_BLOCK_SIZE - sha_ctx.size;
+	rem_size = size < tmp_size ? size : tmp_size;
+
+	memcpy(&sha_ctx.block[sha_ctx.size], buf, rem_size);
+
+	if (sha_ctx.size + size < VB2_SHA256_BLOCK_SIZE) {
+		sha_ctx.size += size;
+		return VB2_SUCCESS;
+	}
+
+	new_size = size - rem_size;
+	remaining_blocks = new_size / VB2_SHA256_BLOCK_SIZE;
+
+	shifted_data = buf + rem_size;
+
+	vb2_sha256_transform_armv8ce(sha_ctx.block, 1);
+	vb2_sha256_transform_armv8ce(shifted_data, remaining_blocks);
+
+	rem_size = new_size % VB2_SHA256_BLOCK_SIZE;
+
+	memcpy(sha_ctx.block,
+	       &shifted_data[remaining_blocks * VB2_SHA256_BLOCK_SIZE],
+	       rem_size);
+
+	sha_ctx.size = rem_size;
+	sha_ctx.total_size += (remaining_blocks + 1) * VB2_SHA256_BLOCK_SIZE;
+	return VB2_SUCCESS;
+}
+
+vb2_error_t vb2ex_hwcrypto_digest_finalize(uint8_t *digest,
+					   uint32_t digest_size)
+{
+	unsigned int block_nb;
+	unsigned int pm_size;
+	unsigned int size_b;
+	unsigned int block_rem_size = sha_ctx.size % VB2_SHA256_BLOCK_SIZE;
+	int i;
+
+	if (digest_size != VB2_SHA256_DIGEST_SIZE) {
+		VB2_DEBUG("ERROR: Digest size does not match expected length.\n");
+		return VB2_ERROR_SHA_FINALIZE_DIGEST_SIZE;
+	}
+
+	block_nb = (1 + ((VB2_SHA256_BLOCK_SIZE - SHA256_MIN_PAD_LEN)
+				< block_rem_size));
+
+	size_b = (sha_ctx.total_size + sha_ctx.size) * 8;
+	pm_size = block_nb * VB2_SHA256_BLOCK_SIZE;
+
+	memset(sha_ctx.block + sha_ctx.size, 0, pm_size - sha_ctx.size);
+	sha_ctx.block[sha_ctx.size] = SHA256_PAD_BEGIN;
+	UNPACK32(size_b, sha_ctx.block + pm_size - 4);
+
+	vb2_sha256_transform_armv8ce(sha_ctx.block, block_nb);
+
+	for (i = 0; i < 8; i++)
+		UNPACK32(sha_ctx.h[i], &digest[i * 4]);
+	return VB2_SUCCESS;
+}
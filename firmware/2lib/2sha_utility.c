@@ -27,6 +27,10 @@ size_t vb2_digest_size(enum vb2_hash_algorithm hash_alg)
 		return VB2_SHA384_DIGEST_SIZE;
 	case VB2_HASH_SHA512:
 		return VB2_SHA512_DIGEST_SIZE;
+#endif
+#if VB2_SUPPORT_BLAKE3
+	case VB2_HASH_BLAKE3:
+		return VB2_BLAKE3_DIGEST_SIZE;
 #endif
 	default:
 		return 0;
@@ -49,6 +53,10 @@ size_t vb2_hash_block_size(enum vb2_hash_algorithm alg)
 	case VB2_HASH_SHA384:	/* SHA384 reuses SHA512 internal structures */
 	case VB2_HASH_SHA512:
 		return VB2_SHA512_BLOCK_SIZE;
+#endif
+#if VB2_SUPPORT_BLAKE3
+	case VB2_HASH_BLAKE3:
+		return VB2_BLAKE3_BLOCK_SIZE;
 #endif
 	default:
 		return 0;
@@ -79,6 +87,11 @@ vb2_error_t vb2_digest_init(struct vb2_digest_context *dc,
 	case VB2_HASH_SHA512:
 		vb2_sha512_init(&dc->sha512, hash_alg);
 		return VB2_SUCCESS;
+#endif
+#if VB2_SUPPORT_BLAKE3
+	case VB2_HASH_BLAKE3:
+		vb2_blake3_init(&dc->blake3);
+		return VB2_SUCCESS;
 #endif
 	default:
 		return VB2_ERROR_SHA_INIT_ALGORITHM;
@@ -106,6 +119,11 @@ vb2_error_t vb2_digest_extend(struct vb2_digest_context *dc, const uint8_t *buf,
 	case VB2_HASH_SHA512:
 		vb2_sha512_update(&dc->sha512, buf, size);
 		return VB2_SUCCESS;
+#endif
+#if VB2_SUPPORT_BLAKE3
+	case VB2_HASH_BLAKE3:
+		vb2_blake3_update(&dc->blake3, buf, size);
+		return VB2_SUCCESS;
 #endif
 	default:
 		return VB2_ERROR_SHA_EXTEND_ALGORITHM;
@@ -136,6 +154,11 @@ vb2_error_t vb2_digest_finalize(struct vb2_digest_context *dc, uint8_t *digest,
 	case VB2_HASH_SHA512:
 		vb2_sha512_finalize(&dc->sha512, digest, dc->hash_alg);
 		return VB2_SUCCESS;
+#endif
+#if VB2_SUPPORT_BLAKE3
+	case VB2_HASH_BLAKE3:
+		vb2_blake3_finalize(&dc->blake3, digest);
+		return VB2_SUCCESS;
 #endif
 	default:
 		return VB2_ERROR_SHA_FINALIZE_ALGORITHM;
@@ -164,6 +164,16 @@ uint32_t vb2_kernel_get_flags(const struct vb2_kernel_preamble *preamble)
 	return preamble->flags;
 }
 
+uint32_t vb2_kernel_get_body_chunk_size(
+	const struct vb2_kernel_preamble *preamble)
+{
+	uint32_t shift = (vb2_kernel_get_flags(preamble) &
+			  VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_MASK) >>
+		VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_SHIFT;
+
+	return shift ? 1U << shift : 0;
+}
+
 test_mockable
 vb2_error_t vb2_verify_keyblock_hash(const struct vb2_keyblock *block,
 				     uint32_t size,
@@ -312,6 +322,14 @@ vb2_error_t vb2_verify_kernel_preamble(struct vb2_kernel_preamble *preamble,
 		}
 	}
 
+	/* Tree-hashed body chunks must not be uselessly small */
+	if (vb2_kernel_get_body_chunk_size(preamble) &&
+	    vb2_kernel_get_body_chunk_size(preamble) <
+	    (1U << VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_MIN)) {
+		VB2_DEBUG("Body chunk size too small\n");
+		return VB2_ERROR_PREAMBLE_BODY_CHUNK_SIZE;
+	}
+
 	/* Success */
 	return VB2_SUCCESS;
 }
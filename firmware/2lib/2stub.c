@@ -54,6 +54,15 @@ vb2_error_t vb2ex_read_resource(struct vb2_context *ctx,
 	return VB2_ERROR_EX_UNIMPLEMENTED;
 }
 
+__attribute__((weak))
+vb2_error_t vb2ex_map_resource(struct vb2_context *ctx,
+			       enum vb2_resource_index index,
+			       const void **buf_ptr, uint32_t *size_ptr)
+{
+	/* Optional; callers fall back to vb2ex_read_resource() */
+	return VB2_ERROR_EX_UNIMPLEMENTED;
+}
+
 /*****************************************************************************/
 /* TPM-related stubs */
 
@@ -7,7 +7,7 @@
 
 #include "2api.h"
 
-#ifndef X86_SHA_EXT
+#if !defined(X86_SHA_EXT) && !defined(ARMV8_SHA_EXT)
 __attribute__((weak))
 vb2_error_t vb2ex_hwcrypto_digest_init(enum vb2_hash_algorithm hash_alg,
 				       uint32_t data_size)
@@ -41,3 +41,12 @@ vb2_error_t vb2ex_hwcrypto_modexp(const struct vb2_public_key *key,
 				  uint8_t *inout, uint32_t *workbuf32, int exp) {
 	return VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
 }
+
+__attribute__((weak))
+vb2_error_t vb2ex_hwcrypto_digest_chunks(enum vb2_hash_algorithm hash_alg,
+					 const uint8_t *buf, uint32_t size,
+					 uint32_t chunk_size, uint8_t *digests,
+					 uint32_t digests_size)
+{
+	return VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
+}
@@ -1022,6 +1022,32 @@ vb2_error_t vb2ex_read_resource(struct vb2_context *ctx,
 				enum vb2_resource_index index, uint32_t offset,
 				void *buf, uint32_t size);
 
+/**
+ * Map a verified boot resource for reading in place.
+ *
+ * Optional; platforms where the resource is already addressable (for example,
+ * memory-mapped SPI flash) can implement this so vboot copies structures out
+ * of it in one piece instead of reading them with vb2ex_read_resource().
+ *
+ * Flash contents can change between reads, so anything vboot verifies is
+ * copied to the work buffer first, and only the copy is checked and used.
+ * The GBB root key is the only data used straight from the mapping; it is
+ * trusted as it stands, not verified.
+ *
+ * The mapping must stay valid until vboot is done with the context.  vboot
+ * never writes through the mapping.
+ *
+ * @param ctx		Vboot context
+ * @param index		Resource index to map
+ * @param buf_ptr	On success, points to the start of the resource
+ * @param size_ptr	On success, size of the resource in bytes
+ * @return VB2_SUCCESS, or non-zero error code if the resource can't be mapped
+ * (vboot then falls back to vb2ex_read_resource()).
+ */
+vb2_error_t vb2ex_map_resource(struct vb2_context *ctx,
+			       enum vb2_resource_index index,
+			       const void **buf_ptr, uint32_t *size_ptr);
+
 /**
  * Print debug output.
  *
@@ -1071,7 +1097,7 @@ vb2_error_t vb2ex_hwcrypto_digest_finalize(uint8_t *digest,
  * against an expected hash digest.
  *
  * @param key		Key to use in signature verification
- * @param sig		Signature to verify (destroyed in process)
+ * @param sig		Signature to verify
  * @param digest	Digest of signed data
  * @return VB2_SUCCESS, or non-zero error code (HWCRYPTO_UNSUPPORTED not fatal).
  */
@@ -1093,6 +1119,27 @@ vb2_error_t vb2ex_hwcrypto_modexp(const struct vb2_public_key *key,
 				  uint8_t *inout,
 				  uint32_t *workbuf32, int exp);
 
+/**
+ * Calculate the digests of a run of equal-sized chunks of data.
+ *
+ * Used for tree-hashed kernel bodies.  The chunks are independent, so an
+ * implementation may hash them in parallel (multiple cores, or a crypto
+ * engine with several queues).  The last chunk may be shorter than
+ * chunk_size.
+ *
+ * @param hash_alg	Hash algorithm to use
+ * @param buf		Data to hash
+ * @param size		Length of data in bytes
+ * @param chunk_size	Size of each chunk in bytes
+ * @param digests	Destination for the chunk digests, one after another
+ * @param digests_size	Length of digests buffer in bytes
+ * @return VB2_SUCCESS, or non-zero error code (HWCRYPTO_UNSUPPORTED not fatal).
+ */
+vb2_error_t vb2ex_hwcrypto_digest_chunks(enum vb2_hash_algorithm hash_alg,
+					 const uint8_t *buf, uint32_t size,
+					 uint32_t chunk_size, uint8_t *digests,
+					 uint32_t digests_size);
+
 /*
  * Abort vboot flow due to a failed assertion or broken assumption.
  *
@@ -1174,6 +1221,46 @@ uint32_t vb2ex_tpm_send_recv(const uint8_t *request, uint32_t request_length,
  */
 vb2_error_t vb2ex_tpm_get_random(uint8_t *buf, uint32_t length);
 
+/**
+ * Start sending a request to the TPM without waiting for the response.
+ *
+ * This lets the caller do other work while the TPM executes a slow command.
+ * Only one request may be outstanding, and it must be finished with
+ * vb2ex_tpm_collect() before any other TPM command is sent.
+ *
+ * @param request		Pointer to request buffer
+ * @param request_length	Number of bytes to send
+ * @return TPM_SUCCESS, or non-zero if error.
+ */
+uint32_t vb2ex_tpm_submit(const uint8_t *request, uint32_t request_length);
+
+/**
+ * Get a file descriptor which polls readable (POLLIN) once the response to the
+ * outstanding request is ready, for use with poll() or epoll.
+ *
+ * @return File descriptor, or -1 if no request is outstanding.
+ */
+int vb2ex_tpm_poll_fd(void);
+
+/**
+ * Wait for the response to the outstanding request.
+ *
+ * @param timeout_ms	Milliseconds to wait; 0 only checks, -1 waits forever
+ * @return 1 if vb2ex_tpm_collect() will not block, 0 if not.
+ */
+int vb2ex_tpm_poll(int timeout_ms);
+
+/**
+ * Receive the response to the request sent by vb2ex_tpm_submit(), waiting for
+ * it if needed.
+ *
+ * @param response		Pointer to response buffer
+ * @param response_length	Size of response buffer; on return,
+ * 				set to number of received bytes
+ * @return TPM_SUCCESS, or non-zero if error.
+ */
+uint32_t vb2ex_tpm_collect(uint8_t *response, uint32_t *response_length);
+
 #endif  /* CHROMEOS_ENVIRONMENT */
 
 /* Modes for vb2ex_tpm_set_mode. */
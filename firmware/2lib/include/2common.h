@@ -256,6 +256,20 @@ const struct vb2_id *vb2_hash_id(enum vb2_hash_algorithm hash_alg);
  */
 #define VB2_VERIFY_KERNEL_PREAMBLE_WORKBUF_BYTES VB2_VERIFY_DATA_WORKBUF_BYTES
 
+/* Number of chunk digests vb2_tree_digest() collects per batch. */
+#define VB2_TREE_HASH_BATCH 32
+
+/* Size of work buffer sufficient for vb2_tree_digest() worst case. */
+#define VB2_TREE_DIGEST_WORKBUF_BYTES					\
+	(sizeof(struct vb2_digest_context) +				\
+	 VB2_TREE_HASH_BATCH * VB2_SHA512_DIGEST_SIZE)
+
+/* Size of work buffer sufficient for vb2_verify_data_tree() worst case. */
+#define VB2_VERIFY_DATA_TREE_WORKBUF_BYTES				\
+	(VB2_SHA512_DIGEST_SIZE +					\
+	 VB2_MAX(VB2_VERIFY_DIGEST_WORKBUF_BYTES,			\
+		 VB2_TREE_DIGEST_WORKBUF_BYTES))
+
 /**
  * Verify the data pointed to by a subfield is inside the parent data.
  *
@@ -371,7 +385,7 @@ vb2_error_t vb2_verify_digest(const struct vb2_public_key *key,
  * @param data		Data to verify
  * @param size		Size of data buffer.  Note that amount of data to
  *			actually validate is contained in sig->data_size.
- * @param sig		Signature of data (destroyed in process)
+ * @param sig		Signature of data (may be destroyed in process)
  * @param key		Key to use to validate signature
  * @param wb		Work buffer
  * @return VB2_SUCCESS, or non-zero error code if error.
@@ -381,6 +395,52 @@ vb2_error_t vb2_verify_data(const uint8_t *data, uint32_t size,
 			    const struct vb2_public_key *key,
 			    const struct vb2_workbuf *wb);
 
+/**
+ * Calculate the tree digest of a buffer.
+ *
+ * The buffer is split into chunk_size chunks (the last one may be short),
+ * each chunk is hashed, and the result is the hash of the concatenated chunk
+ * digests.  All hashes use hash_alg.  Chunks are handed to
+ * vb2ex_hwcrypto_digest_chunks() in batches if allow_hwcrypto is set, so
+ * the platform can hash them in parallel.
+ *
+ * @param data		Data to hash
+ * @param size		Size of data in bytes
+ * @param chunk_size	Chunk size in bytes; must be non-zero
+ * @param hash_alg	Hash algorithm
+ * @param allow_hwcrypto	Try the platform chunk hashing hook first
+ * @param digest	Destination for digest
+ * @param digest_size	Length of digest buffer in bytes
+ * @param wb		Work buffer
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t vb2_tree_digest(const uint8_t *data, uint32_t size,
+			    uint32_t chunk_size,
+			    enum vb2_hash_algorithm hash_alg,
+			    int allow_hwcrypto, uint8_t *digest,
+			    uint32_t digest_size, const struct vb2_workbuf *wb);
+
+/**
+ * Verify tree-hashed data matches signature.
+ *
+ * Like vb2_verify_data(), but the signature is over the vb2_tree_digest() of
+ * the data instead of its flat digest.
+ *
+ * @param data		Data to verify
+ * @param size		Size of data buffer.  Note that amount of data to
+ *			actually validate is contained in sig->data_size.
+ * @param sig		Signature of data (may be destroyed in process)
+ * @param key		Key to use to validate signature
+ * @param chunk_size	Chunk size the data was signed with
+ * @param wb		Work buffer
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t vb2_verify_data_tree(const uint8_t *data, uint32_t size,
+				 struct vb2_signature *sig,
+				 const struct vb2_public_key *key,
+				 uint32_t chunk_size,
+				 const struct vb2_workbuf *wb);
+
 /**
  * Check the validity of a keyblock structure.
  *
@@ -400,7 +460,7 @@ vb2_error_t vb2_check_keyblock(const struct vb2_keyblock *block, uint32_t size,
  * Verify a keyblock using a public key.
  *
  * Header fields are also checked for validity. Does not verify key index or key
- * block flags.  Signature inside block is destroyed during check.
+ * block flags.  Signature inside block may be destroyed during check.
  *
  * @param block		Keyblock to verify
  * @param size		Size of keyblock buffer
@@ -415,7 +475,7 @@ vb2_error_t vb2_verify_keyblock(struct vb2_keyblock *block, uint32_t size,
 /**
  * Check the validity of a firmware preamble using a public key.
  *
- * The signature in the preamble is destroyed during the check.
+ * The signature in the preamble may be destroyed during the check.
  *
  * @param preamble     	Preamble to verify
  * @param size		Size of preamble buffer
@@ -436,6 +496,16 @@ vb2_error_t vb2_verify_fw_preamble(struct vb2_fw_preamble *preamble,
  */
 uint32_t vb2_kernel_get_flags(const struct vb2_kernel_preamble *preamble);
 
+/**
+ * Get the body chunk size for the kernel preamble.
+ *
+ * @param preamble	Preamble to check
+ * @return Chunk size in bytes the body was tree-hashed with, or 0 if the body
+ *	   signature is over a flat digest of the body.
+ */
+uint32_t vb2_kernel_get_body_chunk_size(
+	const struct vb2_kernel_preamble *preamble);
+
 /**
  * Verify a keyblock using its hash.
  *
@@ -455,7 +525,7 @@ vb2_error_t vb2_verify_keyblock_hash(const struct vb2_keyblock *block,
 /**
  * Check the validity of a kernel preamble using a public key.
  *
- * The signature in the preamble is destroyed during the check.
+ * The signature in the preamble may be destroyed during the check.
  *
  * @param preamble     	Preamble to verify
  * @param size		Size of preamble buffer
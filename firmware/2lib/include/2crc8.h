@@ -10,6 +10,15 @@
 
 #include "2sysincludes.h"
 
+/*
+ * Implementation used by vb2_crc8(), set by the CRC8_TABLE build option:
+ * 0 = bit at a time (smallest), 4 = 16-byte nibble table, 8 = 256-byte table
+ * (fastest).
+ */
+#ifndef VB2_CRC8_TABLE
+#define VB2_CRC8_TABLE 0
+#endif
+
 /**
  * Calculate CRC-8 of the data, using the ITU version.
  *
@@ -23,4 +32,13 @@
  */
 uint8_t vb2_crc8(const void *data, uint32_t size);
 
+/*
+ * The individual implementations behind vb2_crc8(), for tests and
+ * benchmarks.  They all return the same value as vb2_crc8().  Unused ones are
+ * dropped from the firmware by the linker.
+ */
+uint8_t vb2_crc8_bitwise(const void *data, uint32_t size);
+uint8_t vb2_crc8_nibble(const void *data, uint32_t size);
+uint8_t vb2_crc8_byte(const void *data, uint32_t size);
+
 #endif  /* VBOOT_REFERENCE_2CRC8_H_ */
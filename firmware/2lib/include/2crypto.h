@@ -75,13 +75,16 @@ enum vb2_hash_algorithm {
 	VB2_HASH_SHA224 = 4,
 	VB2_HASH_SHA384 = 5,
 
+	/* BLAKE3, with the default 256-bit output. */
+	VB2_HASH_BLAKE3 = 6,
+
 	/* Last index. Don't add anything below. */
 	VB2_HASH_ALG_COUNT,
 };
 
 /* Arrays mapping signature/hash types to their string representations. */
-extern const char *vb2_sig_names[VB2_SIG_ALG_COUNT];
-extern const char *vb2_hash_names[VB2_HASH_ALG_COUNT];
+extern const char *const vb2_sig_names[VB2_SIG_ALG_COUNT];
+extern const char *const vb2_hash_names[VB2_HASH_ALG_COUNT];
 
 /**
  * Convert vb2_crypto_algorithm to vb2_signature_algorithm.
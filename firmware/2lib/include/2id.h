@@ -29,6 +29,7 @@ struct vb2_id {
 #define VB2_ID_NONE_SHA1   {{0x00, 0x01,}}
 #define VB2_ID_NONE_SHA256 {{0x02, 0x56,}}
 #define VB2_ID_NONE_SHA512 {{0x05, 0x12,}}
+#define VB2_ID_NONE_BLAKE3 {{0xb1, 0xa3,}}
 
 #ifdef __cplusplus
 }
@@ -66,6 +66,23 @@ void vb2_workbuf_from_ctx(struct vb2_context *ctx, struct vb2_workbuf *wb);
  */
 void vb2_set_workbuf_used(struct vb2_context *ctx, uint32_t used);
 
+/**
+ * Map part of a resource for reading in place.
+ *
+ * Uses vb2ex_map_resource(), and checks the requested range is inside the
+ * mapping and aligned well enough to parse structures from.
+ *
+ * @param ctx		Vboot context
+ * @param index		Resource index to map
+ * @param offset	Byte offset within resource
+ * @param size		Number of bytes needed
+ * @return A read-only pointer to the data, or NULL if it can't be mapped; the
+ * caller should then read it with vb2ex_read_resource().
+ */
+const void *vb2_map_resource(struct vb2_context *ctx,
+			     enum vb2_resource_index index,
+			     uint32_t offset, uint32_t size);
+
 /**
  * Read the GBB header.
  *
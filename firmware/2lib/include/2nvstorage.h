@@ -127,6 +127,11 @@ enum vb2_nv_param {
 	VB2_NV_DIAG_REQUEST,
 	/* Priority of miniOS partition to load: 0=MINIOS-A, 1=MINIOS-B. */
 	VB2_NV_MINIOS_PRIORITY,
+	/*
+	 * Partition number (1...255) of the kernel last booted from the
+	 * fixed disk, used as a scan hint by LoadKernel().  0=none.
+	 */
+	VB2_NV_KERNEL_LAST_GOOD_PARTITION,
 };
 
 /* Firmware result codes for VB2_NV_FW_RESULT and VB2_NV_FW_PREV_RESULT */
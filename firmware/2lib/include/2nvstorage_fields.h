@@ -49,6 +49,7 @@ enum vb2_nv_offset {
 	VB2_NV_OFFS_FW_MAX_ROLLFORWARD2 = 17, /* bits 8-15 of 32 */
 	VB2_NV_OFFS_FW_MAX_ROLLFORWARD3 = 18, /* bits 16-23 of 32 */
 	VB2_NV_OFFS_FW_MAX_ROLLFORWARD4 = 19, /* bits 24-31 of 32 */
+	VB2_NV_OFFS_KERNEL_LAST_GOOD = 20,
 
 	/* CRC must be last field */
 	VB2_NV_OFFS_CRC_V2 = 63,
@@ -357,6 +357,12 @@ enum vb2_return_code {
 	/* Null public key buffer passed to vb2_unpack_key_buffer() */
 	VB2_ERROR_UNPACK_KEY_BUFFER,
 
+	/* Bad chunk size in vb2_tree_digest() */
+	VB2_ERROR_VDATA_CHUNK_SIZE,
+
+	/* Not enough work buffer for chunk digests in vb2_tree_digest() */
+	VB2_ERROR_VDATA_WORKBUF_CHUNKS,
+
 	/**********************************************************************
 	 * Keyblock verification errors (all in vb2_verify_keyblock())
 	 */
@@ -448,6 +454,9 @@ enum vb2_return_code {
 	/* Vmlinuz header outside signed portion of body */
 	VB2_ERROR_PREAMBLE_VMLINUZ_HEADER_OUTSIDE,
 
+	/* Body chunk size in flags is too small */
+	VB2_ERROR_PREAMBLE_BODY_CHUNK_SIZE,
+
 	/**********************************************************************
 	 * Misc higher-level code errors
 	 */
@@ -623,6 +632,24 @@ enum vb2_return_code {
 	 */
 	VB2_ERROR_KERNEL_KEYBLOCK_MINIOS_FLAG = 0x10080035,
 
+	/* Keyblock runs past end of mapped vblock in vb2_load_fw_keyblock() */
+	VB2_ERROR_FW_KEYBLOCK_MAP = 0x10080036,
+
+	/* Preamble runs past end of mapped vblock in vb2_load_fw_preamble() */
+	VB2_ERROR_FW_PREAMBLE2_MAP = 0x10080037,
+
+	/*
+	 * Keyblock runs past end of mapped vblock in
+	 * vb2_load_kernel_keyblock().
+	 */
+	VB2_ERROR_KERNEL_KEYBLOCK_MAP = 0x10080038,
+
+	/*
+	 * Preamble runs past end of mapped vblock in
+	 * vb2_load_kernel_preamble().
+	 */
+	VB2_ERROR_KERNEL_PREAMBLE2_MAP = 0x10080039,
+
 	/**********************************************************************
 	 * API-level errors
 	 */
@@ -849,6 +876,21 @@ enum vb2_return_code {
 	/* cbfstool exited with failure status */
 	VB2_ERROR_CBFSTOOL,
 
+	/* Malformed CBFS entry in cbfs_region_*() */
+	VB2_ERROR_CBFS_CORRUPT,
+
+	/* File not found in cbfs_region_*() */
+	VB2_ERROR_CBFS_NOT_FOUND,
+
+	/* File is compressed in cbfs_region_find() */
+	VB2_ERROR_CBFS_COMPRESSED,
+
+	/* File already exists in cbfs_region_add_raw() */
+	VB2_ERROR_CBFS_EXISTS,
+
+	/* File does not fit at the requested offset in cbfs_region_add_raw() */
+	VB2_ERROR_CBFS_NO_SPACE,
+
 	/**********************************************************************
 	 * Errors generated by host library key functions
 	 */
@@ -950,6 +992,24 @@ enum vb2_return_code {
 	/* Packed key with invalid version */
 	VB2_ERROR_PACKED_KEY_VERSION,
 
+	/* Unable to read or unpack key in vb21_keyring_private_key_read() */
+	VB2_ERROR_KEYRING_READ,
+
+	/* Host library was built without PKCS#11 support */
+	VB2_ERROR_PKCS11_UNSUPPORTED,
+
+	/* Unable to load PKCS#11 module in pkcs11_get_key() */
+	VB2_ERROR_PKCS11_LOAD,
+
+	/* Unable to open or log in to session in pkcs11_get_key() */
+	VB2_ERROR_PKCS11_SESSION,
+
+	/* Unable to find private key in pkcs11_get_key() */
+	VB2_ERROR_PKCS11_FIND_KEY,
+
+	/* C_Sign() failed in pkcs11_sign() */
+	VB2_ERROR_PKCS11_SIGN,
+
 	/**********************************************************************
 	 * Errors generated by host library signature functions
 	 */
@@ -1030,6 +1090,67 @@ enum vb2_return_code {
 	/* Unable to open an input file needed for a unit test */
 	VB2_ERROR_TEST_INPUT_FILE,
 
+	/**********************************************************************
+	 * Errors generated by the host API in vboot_host_api.h
+	 */
+	VB2_ERROR_HOST_API = VB2_ERROR_HOST_BASE + 0x070000,
+
+	/* Unable to allocate memory */
+	VB2_ERROR_HOST_API_ALLOC,
+
+	/* Not a valid public key */
+	VB2_ERROR_HOST_API_PUBLIC_KEY,
+
+	/* Unable to load private key */
+	VB2_ERROR_HOST_API_PRIVATE_KEY,
+
+	/* Key is the wrong kind (public or private) for the operation */
+	VB2_ERROR_HOST_API_KEY_TYPE,
+
+	/* Kernel partition too small to hold its keyblock and preamble */
+	VB2_ERROR_HOST_API_KERNEL_SIZE,
+
+	/* Kernel body is outside the kernel partition */
+	VB2_ERROR_HOST_API_KERNEL_BODY,
+
+	/* New keyblock and preamble don't fit in front of the kernel body */
+	VB2_ERROR_HOST_API_VBLOCK_SIZE,
+
+	/* Unable to sign kernel body */
+	VB2_ERROR_HOST_API_SIGN_BODY,
+
+	/* Unable to create kernel preamble */
+	VB2_ERROR_HOST_API_SIGN_PREAMBLE,
+
+	/* Disk image is not a whole number of sectors */
+	VB2_ERROR_HOST_API_GPT_SIZE,
+
+	/* Neither GPT is valid */
+	VB2_ERROR_HOST_API_GPT_INVALID,
+
+	/* GPT entry index out of range */
+	VB2_ERROR_HOST_API_GPT_INDEX,
+
+	/**********************************************************************
+	 * Errors generated by the VPD parser in host/lib/vpd.c
+	 */
+	VB2_ERROR_VPD = VB2_ERROR_HOST_BASE + 0x080000,
+
+	/* Unable to allocate memory */
+	VB2_ERROR_VPD_ALLOC,
+
+	/* VPD section not found in the firmware image */
+	VB2_ERROR_VPD_SECTION,
+
+	/* gVpdInfo header claims more data than the section holds */
+	VB2_ERROR_VPD_INFO_SIZE,
+
+	/* Entry of an unknown type */
+	VB2_ERROR_VPD_TYPE,
+
+	/* Entry runs past the end of the VPD data */
+	VB2_ERROR_VPD_TRUNCATED,
+
 	/**********************************************************************
 	 * Highest non-zero error generated inside vboot library.  Note that
 	 * error codes passed through vboot when it calls external APIs may
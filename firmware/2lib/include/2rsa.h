@@ -41,6 +41,14 @@ uint32_t vb2_rsa_sig_size(enum vb2_signature_algorithm sig_alg);
  */
 uint32_t vb2_packed_key_size(enum vb2_signature_algorithm sig_alg);
 
+/**
+ * Return the size of scratch space needed to verify a RSA signature.
+ *
+ * @param sig_alg	Signature algorithm
+ * @return The size of the scratch space in bytes, or 0 if error.
+ */
+uint32_t vb2_rsa_verify_scratch_size(enum vb2_signature_algorithm sig_alg);
+
 /* Size of work buffer sufficient for vb2_rsa_verify_digest() worst case */
 #define VB2_VERIFY_RSA_DIGEST_WORKBUF_BYTES (3 * 1024)
 
@@ -48,7 +56,8 @@ uint32_t vb2_packed_key_size(enum vb2_signature_algorithm sig_alg);
  * Verify a RSA PKCS1.5 signature against an expected hash digest.
  *
  * @param key		Key to use in signature verification
- * @param sig		Signature to verify (destroyed in process)
+ * @param sig		Signature to verify (destroyed in process if hardware
+ *			modexp is used)
  * @param digest	Digest of signed data
  * @param wb		Work buffer
  * @return VB2_SUCCESS, or non-zero if error.
@@ -57,4 +66,25 @@ vb2_error_t vb2_rsa_verify_digest(const struct vb2_public_key *key,
 				  uint8_t *sig, const uint8_t *digest,
 				  const struct vb2_workbuf *wb);
 
+/**
+ * Verify a RSA PKCS1.5 signature without modifying or copying it.
+ *
+ * Exponentiation reads straight from the signature and writes its result into
+ * the caller-supplied scratch area, where padding and digest are checked.
+ * This never uses vb2ex_hwcrypto_modexp(), since that works in place on its
+ * input; use vb2_rsa_verify_digest() to allow hardware acceleration.
+ *
+ * @param key		Key to use in signature verification
+ * @param sig		Signature to verify (left intact)
+ * @param digest	Digest of signed data
+ * @param scratch	Scratch area, aligned to at least 4 bytes
+ * @param scratch_size	Size of scratch area in bytes; must be at least
+ *			vb2_rsa_verify_scratch_size(key->sig_alg).
+ * @return VB2_SUCCESS, or non-zero if error.
+ */
+vb2_error_t vb2_rsa_verify_digest_inplace(const struct vb2_public_key *key,
+					  const uint8_t *sig,
+					  const uint8_t *digest,
+					  void *scratch, uint32_t scratch_size);
+
 #endif  /* VBOOT_REFERENCE_2RSA_H_ */
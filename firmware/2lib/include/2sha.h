@@ -28,6 +28,11 @@
 #define VB2_SUPPORT_SHA512 1
 #endif
 
+/* BLAKE3 makes struct vb2_digest_context much bigger, so it is opt-in. */
+#ifndef VB2_SUPPORT_BLAKE3
+#define VB2_SUPPORT_BLAKE3 0
+#endif
+
 /* These are set to the biggest values among the supported hash algorithms.
  * They have to be updated as we add new hash algorithms */
 #define VB2_MAX_DIGEST_SIZE	VB2_SHA512_DIGEST_SIZE
@@ -75,6 +80,29 @@ struct vb2_sha512_context {
 	uint8_t block[2 * VB2_SHA512_BLOCK_SIZE];
 };
 
+#define VB2_BLAKE3_DIGEST_SIZE 32
+#define VB2_BLAKE3_BLOCK_SIZE 64
+#define VB2_BLAKE3_CHUNK_SIZE 1024
+#define VB2_BLAKE3_ALG_NAME	"BLAKE3"
+
+/*
+ * BLAKE3 hashes the input as 1 KiB chunks, which are the leaves of a binary
+ * tree of chaining values.  The stack keeps the root of every complete subtree
+ * not yet merged into a parent; one entry per bit of the chunk count, so this
+ * is enough for 2^32 chunks (4 TiB).
+ */
+#define VB2_BLAKE3_MAX_DEPTH 32
+
+struct vb2_blake3_context {
+	uint32_t cv[8];
+	uint64_t chunk_counter;
+	uint32_t blocks_compressed;
+	uint32_t block_len;
+	uint8_t block[VB2_BLAKE3_BLOCK_SIZE];
+	uint32_t cv_stack_len;
+	uint32_t cv_stack[VB2_BLAKE3_MAX_DEPTH][8];
+};
+
 /*
  * SHA224/SHA384 are variants of SHA256/SHA512 that use almost all the same code
  * (and the same context structures), so no separate "SUPPORT" flags for them.
@@ -96,6 +124,9 @@ struct vb2_digest_context {
 #endif
 #if VB2_SUPPORT_SHA512
 		struct vb2_sha512_context sha512;
+#endif
+#if VB2_SUPPORT_BLAKE3
+		struct vb2_blake3_context blake3;
 #endif
 	};
 
@@ -131,6 +162,9 @@ struct vb2_hash {
 #endif
 #if VB2_SUPPORT_SHA512
 		uint8_t sha512[VB2_SHA512_DIGEST_SIZE];
+#endif
+#if VB2_SUPPORT_BLAKE3
+		uint8_t blake3[VB2_BLAKE3_DIGEST_SIZE];
 #endif
 	};
 };
@@ -149,6 +183,7 @@ void vb2_sha256_init(struct vb2_sha256_context *ctx,
 		     enum vb2_hash_algorithm algo);
 void vb2_sha512_init(struct vb2_sha512_context *ctx,
 		     enum vb2_hash_algorithm algo);
+void vb2_blake3_init(struct vb2_blake3_context *ctx);
 
 /**
  * Update (extend) a hash.
@@ -166,6 +201,9 @@ void vb2_sha256_update(struct vb2_sha256_context *ctx,
 void vb2_sha512_update(struct vb2_sha512_context *ctx,
 		       const uint8_t *data,
 		       uint32_t size);
+void vb2_blake3_update(struct vb2_blake3_context *ctx,
+		       const uint8_t *data,
+		       uint32_t size);
 
 /**
  * Finalize a hash digest.
@@ -179,6 +217,7 @@ void vb2_sha256_finalize(struct vb2_sha256_context *ctx, uint8_t *digest,
 			 enum vb2_hash_algorithm algo);
 void vb2_sha512_finalize(struct vb2_sha512_context *ctx, uint8_t *digest,
 			 enum vb2_hash_algorithm algo);
+void vb2_blake3_finalize(struct vb2_blake3_context *ctx, uint8_t *digest);
 
 /**
  * Hash-extend data
@@ -35,4 +35,31 @@ extern const uint32_t vb2_sha256_k[64];
 			| ((uint32_t) *((str) + 1) << 16)       \
 			| ((uint32_t) *((str) + 0) << 24);      \
 	}
+
+/* BLAKE3 compression flags */
+#define BLAKE3_CHUNK_START	(1 << 0)
+#define BLAKE3_CHUNK_END	(1 << 1)
+#define BLAKE3_PARENT		(1 << 2)
+#define BLAKE3_ROOT		(1 << 3)
+
+/* Most chunks vb2_blake3_hash_chunks() is asked to hash at once */
+#define BLAKE3_MAX_CHUNKS 4
+
+extern const uint32_t vb2_blake3_iv[8];
+extern const uint8_t vb2_blake3_msg_schedule[7][16];
+
+/**
+ * Hash whole BLAKE3 chunks, none of which is the root of the tree.
+ *
+ * The portable version hashes one chunk after another; building with
+ * BLAKE3_SIMD=1 replaces it with one hashing the chunks in parallel.
+ *
+ * @param input		Whole chunks to hash, back to back
+ * @param num_chunks	Number of chunks, at most BLAKE3_MAX_CHUNKS
+ * @param chunk_counter	Index of the first chunk in the input stream
+ * @param cvs		Destination for the chaining value of each chunk
+ */
+void vb2_blake3_hash_chunks(const uint8_t *input, uint32_t num_chunks,
+			    uint64_t chunk_counter, uint32_t cvs[][8]);
+
 #endif  /* VBOOT_REFERENCE_2SHA_PRIVATE_H_ */
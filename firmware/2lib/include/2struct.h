@@ -508,6 +508,15 @@ _Static_assert(EXPECTED_VB2_FW_PREAMBLE_SIZE == sizeof(struct vb2_fw_preamble),
 #define VB2_KERNEL_PREAMBLE_KERNEL_TYPE_BOOTIMG   1
 #define VB2_KERNEL_PREAMBLE_KERNEL_TYPE_MULTIBOOT 2
 /* Kernel type 3 is reserved for future use */
+/*
+ * Body chunk size = bits 6:2, as log2 of the size in bytes.  Zero means the
+ * body signature covers a flat digest of the body; otherwise it covers the
+ * tree digest (see vb2_tree_digest()) with chunks of that size.
+ */
+#define VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_MASK 0x0000007c
+#define VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_SHIFT 2
+/* Smallest body chunk size accepted, as log2 */
+#define VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_MIN 12
 
 /*
  * Preamble block for kernel, version 2.2
@@ -586,7 +595,8 @@ struct vb2_kernel_preamble {
 	/*
 	 * Flags; see VB2_KERNEL_PREAMBLE_*.  Readers should return 0 for
 	 * header version < 2.2.  Flags field is currently defined as:
-	 * [31:2] - Reserved (for future use)
+	 * [31:7] - Reserved (for future use)
+	 * [6:2]  - log2 of body chunk size, or 0 for a flat body digest
 	 * [1:0]  - Kernel image type (0b00 - CrOS,
 	 *                             0b01 - bootimg,
 	 *                             0b10 - multiboot)
@@ -68,6 +68,14 @@ enum {
 
 /* If this bit is 1, the GPT is stored in another from the streaming data */
 #define GPT_FLAG_EXTERNAL	0x1
+/*
+ * If this bit is 1, AllocAndReadGptData() only reads the secondary GPT if the
+ * primary GPT is not valid.  Otherwise the secondary GPT is assumed to match
+ * the primary, and is only regenerated and written if the GPT is modified.  A
+ * damaged secondary GPT is not repaired while this bit is set, so callers
+ * should leave it clear every so often.
+ */
+#define GPT_FLAG_LAZY_SECONDARY	0x2
 
 /*
  * A note about stored_on_device and gpt_drive_sectors:
@@ -113,6 +121,8 @@ typedef struct {
 
 	/* Internal variables */
 	uint8_t valid_headers, valid_entries, ignored;
+	/* Which copies were not read from the drive (GPT_FLAG_LAZY_SECONDARY) */
+	uint8_t deferred;
 	int current_priority;
 } GptData;
 
@@ -125,6 +125,17 @@ uint32_t TlclRead(uint32_t index, void *data, uint32_t length);
  */
 uint32_t TlclPCRRead(uint32_t index, void *data, uint32_t length);
 
+/**
+ * Read the PCRs set in [pcr_mask] from [bank] (TPM_ALG_SHA1 or, on TPM2,
+ * TPM_ALG_SHA256) into [data], one digest after another in PCR order.  The
+ * digest size of the bank is stored in [digest_size]; [length] must be at
+ * least that times the number of PCRs read.  On TPM2 this takes as few
+ * TPM2_PCR_Read commands as the responses allow.  The TPM error code is
+ * returned.
+ */
+uint32_t TlclPCRReadMultiple(uint32_t pcr_mask, uint16_t bank, void *data,
+			     uint32_t length, uint32_t *digest_size);
+
 /**
  * Write-lock space at [index].  The TPM error code is returned.
  */
@@ -284,6 +295,31 @@ uint32_t TlclUndefineSpaceEx(const uint8_t* owner_auth,
 			     uint32_t owner_auth_size,
 			     uint32_t index);
 
+/**
+ * Start a raw TPM request without waiting for the response, so that slow
+ * commands can overlap with other work.  Only one request may be in flight;
+ * finish it with TlclCollect() before sending any other command.
+ */
+uint32_t TlclSubmit(const uint8_t *request);
+
+/**
+ * Return a file descriptor which polls readable once the response to the
+ * request started by TlclSubmit() is ready, or -1 if none is in flight.
+ */
+int TlclPollFd(void);
+
+/**
+ * Wait up to [timeout_ms] milliseconds (-1 for no limit) for the response to
+ * the request started by TlclSubmit().  Returns 1 if it is ready, 0 if not.
+ */
+int TlclPoll(int timeout_ms);
+
+/**
+ * Finish the request started by TlclSubmit(), waiting for the response if
+ * needed.  Returns 0 if success or the TPM error code if error.
+ */
+uint32_t TlclCollect(uint8_t *response, int max_length);
+
 #ifndef TPM2_MODE
 
 /**
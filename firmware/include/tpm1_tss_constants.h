@@ -78,6 +78,7 @@ typedef uint32_t TPM_FAMILY_FLAGS;
 #define TPM_KEY_USAGE_STORAGE ((uint16_t) 0x0011)
 
 #define TPM_ALG_RSA ((uint16_t)0x0001)
+#define TPM_ALG_SHA1 ((uint16_t)0x0004)
 
 #define TPM_ES_RSAESOAEP_SHA1_MGF1 ((uint16_t)0x0003)
 
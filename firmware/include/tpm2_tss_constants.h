@@ -34,6 +34,7 @@ extern "C" {
 #define TPM2_NV_ReadPublic     ((TPM_CC)0x00000169)
 #define TPM2_GetCapability     ((TPM_CC)0x0000017A)
 #define TPM2_GetRandom         ((TPM_CC)0x0000017B)
+#define TPM2_PCR_Read          ((TPM_CC)0x0000017E)
 #define TPM2_PCR_Extend        ((TPM_CC)0x00000182)
 
 #define TPM_HT_PCR             0x00
@@ -116,9 +117,15 @@ extern "C" {
 
 #define HASH_COUNT 1 /* Only SHA-256 is supported */
 
+/* Table 205 - Defines for SHA1 Hash Values */
+#define SHA1_DIGEST_SIZE    20
+
 /* Table 206 - Defines for SHA256 Hash Values */
 #define SHA256_DIGEST_SIZE  32
 
+/* Bytes in a PCR selection bitmap, enough for the 24 PCRs of a PC client */
+#define PCR_SELECT_MIN 3
+
 typedef uint8_t TPMI_YES_NO;
 typedef uint32_t TPM_CC;
 typedef uint32_t TPM_HANDLE;
@@ -150,9 +157,15 @@ typedef struct {
 	uint32_t value;
 } TPMS_TAGGED_PROPERTY;
 
+/*
+ * Most properties requested by a single TPM2_GetCapability. This is far less
+ * than the TPM could return, but enough for the ranges tlcl asks for.
+ */
+#define MAX_TPM_PROPERTIES 8
+
 typedef struct {
 	uint32_t count;
-	TPMS_TAGGED_PROPERTY tpm_property[1];
+	TPMS_TAGGED_PROPERTY tpm_property[MAX_TPM_PROPERTIES];
 } TPML_TAGGED_TPM_PROPERTY;
 
 typedef union {
@@ -169,6 +182,14 @@ typedef struct {
 	TPMT_HA digests[HASH_COUNT];
 } TPML_DIGEST_VALUES;
 
+/* Most digests a TPML_DIGEST, and so a single TPM2_PCR_Read, can return */
+#define MAX_TPML_DIGESTS 8
+
+typedef struct {
+	uint32_t count;
+	TPM2B_DIGEST digests[MAX_TPML_DIGESTS];
+} TPML_DIGEST;
+
 typedef union {
 	TPML_TAGGED_TPM_PROPERTY tpm_properties;
 } TPMU_CAPABILITIES;
@@ -252,6 +273,11 @@ struct tpm2_pcr_extend_cmd {
 	TPML_DIGEST_VALUES digests;
 };
 
+struct tpm2_pcr_read_cmd {
+	TPMI_ALG_HASH hash_alg;
+	uint32_t pcr_select;  /* Bitmap of PCRs in the one selected bank */
+};
+
 /* Common command/response header. */
 struct tpm_header {
 	uint16_t tpm_tag;
@@ -300,6 +326,13 @@ struct nv_read_public_response {
 	TPM2B_NAME nvName;
 } __attribute__((packed));
 
+struct pcr_read_response {
+	uint32_t pcr_update_counter;
+	TPMI_ALG_HASH hash_alg;  /* TPM_ALG_NULL if no bank was returned */
+	uint32_t pcr_select;
+	TPML_DIGEST pcr_values;
+};
+
 struct tpm2_response {
 	struct tpm_header hdr;
 	union {
@@ -308,6 +341,7 @@ struct tpm2_response {
 		struct get_capability_response cap;
 		struct get_random_response random;
 		struct nv_read_public_response nv_read_public;
+		struct pcr_read_response pcr_read;
 	};
 };
 
@@ -44,12 +44,50 @@ typedef struct VbSharedDataHeader VbSharedDataHeader;
  */
 typedef void *VbExDiskHandle_t;
 
+/* Flags for VbKernelBootPolicy.flags */
+/*
+ * Try the kernel partition recorded in VB2_NV_KERNEL_LAST_GOOD_PARTITION
+ * before the others on fixed disks, and record the partition booted from a
+ * fixed disk there.  The hint is ignored while a higher-priority partition
+ * has booted successfully or still has trial boots left.
+ */
+#define VB_BOOT_POLICY_PREFER_LAST_GOOD		(1 << 0)
+/*
+ * Stop at the first kernel which verifies, instead of reading the vblocks of
+ * the remaining partitions to find the kernel version to roll forward to.
+ * The TPM kernel version is not rolled forward on such boots.
+ */
+#define VB_BOOT_POLICY_STOP_AT_FIRST_VERIFIED	(1 << 1)
+/*
+ * Don't read the secondary GPT unless the primary GPT is bad or the GPT is
+ * written back.  A damaged secondary GPT is not repaired on such boots, so
+ * callers should leave this clear every so often.
+ */
+#define VB_BOOT_POLICY_LAZY_SECONDARY_GPT	(1 << 2)
+
+/*
+ * Kernel partition scan policy for LoadKernel().  All zeroes gives the
+ * default behavior.
+ */
+typedef struct VbKernelBootPolicy {
+	/* Flags (VB_BOOT_POLICY_*) */
+	uint32_t flags;
+	/*
+	 * Maximum number of kernel partitions to examine per disk, including
+	 * ones which fail to verify; 0=no limit.  If the limit stops the
+	 * scan early, the TPM kernel version is not rolled forward.
+	 */
+	uint32_t max_partitions;
+} VbKernelBootPolicy;
+
 typedef struct VbSelectAndLoadKernelParams {
 	/* Inputs to VbSelectAndLoadKernel() */
 	/* Destination buffer for kernel (normally at 0x100000 on x86) */
 	void *kernel_buffer;
 	/* Size of kernel buffer in bytes */
 	uint32_t kernel_buffer_size;
+	/* Kernel partition scan policy */
+	VbKernelBootPolicy policy;
 
 	/*
 	 * Outputs from VbSelectAndLoadKernel(); valid only if it returns
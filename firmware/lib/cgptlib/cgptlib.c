@@ -111,6 +111,62 @@ int GptNextKernelEntry(GptData *gpt, uint64_t *start_sector, uint64_t *size)
 	return GPT_SUCCESS;
 }
 
+int GptPreferKernelEntry(GptData *gpt, uint32_t index,
+			 uint64_t *start_sector, uint64_t *size)
+{
+	GptHeader *header = (GptHeader *)gpt->primary_header;
+	GptEntry *entries = (GptEntry *)gpt->primary_entries;
+	GptEntry *e;
+	int prio;
+	uint32_t i;
+
+	/* Only valid before the priority scan has started */
+	if (gpt->current_kernel != CGPT_KERNEL_ENTRY_NOT_FOUND ||
+	    index >= header->number_of_entries)
+		return GPT_ERROR_NO_VALID_KERNEL;
+
+	e = entries + index;
+	if (!IsKernelEntry(e) || !GetEntrySuccessful(e) ||
+	    !GetEntryPriority(e)) {
+		VB2_DEBUG("GptPreferKernelEntry partition %d not bootable\n",
+			  index + 1);
+		return GPT_ERROR_NO_VALID_KERNEL;
+	}
+
+	/*
+	 * The preference only reorders kernels the priority order would not
+	 * pick first anyway.  It must not override a higher-priority kernel
+	 * which has booted successfully (e.g. one an admin raised), nor starve
+	 * one still waiting for its trial boots (e.g. after an update).
+	 */
+	prio = GetEntryPriority(e);
+	for (i = 0, e = entries; i < header->number_of_entries; i++, e++) {
+		if (!IsKernelEntry(e) || GetEntryPriority(e) <= prio)
+			continue;
+		if (GetEntrySuccessful(e)) {
+			VB2_DEBUG("GptPreferKernelEntry partition %d has "
+				  "higher priority\n", i + 1);
+			return GPT_ERROR_NO_VALID_KERNEL;
+		}
+		if (GetEntryTries(e)) {
+			VB2_DEBUG("GptPreferKernelEntry partition %d is on "
+				  "trial\n", i + 1);
+			return GPT_ERROR_NO_VALID_KERNEL;
+		}
+	}
+
+	/*
+	 * current_priority is left alone, so the next GptNextKernelEntry()
+	 * call starts the priority scan from the top.
+	 */
+	VB2_DEBUG("GptPreferKernelEntry likes partition %d\n", index + 1);
+	e = entries + index;
+	gpt->current_kernel = index;
+	*start_sector = e->starting_lba;
+	*size = e->ending_lba - e->starting_lba + 1;
+	return GPT_SUCCESS;
+}
+
 /*
  * Func: GptUpdateKernelWithEntry
  * Desc: This function updates the given kernel entry according to the provided
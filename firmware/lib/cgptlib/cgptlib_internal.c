@@ -266,9 +266,12 @@ int GptValidityCheck(GptData *gpt)
 		   GPT_HEADER_SIGNATURE_IGNORED, GPT_HEADER_SIGNATURE_SIZE)) {
 		gpt->ignored |= MASK_PRIMARY;
 	}
-	if (0 == CheckHeader(header2, 1, gpt->streaming_drive_sectors,
-			     gpt->gpt_drive_sectors, gpt->flags,
-			     gpt->sector_bytes)) {
+	if (gpt->deferred & MASK_SECONDARY) {
+		/* Not read from the drive; only the primary can be checked. */
+	} else if (0 == CheckHeader(header2, 1,
+				    gpt->streaming_drive_sectors,
+				    gpt->gpt_drive_sectors, gpt->flags,
+				    gpt->sector_bytes)) {
 		gpt->valid_headers |= MASK_SECONDARY;
 		if (!goodhdr)
 			goodhdr = header2;
@@ -315,10 +318,11 @@ int GptValidityCheck(GptData *gpt)
 		gpt->valid_headers &= ~MASK_SECONDARY;
 
 	/*
-	 * When we're ignoring a GPT, make it look in memory like the other one
-	 * and pretend that everything is fine (until we try to save).
+	 * When we're ignoring a GPT, or haven't read it, make it look in
+	 * memory like the other one and pretend that everything is fine (until
+	 * we try to save).
 	 */
-	if (MASK_NONE != gpt->ignored) {
+	if (MASK_NONE != gpt->ignored || MASK_NONE != gpt->deferred) {
 		GptRepair(gpt);
 		gpt->modified = 0;
 	}
@@ -22,4 +22,23 @@
  *   GPT_ERROR_NO_VALID_KERNEL, no avaliable kernel, enters recovery mode */
 int GptNextKernelEntry(GptData *gpt, uint64_t *start_sector, uint64_t *size);
 
+/**
+ * Provides the location of a specific kernel partition, ahead of the priority
+ * order returned by GptNextKernelEntry().
+ *
+ * Must be called before the first call to GptNextKernelEntry(), which then
+ * starts from the highest-priority kernel as usual; callers should skip the
+ * preferred partition when it comes up again.  The partition is only
+ * accepted if it has booted successfully before, has non-zero priority, and
+ * no higher-priority kernel partition has booted successfully or is still
+ * being tried.
+ *
+ * On success, start_sector, size and gpt.current_kernel are set as for
+ * GptNextKernelEntry().
+ *
+ * Returns GPT_SUCCESS if successful, else
+ *   GPT_ERROR_NO_VALID_KERNEL, partition is not acceptable */
+int GptPreferKernelEntry(GptData *gpt, uint32_t index,
+			 uint64_t *start_sector, uint64_t *size);
+
 #endif  /* VBOOT_REFERENCE_CGPTLIB_H_ */
@@ -27,6 +27,8 @@ int AllocAndReadGptData(VbExDiskHandle_t disk_handle, GptData *gptdata)
 	gptdata->modified = 0;
 	/* This should get overwritten by GptInit() */
 	gptdata->ignored = 0;
+	/* Nothing deferred unless the primary GPT turns out to be good */
+	gptdata->deferred = 0;
 
 	/* Allocate all buffers */
 	gptdata->primary_header = (uint8_t *)malloc(gptdata->sector_bytes);
@@ -81,6 +83,19 @@ int AllocAndReadGptData(VbExDiskHandle_t disk_handle, GptData *gptdata)
 			  ? "invalid" : "being ignored");
 	}
 
+	/*
+	 * In lazy mode, a fully valid primary GPT is enough; the secondary
+	 * GPT is only needed if something is written back.
+	 */
+	if (primary_valid && (gptdata->flags & GPT_FLAG_LAZY_SECONDARY) &&
+	    0 == CheckEntries((GptEntry *)gptdata->primary_entries,
+			      primary_header)) {
+		VB2_DEBUG("Primary GPT is valid; deferring secondary GPT\n");
+		memset(gptdata->secondary_header, 0, gptdata->sector_bytes);
+		gptdata->deferred = MASK_SECONDARY;
+		return 0;
+	}
+
 	/* Read secondary header from the end of the drive */
 	if (0 != VbExDiskRead(disk_handle, gptdata->gpt_drive_sectors - 1, 1,
 			      gptdata->secondary_header)) {
@@ -121,6 +136,32 @@ int AllocAndReadGptData(VbExDiskHandle_t disk_handle, GptData *gptdata)
 	return (primary_valid || secondary_valid) ? 0 : 1;
 }
 
+/**
+ * Read the secondary header which AllocAndReadGptData() deferred, so that a
+ * secondary GPT marked to be ignored is not overwritten.
+ */
+static void ReadDeferredSecondary(VbExDiskHandle_t disk_handle,
+				  GptData *gptdata)
+{
+	uint8_t *header;
+
+	header = (uint8_t *)malloc(gptdata->sector_bytes);
+	if (!header)
+		return;
+
+	if (0 != VbExDiskRead(disk_handle, gptdata->gpt_drive_sectors - 1, 1,
+			      header)) {
+		VB2_DEBUG("Read error in deferred secondary GPT header\n");
+	} else if (!memcmp(((GptHeader *)header)->signature,
+			   GPT_HEADER_SIGNATURE_IGNORED,
+			   GPT_HEADER_SIGNATURE_SIZE)) {
+		gptdata->ignored |= MASK_SECONDARY;
+	}
+
+	gptdata->deferred &= ~MASK_SECONDARY;
+	free(header);
+}
+
 /**
  * Write any changes for the GPT data back to the drive, then free the buffers.
  *
@@ -181,6 +222,11 @@ int WriteAndFreeGptData(VbExDiskHandle_t disk_handle, GptData *gptdata)
 		}
 	}
 
+	if ((gptdata->deferred & MASK_SECONDARY) &&
+	    (gptdata->modified &
+	     (GPT_MODIFIED_HEADER2 | GPT_MODIFIED_ENTRIES2)))
+		ReadDeferredSecondary(disk_handle, gptdata);
+
 	entries_lba = (gptdata->gpt_drive_sectors - entries_sectors -
 		GPT_HEADER_SECTORS);
 	if (gptdata->secondary_header && !(gptdata->ignored & MASK_SECONDARY)) {
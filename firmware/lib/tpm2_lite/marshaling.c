@@ -216,9 +216,11 @@ static void unmarshal_nv_read_public(void **buffer, int *size,
 static void unmarshal_TPML_TAGGED_TPM_PROPERTY(void **buffer, int *size,
 					       TPML_TAGGED_TPM_PROPERTY *prop)
 {
+	int i;
+
 	prop->count = unmarshal_u32(buffer, size);
 
-	if (prop->count != 1) {
+	if (prop->count > ARRAY_SIZE(prop->tpm_property)) {
 		*size = -1;
 		VB2_DEBUG("Request to unmarshal unsupported "
 			  "number of properties: %u\n",
@@ -226,8 +228,10 @@ static void unmarshal_TPML_TAGGED_TPM_PROPERTY(void **buffer, int *size,
 		return;
 	}
 
-	prop->tpm_property[0].property = unmarshal_u32(buffer, size);
-	prop->tpm_property[0].value = unmarshal_u32(buffer, size);
+	for (i = 0; i < prop->count; i++) {
+		prop->tpm_property[i].property = unmarshal_u32(buffer, size);
+		prop->tpm_property[i].value = unmarshal_u32(buffer, size);
+	}
 }
 
 static void unmarshal_TPMS_CAPABILITY_DATA(void **buffer, int *size,
@@ -264,6 +268,51 @@ static void unmarshal_get_random(void **buffer, int *size,
 	unmarshal_TPM2B(buffer, size, &random->random_bytes);
 }
 
+static void unmarshal_pcr_read(void **buffer, int *size,
+			       struct pcr_read_response *pcr_read)
+{
+	uint32_t count;
+	uint8_t select_size;
+	int i;
+
+	pcr_read->pcr_update_counter = unmarshal_u32(buffer, size);
+
+	/* Only one bank is ever asked for, so at most one comes back. */
+	pcr_read->hash_alg = TPM_ALG_NULL;
+	pcr_read->pcr_select = 0;
+	count = unmarshal_u32(buffer, size);
+	if (count > 1) {
+		VB2_DEBUG("unexpected number of PCR banks: %u\n", count);
+		*size = -1;
+		return;
+	}
+	if (count) {
+		pcr_read->hash_alg = unmarshal_ALG_ID(buffer, size);
+		select_size = unmarshal_u8(buffer, size);
+		if (select_size > sizeof(pcr_read->pcr_select)) {
+			VB2_DEBUG("PCR selection too large: %u\n",
+				  select_size);
+			*size = -1;
+			return;
+		}
+		for (i = 0; i < select_size; i++)
+			pcr_read->pcr_select |=
+				(uint32_t)unmarshal_u8(buffer, size) << (8 * i);
+	}
+
+	pcr_read->pcr_values.count = unmarshal_u32(buffer, size);
+	if (pcr_read->pcr_values.count >
+	    ARRAY_SIZE(pcr_read->pcr_values.digests)) {
+		VB2_DEBUG("unexpected number of PCR values: %u\n",
+			  pcr_read->pcr_values.count);
+		*size = -1;
+		return;
+	}
+	for (i = 0; i < pcr_read->pcr_values.count; i++)
+		unmarshal_TPM2B(buffer, size,
+				&pcr_read->pcr_values.digests[i]);
+}
+
 /*
  * Each marshaling function receives a pointer to the buffer to marshal into,
  * a pointer to the data item to be marshaled, and a pointer to the remaining
@@ -714,6 +763,23 @@ static void marshal_pcr_extend(void **buffer,
 	marshal_TPML_DIGEST_VALUES(buffer, &command_body->digests, buffer_space);
 }
 
+static void marshal_pcr_read(void **buffer,
+			     struct tpm2_pcr_read_cmd *command_body,
+			     int *buffer_space)
+{
+	int i;
+
+	tpm_tag = TPM_ST_NO_SESSIONS;
+
+	/* A TPML_PCR_SELECTION holding a single bank */
+	marshal_u32(buffer, 1, buffer_space);
+	marshal_TPMI_ALG_HASH(buffer, command_body->hash_alg, buffer_space);
+	marshal_u8(buffer, PCR_SELECT_MIN, buffer_space);
+	for (i = 0; i < PCR_SELECT_MIN; i++)
+		marshal_u8(buffer, command_body->pcr_select >> (8 * i),
+			   buffer_space);
+}
+
 int tpm_marshal_command(TPM_CC command, void *tpm_command_body,
 			void *buffer, int buffer_size)
 {
@@ -787,6 +853,10 @@ int tpm_marshal_command(TPM_CC command, void *tpm_command_body,
 		marshal_pcr_extend(&cmd_body, tpm_command_body, &body_size);
 		break;
 
+	case TPM2_PCR_Read:
+		marshal_pcr_read(&cmd_body, tpm_command_body, &body_size);
+		break;
+
 	default:
 		body_size = -1;
 		VB2_DEBUG("Request to marshal unsupported command %#x\n",
@@ -848,6 +918,11 @@ int tpm_unmarshal_response(TPM_CC command,
 				     &response->random);
 		break;
 
+	case TPM2_PCR_Read:
+		unmarshal_pcr_read(&response_body, &cr_size,
+				   &response->pcr_read);
+		break;
+
 	case TPM2_Hierarchy_Control:
 	case TPM2_NV_Write:
 	case TPM2_NV_WriteLock:
@@ -150,6 +150,35 @@ int TlclPacketSize(const uint8_t *packet)
 	return tpm_get_packet_size(packet);
 }
 
+#ifdef CHROMEOS_ENVIRONMENT
+
+uint32_t TlclSubmit(const uint8_t *request)
+{
+	return vb2ex_tpm_submit(request, tpm_get_packet_size(request));
+}
+
+int TlclPollFd(void)
+{
+	return vb2ex_tpm_poll_fd();
+}
+
+int TlclPoll(int timeout_ms)
+{
+	return vb2ex_tpm_poll(timeout_ms);
+}
+
+uint32_t TlclCollect(uint8_t *response, int max_length)
+{
+	uint32_t rv, resp_size;
+
+	resp_size = max_length;
+	rv = vb2ex_tpm_collect(response, &resp_size);
+
+	return rv ? rv : tpm_get_packet_response_code(response);
+}
+
+#endif  /* CHROMEOS_ENVIRONMENT */
+
 uint32_t TlclStartup(void)
 {
 	struct tpm2_startup_cmd startup;
@@ -382,6 +411,7 @@ uint32_t TlclGetSpaceInfo(uint32_t index, uint32_t *attributes, uint32_t *size,
 }
 
 static uint32_t tlcl_get_capability(TPM_CAP cap, TPM_PT property,
+				    uint32_t count,
 				    struct get_capability_response **presp)
 {
 	struct tpm2_response *response = &tpm2_resp;
@@ -390,7 +420,7 @@ static uint32_t tlcl_get_capability(TPM_CAP cap, TPM_PT property,
 
 	getcap.capability = cap;
 	getcap.property = property;
-	getcap.property_count = 1;
+	getcap.property_count = count;
 
 	rv = tpm_send_receive(TPM2_GetCapability, &getcap, response);
 	if (rv == TPM_SUCCESS)
@@ -399,29 +429,70 @@ static uint32_t tlcl_get_capability(TPM_CAP cap, TPM_PT property,
 	return rv;
 }
 
-static uint32_t tlcl_get_tpm_property(TPM_PT property, uint32_t *pvalue)
+/*
+ * Reads the contiguous TPM properties [first, first + count) into values[],
+ * asking for as many as possible in each TPM2_GetCapability.  The TPM may
+ * return fewer properties than requested, setting more_data if there are
+ * others, and leaves out properties it doesn't implement.  Bit i of *found is
+ * set for each values[i] which was filled in.
+ */
+static uint32_t tlcl_get_tpm_properties(TPM_PT first, uint32_t count,
+					uint32_t *values, uint32_t *found)
 {
-	uint32_t rv;
 	struct get_capability_response *resp;
 	TPML_TAGGED_TPM_PROPERTY *tpm_prop;
+	TPM_PT property = first;
+	uint32_t rv, i;
 
-	rv = tlcl_get_capability(TPM_CAP_TPM_PROPERTIES, property, &resp);
-	if (rv != TPM_SUCCESS)
-		return rv;
+	VB2_ASSERT(count <= 32);
+	*found = 0;
 
-	if (resp->capability_data.capability != TPM_CAP_TPM_PROPERTIES)
-		return TPM_E_IOERROR;
+	while (property < first + count) {
+		rv = tlcl_get_capability(TPM_CAP_TPM_PROPERTIES, property,
+					 VB2_MIN(first + count - property,
+						 MAX_TPM_PROPERTIES),
+					 &resp);
+		if (rv != TPM_SUCCESS)
+			return rv;
 
-	tpm_prop = &resp->capability_data.data.tpm_properties;
+		if (resp->capability_data.capability != TPM_CAP_TPM_PROPERTIES)
+			return TPM_E_IOERROR;
 
-	if ((tpm_prop->count != 1) ||
-	    (tpm_prop->tpm_property[0].property != property))
-		return TPM_E_IOERROR;
+		tpm_prop = &resp->capability_data.data.tpm_properties;
+		if (!tpm_prop->count)
+			break;
+
+		for (i = 0; i < tpm_prop->count; i++) {
+			TPM_PT got = tpm_prop->tpm_property[i].property;
+
+			/* Properties come back in increasing order. */
+			if (got < property)
+				return TPM_E_IOERROR;
+			property = got + 1;
+			if (got >= first + count)
+				break;
+			values[got - first] = tpm_prop->tpm_property[i].value;
+			*found |= 1u << (got - first);
+		}
+
+		if (!resp->more_data)
+			break;
+	}
 
-	*pvalue = tpm_prop->tpm_property[0].value;
 	return TPM_SUCCESS;
 }
 
+static uint32_t tlcl_get_tpm_property(TPM_PT property, uint32_t *pvalue)
+{
+	uint32_t rv, found;
+
+	rv = tlcl_get_tpm_properties(property, 1, pvalue, &found);
+	if (rv != TPM_SUCCESS)
+		return rv;
+
+	return found ? TPM_SUCCESS : TPM_E_IOERROR;
+}
+
 uint32_t TlclGetPermanentFlags(TPM_PERMANENT_FLAGS *pflags)
 {
 	return tlcl_get_tpm_property(TPM_PT_PERMANENT,
@@ -558,7 +629,111 @@ uint32_t TlclWrite(uint32_t index, const void *data, uint32_t length)
 
 uint32_t TlclPCRRead(uint32_t index, void *data, uint32_t length)
 {
-	VB2_DEBUG("NOT YET IMPLEMENTED\n");
+	uint32_t digest_size;
+
+	if (index >= 8 * PCR_SELECT_MIN)
+		return TPM_E_BADINDEX;
+
+	return TlclPCRReadMultiple(1 << index, TPM_ALG_SHA256, data, length,
+				   &digest_size);
+}
+
+/*
+ * Fixed part of a TPM2_PCR_Read response: header, pcrUpdateCounter, a
+ * single-bank pcrSelectionOut and the pcrValues count.
+ */
+#define PCR_READ_RESPONSE_FIXED_SIZE \
+	(sizeof(struct tpm_header) + 4 + 4 + 2 + 1 + PCR_SELECT_MIN + 4)
+
+static int count_bits(uint32_t value)
+{
+	int count = 0;
+
+	for (; value; value &= value - 1)
+		count++;
+	return count;
+}
+
+uint32_t TlclPCRReadMultiple(uint32_t pcr_mask, uint16_t bank, void *data,
+			     uint32_t length, uint32_t *digest_size)
+{
+	struct tpm2_pcr_read_cmd pcr_readc;
+	struct pcr_read_response *response = &tpm2_resp.pcr_read;
+	uint8_t *out = data;
+	uint32_t remaining = pcr_mask;
+	uint32_t size, max_per_read, pending, returned, bit, rv;
+	int i, n;
+
+	switch (bank) {
+	case TPM_ALG_SHA1:
+		size = SHA1_DIGEST_SIZE;
+		break;
+	case TPM_ALG_SHA256:
+		size = SHA256_DIGEST_SIZE;
+		break;
+	default:
+		VB2_DEBUG("unsupported PCR bank %#x\n", bank);
+		return TPM_E_BADINDEX;
+	}
+
+	if (pcr_mask >> (8 * PCR_SELECT_MIN))
+		return TPM_E_BADINDEX;
+
+	if (length < count_bits(pcr_mask) * size)
+		return TPM_E_BUFFER_SIZE;
+
+	*digest_size = size;
+
+	/*
+	 * Ask for no more PCRs than fit in the response buffer.  The TPM may
+	 * still return fewer; pcrSelectionOut says which ones it did.
+	 */
+	max_per_read = (TPM_BUFFER_SIZE - PCR_READ_RESPONSE_FIXED_SIZE) /
+		(2 + size);
+	if (max_per_read > MAX_TPML_DIGESTS)
+		max_per_read = MAX_TPML_DIGESTS;
+
+	while (remaining) {
+		memset(&pcr_readc, 0, sizeof(pcr_readc));
+		pcr_readc.hash_alg = bank;
+		pending = remaining;
+		for (i = 0; i < max_per_read && pending; i++) {
+			bit = pending & -pending;
+			pcr_readc.pcr_select |= bit;
+			pending &= ~bit;
+		}
+
+		rv = tpm_send_receive(TPM2_PCR_Read, &pcr_readc, &tpm2_resp);
+		if (rv != TPM_SUCCESS)
+			return rv;
+
+		returned = response->pcr_select;
+		if (!returned) {
+			VB2_DEBUG("no PCRs returned for %#x\n",
+				  pcr_readc.pcr_select);
+			return TPM_E_BADINDEX;
+		}
+		if (response->hash_alg != bank ||
+		    (returned & ~pcr_readc.pcr_select) ||
+		    response->pcr_values.count != count_bits(returned))
+			return TPM_E_INVALID_RESPONSE;
+
+		/* Digests come back in PCR order */
+		for (i = 0, n = 0; returned >> i; i++) {
+			const TPM2B_DIGEST *digest;
+
+			bit = 1 << i;
+			if (!(returned & bit))
+				continue;
+			digest = &response->pcr_values.digests[n++];
+			if (digest->size != size)
+				return TPM_E_INVALID_RESPONSE;
+			memcpy(out + count_bits(pcr_mask & (bit - 1)) * size,
+			       digest->buffer, size);
+		}
+		remaining &= ~returned;
+	}
+
 	return TPM_SUCCESS;
 }
 
@@ -632,20 +807,26 @@ uint32_t TlclGetVersion(uint32_t* vendor, uint64_t* firmware_version,
 			uint8_t* vendor_specific_buf,
 			size_t* vendor_specific_buf_size)
 {
-	uint32_t result =  tlcl_get_tpm_property(TPM_PT_MANUFACTURER, vendor);
+	/* The vendor, vendor strings and firmware version are adjacent. */
+	uint32_t props[TPM_PT_FIRMWARE_VERSION_2 - TPM_PT_MANUFACTURER + 1];
+	uint32_t found;
+	uint32_t result = tlcl_get_tpm_properties(TPM_PT_MANUFACTURER,
+						  ARRAY_SIZE(props), props,
+						  &found);
 	if (result != TPM_SUCCESS)
 		return result;
 
-	uint32_t version_1;
-	uint32_t version_2;
-	result = tlcl_get_tpm_property(TPM_PT_FIRMWARE_VERSION_1, &version_1);
-	if (result != TPM_SUCCESS)
-		return result;
-	result = tlcl_get_tpm_property(TPM_PT_FIRMWARE_VERSION_2, &version_2);
-	if (result != TPM_SUCCESS)
-		return result;
+#define PROP_INDEX(prop) ((prop) - TPM_PT_MANUFACTURER)
+#define PROP_FOUND(prop) (found & (1u << PROP_INDEX(prop)))
+	if (!PROP_FOUND(TPM_PT_MANUFACTURER) ||
+	    !PROP_FOUND(TPM_PT_FIRMWARE_VERSION_1) ||
+	    !PROP_FOUND(TPM_PT_FIRMWARE_VERSION_2))
+		return TPM_E_IOERROR;
 
-	*firmware_version = ((uint64_t) version_1 << 32) | version_2;
+	*vendor = props[PROP_INDEX(TPM_PT_MANUFACTURER)];
+	*firmware_version =
+		((uint64_t)props[PROP_INDEX(TPM_PT_FIRMWARE_VERSION_1)] << 32) |
+		props[PROP_INDEX(TPM_PT_FIRMWARE_VERSION_2)];
 
 	if (!vendor_specific_buf_size)
 		return TPM_SUCCESS;
@@ -656,19 +837,20 @@ uint32_t TlclGetVersion(uint32_t* vendor, uint64_t* firmware_version,
 	for (prop_id = TPM_PT_VENDOR_STRING_1;
 	     prop_id <= TPM_PT_VENDOR_STRING_4;
 	     ++prop_id) {
-		uint32_t prop_value;
-		result = tlcl_get_tpm_property(prop_id, &prop_value);
-		if (result != TPM_SUCCESS)
+		if (!PROP_FOUND(prop_id))
 			break;
 
 		size_t prop_len = tlcl_vendor_string_parse(
-				prop_value, prop_string + total_size);
+				props[PROP_INDEX(prop_id)],
+				prop_string + total_size);
 		VB2_ASSERT(prop_len <= 4 &&
 			   total_size + prop_len <= sizeof(prop_string));
 		total_size += prop_len;
 		if (prop_len < 4)
 			break;
 	}
+#undef PROP_FOUND
+#undef PROP_INDEX
 	if (vendor_specific_buf) {
 		if (total_size > *vendor_specific_buf_size)
 			total_size = *vendor_specific_buf_size;
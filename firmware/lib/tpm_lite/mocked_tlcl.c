@@ -80,6 +80,14 @@ uint32_t TlclPCRRead(uint32_t index, void* data, uint32_t length)
 	return TPM_SUCCESS;
 }
 
+uint32_t TlclPCRReadMultiple(uint32_t pcr_mask, uint16_t bank, void *data,
+			     uint32_t length, uint32_t *digest_size)
+{
+	memset(data, '\0', length);
+	*digest_size = TPM_PCR_DIGEST;
+	return TPM_SUCCESS;
+}
+
 uint32_t TlclWriteLock(uint32_t index)
 {
 	return TPM_SUCCESS;
@@ -224,6 +232,30 @@ uint32_t TlclSendReceive(const uint8_t* request, uint8_t* response,
 	return TPM_SUCCESS;
 }
 
+#ifdef CHROMEOS_ENVIRONMENT
+
+uint32_t TlclSubmit(const uint8_t* request)
+{
+	return TPM_SUCCESS;
+}
+
+int TlclPollFd(void)
+{
+	return -1;
+}
+
+int TlclPoll(int timeout_ms)
+{
+	return 1;
+}
+
+uint32_t TlclCollect(uint8_t* response, int max_length)
+{
+	return TPM_SUCCESS;
+}
+
+#endif  /* CHROMEOS_ENVIRONMENT */
+
 uint32_t TlclIFXFieldUpgradeInfo(TPM_IFX_FIELDUPGRADEINFO* info)
 {
 	memset(info, 0, sizeof(*info));
@@ -139,6 +139,43 @@ uint32_t TlclSendReceive(const uint8_t* request, uint8_t* response,
 	return result;
 }
 
+#ifdef CHROMEOS_ENVIRONMENT
+
+uint32_t TlclSubmit(const uint8_t* request)
+{
+	uint32_t result = vb2ex_tpm_submit(request, TpmCommandSize(request));
+	if (TPM_SUCCESS != result)
+		VB2_DEBUG("TPM: command %#x submit failed: %#x\n",
+			  TpmCommandCode(request), result);
+	return result;
+}
+
+int TlclPollFd(void)
+{
+	return vb2ex_tpm_poll_fd();
+}
+
+int TlclPoll(int timeout_ms)
+{
+	return vb2ex_tpm_poll(timeout_ms);
+}
+
+/* Like TlclSendReceiveNoRetry, for the response to TlclSubmit(). */
+uint32_t TlclCollect(uint8_t* response, int max_length)
+{
+	uint32_t response_length = max_length;
+	uint32_t result = vb2ex_tpm_collect(response, &response_length);
+	if (TPM_SUCCESS != result) {
+		VB2_DEBUG("TPM: collect failed: %#x\n", result);
+		return result;
+	}
+	result = TpmReturnCode(response);
+	VB2_DEBUG("TPM: async command returned %#x\n", result);
+	return result;
+}
+
+#endif  /* CHROMEOS_ENVIRONMENT */
+
 /* Sends a command and returns the error code. */
 static uint32_t Send(const uint8_t* command)
 {
@@ -678,6 +715,48 @@ uint32_t TlclPCRRead(uint32_t index, void* data, uint32_t length)
 	return result;
 }
 
+uint32_t TlclPCRReadMultiple(uint32_t pcr_mask, uint16_t bank, void *data,
+			     uint32_t length, uint32_t *digest_size)
+{
+	struct s_tpm_pcr_read_cmd cmd;
+	uint8_t response[TPM_LARGE_ENOUGH_COMMAND_SIZE];
+	uint8_t *out = data;
+	uint32_t needed = 0;
+	uint32_t index, result;
+
+	VB2_DEBUG("TPM: TlclPCRReadMultiple(%#x, %#x, %d)\n",
+		  pcr_mask, bank, length);
+	if (bank != TPM_ALG_SHA1)
+		return TPM_E_BADINDEX;
+	for (index = 0; index < 32; index++) {
+		if (pcr_mask & (1U << index))
+			needed += kPcrDigestLength;
+	}
+	if (length < needed)
+		return TPM_E_BUFFER_SIZE;
+	*digest_size = kPcrDigestLength;
+
+	/*
+	 * TPM 1.2 reads one PCR per command, so build the command once and
+	 * only patch in each index.
+	 */
+	memcpy(&cmd, &tpm_pcr_read_cmd, sizeof(cmd));
+	for (index = 0; index < 32; index++) {
+		if (!(pcr_mask & (1U << index)))
+			continue;
+		ToTpmUint32(cmd.buffer + tpm_pcr_read_cmd.pcrNum, index);
+		result = TlclSendReceive(cmd.buffer, response,
+					 sizeof(response));
+		if (result != TPM_SUCCESS)
+			return result;
+		memcpy(out, response + kTpmResponseHeaderLength,
+		       kPcrDigestLength);
+		out += kPcrDigestLength;
+	}
+
+	return TPM_SUCCESS;
+}
+
 uint32_t TlclWriteLock(uint32_t index)
 {
 	VB2_DEBUG("TPM: Write lock %#x\n", index);
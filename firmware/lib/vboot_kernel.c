@@ -468,8 +468,17 @@ static vb2_error_t vb2_load_partition(
 		data_key.allow_hwcrypto = 1;
 
 	/* Verify kernel data */
-	if (vb2_verify_data(kernbuf, kernbuf_size, &preamble->body_signature,
-			    &data_key, &wb)) {
+	uint32_t body_chunk_size = vb2_kernel_get_body_chunk_size(preamble);
+	vb2_error_t rv;
+	if (body_chunk_size)
+		rv = vb2_verify_data_tree(kernbuf, kernbuf_size,
+					  &preamble->body_signature, &data_key,
+					  body_chunk_size, &wb);
+	else
+		rv = vb2_verify_data(kernbuf, kernbuf_size,
+				     &preamble->body_signature, &data_key,
+				     &wb);
+	if (rv) {
 		VB2_DEBUG("Kernel data verification failed.\n");
 		return VB2_ERROR_LOAD_PARTITION_VERIFY_BODY;
 	}
@@ -626,18 +635,54 @@ vb2_error_t LoadMiniOsKernel(struct vb2_context *ctx,
 	return rv;
 }
 
+/*
+ * Get the next kernel partition to examine.  If *hint is a partition number,
+ * try that partition first (once), then the rest in priority order, skipping
+ * the hinted partition if it was already tried.
+ */
+static int next_kernel_entry(GptData *gpt, uint32_t *hint, int *skip,
+			     uint64_t *start_sector, uint64_t *size)
+{
+	uint32_t part = *hint;
+
+	if (part) {
+		*hint = 0;
+		if (GptPreferKernelEntry(gpt, part - 1, start_sector,
+					 size) == GPT_SUCCESS) {
+			*skip = part - 1;
+			return GPT_SUCCESS;
+		}
+	}
+
+	do {
+		if (GptNextKernelEntry(gpt, start_sector, size) != GPT_SUCCESS)
+			return GPT_ERROR_NO_VALID_KERNEL;
+	} while (gpt->current_kernel == *skip);
+
+	return GPT_SUCCESS;
+}
+
 vb2_error_t LoadKernel(struct vb2_context *ctx,
 		       VbSelectAndLoadKernelParams *params,
 		       VbDiskInfo *disk_info)
 {
 	struct vb2_shared_data *sd = vb2_get_sd(ctx);
+	const VbKernelBootPolicy *policy = &params->policy;
+	int use_last_good = (policy->flags & VB_BOOT_POLICY_PREFER_LAST_GOOD) &&
+		(disk_info->flags & VB_DISK_FLAG_FIXED);
 	int found_partitions = 0;
+	int stopped_early = 0;
 	uint32_t lowest_version = LOWEST_TPM_VERSION;
+	uint32_t hint = 0;
+	int skip = CGPT_KERNEL_ENTRY_NOT_FOUND;
 	vb2_error_t rv;
 
 	/* Clear output params */
 	params->partition_number = 0;
 
+	if (use_last_good)
+		hint = vb2_nv_get(ctx, VB2_NV_KERNEL_LAST_GOOD_PARTITION);
+
 	/* Read GPT data */
 	GptData gpt;
 	gpt.sector_bytes = (uint32_t)disk_info->bytes_per_lba;
@@ -646,6 +691,8 @@ vb2_error_t LoadKernel(struct vb2_context *ctx,
 	gpt.gpt_drive_sectors = disk_info->lba_count;
 	gpt.flags = disk_info->flags & VB_DISK_FLAG_EXTERNAL_GPT
 			? GPT_FLAG_EXTERNAL : 0;
+	if (policy->flags & VB_BOOT_POLICY_LAZY_SECONDARY_GPT)
+		gpt.flags |= GPT_FLAG_LAZY_SECONDARY;
 	if (AllocAndReadGptData(disk_info->handle, &gpt)) {
 		VB2_DEBUG("Unable to read GPT data\n");
 		goto gpt_done;
@@ -659,8 +706,16 @@ vb2_error_t LoadKernel(struct vb2_context *ctx,
 
 	/* Loop over candidate kernel partitions */
 	uint64_t part_start, part_size;
-	while (GptNextKernelEntry(&gpt, &part_start, &part_size) ==
-	       GPT_SUCCESS) {
+	while (next_kernel_entry(&gpt, &hint, &skip, &part_start,
+				 &part_size) == GPT_SUCCESS) {
+
+		if (policy->max_partitions &&
+		    found_partitions >= policy->max_partitions) {
+			VB2_DEBUG("Examined %d partitions; stopping\n",
+				  found_partitions);
+			stopped_early = 1;
+			break;
+		}
 
 		VB2_DEBUG("Found kernel entry at %"
 			  PRIu64 " size %" PRIu64 "\n",
@@ -756,6 +811,16 @@ vb2_error_t LoadKernel(struct vb2_context *ctx,
 			VB2_DEBUG("Same kernel version\n");
 			break;
 		}
+
+		/*
+		 * The integrator doesn't need the TPM rolled forward on this
+		 * boot, so skip reading the remaining vblocks.
+		 */
+		if (policy->flags & VB_BOOT_POLICY_STOP_AT_FIRST_VERIFIED) {
+			VB2_DEBUG("Stopping at first verified kernel\n");
+			stopped_early = 1;
+			break;
+		}
 	} /* while(GptNextKernelEntry) */
 
  gpt_done:
@@ -771,9 +836,20 @@ vb2_error_t LoadKernel(struct vb2_context *ctx,
 		 * didn't find one; for example, we're in developer mode and
 		 * just didn't look.
 		 */
-		if (lowest_version != LOWEST_TPM_VERSION &&
-		    lowest_version > sd->kernel_version_secdata)
+		if (stopped_early) {
+			/*
+			 * We didn't look at every kernel, so a lower version
+			 * may still be out there; don't roll forward.
+			 */
+			sd->kernel_version = sd->kernel_version_secdata;
+		} else if (lowest_version != LOWEST_TPM_VERSION &&
+			   lowest_version > sd->kernel_version_secdata) {
 			sd->kernel_version = lowest_version;
+		}
+
+		if (use_last_good)
+			vb2_nv_set(ctx, VB2_NV_KERNEL_LAST_GOOD_PARTITION,
+				   params->partition_number);
 
 		/* Success! */
 		rv = VB2_SUCCESS;
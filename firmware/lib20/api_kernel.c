@@ -64,6 +64,7 @@ vb2_error_t vb2api_verify_kernel_data(struct vb2_context *ctx, const void *buf,
 
 	uint8_t *digest;
 	uint32_t digest_size;
+	uint32_t chunk_size;
 
 	vb2_workbuf_from_ctx(ctx, &wb);
 
@@ -99,6 +100,12 @@ vb2_error_t vb2api_verify_kernel_data(struct vb2_context *ctx, const void *buf,
 				      vb2_member_of(sd, sd->data_key_offset),
 				      sd->data_key_size));
 
+	/* Tree-hashed bodies are signed over the digest of chunk digests */
+	chunk_size = vb2_kernel_get_body_chunk_size(pre);
+	if (chunk_size)
+		return vb2_verify_data_tree(buf, size, &pre->body_signature,
+					    &key, chunk_size, &wb);
+
 	VB2_TRY(vb2_digest_init(dc, key.hash_alg));
 
 	VB2_TRY(vb2_digest_extend(dc, buf, size));
@@ -115,10 +122,7 @@ vb2_error_t vb2api_verify_kernel_data(struct vb2_context *ctx, const void *buf,
 	 * just its hash.  So we need to verify the signature.
 	 */
 
-	/*
-	 * Check digest vs. signature.  Note that this destroys the signature.
-	 * That's ok, because we only check each signature once per boot.
-	 */
+	/* Check digest vs. signature */
 	return vb2_verify_digest(&key, &pre->body_signature, digest, &wb);
 }
 
@@ -46,6 +46,7 @@ vb2_error_t vb2_load_kernel_keyblock(struct vb2_context *ctx)
 
 	struct vb2_keyblock *kb;
 	uint32_t block_size;
+	const struct vb2_keyblock *mapped;
 
 	int rec_switch = (ctx->flags & VB2_CONTEXT_RECOVERY_MODE) != 0;
 	int dev_switch = (ctx->flags & VB2_CONTEXT_DEVELOPER_MODE) != 0;
@@ -68,28 +69,49 @@ vb2_error_t vb2_load_kernel_keyblock(struct vb2_context *ctx)
 	key_size = sd->kernel_key_size;
 	VB2_TRY(vb2_unpack_key_buffer(&kernel_key, key_data, key_size));
 
-	/* Load the kernel keyblock header after the root key */
-	kb = vb2_workbuf_alloc(&wb, sizeof(*kb));
-	if (!kb)
-		return VB2_ERROR_KERNEL_KEYBLOCK_WORKBUF_HEADER;
-
-	VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_KERNEL_VBLOCK, 0, kb,
-				    sizeof(*kb)));
-
-	block_size = kb->keyblock_size;
-
 	/*
-	 * Load the entire keyblock, now that we know how big it is.  Note that
-	 * we're loading the entire keyblock instead of just the piece after
-	 * the header.  That means we re-read the header.  But that's a tiny
-	 * amount of data, and it makes the code much more straightforward.
+	 * Verify and use a copy of the keyblock even if the vblock is mapped,
+	 * since flash can change after the signature check.  Mapping just lets
+	 * us copy it in one go.
 	 */
-	kb = vb2_workbuf_realloc(&wb, sizeof(*kb), block_size);
-	if (!kb)
-		return VB2_ERROR_KERNEL_KEYBLOCK_WORKBUF;
-
-	VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_KERNEL_VBLOCK, 0, kb,
-				    block_size));
+	mapped = vb2_map_resource(ctx, VB2_RES_KERNEL_VBLOCK, 0, sizeof(*kb));
+	if (mapped) {
+		block_size = mapped->keyblock_size;
+		mapped = vb2_map_resource(ctx, VB2_RES_KERNEL_VBLOCK, 0,
+					  block_size);
+		if (!mapped)
+			return VB2_ERROR_KERNEL_KEYBLOCK_MAP;
+
+		kb = vb2_workbuf_alloc(&wb, block_size);
+		if (!kb)
+			return VB2_ERROR_KERNEL_KEYBLOCK_WORKBUF;
+
+		memcpy(kb, mapped, block_size);
+	} else {
+		/* Load the kernel keyblock header after the root key */
+		kb = vb2_workbuf_alloc(&wb, sizeof(*kb));
+		if (!kb)
+			return VB2_ERROR_KERNEL_KEYBLOCK_WORKBUF_HEADER;
+
+		VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_KERNEL_VBLOCK, 0, kb,
+					    sizeof(*kb)));
+
+		block_size = kb->keyblock_size;
+
+		/*
+		 * Load the entire keyblock, now that we know how big it is.
+		 * Note that we're loading the entire keyblock instead of just
+		 * the piece after the header.  That means we re-read the
+		 * header.  But that's a tiny amount of data, and it makes the
+		 * code much more straightforward.
+		 */
+		kb = vb2_workbuf_realloc(&wb, sizeof(*kb), block_size);
+		if (!kb)
+			return VB2_ERROR_KERNEL_KEYBLOCK_WORKBUF;
+
+		VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_KERNEL_VBLOCK, 0, kb,
+					    block_size));
+	}
 
 	/* Verify the keyblock */
 	rv = vb2_verify_keyblock(kb, block_size, &kernel_key, &wb);
@@ -193,6 +215,7 @@ vb2_error_t vb2_load_kernel_preamble(struct vb2_context *ctx)
 	 * padded to around 64KB. */
 	struct vb2_kernel_preamble *pre;
 	uint32_t pre_size;
+	const struct vb2_kernel_preamble *mapped;
 
 	vb2_workbuf_from_ctx(ctx, &wb);
 
@@ -202,25 +225,46 @@ vb2_error_t vb2_load_kernel_preamble(struct vb2_context *ctx)
 
 	VB2_TRY(vb2_unpack_key_buffer(&data_key, key_data, key_size));
 
-	/* Load the kernel preamble header */
-	pre = vb2_workbuf_alloc(&wb, sizeof(*pre));
-	if (!pre)
-		return VB2_ERROR_KERNEL_PREAMBLE2_WORKBUF_HEADER;
-
-	VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_KERNEL_VBLOCK,
-				    sd->vblock_preamble_offset,
-				    pre, sizeof(*pre)));
-
-	pre_size = pre->preamble_size;
-
-	/* Load the entire preamble, now that we know how big it is */
-	pre = vb2_workbuf_realloc(&wb, sizeof(*pre), pre_size);
-	if (!pre)
-		return VB2_ERROR_KERNEL_PREAMBLE2_WORKBUF;
-
-	VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_KERNEL_VBLOCK,
-				    sd->vblock_preamble_offset,
-				    pre, pre_size));
+	/*
+	 * The preamble persists after we return, so it is copied even if the
+	 * vblock is mapped; that just takes a single copy.
+	 */
+	mapped = vb2_map_resource(ctx, VB2_RES_KERNEL_VBLOCK,
+				  sd->vblock_preamble_offset, sizeof(*pre));
+	if (mapped) {
+		pre_size = mapped->preamble_size;
+		mapped = vb2_map_resource(ctx, VB2_RES_KERNEL_VBLOCK,
+					  sd->vblock_preamble_offset,
+					  pre_size);
+		if (!mapped)
+			return VB2_ERROR_KERNEL_PREAMBLE2_MAP;
+
+		pre = vb2_workbuf_alloc(&wb, pre_size);
+		if (!pre)
+			return VB2_ERROR_KERNEL_PREAMBLE2_WORKBUF;
+
+		memcpy(pre, mapped, pre_size);
+	} else {
+		/* Load the kernel preamble header */
+		pre = vb2_workbuf_alloc(&wb, sizeof(*pre));
+		if (!pre)
+			return VB2_ERROR_KERNEL_PREAMBLE2_WORKBUF_HEADER;
+
+		VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_KERNEL_VBLOCK,
+					    sd->vblock_preamble_offset,
+					    pre, sizeof(*pre)));
+
+		pre_size = pre->preamble_size;
+
+		/* Load the entire preamble, now that we know how big it is */
+		pre = vb2_workbuf_realloc(&wb, sizeof(*pre), pre_size);
+		if (!pre)
+			return VB2_ERROR_KERNEL_PREAMBLE2_WORKBUF;
+
+		VB2_TRY(vb2ex_read_resource(ctx, VB2_RES_KERNEL_VBLOCK,
+					    sd->vblock_preamble_offset,
+					    pre, pre_size));
+	}
 
 	/*
 	 * Work buffer now contains:
@@ -13,6 +13,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <poll.h>
 #include <string.h>
 #include <sys/time.h>
 #include <sys/types.h>
@@ -42,6 +43,9 @@ static int tpm_fd = -1;
 /* If the library should exit during an OS-level TPM failure.
  */
 static int exit_on_failure = 1;
+/* If a command sent by vb2ex_tpm_submit() still awaits vb2ex_tpm_collect().
+ */
+static int async_pending = 0;
 
 /* Similar to VbExError, only handle the non-exit case.
  */
@@ -72,12 +76,14 @@ __attribute__((unused)) static void DbgPrintBytes(const uint8_t* a, int n)
 }
 
 
-/* Executes a command on the TPM.
+/* Writes a command to the TPM.  Retries in case of communication errors.
  */
-static uint32_t TpmExecute(const uint8_t *in, const uint32_t in_len,
-			   uint8_t *out, uint32_t *pout_len)
+static uint32_t TpmWrite(const uint8_t *in, const uint32_t in_len)
 {
-	uint8_t response[TPM_MAX_COMMAND_SIZE];
+	int n;
+	int retries = 0;
+	int first_errno = 0;
+
 	if (in_len <= 0) {
 		return DoError(TPM_E_INPUT_TOO_SMALL,
 			       "invalid command length %d for command %#x\n",
@@ -86,69 +92,104 @@ static uint32_t TpmExecute(const uint8_t *in, const uint32_t in_len,
 		return DoError(TPM_E_NO_DEVICE,
 			       "the TPM device was not opened.  " \
 			       "Forgot to call TlclLibInit?\n");
-	} else {
-		int n;
-		int retries = 0;
-		int first_errno = 0;
-
-		/* Write command. Retry in case of communication errors.
-		 */
-		for ( ; retries < COMM_RETRY_MAX_NUM; ++retries) {
-			n = write(tpm_fd, in, in_len);
-			if (n >= 0) {
-				break;
-			}
-			if (retries == 0) {
-				first_errno = errno;
-			}
-			VB2_DEBUG("TPM: write attempt %d failed: %s\n",
-				  retries + 1, strerror(errno));
+	} else if (async_pending) {
+		return DoError(TPM_E_INTERNAL_INCONSISTENCY,
+			       "a TPM command is already in flight\n");
+	}
+
+	for ( ; retries < COMM_RETRY_MAX_NUM; ++retries) {
+		n = write(tpm_fd, in, in_len);
+		if (n >= 0) {
+			break;
 		}
-		if (n < 0) {
-			return DoError(TPM_E_WRITE_FAILURE,
-				       "write failure to TPM device: %s "
-				       "(first error %d)\n",
-				       strerror(errno), first_errno);
-		} else if (n != in_len) {
-			return DoError(TPM_E_WRITE_FAILURE,
-				       "bad write size to TPM device: %d vs %u "
-				       "(%d retries, first error %d)\n",
-				       n, in_len, retries, first_errno);
+		if (retries == 0) {
+			first_errno = errno;
 		}
+		VB2_DEBUG("TPM: write attempt %d failed: %s\n",
+			  retries + 1, strerror(errno));
+	}
+	if (n < 0) {
+		return DoError(TPM_E_WRITE_FAILURE,
+			       "write failure to TPM device: %s "
+			       "(first error %d)\n",
+			       strerror(errno), first_errno);
+	} else if (n != in_len) {
+		return DoError(TPM_E_WRITE_FAILURE,
+			       "bad write size to TPM device: %d vs %u "
+			       "(%d retries, first error %d)\n",
+			       n, in_len, retries, first_errno);
+	}
+	return TPM_SUCCESS;
+}
 
-		/* Read response. Retry in case of communication errors.
-		 */
-		for (retries = 0, first_errno = 0;
-		     retries < COMM_RETRY_MAX_NUM; ++retries) {
-			n = read(tpm_fd, response, sizeof(response));
-			if (n >= 0) {
-				break;
-			}
-			if (retries == 0) {
-				first_errno = errno;
-			}
-			VB2_DEBUG("TPM: read attempt %d failed: %s\n",
-				  retries + 1, strerror(errno));
+/* Reads a response from the TPM.  Retries in case of communication errors.
+ */
+static uint32_t TpmRead(uint8_t *out, uint32_t *pout_len)
+{
+	uint8_t response[TPM_MAX_COMMAND_SIZE];
+	int n;
+	int retries;
+	int first_errno;
+
+	for (retries = 0, first_errno = 0;
+	     retries < COMM_RETRY_MAX_NUM; ++retries) {
+		n = read(tpm_fd, response, sizeof(response));
+		if (n >= 0) {
+			break;
 		}
-		if (n == 0) {
-			return DoError(TPM_E_READ_EMPTY,
-				       "null read from TPM device\n");
-		} else if (n < 0) {
-			return DoError(TPM_E_READ_FAILURE,
-				       "read failure from TPM device: %s "
-				       "(first error %d)\n",
-				       strerror(errno), first_errno);
-		} else {
-			if (n > *pout_len) {
-				return DoError(TPM_E_RESPONSE_TOO_LARGE,
-					       "TPM response too long for "
-					       "output buffer\n");
-			} else {
-				*pout_len = n;
-				memcpy(out, response, n);
-			}
+		if (retries == 0) {
+			first_errno = errno;
 		}
+		VB2_DEBUG("TPM: read attempt %d failed: %s\n",
+			  retries + 1, strerror(errno));
 	}
+	if (n == 0) {
+		return DoError(TPM_E_READ_EMPTY,
+			       "null read from TPM device\n");
+	} else if (n < 0) {
+		return DoError(TPM_E_READ_FAILURE,
+			       "read failure from TPM device: %s "
+			       "(first error %d)\n",
+			       strerror(errno), first_errno);
+	} else if (n > *pout_len) {
+		return DoError(TPM_E_RESPONSE_TOO_LARGE,
+			       "TPM response too long for output buffer\n");
+	}
+	*pout_len = n;
+	memcpy(out, response, n);
+	return TPM_SUCCESS;
+}
+
+/* Executes a command on the TPM.
+ */
+static uint32_t TpmExecute(const uint8_t *in, const uint32_t in_len,
+			   uint8_t *out, uint32_t *pout_len)
+{
+	uint32_t result = TpmWrite(in, in_len);
+	if (result != TPM_SUCCESS)
+		return result;
+	return TpmRead(out, pout_len);
+}
+
+/* Switches the TPM device between blocking and non-blocking mode.  With
+ * O_NONBLOCK set, the kernel driver queues a command on write() and the file
+ * descriptor polls readable once the response is ready.
+ */
+static uint32_t TpmSetNonBlocking(int nonblocking)
+{
+	int flags = fcntl(tpm_fd, F_GETFL);
+	if (flags < 0)
+		return DoError(TPM_E_COMMUNICATION_ERROR,
+			       "cannot get TPM device flags: %s\n",
+			       strerror(errno));
+	if (nonblocking)
+		flags |= O_NONBLOCK;
+	else
+		flags &= ~O_NONBLOCK;
+	if (fcntl(tpm_fd, F_SETFL, flags) < 0)
+		return DoError(TPM_E_COMMUNICATION_ERROR,
+			       "cannot set TPM device flags: %s\n",
+			       strerror(errno));
 	return TPM_SUCCESS;
 }
 
@@ -186,6 +227,7 @@ vb2_error_t vb2ex_tpm_close(void)
 		close(tpm_fd);
 		tpm_fd = -1;
 	}
+	async_pending = 0;
 	return VB2_SUCCESS;
 }
 
@@ -289,6 +331,80 @@ uint32_t vb2ex_tpm_send_recv(const uint8_t* request, uint32_t request_length,
 	return TPM_SUCCESS;
 }
 
+uint32_t vb2ex_tpm_submit(const uint8_t *request, uint32_t request_length)
+{
+	uint32_t result;
+
+#ifdef VBOOT_DEBUG
+	VB2_DEBUG("async request (%d bytes):\n", request_length);
+	DbgPrintBytes(request, request_length);
+#endif
+
+	/* Check the request before touching the device flags. */
+	if (request_length <= 0 || tpm_fd < 0 || async_pending)
+		return TpmWrite(request, request_length);
+
+	result = TpmSetNonBlocking(1);
+	if (result != TPM_SUCCESS)
+		return result;
+
+	result = TpmWrite(request, request_length);
+	if (result != TPM_SUCCESS) {
+		TpmSetNonBlocking(0);
+		return result;
+	}
+
+	async_pending = 1;
+	return TPM_SUCCESS;
+}
+
+int vb2ex_tpm_poll_fd(void)
+{
+	return async_pending ? tpm_fd : -1;
+}
+
+int vb2ex_tpm_poll(int timeout_ms)
+{
+	struct pollfd pfd;
+	int n;
+
+	if (!async_pending)
+		return 0;
+
+	pfd.fd = tpm_fd;
+	pfd.events = POLLIN;
+	do {
+		n = poll(&pfd, 1, timeout_ms);
+	} while (n < 0 && errno == EINTR);
+
+	/* Let vb2ex_tpm_collect() report errors and hangups. */
+	return n != 0;
+}
+
+uint32_t vb2ex_tpm_collect(uint8_t *response, uint32_t *response_length)
+{
+	uint32_t result;
+
+	if (!async_pending)
+		return DoError(TPM_E_INTERNAL_INCONSISTENCY,
+			       "no TPM command in flight\n");
+
+	vb2ex_tpm_poll(-1);
+	result = TpmRead(response, response_length);
+	async_pending = 0;
+	if (result != TPM_SUCCESS) {
+		TpmSetNonBlocking(0);
+		return result;
+	}
+
+#ifdef VBOOT_DEBUG
+	VB2_DEBUG("async response (%d bytes):\n", *response_length);
+	DbgPrintBytes(response, *response_length);
+#endif
+
+	return TpmSetNonBlocking(0);
+}
+
 vb2_error_t vb2ex_tpm_get_random(uint8_t *buf, uint32_t length)
 {
 	static int urandom_fd = -1;
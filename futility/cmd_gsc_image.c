@@ -0,0 +1,411 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Assemble a flat GSC flash image from Intel HEX blobs.
+ */
+
+#include <ctype.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "2common.h"
+#include "2sysincludes.h"
+#include "futility.h"
+#include "host_misc.h"
+
+/* Number of pattern bytes looked for, as in sign_gsc_firmware.sh */
+#define PATTERN_SIZE 8
+
+/* Intel HEX record types */
+enum {
+	IHEX_DATA = 0,
+	IHEX_EOF = 1,
+	IHEX_SEGMENT = 2,
+	IHEX_START_SEGMENT = 3,
+	IHEX_LINEAR = 4,
+	IHEX_START_LINEAR = 5,
+};
+
+static const char usage[] = "\n"
+	"Usage:  " MYNAME " %s [OPTIONS] OUTFILE IHEX [IHEX ...]\n"
+	"        " MYNAME " %s --contains PATTERN FILE [FILE ...]\n"
+	"\n"
+	"The first form places the contents of each Intel HEX file at its\n"
+	"address in a flash image filled with 0xff, and writes the image to\n"
+	"OUTFILE.  As with \"objcopy -O binary\", holes between the lowest\n"
+	"and highest address of each file are filled with 0x00.\n"
+	"\n"
+	"The second form succeeds if each FILE contains the first %d bytes\n"
+	"of PATTERN.  Intel HEX FILEs are searched after conversion to\n"
+	"binary, other FILEs (e.g. ELF) as they are.\n"
+	"\n"
+	"Options:\n"
+	"  -b|--base     ADDR      Flash address of the start of the image\n"
+	"  -s|--size     NUM       Size of the image in bytes\n"
+	"  -c|--contains PATTERN   Search FILEs for PATTERN\n"
+	"\n";
+
+static void print_help(int argc, char *argv[])
+{
+	printf(usage, argv[0], argv[0], PATTERN_SIZE);
+}
+
+static int hex_byte(const uint8_t *p)
+{
+	int v = 0, i;
+
+	for (i = 0; i < 2; i++) {
+		v <<= 4;
+		if (p[i] >= '0' && p[i] <= '9')
+			v |= p[i] - '0';
+		else if (p[i] >= 'a' && p[i] <= 'f')
+			v |= p[i] - 'a' + 10;
+		else if (p[i] >= 'A' && p[i] <= 'F')
+			v |= p[i] - 'A' + 10;
+		else
+			return -1;
+	}
+	return v;
+}
+
+/*
+ * Walk the records of an Intel HEX file.
+ *
+ * If image is not NULL, data records are copied into it; image[0] is at
+ * address image_base, and data outside image_size bytes is an error.  The
+ * lowest and one past the highest address of any data are returned in lo_ptr
+ * and hi_ptr.
+ *
+ * Returns 0 if success, non-zero if error.
+ */
+static int parse_ihex(const char *name, const uint8_t *text, uint32_t len,
+		      uint8_t *image, uint64_t image_base, uint64_t image_size,
+		      uint64_t *lo_ptr, uint64_t *hi_ptr)
+{
+	uint8_t rec[5 + 255];
+	uint64_t base = 0, lo = UINT64_MAX, hi = 0;
+	uint32_t pos = 0, line = 0;
+	int got_eof = 0;
+
+	while (pos < len && !got_eof) {
+		uint8_t sum = 0;
+		int count, i, v;
+
+		/* Skip line endings, including <cr> */
+		if (isspace(text[pos])) {
+			pos++;
+			continue;
+		}
+		line++;
+		if (text[pos] != ':') {
+			ERROR("%s:%u: not an Intel HEX record\n", name, line);
+			return 1;
+		}
+		pos++;
+
+		/* Byte count, address, type, data and checksum */
+		if (pos + 2 > len || (v = hex_byte(text + pos)) < 0)
+			goto bad_record;
+		count = 5 + v;
+		if (pos + 2 * count > len)
+			goto bad_record;
+		for (i = 0; i < count; i++) {
+			v = hex_byte(text + pos + 2 * i);
+			if (v < 0)
+				goto bad_record;
+			rec[i] = v;
+			sum += v;
+		}
+		pos += 2 * count;
+		if (sum) {
+			ERROR("%s:%u: bad checksum\n", name, line);
+			return 1;
+		}
+
+		count = rec[0];
+		switch (rec[3]) {
+		case IHEX_DATA: {
+			uint64_t addr = base + (rec[1] << 8 | rec[2]);
+
+			if (!count)
+				break;
+			lo = VB2_MIN(lo, addr);
+			hi = VB2_MAX(hi, addr + count);
+			if (!image)
+				break;
+			if (addr < image_base ||
+			    addr + count > image_base + image_size) {
+				ERROR("%s:%u: address %#llx outside image\n",
+				      name, line, (unsigned long long)addr);
+				return 1;
+			}
+			memcpy(image + (addr - image_base), rec + 4, count);
+			break;
+		}
+		case IHEX_EOF:
+			got_eof = 1;
+			break;
+		case IHEX_SEGMENT:
+		case IHEX_LINEAR:
+			if (count != 2)
+				goto bad_record;
+			base = rec[4] << 8 | rec[5];
+			base <<= rec[3] == IHEX_SEGMENT ? 4 : 16;
+			break;
+		case IHEX_START_SEGMENT:
+		case IHEX_START_LINEAR:
+			break;
+		default:
+			ERROR("%s:%u: unknown record type %02x\n",
+			      name, line, rec[3]);
+			return 1;
+		}
+	}
+
+	if (!got_eof) {
+		ERROR("%s: missing end of file record\n", name);
+		return 1;
+	}
+	if (lo >= hi) {
+		ERROR("%s: no data\n", name);
+		return 1;
+	}
+
+	*lo_ptr = lo;
+	*hi_ptr = hi;
+	return 0;
+
+bad_record:
+	ERROR("%s:%u: malformed record\n", name, line);
+	return 1;
+}
+
+static int is_ihex(const uint8_t *buf, uint32_t len)
+{
+	return len > 0 && buf[0] == ':';
+}
+
+/*
+ * Return non-zero if the file contains the pattern.  Intel HEX files are
+ * converted to binary first.  Returns -1 if the file can't be used.
+ */
+static int file_contains(const char *name, const uint8_t *pattern)
+{
+	uint8_t *buf, *bin = NULL, *search;
+	uint32_t len;
+	uint64_t lo, hi, search_len;
+	int rv = -1;
+
+	if (vb2_read_file(name, &buf, &len)) {
+		ERROR("Can't read %s\n", name);
+		return -1;
+	}
+
+	search = buf;
+	search_len = len;
+	if (is_ihex(buf, len)) {
+		if (parse_ihex(name, buf, len, NULL, 0, 0, &lo, &hi))
+			goto done;
+		search_len = hi - lo;
+		if (search_len > UINT32_MAX) {
+			ERROR("%s: data spans too much address space\n", name);
+			goto done;
+		}
+		bin = malloc(search_len);
+		if (!bin) {
+			ERROR("Out of memory\n");
+			goto done;
+		}
+		/* Zero-fill holes, as the image does within a blob */
+		memset(bin, 0, search_len);
+		if (parse_ihex(name, buf, len, bin, lo, search_len, &lo, &hi))
+			goto done;
+		search = bin;
+	}
+
+	rv = memmem(search, search_len, pattern, PATTERN_SIZE) != NULL;
+done:
+	free(bin);
+	free(buf);
+	return rv;
+}
+
+static int do_contains(const char *pattern_file, int argc, char *argv[])
+{
+	uint8_t *pattern;
+	uint32_t len;
+	int i, found, rv = 0;
+
+	if (vb2_read_file(pattern_file, &pattern, &len)) {
+		ERROR("Can't read %s\n", pattern_file);
+		return 1;
+	}
+	if (len < PATTERN_SIZE) {
+		ERROR("%s is smaller than %d bytes\n", pattern_file,
+		      PATTERN_SIZE);
+		free(pattern);
+		return 1;
+	}
+
+	for (i = 0; i < argc; i++) {
+		found = file_contains(argv[i], pattern);
+		if (found < 0)
+			rv = 2;
+		else if (!found && !rv)
+			rv = 1;
+	}
+
+	free(pattern);
+	return rv;
+}
+
+static int build_image(const char *outfile, uint64_t base, uint64_t size,
+		       int argc, char *argv[])
+{
+	uint8_t *image, *blob, *buf;
+	uint32_t len;
+	uint64_t lo, hi;
+	int i, rv = 1;
+
+	image = malloc(size);
+	blob = malloc(size);
+	if (!image || !blob) {
+		ERROR("Out of memory\n");
+		goto done;
+	}
+	memset(image, 0xff, size);
+
+	for (i = 0; i < argc; i++) {
+		if (vb2_read_file(argv[i], &buf, &len)) {
+			ERROR("Can't read %s\n", argv[i]);
+			goto done;
+		}
+		if (!is_ihex(buf, len)) {
+			ERROR("%s is not an Intel HEX file\n", argv[i]);
+			free(buf);
+			goto done;
+		}
+		/*
+		 * Like "objcopy -O binary", each blob spans its lowest to its
+		 * highest address, with any holes in it zero-filled.
+		 */
+		memset(blob, 0, size);
+		if (parse_ihex(argv[i], buf, len, blob, base, size,
+			       &lo, &hi)) {
+			free(buf);
+			goto done;
+		}
+		VB2_DEBUG("%s: %#llx-%#llx\n", argv[i],
+			  (unsigned long long)lo, (unsigned long long)hi);
+		if (lo < hi)
+			memcpy(image + (lo - base), blob + (lo - base),
+			       hi - lo);
+		free(buf);
+	}
+
+	if (vb2_write_file(outfile, image, size)) {
+		ERROR("Can't write %s\n", outfile);
+		goto done;
+	}
+	rv = 0;
+done:
+	free(blob);
+	free(image);
+	return rv;
+}
+
+enum {
+	OPT_HELP = 1000,
+};
+static const struct option long_opts[] = {
+	{"base",     1, NULL, 'b'},
+	{"size",     1, NULL, 's'},
+	{"contains", 1, NULL, 'c'},
+	{"help",     0, NULL, OPT_HELP},
+	{NULL, 0, NULL, 0}
+};
+static int do_gsc_image(int argc, char *argv[])
+{
+	const char *contains = NULL;
+	uint64_t base = 0, size = 0;
+	int have_base = 0;
+	int errorcnt = 0;
+	char *e;
+	int i;
+
+	opterr = 0;		/* quiet, you */
+	while ((i = getopt_long(argc, argv, ":b:s:c:", long_opts,
+				NULL)) != -1) {
+		switch (i) {
+		case 'b':
+			base = strtoull(optarg, &e, 0);
+			if (!*optarg || (e && *e)) {
+				ERROR("Invalid --base\n");
+				errorcnt++;
+			}
+			have_base = 1;
+			break;
+		case 's':
+			size = strtoull(optarg, &e, 0);
+			if (!*optarg || (e && *e) || !size ||
+			    size > UINT32_MAX) {
+				ERROR("Invalid --size\n");
+				errorcnt++;
+			}
+			break;
+		case 'c':
+			contains = optarg;
+			break;
+		case OPT_HELP:
+			print_help(argc, argv);
+			return !!errorcnt;
+		case '?':
+			if (optopt)
+				ERROR("Unrecognized option: -%c\n", optopt);
+			else
+				ERROR("Unrecognized option\n");
+			errorcnt++;
+			break;
+		case ':':
+			ERROR("Missing argument to -%c\n", optopt);
+			errorcnt++;
+			break;
+		default:
+			FATAL("Unrecognized getopt output: %d\n", i);
+		}
+	}
+
+	if (contains) {
+		if (argc - optind < 1) {
+			ERROR("Nothing to search\n");
+			errorcnt++;
+		}
+	} else {
+		if (!have_base || !size) {
+			ERROR("--base and --size are required\n");
+			errorcnt++;
+		}
+		if (argc - optind < 2) {
+			ERROR("Need an output file and at least one input\n");
+			errorcnt++;
+		}
+	}
+
+	if (errorcnt) {
+		print_help(argc, argv);
+		return 1;
+	}
+
+	if (contains)
+		return do_contains(contains, argc - optind, argv + optind);
+
+	return build_image(argv[optind], base, size,
+			   argc - optind - 1, argv + optind + 1);
+}
+
+DECLARE_FUTIL_COMMAND(gsc_image, do_gsc_image, VBOOT_VERSION_ALL,
+		      "Assemble a GSC flash image from Intel HEX files");
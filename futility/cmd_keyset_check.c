@@ -0,0 +1,451 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Check a keyset directory for consistent key versions and signatures.
+ */
+
+#include <getopt.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "2common.h"
+#include "2rsa.h"
+#include "2sysincludes.h"
+#include "futility.h"
+#include "host_common.h"
+
+static const char usage[] = "\n"
+	"Usage:  " MYNAME " %s [OPTIONS] KEYSET_DIR\n"
+	"\n"
+	"Check that the keys and keyblocks in a keyset directory agree with\n"
+	"each other and with the versions in key.versions. Every keyblock is\n"
+	"verified against the key that should have signed it, and its data key\n"
+	"must match the .vbpubk file next to it. Keysets with a loem.ini are\n"
+	"checked for each LOEM firmware key listed there.\n"
+	"\n"
+	"All problems are reported, and the exit status is nonzero if there\n"
+	"were any.\n"
+	"\n"
+	"Options:\n"
+	"  -v, --verbose      Describe each check as it passes\n"
+	"\n";
+
+static void print_help(int argc, char *argv[])
+{
+	printf(usage, argv[0]);
+}
+
+enum {
+	OPT_HELP = 1000,
+};
+
+static const struct option long_opts[] = {
+	/* name    hasarg *flag  val */
+	{"verbose",     0, NULL, 'v'},
+	{"help",        0, NULL, OPT_HELP},
+	{NULL,          0, NULL, 0},
+};
+static const char *short_opts = ":v";
+
+/* The versions recorded in key.versions */
+struct keyset_versions {
+	uint32_t firmware_key;
+	uint32_t firmware;
+	uint32_t kernel_key;
+	uint32_t kernel;
+};
+
+struct keyset {
+	const char *dir;
+	int verbose;
+	int problems;
+	int have_versions;
+	struct keyset_versions versions;
+};
+
+/* A keyblock, the key which signs it, and the key which it holds */
+struct keyblock_desc {
+	const char *keyblock;
+	const char *signer;
+	const char *data_key;
+	int optional;
+};
+
+/* Kernel-side keyblocks; the firmware keyblocks come from loem.ini. */
+static const struct keyblock_desc kernel_keyblocks[] = {
+	{"kernel", "kernel_subkey", "kernel_data_key", 0},
+	{"recovery_kernel", "recovery_key", "recovery_kernel_data_key", 1},
+	{"installer_kernel", "recovery_key", "installer_kernel_data_key", 1},
+	{"minios_kernel", "recovery_key", "minios_kernel_data_key", 1},
+	{"ec", "ec_root_key", "ec_data_key", 1},
+};
+
+__attribute__((format(printf, 2, 3)))
+static void problem(struct keyset *ks, const char *format, ...)
+{
+	va_list ap;
+
+	printf("ERROR: ");
+	va_start(ap, format);
+	vprintf(format, ap);
+	va_end(ap);
+	printf("\n");
+	ks->problems++;
+}
+
+__attribute__((format(printf, 2, 3)))
+static void passed(struct keyset *ks, const char *format, ...)
+{
+	va_list ap;
+
+	if (!ks->verbose)
+		return;
+	printf("OK: ");
+	va_start(ap, format);
+	vprintf(format, ap);
+	va_end(ap);
+	printf("\n");
+}
+
+static void keyset_path(const struct keyset *ks, char *path,
+			const char *name, const char *suffix, const char *ext)
+{
+	snprintf(path, PATH_MAX, "%s/%s%s.%s", ks->dir, name, suffix, ext);
+}
+
+static void check_version(struct keyset *ks, uint32_t expected, uint32_t got,
+			  const char *expected_label, const char *got_label)
+{
+	if (expected != got)
+		problem(ks, "%s version %u does not match %s version %u",
+			got_label, got, expected_label, expected);
+	else
+		passed(ks, "%s version %u matches %s", got_label, got,
+		       expected_label);
+}
+
+static int read_versions(struct keyset *ks)
+{
+	static const struct {
+		const char *name;
+		size_t offset;
+	} fields[] = {
+		{"firmware_key_version",
+		 offsetof(struct keyset_versions, firmware_key)},
+		{"firmware_version",
+		 offsetof(struct keyset_versions, firmware)},
+		{"kernel_key_version",
+		 offsetof(struct keyset_versions, kernel_key)},
+		{"kernel_version",
+		 offsetof(struct keyset_versions, kernel)},
+	};
+	char path[PATH_MAX], line[256];
+	int found[ARRAY_SIZE(fields)] = {0};
+	FILE *fp;
+	int i, ret = 0;
+
+	snprintf(path, sizeof(path), "%s/key.versions", ks->dir);
+	fp = fopen(path, "r");
+	if (!fp) {
+		problem(ks, "can't read %s", path);
+		return 1;
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		char *value = strchr(line, '=');
+		char *end;
+
+		if (!value)
+			continue;
+		*value++ = '\0';
+		for (i = 0; i < ARRAY_SIZE(fields); i++) {
+			if (strcmp(line, fields[i].name))
+				continue;
+			*(uint32_t *)((uint8_t *)&ks->versions +
+				      fields[i].offset) =
+				strtoul(value, &end, 0);
+			if (end == value || (*end && *end != '\n'))
+				problem(ks, "bad %s in key.versions",
+					fields[i].name);
+			found[i] = 1;
+		}
+	}
+	fclose(fp);
+
+	for (i = 0; i < ARRAY_SIZE(fields); i++) {
+		if (!found[i]) {
+			problem(ks, "%s missing from key.versions",
+				fields[i].name);
+			ret = 1;
+		}
+	}
+	return ret;
+}
+
+static struct vb2_packed_key *load_key(struct keyset *ks, const char *name,
+				       const char *suffix)
+{
+	char path[PATH_MAX];
+	struct vb2_packed_key *key;
+
+	keyset_path(ks, path, name, suffix, "vbpubk");
+	key = vb2_read_packed_key(path);
+	if (!key)
+		problem(ks, "can't read key %s", path);
+	return key;
+}
+
+static int packed_keys_match(const struct vb2_packed_key *a,
+			     const struct vb2_packed_key *b)
+{
+	return a->algorithm == b->algorithm &&
+		a->key_version == b->key_version &&
+		a->key_size == b->key_size &&
+		!memcmp(vb2_packed_key_data(a), vb2_packed_key_data(b),
+			a->key_size);
+}
+
+/*
+ * Check that a keyblock holds its data key and is signed by its signer. If
+ * data_version is not NULL, it gets the version of the data key in the
+ * keyblock. Returns non-zero if the keyblock could not be read at all.
+ */
+static int check_keyblock(struct keyset *ks, const struct keyblock_desc *desc,
+			  const char *suffix, uint32_t *data_version)
+{
+	static uint8_t workbuf[VB2_FIRMWARE_WORKBUF_RECOMMENDED_SIZE]
+		__attribute__((aligned(VB2_WORKBUF_ALIGN)));
+	struct vb2_workbuf wb;
+	char path[PATH_MAX];
+	struct vb2_keyblock *block;
+	struct vb2_packed_key *signer = NULL, *data_key = NULL;
+	struct vb2_public_key key;
+
+	keyset_path(ks, path, desc->keyblock, suffix, "keyblock");
+	if (desc->optional && access(path, F_OK))
+		return 0;
+
+	/* This verifies the keyblock hash, but not its signature. */
+	block = vb2_read_keyblock(path);
+	if (!block) {
+		problem(ks, "can't read keyblock %s", path);
+		return 1;
+	}
+	if (data_version)
+		*data_version = block->data_key.key_version;
+
+	data_key = load_key(ks, desc->data_key, suffix);
+	if (data_key) {
+		if (packed_keys_match(&block->data_key, data_key))
+			passed(ks, "%s%s.keyblock holds %s%s.vbpubk",
+			       desc->keyblock, suffix, desc->data_key, suffix);
+		else
+			problem(ks, "%s%s.keyblock doesn't hold "
+				"%s%s.vbpubk", desc->keyblock, suffix,
+				desc->data_key, suffix);
+	}
+
+	signer = load_key(ks, desc->signer, suffix);
+	if (!signer)
+		goto done;
+	if (block->keyblock_signature.sig_size == 0) {
+		problem(ks, "%s%s.keyblock is not signed", desc->keyblock,
+			suffix);
+		goto done;
+	}
+	if (VB2_SUCCESS != vb2_unpack_key(&key, signer)) {
+		problem(ks, "%s%s.vbpubk is not a valid key", desc->signer,
+			suffix);
+		goto done;
+	}
+	vb2_workbuf_init(&wb, workbuf, sizeof(workbuf));
+	if (VB2_SUCCESS != vb2_verify_keyblock(block, block->keyblock_size,
+					       &key, &wb))
+		problem(ks, "%s%s.keyblock is not signed by %s%s.vbpubk",
+			desc->keyblock, suffix, desc->signer, suffix);
+	else
+		passed(ks, "%s%s.keyblock is signed by %s%s.vbpubk",
+		       desc->keyblock, suffix, desc->signer, suffix);
+
+done:
+	free(signer);
+	free(data_key);
+	free(block);
+	return 0;
+}
+
+/* Check one set of firmware keys; suffix is "" or ".loem<N>". */
+static void check_firmware_keys(struct keyset *ks, const char *suffix)
+{
+	static const struct keyblock_desc firmware_keyblock = {
+		"firmware", "root_key", "firmware_data_key", 0,
+	};
+	struct vb2_packed_key *data_key;
+	uint32_t keyblock_version;
+	char label[128];
+
+	if (check_keyblock(ks, &firmware_keyblock, suffix, &keyblock_version))
+		return;
+
+	data_key = load_key(ks, "firmware_data_key", suffix);
+	if (!data_key)
+		return;
+	snprintf(label, sizeof(label), "firmware%s.keyblock data key",
+		 suffix);
+	check_version(ks, keyblock_version, data_key->key_version, label,
+		      "firmware data key");
+	if (ks->have_versions)
+		check_version(ks, ks->versions.firmware_key,
+			      data_key->key_version,
+			      "key.versions firmware key", "firmware data key");
+	free(data_key);
+}
+
+/* Check each LOEM firmware keyset listed in loem.ini. */
+static void check_loem_keys(struct keyset *ks, FILE *fp)
+{
+	char line[64], suffix[80];
+	int count = 0;
+
+	/* Lines look like "<index> = <key id>". */
+	while (fgets(line, sizeof(line), fp)) {
+		char *index = line, *end = strchr(line, '=');
+
+		if (!end)
+			continue;
+		while (end > index && end[-1] == ' ')
+			end--;
+		*end = '\0';
+		snprintf(suffix, sizeof(suffix), ".loem%s", index);
+		check_firmware_keys(ks, suffix);
+		count++;
+	}
+
+	if (!count)
+		problem(ks, "loem.ini lists no keys");
+}
+
+static void check_kernel_keys(struct keyset *ks)
+{
+	struct vb2_packed_key *subkey, *data_key;
+	uint32_t keyblock_version = 0;
+	int i, have_keyblock;
+
+	have_keyblock = !check_keyblock(ks, &kernel_keyblocks[0], "",
+					&keyblock_version);
+	for (i = 1; i < ARRAY_SIZE(kernel_keyblocks); i++)
+		check_keyblock(ks, &kernel_keyblocks[i], "", NULL);
+
+	subkey = load_key(ks, "kernel_subkey", "");
+	data_key = load_key(ks, "kernel_data_key", "");
+
+	if (subkey && have_keyblock)
+		check_version(ks, subkey->key_version, keyblock_version,
+			      "kernel subkey", "kernel keyblock data key");
+	if (subkey && data_key)
+		check_version(ks, subkey->key_version, data_key->key_version,
+			      "kernel subkey", "kernel data key");
+	if (data_key && ks->have_versions)
+		check_version(ks, ks->versions.kernel_key,
+			      data_key->key_version,
+			      "key.versions kernel key", "kernel data key");
+	if (subkey && ks->have_versions)
+		check_version(ks, ks->versions.kernel_key,
+			      subkey->key_version,
+			      "key.versions kernel key", "kernel subkey");
+
+	free(subkey);
+	free(data_key);
+}
+
+static int check_keyset(const char *dir, int verbose)
+{
+	struct keyset ks = {
+		.dir = dir,
+		.verbose = verbose,
+	};
+	char path[PATH_MAX];
+	struct stat st;
+	FILE *fp;
+
+	if (stat(dir, &st) || !S_ISDIR(st.st_mode)) {
+		fprintf(stderr, "%s is not a directory\n", dir);
+		return 1;
+	}
+
+	ks.have_versions = !read_versions(&ks);
+	if (ks.have_versions)
+		check_version(&ks, ks.versions.kernel_key,
+			      ks.versions.firmware, "key.versions kernel key",
+			      "key.versions firmware");
+
+	snprintf(path, sizeof(path), "%s/loem.ini", dir);
+	fp = fopen(path, "r");
+	if (fp) {
+		check_loem_keys(&ks, fp);
+		fclose(fp);
+	} else {
+		check_firmware_keys(&ks, "");
+	}
+
+	check_kernel_keys(&ks);
+
+	if (ks.problems) {
+		printf("%s: %d problem%s found\n", dir, ks.problems,
+		       ks.problems == 1 ? "" : "s");
+		return 1;
+	}
+	printf("%s: OK\n", dir);
+	return 0;
+}
+
+static int do_keyset_check(int argc, char *argv[])
+{
+	int verbose = 0;
+	int errorcnt = 0;
+	int i;
+
+	opterr = 0;		/* quiet, you */
+	while ((i = getopt_long(argc, argv, short_opts, long_opts, 0)) != -1) {
+		switch (i) {
+		case 'v':
+			verbose = 1;
+			break;
+		case OPT_HELP:
+			print_help(argc, argv);
+			return !!errorcnt;
+		case '?':
+			if (optopt)
+				fprintf(stderr, "Unrecognized option: -%c\n",
+					optopt);
+			else
+				fprintf(stderr, "Unrecognized option: %s\n",
+					argv[optind - 1]);
+			errorcnt++;
+			break;
+		default:
+			FATAL("Unrecognized getopt output: %d\n", i);
+		}
+	}
+
+	if (argc - optind != 1) {
+		fprintf(stderr, "You must specify one keyset directory\n");
+		errorcnt++;
+	}
+	if (errorcnt) {
+		print_help(argc, argv);
+		return 1;
+	}
+
+	return check_keyset(argv[optind], verbose);
+}
+
+DECLARE_FUTIL_COMMAND(keyset_check, do_keyset_check, VBOOT_VERSION_1_0,
+		      "Check the keys and versions in a keyset directory");
@@ -400,6 +400,9 @@ int ft_show_kernel_preamble(const char *name, void *data)
 	}
 
 	printf("  Flags:                 %#x\n", vb2_kernel_get_flags(pre2));
+	uint32_t chunk_size = vb2_kernel_get_body_chunk_size(pre2);
+	if (chunk_size)
+		printf("  Body chunk size:       %#x\n", chunk_size);
 
 	/* Verify kernel body */
 	uint8_t *kernel_blob = 0;
@@ -420,9 +423,13 @@ int ft_show_kernel_preamble(const char *name, void *data)
 		goto done;
 	}
 
-	if (VB2_SUCCESS !=
-	    vb2_verify_data(kernel_blob, kernel_size, &pre2->body_signature,
-			    &data_key, &wb)) {
+	if (VB2_SUCCESS != (chunk_size ?
+			    vb2_verify_data_tree(kernel_blob, kernel_size,
+						 &pre2->body_signature,
+						 &data_key, chunk_size, &wb) :
+			    vb2_verify_data(kernel_blob, kernel_size,
+					    &pre2->body_signature,
+					    &data_key, &wb))) {
 		fprintf(stderr, "Error verifying kernel body.\n");
 		goto done;
 	}
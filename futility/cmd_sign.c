@@ -112,6 +112,7 @@ done:
 
 int ft_sign_raw_kernel(const char *name, void *data)
 {
+	struct kernel_blob kb;
 	uint8_t *vmlinuz_data = NULL, *kblob_data = NULL, *vblock_data = NULL;
 	uint32_t vmlinuz_size, kblob_size, vblock_size;
 	int rv = 1;
@@ -122,7 +123,7 @@ int ft_sign_raw_kernel(const char *name, void *data)
 		return 1;
 
 	kblob_data = CreateKernelBlob(
-		vmlinuz_data, vmlinuz_size,
+		&kb, vmlinuz_data, vmlinuz_size,
 		sign_option.arch, sign_option.kloadaddr,
 		sign_option.config_data, sign_option.config_size,
 		sign_option.bootloader_data, sign_option.bootloader_size,
@@ -133,7 +134,7 @@ int ft_sign_raw_kernel(const char *name, void *data)
 	}
 	VB2_DEBUG("kblob_size = %#x\n", kblob_size);
 
-	vblock_data = SignKernelBlob(kblob_data, kblob_size,
+	vblock_data = SignKernelBlob(&kb, kblob_data, kblob_size,
 				     sign_option.padding,
 				     sign_option.version,
 				     sign_option.kloadaddr,
@@ -170,6 +171,7 @@ done:
 
 int ft_sign_kern_preamble(const char *name, void *data)
 {
+	struct kernel_blob kb;
 	uint8_t *kpart_data = NULL, *kblob_data = NULL, *vblock_data = NULL;
 	uint32_t kpart_size, kblob_size, vblock_size;
 	struct vb2_keyblock *keyblock = NULL;
@@ -181,8 +183,8 @@ int ft_sign_kern_preamble(const char *name, void *data)
 				    &kpart_data, &kpart_size))
 		return 1;
 
-	/* Note: This just sets some static pointers. It doesn't malloc. */
-	kblob_data = unpack_kernel_partition(kpart_data, kpart_size,
+	/* Note: This just sets some pointers in kb. It doesn't malloc. */
+	kblob_data = unpack_kernel_partition(&kb, kpart_data, kpart_size,
 					     sign_option.padding,
 					     &keyblock, &preamble, &kblob_size);
 
@@ -202,7 +204,7 @@ int ft_sign_kern_preamble(const char *name, void *data)
 
 	/* Replace the config if asked */
 	if (sign_option.config_data &&
-	    0 != UpdateKernelBlobConfig(kblob_data, kblob_size,
+	    0 != UpdateKernelBlobConfig(&kb, kblob_data, kblob_size,
 					sign_option.config_data,
 					sign_option.config_size)) {
 		fprintf(stderr, "Unable to update config\n");
@@ -223,7 +225,7 @@ int ft_sign_kern_preamble(const char *name, void *data)
 		keyblock = sign_option.keyblock;
 
 	/* Compute the new signature */
-	vblock_data = SignKernelBlob(kblob_data, kblob_size,
+	vblock_data = SignKernelBlob(&kb, kblob_data, kblob_size,
 				     sign_option.padding,
 				     sign_option.version,
 				     sign_option.kloadaddr,
@@ -23,6 +23,8 @@ enum {
 	OPT_FORCE,
 	OPT_GBB_FLAGS,
 	OPT_HOST_ONLY,
+	OPT_JOURNAL,
+	OPT_JOURNAL_FAIL,
 	OPT_MANIFEST,
 	OPT_MODEL,
 	OPT_OUTPUT_DIR,
@@ -63,6 +65,8 @@ static struct option const long_opts[] = {
 	{"force", 0, NULL, OPT_FORCE},
 	{"gbb_flags", 1, NULL, OPT_GBB_FLAGS},
 	{"host_only", 0, NULL, OPT_HOST_ONLY},
+	{"journal", 1, NULL, OPT_JOURNAL},
+	{"journal_fail", 1, NULL, OPT_JOURNAL_FAIL},
 	{"list-quirks", 0, NULL, OPT_QUIRKS_LIST},
 	{"manifest", 0, NULL, OPT_MANIFEST},
 	{"model", 1, NULL, OPT_MODEL},
@@ -115,6 +119,8 @@ static void print_help(int argc, char *argv[])
 		"    --unpack=DIR    \tExtracts archive to DIR\n"
 		"-p, --programmer=PRG\tChange AP (host) flashrom programmer\n"
 		"    --fast          \tReduce read cycles and do not verify\n"
+		"    --journal=FILE  \tRecord full update progress in FILE, and\n"
+		"                    \tresume from it if interrupted\n"
 		"    --quirks=LIST   \tSpecify the quirks to apply\n"
 		"    --list-quirks   \tPrint all available quirks\n"
 		"-m, --mode=MODE     \tRun updater in specified mode\n"
@@ -128,6 +134,7 @@ static void print_help(int argc, char *argv[])
 		"    --wp=1|0        \tSpecify write protection status\n"
 		"    --host_only     \tUpdate only AP (host) firmware\n"
 		"    --emulate=FILE  \tEmulate system firmware using file\n"
+		"    --journal_fail=N\tFail journaled update after N blocks\n"
 		"    --model=MODEL   \tOverride system model for images\n"
 		"    --gbb_flags=FLAG\tOverride new GBB flags\n"
 		"    --ccd           \tDo fast,force,wp=0,p=raiden_debug_spi\n"
@@ -247,6 +254,17 @@ static int do_update(int argc, char *argv[])
 		case OPT_HOST_ONLY:
 			args.host_only = 1;
 			break;
+		case OPT_JOURNAL:
+			args.journal = optarg;
+			break;
+		case OPT_JOURNAL_FAIL:
+			args.journal_fail = strtol(optarg, &endptr, 0);
+			if (*endptr || args.journal_fail <= 0) {
+				ERROR("Invalid number of blocks: %s\n",
+				      optarg);
+				errorcnt++;
+			}
+			break;
 		case OPT_FORCE:
 			args.force_update = 1;
 			break;
@@ -345,6 +363,8 @@ static int do_update(int argc, char *argv[])
 			ERROR("%s\n", updater_error_messages[r]);
 			errorcnt++;
 		}
+		if (cfg->emulation)
+			flash_emulator_print_stats(&cfg->emulated_flash);
 		/* Use stdout for the final result. */
 		printf(">> %s: Firmware updater %s.\n",
 			errorcnt ? "FAILED": "DONE",
@@ -12,6 +12,7 @@
 #if !defined(HAVE_MACOS) && !defined(__FreeBSD__) && !defined(__OpenBSD__)
 #include <linux/fs.h>		/* For BLKGETSIZE64 */
 #endif
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -31,6 +32,7 @@
 static int opt_verbose;
 static int opt_vblockonly;
 static uint64_t opt_pad = 65536;
+static int opt_jobs;
 
 /* Command line options */
 enum {
@@ -38,6 +40,7 @@ enum {
 	OPT_MODE_REPACK,
 	OPT_MODE_VERIFY,
 	OPT_MODE_GET_VMLINUZ,
+	OPT_MODE_PACK_BATCH,
 	OPT_ARCH,
 	OPT_OLDBLOB,
 	OPT_KLOADADDR,
@@ -54,6 +57,7 @@ enum {
 	OPT_MINVERSION,
 	OPT_VMLINUZ_OUT,
 	OPT_FLAGS,
+	OPT_JOBS,
 	OPT_HELP,
 };
 
@@ -62,6 +66,7 @@ static const struct option long_opts[] = {
 	{"repack", 1, 0, OPT_MODE_REPACK},
 	{"verify", 1, 0, OPT_MODE_VERIFY},
 	{"get-vmlinuz", 1, 0, OPT_MODE_GET_VMLINUZ},
+	{"pack-batch", 1, 0, OPT_MODE_PACK_BATCH},
 	{"arch", 1, 0, OPT_ARCH},
 	{"oldblob", 1, 0, OPT_OLDBLOB},
 	{"kloadaddr", 1, 0, OPT_KLOADADDR},
@@ -78,6 +83,7 @@ static const struct option long_opts[] = {
 	{"verbose", 0, &opt_verbose, 1},
 	{"vmlinuz-out", 1, 0, OPT_VMLINUZ_OUT},
 	{"flags", 1, 0, OPT_FLAGS},
+	{"jobs", 1, 0, OPT_JOBS},
 	{"help", 0, 0, OPT_HELP},
 	{NULL, 0, 0, 0}
 };
@@ -136,13 +142,38 @@ static const char usage[] =
 	"\n"
 	"  Required parameters:\n"
 	"    --vmlinuz-out <file>      vmlinuz image output file\n"
+	"\nOR\n\n"
+	"Usage:  " MYNAME " %s --pack-batch <listfile> [PARAMETERS]\n"
+	"\n"
+	"  Packs several kernels in parallel, e.g. the A/B, MiniOS and\n"
+	"  recovery variants of one vmlinuz. Each line of <listfile> is\n"
+	"    <outfile> [<keyblock> [<signprivate> [<config>]]]\n"
+	"  Fields left out or given as '-' are taken from the parameters.\n"
+	"  Empty lines and lines starting with '#' are ignored.\n"
+	"\n"
+	"  Required parameters:\n"
+	"    --version <number>        Kernel version\n"
+	"    --vmlinuz <file>          Linux kernel bzImage file\n"
+	"    --bootloader <file>       Bootloader stub\n"
+	"\n"
+	"  Optional:\n"
+	"    --keyblock <file>         Default keyblock\n"
+	"    --signprivate <file>      Default private key\n"
+	"    --config <file>           Default command line file\n"
+	"    --arch <arch>             Cpu architecture (default x86)\n"
+	"    --kloadaddr <address>     Assign kernel body load address\n"
+	"    --pad <number>            Verification padding size in bytes\n"
+	"    --vblockonly              Emit just the verification blobs\n"
+	"    --flags NUM               Flags to be passed in the header\n"
+	"    --jobs <number>           Kernels to pack at once\n"
+	"                                (default: number of CPUs)\n"
 	"\n";
 
 
 /* Print help and return error */
 static void print_help(int argc, char *argv[])
 {
-	printf(usage, argv[0], argv[0], argv[0], argv[0]);
+	printf(usage, argv[0], argv[0], argv[0], argv[0], argv[0]);
 }
 
 
@@ -204,6 +235,231 @@ static uint8_t *ReadOldKPartFromFileOrDie(const char *filename,
 	return buf;
 }
 
+/****************************************************************************/
+/* --pack-batch */
+
+/* One kernel to pack */
+struct pack_job {
+	const char *outfile;
+	const char *keyblock_file;
+	const char *signprivkey_file;
+	const char *config_file;
+	int rv;
+};
+
+/* Everything shared by the kernels packed together */
+struct pack_batch {
+	struct pack_job *jobs;
+	int num_jobs;
+	int next_job;
+	pthread_mutex_t lock;
+
+	uint8_t *vmlinuz_buf;
+	uint32_t vmlinuz_size;
+	uint8_t *bootloader_data;
+	uint32_t bootloader_size;
+	enum arch_t arch;
+	uint64_t kernel_body_load_address;
+	int version;
+	uint32_t flags;
+};
+
+/*
+ * Packs one kernel the same way as --pack. This runs on a worker thread, so it
+ * reports errors instead of exiting.
+ */
+static int pack_one(struct pack_batch *batch, const struct pack_job *job)
+{
+	struct kernel_blob kb;
+	struct vb2_keyblock *keyblock = NULL;
+	struct vb2_private_key *signpriv_key = NULL;
+	uint8_t *config_data = NULL;
+	uint8_t *kblob_data = NULL;
+	uint8_t *vblock_data = NULL;
+	uint32_t config_size, kblob_size, vblock_size;
+	int rv = 1;
+
+	keyblock = (struct vb2_keyblock *)ReadFile(job->keyblock_file, 0);
+	if (!keyblock) {
+		fprintf(stderr, "%s: Error reading keyblock.\n", job->outfile);
+		goto done;
+	}
+
+	signpriv_key = vb2_read_private_key(job->signprivkey_file);
+	if (!signpriv_key) {
+		fprintf(stderr, "%s: Error reading signing key.\n",
+			job->outfile);
+		goto done;
+	}
+
+	VB2_DEBUG("Reading %s\n", job->config_file);
+	config_data = ReadConfigFile(job->config_file, &config_size);
+	if (!config_data) {
+		fprintf(stderr, "%s: Error reading config file.\n",
+			job->outfile);
+		goto done;
+	}
+
+	kblob_data = CreateKernelBlob(
+		&kb, batch->vmlinuz_buf, batch->vmlinuz_size,
+		batch->arch, batch->kernel_body_load_address,
+		config_data, config_size,
+		batch->bootloader_data, batch->bootloader_size,
+		&kblob_size);
+	if (!kblob_data) {
+		fprintf(stderr, "%s: Unable to create kernel blob\n",
+			job->outfile);
+		goto done;
+	}
+
+	vblock_data = SignKernelBlob(&kb, kblob_data, kblob_size, opt_pad,
+				     batch->version,
+				     batch->kernel_body_load_address,
+				     keyblock, signpriv_key, batch->flags,
+				     &vblock_size);
+	if (!vblock_data) {
+		fprintf(stderr, "%s: Unable to sign kernel blob\n",
+			job->outfile);
+		goto done;
+	}
+
+	if (opt_vblockonly)
+		rv = WriteSomeParts(job->outfile,
+				    vblock_data, vblock_size,
+				    NULL, 0);
+	else
+		rv = WriteSomeParts(job->outfile,
+				    vblock_data, vblock_size,
+				    kblob_data, kblob_size);
+
+done:
+	free(vblock_data);
+	free(kblob_data);
+	free(config_data);
+	vb2_free_private_key(signpriv_key);
+	free(keyblock);
+	return rv;
+}
+
+static void *pack_worker(void *arg)
+{
+	struct pack_batch *batch = arg;
+	int i;
+
+	while (1) {
+		pthread_mutex_lock(&batch->lock);
+		i = batch->next_job++;
+		pthread_mutex_unlock(&batch->lock);
+		if (i >= batch->num_jobs)
+			break;
+		batch->jobs[i].rv = pack_one(batch, &batch->jobs[i]);
+	}
+	return NULL;
+}
+
+/*
+ * Parses the --pack-batch list in place. Fields that are left out fall back to
+ * the given defaults. Returns the number of jobs, or -1 on error.
+ */
+static int parse_pack_list(char *list, struct pack_job **jobs_ptr,
+			   const char *keyblock_file,
+			   const char *signprivkey_file,
+			   const char *config_file)
+{
+	const char *defaults[3] = {keyblock_file, signprivkey_file,
+				   config_file};
+	const char *names[3] = {"keyblock", "signprivate", "config"};
+	struct pack_job *jobs = NULL;
+	char *line, *save_line, *field, *save_field;
+	const char *fields[4];
+	int num_jobs = 0;
+	int i, n;
+
+	for (line = strtok_r(list, "\n", &save_line); line;
+	     line = strtok_r(NULL, "\n", &save_line)) {
+		n = 0;
+		for (field = strtok_r(line, " \t\r", &save_field);
+		     field && n < 4;
+		     field = strtok_r(NULL, " \t\r", &save_field))
+			fields[n++] = field;
+		if (!n || fields[0][0] == '#')
+			continue;
+		if (field) {
+			fprintf(stderr, "Too many fields for %s\n", fields[0]);
+			goto fail;
+		}
+
+		for (i = 0; i < 3; i++) {
+			if (i + 1 >= n || !strcmp(fields[i + 1], "-"))
+				fields[i + 1] = defaults[i];
+			if (!fields[i + 1]) {
+				fprintf(stderr, "Missing %s for %s\n",
+					names[i], fields[0]);
+				goto fail;
+			}
+		}
+
+		jobs = realloc(jobs, (num_jobs + 1) * sizeof(*jobs));
+		if (!jobs)
+			goto fail;
+		jobs[num_jobs].outfile = fields[0];
+		jobs[num_jobs].keyblock_file = fields[1];
+		jobs[num_jobs].signprivkey_file = fields[2];
+		jobs[num_jobs].config_file = fields[3];
+		jobs[num_jobs].rv = 1;
+		num_jobs++;
+	}
+
+	*jobs_ptr = jobs;
+	return num_jobs;
+
+fail:
+	free(jobs);
+	return -1;
+}
+
+/* Packs each kernel in the list, using up to opt_jobs threads. */
+static int pack_batch(struct pack_batch *batch)
+{
+	pthread_t *threads;
+	int num_threads = opt_jobs;
+	int started = 0;
+	int rv = 0;
+	int i;
+
+	if (num_threads <= 0)
+		num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num_threads > batch->num_jobs)
+		num_threads = batch->num_jobs;
+	if (num_threads < 1)
+		num_threads = 1;
+
+	batch->next_job = 0;
+	pthread_mutex_init(&batch->lock, NULL);
+
+	/* This thread is one of the workers too. */
+	threads = calloc(num_threads, sizeof(*threads));
+	for (i = 1; threads && i < num_threads; i++) {
+		if (pthread_create(&threads[i], NULL, pack_worker, batch))
+			break;
+		started = i;
+	}
+	pack_worker(batch);
+	for (i = 1; i <= started; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+	pthread_mutex_destroy(&batch->lock);
+
+	for (i = 0; i < batch->num_jobs; i++) {
+		if (batch->jobs[i].rv) {
+			fprintf(stderr, "Unable to pack %s\n",
+				batch->jobs[i].outfile);
+			rv = 1;
+		}
+	}
+	return rv;
+}
+
 /****************************************************************************/
 
 static int do_vbutil_kernel(int argc, char *argv[])
@@ -250,6 +506,10 @@ static int do_vbutil_kernel(int argc, char *argv[])
 	uint32_t vblock_size = 0;
 	uint32_t flags = 0;
 	FILE *f;
+	struct kernel_blob kb;
+	struct pack_batch batch;
+	uint8_t *list_data;
+	uint32_t list_size;
 
 	while (((i = getopt_long(argc, argv, ":", long_opts, NULL)) != -1) &&
 	       !parse_error) {
@@ -271,6 +531,7 @@ static int do_vbutil_kernel(int argc, char *argv[])
 		case OPT_MODE_REPACK:
 		case OPT_MODE_VERIFY:
 		case OPT_MODE_GET_VMLINUZ:
+		case OPT_MODE_PACK_BATCH:
 			if (mode && (mode != i)) {
 				fprintf(stderr,
 					"Only one mode can be specified\n");
@@ -374,6 +635,15 @@ static int do_vbutil_kernel(int argc, char *argv[])
 			break;
 		case OPT_VMLINUZ_OUT:
 			vmlinuz_out_file = optarg;
+			break;
+
+		case OPT_JOBS:
+			opt_jobs = strtoul(optarg, &e, 0);
+			if (!*optarg || (e && *e)) {
+				fprintf(stderr, "Invalid --jobs\n");
+				parse_error = 1;
+			}
+			break;
 		}
 	}
 
@@ -432,7 +702,7 @@ static int do_vbutil_kernel(int argc, char *argv[])
 			FATAL("Empty vmlinuz file\n");
 
 		kblob_data = CreateKernelBlob(
-			vmlinuz_buf, vmlinuz_size,
+			&kb, vmlinuz_buf, vmlinuz_size,
 			arch, kernel_body_load_address,
 			t_config_data, t_config_size,
 			t_bootloader_data, t_bootloader_size,
@@ -442,8 +712,9 @@ static int do_vbutil_kernel(int argc, char *argv[])
 
 		VB2_DEBUG("kblob_size = %#x\n", kblob_size);
 
-		vblock_data = SignKernelBlob(kblob_data, kblob_size, opt_pad,
-					     version, kernel_body_load_address,
+		vblock_data = SignKernelBlob(&kb, kblob_data, kblob_size,
+					     opt_pad, version,
+					     kernel_body_load_address,
 					     t_keyblock, signpriv_key, flags,
 					     &vblock_size);
 		if (!vblock_data)
@@ -489,9 +760,10 @@ static int do_vbutil_kernel(int argc, char *argv[])
 		    futil_file_type_buf(kpart_data, kpart_size))
 			FATAL("%s is not a kernel blob\n", oldfile);
 
-		kblob_data = unpack_kernel_partition(kpart_data, kpart_size,
-						     opt_pad, &keyblock,
-						     &preamble, &kblob_size);
+		kblob_data = unpack_kernel_partition(&kb, kpart_data,
+						     kpart_size, opt_pad,
+						     &keyblock, &preamble,
+						     &kblob_size);
 
 		if (!kblob_data)
 			FATAL("Unable to unpack kernel partition\n");
@@ -506,7 +778,7 @@ static int do_vbutil_kernel(int argc, char *argv[])
 			if (!t_config_data)
 				FATAL("Error reading config file.\n");
 			if (0 != UpdateKernelBlobConfig(
-				    kblob_data, kblob_size,
+				    &kb, kblob_data, kblob_size,
 				    t_config_data, t_config_size))
 				FATAL("Unable to update config\n");
 		}
@@ -525,8 +797,9 @@ static int do_vbutil_kernel(int argc, char *argv[])
 		}
 
 		/* Reuse previous body size */
-		vblock_data = SignKernelBlob(kblob_data, kblob_size, opt_pad,
-					     version, kernel_body_load_address,
+		vblock_data = SignKernelBlob(&kb, kblob_data, kblob_size,
+					     opt_pad, version,
+					     kernel_body_load_address,
 					     t_keyblock ? t_keyblock : keyblock,
 					     signpriv_key, flags, &vblock_size);
 		if (!vblock_data)
@@ -557,13 +830,13 @@ static int do_vbutil_kernel(int argc, char *argv[])
 		/* Load the kernel partition */
 		kpart_data = ReadOldKPartFromFileOrDie(filename, &kpart_size);
 
-		kblob_data = unpack_kernel_partition(kpart_data, kpart_size,
-						     opt_pad, 0, 0,
+		kblob_data = unpack_kernel_partition(&kb, kpart_data,
+						     kpart_size, opt_pad, 0, 0,
 						     &kblob_size);
 		if (!kblob_data)
 			FATAL("Unable to unpack kernel partition\n");
 
-		rv = VerifyKernelBlob(kblob_data, kblob_size,
+		rv = VerifyKernelBlob(&kb, kblob_data, kblob_size,
 				      signpub_key, keyblock_file, min_version);
 
 		return rv;
@@ -580,9 +853,10 @@ static int do_vbutil_kernel(int argc, char *argv[])
 
 		kpart_data = ReadOldKPartFromFileOrDie(filename, &kpart_size);
 
-		kblob_data = unpack_kernel_partition(kpart_data, kpart_size,
-						     opt_pad, &keyblock,
-						     &preamble, &kblob_size);
+		kblob_data = unpack_kernel_partition(&kb, kpart_data,
+						     kpart_size, opt_pad,
+						     &keyblock, &preamble,
+						     &kblob_size);
 
 		if (!kblob_data)
 			FATAL("Unable to unpack kernel partition\n");
@@ -639,11 +913,67 @@ static int do_vbutil_kernel(int argc, char *argv[])
 
 		fclose(f);
 		return 0;
+
+	case OPT_MODE_PACK_BATCH:
+
+		VB2_DEBUG("Reading %s\n", filename);
+		if (VB2_SUCCESS != vb2_read_file(filename, &list_data,
+						 &list_size))
+			FATAL("Error reading list file.\n");
+		/* Make room for the terminating NUL */
+		list_data = realloc(list_data, list_size + 1);
+		if (!list_data)
+			FATAL("Can't allocate list file buffer\n");
+		list_data[list_size] = '\0';
+
+		memset(&batch, 0, sizeof(batch));
+		batch.num_jobs = parse_pack_list((char *)list_data,
+						 &batch.jobs,
+						 keyblock_file,
+						 signprivkey_file,
+						 config_file);
+		if (batch.num_jobs < 0)
+			FATAL("Error parsing list file.\n");
+		if (!batch.num_jobs)
+			FATAL("No kernels to pack in %s\n", filename);
+
+		if (!bootloader_file)
+			FATAL("Missing required bootloader file.\n");
+
+		VB2_DEBUG("Reading %s\n", bootloader_file);
+		if (VB2_SUCCESS != vb2_read_file(bootloader_file,
+						 &batch.bootloader_data,
+						 &batch.bootloader_size))
+			FATAL("Error reading bootloader file.\n");
+
+		if (!vmlinuz_file)
+			FATAL("Missing required vmlinuz file.\n");
+
+		VB2_DEBUG("Reading %s\n", vmlinuz_file);
+		if (VB2_SUCCESS != vb2_read_file(vmlinuz_file,
+						 &batch.vmlinuz_buf,
+						 &batch.vmlinuz_size))
+			FATAL("Error reading vmlinuz file.\n");
+		if (!batch.vmlinuz_size)
+			FATAL("Empty vmlinuz file\n");
+
+		batch.arch = arch;
+		batch.kernel_body_load_address = kernel_body_load_address;
+		batch.version = version;
+		batch.flags = flags;
+
+		rv = pack_batch(&batch);
+
+		free(batch.vmlinuz_buf);
+		free(batch.bootloader_data);
+		free(batch.jobs);
+		free(list_data);
+		return rv;
 	}
 
 	fprintf(stderr,
-		"You must specify a mode: "
-		"--pack, --repack, --verify, or --get-vmlinuz\n");
+		"You must specify a mode: --pack, --repack, --verify, "
+		"--get-vmlinuz, or --pack-batch\n");
 	print_help(argc, argv);
 	return 1;
 }
@@ -69,24 +69,24 @@ static char *FindKernelConfigFromStream(void *ctx, ReadFullyFn read_fn,
 
 	/* Skip the keyblock */
 	if (read_fn(ctx, &keyblock, sizeof(keyblock)) != sizeof(keyblock)) {
-		FATAL("not enough data to fill keyblock header\n");
+		ERROR("not enough data to fill keyblock header\n");
 		return NULL;
 	}
 	ssize_t to_skip = keyblock.keyblock_size - sizeof(keyblock);
 	if (to_skip < 0 || SkipWithRead(ctx, read_fn, to_skip)) {
-		FATAL("keyblock_size advances past the end of the blob\n");
+		ERROR("keyblock_size advances past the end of the blob\n");
 		return NULL;
 	}
 	now += keyblock.keyblock_size;
 
 	/* Open up the preamble */
 	if (read_fn(ctx, &preamble, sizeof(preamble)) != sizeof(preamble)) {
-		FATAL("not enough data to fill preamble\n");
+		ERROR("not enough data to fill preamble\n");
 		return NULL;
 	}
 	to_skip = preamble.preamble_size - sizeof(preamble);
 	if (to_skip < 0 || SkipWithRead(ctx, read_fn, to_skip)) {
-		FATAL("preamble_size advances past the end of the blob\n");
+		ERROR("preamble_size advances past the end of the blob\n");
 		return NULL;
 	}
 	now += preamble.preamble_size;
@@ -104,16 +104,16 @@ static char *FindKernelConfigFromStream(void *ctx, ReadFullyFn read_fn,
 	     CROS_CONFIG_SIZE) + now;
 	to_skip = offset - now;
 	if (to_skip < 0 || SkipWithRead(ctx, read_fn, to_skip)) {
-		FATAL("params are outside of the memory blob: %x\n", offset);
+		ERROR("params are outside of the memory blob: %x\n", offset);
 		return NULL;
 	}
 	char *ret = malloc(CROS_CONFIG_SIZE);
 	if (!ret) {
-		FATAL("No memory\n");
+		ERROR("No memory\n");
 		return NULL;
 	}
 	if (read_fn(ctx, ret, CROS_CONFIG_SIZE) != CROS_CONFIG_SIZE) {
-		FATAL("Cannot read kernel config\n");
+		ERROR("Cannot read kernel config\n");
 		free(ret);
 		ret = NULL;
 	}
@@ -130,7 +130,7 @@ char *FindKernelConfig(const char *infile, uint64_t kernel_body_load_address)
 #endif
 			);
 	if (fd < 0) {
-		FATAL("Cannot open %s\n", infile);
+		ERROR("Cannot open %s\n", infile);
 		return NULL;
 	}
 
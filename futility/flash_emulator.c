@@ -0,0 +1,152 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * An in-memory SPI flash chip with a timing model.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "2common.h"
+#include "flash_emulator.h"
+#include "futility.h"
+
+/*
+ * Typical numbers for a 4K-sector SPI NOR chip (datasheet typical values)
+ * behind the host programmer.
+ */
+static const struct flash_timing default_timing = {
+	.erase_block_size = 4 * 1024,
+	.page_size = 256,
+	.read_bandwidth = 8 * 1024 * 1024,
+	.erase_us = 45000,
+	.program_us = 700,
+};
+
+int flash_emulator_init(struct flash_emulator *flash, const uint8_t *data,
+			uint32_t size)
+{
+	memset(flash, 0, sizeof(*flash));
+	flash->data = malloc(size);
+	if (!flash->data)
+		return -1;
+	memcpy(flash->data, data, size);
+	flash->size = size;
+	flash->timing = default_timing;
+	return 0;
+}
+
+void flash_emulator_free(struct flash_emulator *flash)
+{
+	free(flash->data);
+	memset(flash, 0, sizeof(*flash));
+}
+
+int flash_emulator_read(struct flash_emulator *flash, uint32_t offset,
+			uint32_t size, uint8_t *buf)
+{
+	if (offset > flash->size || size > flash->size - offset) {
+		ERROR("(emulation) Read %#x+%#x is outside the flash (%#x).\n",
+		      offset, size, flash->size);
+		return -1;
+	}
+	if (buf)
+		memcpy(buf, flash->data + offset, size);
+	flash->stats.read_bytes += size;
+	flash->stats.time_us += (uint64_t)size * 1000000 /
+				flash->timing.read_bandwidth;
+	return 0;
+}
+
+/* Writes one erase block at offset with new contents. */
+static void write_block(struct flash_emulator *flash, uint32_t offset,
+			const uint8_t *new_data, uint32_t size)
+{
+	const struct flash_timing *t = &flash->timing;
+	uint8_t *block = flash->data + offset;
+	uint32_t i, page_size;
+
+	if (!memcmp(block, new_data, size))
+		return;
+
+	/* Programming can only clear bits; setting one needs an erase. */
+	for (i = 0; i < size; i++) {
+		if ((block[i] & new_data[i]) == new_data[i])
+			continue;
+		memset(block, 0xff, size);
+		flash->stats.erase_blocks++;
+		flash->stats.time_us += t->erase_us;
+		break;
+	}
+
+	for (i = 0; i < size; i += page_size) {
+		page_size = VB2_MIN(t->page_size, size - i);
+		if (!memcmp(block + i, new_data + i, page_size))
+			continue;
+		memcpy(block + i, new_data + i, page_size);
+		flash->stats.program_pages++;
+		flash->stats.time_us += t->program_us;
+	}
+}
+
+int flash_emulator_write(struct flash_emulator *flash, uint32_t offset,
+			 const uint8_t *data, uint32_t size, int verify)
+{
+	const uint32_t block_size = flash->timing.erase_block_size;
+	uint32_t start, end, block, block_end;
+	uint8_t *buf;
+
+	if (offset > flash->size || size > flash->size - offset) {
+		ERROR("(emulation) Write %#x+%#x is outside the flash (%#x).\n",
+		      offset, size, flash->size);
+		return -1;
+	}
+	if (flash->wp_size && offset < flash->wp_start + flash->wp_size &&
+	    flash->wp_start < offset + size) {
+		ERROR("(emulation) Write %#x+%#x overlaps write protected "
+		      "range %#x+%#x.\n", offset, size, flash->wp_start,
+		      flash->wp_size);
+		return -1;
+	}
+
+	start = offset / block_size * block_size;
+	end = VB2_MIN((uint64_t)flash->size,
+		      ((uint64_t)offset + size + block_size - 1) /
+		      block_size * block_size);
+
+	/* Read the blocks to find those which need no change. */
+	if (flash_emulator_read(flash, start, end - start, NULL))
+		return -1;
+
+	buf = malloc(block_size);
+	if (!buf)
+		return -1;
+
+	for (block = start; block < end; block = block_end) {
+		uint32_t from, to;
+
+		block_end = VB2_MIN(end, block + block_size);
+		from = VB2_MAX(block, offset);
+		to = VB2_MIN(block_end, offset + size);
+
+		/* Bytes outside the range keep their old contents. */
+		memcpy(buf, flash->data + block, block_end - block);
+		memcpy(buf + from - block, data + from - offset, to - from);
+		write_block(flash, block, buf, block_end - block);
+	}
+	free(buf);
+
+	if (verify)
+		return flash_emulator_read(flash, offset, size, NULL);
+	return 0;
+}
+
+void flash_emulator_print_stats(const struct flash_emulator *flash)
+{
+	STATUS("(emulation) Flash time: %llu ms (read %llu bytes, "
+	       "erased %u blocks, programmed %u pages).\n",
+	       (unsigned long long)(flash->stats.time_us / 1000),
+	       (unsigned long long)flash->stats.read_bytes,
+	       flash->stats.erase_blocks, flash->stats.program_pages);
+}
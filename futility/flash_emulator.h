@@ -0,0 +1,72 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * An in-memory SPI flash chip with a timing model, used by the firmware
+ * updater in emulation mode to estimate how long flashing would take.
+ */
+
+#ifndef VBOOT_REFERENCE_FUTILITY_FLASH_EMULATOR_H_
+#define VBOOT_REFERENCE_FUTILITY_FLASH_EMULATOR_H_
+
+#include <stdint.h>
+
+/* Characteristics of the emulated chip and programmer. */
+struct flash_timing {
+	uint32_t erase_block_size;	/* Smallest erasable unit, in bytes */
+	uint32_t page_size;		/* Largest programmable unit, in bytes */
+	uint32_t read_bandwidth;	/* Bytes per second */
+	uint32_t erase_us;		/* Time to erase one block */
+	uint32_t program_us;		/* Time to program one page */
+};
+
+/* Operations done on the emulated chip so far. */
+struct flash_stats {
+	uint64_t read_bytes;
+	uint32_t erase_blocks;
+	uint32_t program_pages;
+	uint64_t time_us;
+};
+
+struct flash_emulator {
+	struct flash_timing timing;
+	struct flash_stats stats;
+	uint8_t *data;
+	uint32_t size;
+	/* Writes into [wp_start, wp_start + wp_size) are refused. */
+	uint32_t wp_start, wp_size;
+};
+
+/*
+ * Sets up an emulated chip holding a copy of data, with default timing and
+ * no write protection.
+ * Returns 0 on success, otherwise non-zero.
+ */
+int flash_emulator_init(struct flash_emulator *flash, const uint8_t *data,
+			uint32_t size);
+
+/* Releases the contents of an emulated chip. */
+void flash_emulator_free(struct flash_emulator *flash);
+
+/*
+ * Reads size bytes at offset into buf (which may be NULL to only account for
+ * the time).
+ * Returns 0 on success, otherwise non-zero.
+ */
+int flash_emulator_read(struct flash_emulator *flash, uint32_t offset,
+			uint32_t size, uint8_t *buf);
+
+/*
+ * Writes size bytes of data at offset, the way flashrom does: erase blocks
+ * are read first, unchanged blocks are skipped, blocks are erased only when
+ * some bit has to go from 0 to 1, and only changed pages are programmed.
+ * If verify is set, the range is read back afterwards.
+ * Returns 0 on success, otherwise non-zero (e.g. write protected).
+ */
+int flash_emulator_write(struct flash_emulator *flash, uint32_t offset,
+			 const uint8_t *data, uint32_t size, int verify);
+
+/* Prints the operations done and modelled time so far. */
+void flash_emulator_print_stats(const struct flash_emulator *flash);
+
+#endif  /* VBOOT_REFERENCE_FUTILITY_FLASH_EMULATOR_H_ */
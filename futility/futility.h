@@ -113,6 +113,24 @@ void update_hwid_digest(struct vb2_gbb_header *gbb);
 int print_hwid_digest(struct vb2_gbb_header *gbb,
 		      const char *banner, const char *footer);
 
+/* Ways of copying a file, fastest first */
+enum futil_copy_method {
+	FUTIL_COPY_CLONE,	/* Reflink with FICLONE, copying nothing */
+	FUTIL_COPY_RANGE,	/* copy_file_range() inside the kernel */
+	FUTIL_COPY_BUFFERED,	/* read() and write() */
+};
+
+/*
+ * Copies infile to outfile without spawning a process.  Methods are tried
+ * from first_method down until one of them works, so unsupported methods
+ * cost only a failed syscall.  Inputs which aren't regular files, like pipes
+ * and character devices, are always copied with read() and write().
+ *
+ * Returns the enum futil_copy_method that finished the copy, or -1 if error.
+ */
+int futil_copy_file(const char *infile, const char *outfile,
+		    enum futil_copy_method first_method);
+
 /* Copies a file or dies with an error message */
 void futil_copy_file_or_die(const char *infile, const char *outfile);
 
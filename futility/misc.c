@@ -7,7 +7,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #if !defined(HAVE_MACOS) && !defined(__FreeBSD__) && !defined(__OpenBSD__)
-#include <linux/fs.h>		/* For BLKGETSIZE64 */
+#include <linux/fs.h>		/* For BLKGETSIZE64 and FICLONE */
+#define HAVE_COPY_FILE_RANGE
 #endif
 #include <stdarg.h>
 #include <stdint.h>
@@ -18,7 +19,6 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
-#include <sys/wait.h>
 #include <unistd.h>
 
 #include "2common.h"
@@ -205,58 +205,213 @@ int futil_set_gbb_hwid(struct vb2_gbb_header *gbb, const char *hwid)
 				 sizeof(gbb->hwid_digest));
 }
 
+/* Size of the bounce buffer for a plain read()/write() copy */
+#define COPY_BUFFER_SIZE (1024 * 1024)
+
 /*
- * TODO: All sorts of race conditions likely here, and everywhere this is used.
- * Do we care? If so, fix it.
+ * Copy whatever is left from in_fd to out_fd with read() and write(), picking
+ * up where a faster method may have given up.
  */
-void futil_copy_file_or_die(const char *infile, const char *outfile)
+static int copy_buffered(int in_fd, int out_fd, off_t offset, off_t size)
+{
+	uint8_t *buf;
+	ssize_t rd, wr, done;
+	int rv = 0;
+
+	buf = malloc(COPY_BUFFER_SIZE);
+	if (!buf) {
+		fprintf(stderr, "Couldn't allocate copy buffer\n");
+		return -1;
+	}
+
+	while (offset < size) {
+		rd = pread(in_fd, buf, COPY_BUFFER_SIZE, offset);
+		if (rd < 0 && errno == EINTR)
+			continue;
+		if (rd <= 0) {
+			fprintf(stderr, "Read error: %s\n",
+				rd ? strerror(errno) : "unexpected EOF");
+			rv = -1;
+			break;
+		}
+		for (done = 0; done < rd; done += wr) {
+			wr = pwrite(out_fd, buf + done, rd - done,
+				    offset + done);
+			if (wr < 0 && errno == EINTR) {
+				wr = 0;
+				continue;
+			}
+			if (wr <= 0) {
+				fprintf(stderr, "Write error: %s\n",
+					strerror(errno));
+				rv = -1;
+				goto done;
+			}
+		}
+		offset += rd;
+	}
+done:
+	free(buf);
+	return rv;
+}
+
+/*
+ * Copy from in_fd to out_fd with read() and write() until end of file, for
+ * inputs like pipes and devices which have no size to go by.
+ */
+static int copy_stream(int in_fd, int out_fd)
+{
+	uint8_t *buf;
+	ssize_t rd, wr, done;
+	int rv = 0;
+
+	buf = malloc(COPY_BUFFER_SIZE);
+	if (!buf) {
+		fprintf(stderr, "Couldn't allocate copy buffer\n");
+		return -1;
+	}
+
+	for (;;) {
+		rd = read(in_fd, buf, COPY_BUFFER_SIZE);
+		if (rd < 0 && errno == EINTR)
+			continue;
+		if (rd < 0) {
+			fprintf(stderr, "Read error: %s\n", strerror(errno));
+			rv = -1;
+			break;
+		}
+		if (!rd)
+			break;
+		for (done = 0; done < rd; done += wr) {
+			wr = write(out_fd, buf + done, rd - done);
+			if (wr < 0 && errno == EINTR) {
+				wr = 0;
+				continue;
+			}
+			if (wr <= 0) {
+				fprintf(stderr, "Write error: %s\n",
+					strerror(errno));
+				rv = -1;
+				goto done;
+			}
+		}
+	}
+done:
+	free(buf);
+	return rv;
+}
+
+int futil_copy_file(const char *infile, const char *outfile,
+		    enum futil_copy_method first_method)
 {
-	pid_t pid;
-	int status;
+	enum futil_copy_method method = first_method;
+	struct stat in_sb, out_sb;
+	off_t offset = 0;
+	int in_fd, out_fd;
+	int rv = -1;
 
 	VB2_DEBUG("%s -> %s\n", infile, outfile);
 
-	pid = fork();
+	in_fd = open(infile, O_RDONLY);
+	if (in_fd < 0) {
+		fprintf(stderr, "Can't open %s for reading: %s\n",
+			infile, strerror(errno));
+		return -1;
+	}
+	if (fstat(in_fd, &in_sb)) {
+		fprintf(stderr, "Can't stat %s: %s\n",
+			infile, strerror(errno));
+		close(in_fd);
+		return -1;
+	}
+	if (S_ISDIR(in_sb.st_mode)) {
+		fprintf(stderr, "%s is a directory\n", infile);
+		close(in_fd);
+		return -1;
+	}
 
-	if (pid < 0) {
-		fprintf(stderr, "Couldn't fork /bin/cp process: %s\n",
-			strerror(errno));
-		exit(1);
+	/* Truncating the output must not destroy the input */
+	if (!stat(outfile, &out_sb) && out_sb.st_dev == in_sb.st_dev &&
+	    out_sb.st_ino == in_sb.st_ino) {
+		fprintf(stderr, "%s and %s are the same file\n",
+			infile, outfile);
+		close(in_fd);
+		return -1;
 	}
 
-	/* child */
-	if (!pid) {
-		execl("/bin/cp", "/bin/cp", infile, outfile, NULL);
-		fprintf(stderr, "Child couldn't exec /bin/cp: %s\n",
-			strerror(errno));
-		exit(1);
+	/* Like cp, a new file gets the permissions of the old one */
+	out_fd = open(outfile, O_WRONLY | O_CREAT | O_TRUNC,
+		      S_ISREG(in_sb.st_mode) ? in_sb.st_mode & 0777 : 0666);
+	if (out_fd < 0) {
+		fprintf(stderr, "Can't open %s for writing: %s\n",
+			outfile, strerror(errno));
+		close(in_fd);
+		return -1;
 	}
 
-	/* parent - wait for child to finish */
-	if (wait(&status) == -1) {
-		fprintf(stderr,
-			"Couldn't wait for /bin/cp process to exit: %s\n",
-			strerror(errno));
-		exit(1);
+	/* Pipes and devices (e.g. /dev/stdin) can only be read in order */
+	if (!S_ISREG(in_sb.st_mode)) {
+		method = FUTIL_COPY_BUFFERED;
+		rv = copy_stream(in_fd, out_fd);
+		goto done;
 	}
 
-	if (WIFEXITED(status)) {
-		status = WEXITSTATUS(status);
-		/* zero is normal exit */
-		if (!status)
-			return;
-		fprintf(stderr, "/bin/cp exited with status %d\n", status);
-		exit(1);
+#ifdef HAVE_COPY_FILE_RANGE
+	/* Share the extents, if the filesystem can. */
+	if (method == FUTIL_COPY_CLONE) {
+		if (!ioctl(out_fd, FICLONE, in_fd)) {
+			rv = 0;
+			goto done;
+		}
+		VB2_DEBUG("FICLONE: %s\n", strerror(errno));
+		method = FUTIL_COPY_RANGE;
 	}
 
-	if (WIFSIGNALED(status)) {
-		status = WTERMSIG(status);
-		fprintf(stderr, "/bin/cp was killed with signal %d\n", status);
-		exit(1);
+	/* Let the kernel move the data without a trip through userspace. */
+	if (method == FUTIL_COPY_RANGE) {
+		off_t out_offset = 0;
+
+		while (offset < in_sb.st_size) {
+			ssize_t n = copy_file_range(in_fd, &offset, out_fd,
+						    &out_offset,
+						    in_sb.st_size - offset, 0);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0) {
+				VB2_DEBUG("copy_file_range: %s\n",
+					  n ? strerror(errno) : "short copy");
+				break;
+			}
+		}
+		if (offset == in_sb.st_size) {
+			rv = 0;
+			goto done;
+		}
+		method = FUTIL_COPY_BUFFERED;
+	}
+#else
+	method = FUTIL_COPY_BUFFERED;
+#endif
+
+	rv = copy_buffered(in_fd, out_fd, offset, in_sb.st_size);
+
+done:
+	if (close(out_fd) && !rv) {
+		fprintf(stderr, "Error when closing %s: %s\n",
+			outfile, strerror(errno));
+		rv = -1;
 	}
+	close(in_fd);
 
-	fprintf(stderr, "I have no idea what just happened\n");
-	exit(1);
+	return rv ? -1 : (int)method;
+}
+
+void futil_copy_file_or_die(const char *infile, const char *outfile)
+{
+	if (futil_copy_file(infile, outfile, FUTIL_COPY_CLONE) < 0) {
+		fprintf(stderr, "Couldn't copy %s to %s\n", infile, outfile);
+		exit(1);
+	}
 }
 
 enum futil_file_err futil_open_file(const char *infile, int *fd,
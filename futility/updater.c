@@ -323,13 +323,16 @@ static int set_try_cookies(struct updater_config *cfg, const char *target,
 }
 
 /*
- * Emulates writing to firmware.
+ * Emulates writing to firmware, through the emulated flash chip whose
+ * contents are then saved to the emulation file.
  * Returns 0 if success, non-zero if error.
  */
-static int emulate_write_firmware(const char *filename,
+static int emulate_write_firmware(struct updater_config *cfg,
 				  const struct firmware_image *image,
 				  const char *section_name)
 {
+	const char *filename = cfg->emulation;
+	struct flash_emulator *flash = &cfg->emulated_flash;
 	struct firmware_image to_image = {0};
 	struct firmware_section from, to;
 	int errorcnt = 0;
@@ -365,16 +368,23 @@ static int emulate_write_firmware(const char *filename,
 		to.size = to_image.size;
 	}
 
+	if (!errorcnt && to_image.size != flash->size) {
+		ERROR("Emulated flash size is different (%s:%d != %d)\n",
+		      filename, to_image.size, flash->size);
+		errorcnt++;
+	}
+
 	if (!errorcnt) {
 		size_t to_write = VB2_MIN(to.size, from.size);
 
 		assert(from.data && to.data);
 		VB2_DEBUG("Writing %zu bytes\n", to_write);
-		memcpy(to.data, from.data, to_write);
+		errorcnt += !!flash_emulator_write(
+				flash, to.data - to_image.data, from.data,
+				to_write, !cfg->fast_update);
 	}
 
-	if (!errorcnt && vb2_write_file(
-			filename, to_image.data, to_image.size)) {
+	if (!errorcnt && vb2_write_file(filename, flash->data, flash->size)) {
 		ERROR("Failed writing to file: %s\n", filename);
 		errorcnt++;
 	}
@@ -394,13 +404,25 @@ static int write_firmware(struct updater_config *cfg,
 {
 	struct firmware_image *diff_image = NULL;
 
+	if (cfg->journal && !section_name && image == &cfg->image) {
+		if (image->size == cfg->image_current.size) {
+			if (cfg->emulation)
+				INFO("(emulation) Writing whole image from %s "
+				     "to %s (emu=%s, journal=%s).\n",
+				     image->file_name, image->programmer,
+				     cfg->emulation, cfg->journal);
+			return write_firmware_with_journal(cfg, image);
+		}
+		WARN("Image size is different from system firmware, "
+		     "not using journal %s.\n", cfg->journal);
+	}
+
 	if (cfg->emulation) {
 		INFO("(emulation) Writing %s from %s to %s (emu=%s).\n",
 		     section_name ? section_name : "whole image",
 		     image->file_name, image->programmer, cfg->emulation);
 
-		return emulate_write_firmware(
-				cfg->emulation, image, section_name);
+		return emulate_write_firmware(cfg, image, section_name);
 	}
 
 	if (cfg->fast_update && image == &cfg->image && cfg->image_current.data)
@@ -1020,8 +1042,6 @@ static enum updater_error_codes update_try_rw_firmware(
 	INFO("Checking compatibility...\n");
 	if (check_compatible_root_key(image_from, image_to))
 		return UPDATE_ERR_ROOT_KEY;
-	if (check_compatible_tpm_keys(cfg, image_to))
-		return UPDATE_ERR_TPM_ROLLBACK;
 
 	VB2_DEBUG("Firmware %s vboot2.\n", is_vboot2 ?  "is" : "is NOT");
 	target = decide_rw_target(cfg, TARGET_SELF, is_vboot2);
@@ -1082,8 +1102,6 @@ static enum updater_error_codes update_rw_firmware(
 	INFO("Checking compatibility...\n");
 	if (check_compatible_root_key(image_from, image_to))
 		return UPDATE_ERR_ROOT_KEY;
-	if (check_compatible_tpm_keys(cfg, image_to))
-		return UPDATE_ERR_TPM_ROLLBACK;
 	/*
 	 * TODO(hungte) Speed up by flashing multiple sections in one
 	 * command, or provide diff file.
@@ -1122,7 +1140,8 @@ static enum updater_error_codes update_legacy_firmware(
  */
 static enum updater_error_codes update_whole_firmware(
 		struct updater_config *cfg,
-		struct firmware_image *image_to)
+		struct firmware_image *image_to,
+		enum rootkey_compat_result target_rootkey)
 {
 	STATUS("FULL UPDATE: Updating whole firmware image(s), RO+RW.\n");
 
@@ -1131,10 +1150,10 @@ static enum updater_error_codes update_whole_firmware(
 
 	INFO("Checking compatibility...\n");
 	if (!cfg->force_update) {
-		/* Check if the image_to itself is broken */
-		enum rootkey_compat_result r = check_compatible_root_key(
-				image_to, image_to);
-		if (r != ROOTKEY_COMPAT_OK) {
+		enum rootkey_compat_result r;
+
+		/* The image_to itself was checked by check_target_image. */
+		if (target_rootkey != ROOTKEY_COMPAT_OK) {
 			ERROR("Target image does not look valid. \n"
 			      "Add --force if you really want to use it.");
 			return UPDATE_ERR_ROOT_KEY;
@@ -1157,8 +1176,6 @@ static enum updater_error_codes update_whole_firmware(
 			return UPDATE_ERR_ROOT_KEY;
 		}
 	}
-	if (check_compatible_tpm_keys(cfg, image_to))
-		return UPDATE_ERR_TPM_ROLLBACK;
 
 	/* FMAP may be different so we should just update all. */
 	if (write_firmware(cfg, image_to, NULL) ||
@@ -1169,6 +1186,33 @@ static enum updater_error_codes update_whole_firmware(
 	return UPDATE_ERR_DONE;
 }
 
+/*
+ * Checks the parts of target image that do not depend on the current system
+ * firmware, so they can be done while that is still being read.
+ * Whether the target RW is signed by its own root key is only fatal for a
+ * full update, which is not decided until write protection is known, so the
+ * result is stored in target_rootkey for update_whole_firmware.
+ * Returns UPDATE_ERR_DONE if success, otherwise error.
+ */
+static enum updater_error_codes check_target_image(
+		struct updater_config *cfg,
+		enum rootkey_compat_result *target_rootkey)
+{
+	*target_rootkey = ROOTKEY_COMPAT_OK;
+
+	/* Legacy update only replaces RW_LEGACY, which is not signed. */
+	if (cfg->legacy_update)
+		return UPDATE_ERR_DONE;
+
+	INFO("Checking target image...\n");
+	if (check_compatible_tpm_keys(cfg, &cfg->image))
+		return UPDATE_ERR_TPM_ROLLBACK;
+	if (!cfg->force_update)
+		*target_rootkey = check_compatible_root_key(&cfg->image,
+							    &cfg->image);
+	return UPDATE_ERR_DONE;
+}
+
 /*
  * The main updater to update system firmware using the configuration parameter.
  * Returns UPDATE_ERR_DONE if success, otherwise failure.
@@ -1177,6 +1221,8 @@ enum updater_error_codes update_firmware(struct updater_config *cfg)
 {
 	int wp_enabled, done = 0;
 	enum updater_error_codes r = UPDATE_ERR_UNKNOWN;
+	struct system_firmware_read pending = {0};
+	enum rootkey_compat_result target_rootkey;
 
 	struct firmware_image *image_from = &cfg->image_current,
 			      *image_to = &cfg->image;
@@ -1194,10 +1240,21 @@ enum updater_error_codes update_firmware(struct updater_config *cfg)
 		}
 	}
 	if (!image_from->data) {
-		int ret;
 		INFO("Loading current system firmware...\n");
-		ret = load_system_firmware(image_from, &cfg->tempfiles,
-					   cfg->verbosity);
+		if (load_system_firmware_start(&pending, image_from,
+					       &cfg->tempfiles, cfg->verbosity))
+			return UPDATE_ERR_SYSTEM_IMAGE;
+	}
+
+	/* Check the target image while the system firmware is being read. */
+	r = check_target_image(cfg, &target_rootkey);
+	if (r != UPDATE_ERR_DONE) {
+		load_system_firmware_cancel(&pending);
+		return r;
+	}
+
+	if (pending.pid) {
+		int ret = load_system_firmware_finish(&pending, image_from);
 		if (ret == IMAGE_PARSE_FAILURE && cfg->force_update) {
 			WARN("No compatible firmware in system.\n");
 			cfg->check_platform = 0;
@@ -1222,6 +1279,17 @@ enum updater_error_codes update_firmware(struct updater_config *cfg)
 	       get_system_property(SYS_PROP_WP_HW, cfg),
 	       get_system_property(SYS_PROP_WP_SW, cfg));
 
+	if (cfg->emulation && wp_enabled) {
+		struct firmware_section wp_ro;
+
+		find_firmware_section(&wp_ro, image_from, "WP_RO");
+		if (wp_ro.data) {
+			cfg->emulated_flash.wp_start =
+					wp_ro.data - image_from->data;
+			cfg->emulated_flash.wp_size = wp_ro.size;
+		}
+	}
+
 	if (try_apply_quirk(QUIRK_ENLARGE_IMAGE, cfg))
 		return UPDATE_ERR_SYSTEM_IMAGE;
 
@@ -1245,7 +1313,8 @@ enum updater_error_codes update_firmware(struct updater_config *cfg)
 
 	if (!done) {
 		r = wp_enabled ? update_rw_firmware(cfg, image_from, image_to) :
-				 update_whole_firmware(cfg, image_to);
+				 update_whole_firmware(cfg, image_to,
+						       target_rootkey);
 	}
 
 	/* Providing more hints for what to do on failure. */
@@ -1372,22 +1441,14 @@ static int updater_apply_white_label(struct updater_config *cfg,
 				     struct model_config *model,
 				     const char *signature_id)
 {
-	const char *tmp_image = NULL;
-
 	assert(model->is_white_label);
 	if (!signature_id) {
-		if (cfg->image_current.data) {
-			tmp_image = get_firmware_image_temp_file(
-					&cfg->image_current, &cfg->tempfiles);
-			if (!tmp_image)
-				return 1;
-		} else {
+		if (!cfg->image_current.data) {
 			INFO("Loading system firmware for white label...\n");
 			load_system_firmware(&cfg->image_current,
 					     &cfg->tempfiles, cfg->verbosity);
-			tmp_image = cfg->image_current.file_name;
 		}
-		if (!tmp_image) {
+		if (!cfg->image_current.data) {
 			ERROR("Failed to get system current firmware\n");
 			return 1;
 		}
@@ -1397,7 +1458,8 @@ static int updater_apply_white_label(struct updater_config *cfg,
 					cfg, model, &signature_id);
 	}
 	return !!model_apply_white_label(
-			model, cfg->archive, signature_id, tmp_image);
+			model, cfg->archive, signature_id,
+			&cfg->image_current);
 }
 
 /*
@@ -1476,6 +1538,8 @@ int updater_setup_config(struct updater_config *cfg,
 	/* Setup values that may change output or decision of other argument. */
 	cfg->verbosity = arg->verbosity;
 	cfg->fast_update = arg->fast_update;
+	cfg->journal = arg->journal;
+	cfg->journal_fail = arg->journal_fail;
 	cfg->factory_update = arg->is_factory;
 	if (arg->force_update)
 		cfg->force_update = 1;
@@ -1553,6 +1617,16 @@ int updater_setup_config(struct updater_config *cfg,
 		VB2_DEBUG("Using file %s for emulation.\n", arg->emulation);
 		errorcnt += !!load_firmware_image(
 				&cfg->image_current, arg->emulation, NULL);
+		if (cfg->image_current.data) {
+			struct flash_emulator *flash = &cfg->emulated_flash;
+
+			errorcnt += !!flash_emulator_init(
+					flash, cfg->image_current.data,
+					cfg->image_current.size);
+			/* Loading system firmware reads the whole chip. */
+			errorcnt += !!flash_emulator_read(
+					flash, 0, flash->size, NULL);
+		}
 	}
 
 	/* Always load images specified from command line directly. */
@@ -1659,6 +1733,7 @@ void updater_delete_config(struct updater_config *cfg)
 	free_firmware_image(&cfg->image_current);
 	free_firmware_image(&cfg->ec_image);
 	free_firmware_image(&cfg->pd_image);
+	flash_emulator_free(&cfg->emulated_flash);
 	remove_all_temp_files(&cfg->tempfiles);
 	if (cfg->archive)
 		archive_close(cfg->archive);
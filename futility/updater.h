@@ -8,6 +8,7 @@
 #ifndef VBOOT_REFERENCE_FUTILITY_UPDATER_H_
 #define VBOOT_REFERENCE_FUTILITY_UPDATER_H_
 
+#include "flash_emulator.h"
 #include "futility.h"
 #include "updater_utils.h"
 
@@ -15,6 +16,7 @@
 static const char * const FMAP_RO_FRID = "RO_FRID",
 		  * const FMAP_RO_SECTION = "RO_SECTION",
 		  * const FMAP_RO_GBB = "GBB",
+		  * const FMAP_RO_VPD = "RO_VPD",
 		  * const FMAP_RW_VBLOCK_A = "VBLOCK_A",
 		  * const FMAP_RW_VBLOCK_B = "VBLOCK_B",
 		  * const FMAP_RW_SECTION_A = "RW_SECTION_A",
@@ -71,6 +73,9 @@ struct updater_config {
 	int fast_update;
 	int verbosity;
 	const char *emulation;
+	struct flash_emulator emulated_flash;
+	const char *journal;
+	int journal_fail;
 	int override_gbb_flags;
 	uint32_t gbb_flags;
 };
@@ -83,6 +88,8 @@ struct updater_config_arguments {
 	char *emulation, *sys_props;
 	char *output_dir;
 	char *repack, *unpack;
+	char *journal;
+	int journal_fail;
 	int is_factory, try_update, force_update, do_manifest, host_only;
 	int fast_update;
 	int verbosity;
@@ -195,6 +202,18 @@ int quirk_override_signature_id(struct updater_config *cfg,
 				struct model_config *model,
 				const char **signature_id);
 
+/* Functions from updater_journal.c */
+
+/*
+ * Writes the whole image to system firmware in blocks, recording each block
+ * written in the journal file (cfg->journal). If the journal is for the same
+ * image, blocks it lists are verified against the current system firmware and
+ * skipped if they match, so an interrupted update resumes where it stopped.
+ * Returns 0 if success, non-zero if error.
+ */
+int write_firmware_with_journal(struct updater_config *cfg,
+				const struct firmware_image *image);
+
 /* Functions from updater_archive.c */
 
 /*
@@ -271,13 +290,13 @@ const struct model_config *manifest_find_model(const struct manifest *manifest,
 /*
  * Applies white label information to an existing model configuration.
  * Collects signature ID information from either parameter signature_id or
- * image file (via VPD) and updates model.patches for key files.
+ * image (via VPD) and updates model.patches for key files.
  * Returns 0 on success, otherwise failure.
  */
 int model_apply_white_label(
 		struct model_config *model,
 		struct archive *archive,
 		const char *signature_id,
-		const char *image);
+		const struct firmware_image *image);
 
 #endif  /* VBOOT_REFERENCE_FUTILITY_UPDATER_H_ */
@@ -33,6 +33,7 @@
 #include "host_misc.h"
 #include "updater.h"
 #include "util_misc.h"
+#include "vpd.h"
 
 /*
  * A firmware update package (archive) is a file packed by either shar(1) or
@@ -533,21 +534,17 @@ static int str_startswith(const char *name, const char *pattern)
 	return strncmp(name, pattern, strlen(pattern)) == 0;
 }
 
-/* Returns the VPD value by given key name, or NULL on error (or no value). */
-static char *vpd_get_value(const char *fpath, const char *key)
+/*
+ * Returns a copy of the VPD value by given key name, or NULL if there is no
+ * value. Caller must free the returned string.
+ */
+static char *vpd_dup_value(const struct vpd *vpd, const char *key)
 {
-	char *command, *result;
+	const char *value = vpd_get_value(vpd, key);
 
-	assert(fpath);
-	ASPRINTF(&command, "vpd -g %s -f %s 2>/dev/null", key, fpath);
-	result = host_shell(command);
-	free(command);
-
-	if (result && !*result) {
-		free(result);
-		result = NULL;
-	}
-	return result;
+	if (!value || !*value)
+		return NULL;
+	return strdup(value);
 }
 
 /*
@@ -875,29 +872,39 @@ const struct model_config *manifest_find_model(const struct manifest *manifest,
  * Returns the signature ID for looking up rootkey and vblock files.
  * Caller must free the returned string.
  */
-static char *resolve_signature_id(struct model_config *model, const char *image)
+static char *resolve_signature_id(struct model_config *model,
+				  const struct firmware_image *image)
 {
 	int is_unibuild = model->signature_id ? 1 : 0;
-	char *wl_tag = vpd_get_value(image, VPD_WHITELABEL_TAG);
+	struct vpd vpd;
+	char *wl_tag;
 	char *sig_id = NULL;
 
+	if (vpd_parse_section(&vpd, image->data, image->size, FMAP_RO_VPD)) {
+		WARN("Failed to parse VPD in %s.\n", FMAP_RO_VPD);
+		vpd_free(&vpd);
+	}
+	wl_tag = vpd_dup_value(&vpd, VPD_WHITELABEL_TAG);
+
 	/* Unified build: $model.$wl_tag, or $model (b/126800200). */
 	if (is_unibuild) {
 		if (!wl_tag) {
 			WARN("No VPD '%s' set for white label - use model name "
 			     "'%s' as default.\n", VPD_WHITELABEL_TAG,
 			     model->name);
+			vpd_free(&vpd);
 			return strdup(model->name);
 		}
 
 		ASPRINTF(&sig_id, "%s-%s", model->name, wl_tag);
 		free(wl_tag);
+		vpd_free(&vpd);
 		return sig_id;
 	}
 
 	/* Non-Unibuild: Upper($wl_tag), or Upper(${cid%%-*}). */
 	if (!wl_tag) {
-		char *cid = vpd_get_value(image, VPD_CUSTOMIZATION_ID);
+		char *cid = vpd_dup_value(&vpd, VPD_CUSTOMIZATION_ID);
 		if (cid) {
 			/* customization_id in format LOEM[-VARIANT]. */
 			char *dash = strchr(cid, '-');
@@ -908,20 +915,21 @@ static char *resolve_signature_id(struct model_config *model, const char *image)
 	}
 	if (wl_tag)
 		str_convert(wl_tag, toupper);
+	vpd_free(&vpd);
 	return wl_tag;
 }
 
 /*
  * Applies white label information to an existing model configuration.
  * Collects signature ID information from either parameter signature_id or
- * image file (via VPD) and updates model.patches for key files.
+ * image (via VPD) and updates model.patches for key files.
  * Returns 0 on success, otherwise failure.
  */
 int model_apply_white_label(
 		struct model_config *model,
 		struct archive *archive,
 		const char *signature_id,
-		const char *image)
+		const struct firmware_image *image)
 {
 	char *sig_id = NULL;
 	int r = 0;
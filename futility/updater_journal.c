@@ -0,0 +1,306 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * A write journal for firmware updater, so an interrupted full update can be
+ * resumed without rewriting the blocks that were already done.
+ *
+ * The journal is a text file:
+ *   # futility update journal
+ *   target <sha256 of whole image> <image size>
+ *   done <offset> <size> <sha256 of block>
+ *   ...
+ * with a "done" line appended (and synced) after each block is written.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "2common.h"
+#include "2sha.h"
+#include "futility.h"
+#include "updater.h"
+
+/*
+ * Size of each journaled block. This must be a multiple of the erase block
+ * size of SPI flash chips (usually 4K or 64K), so that rewriting one block
+ * never erases a neighbour.
+ */
+#define JOURNAL_BLOCK_SIZE (1024 * 1024)
+
+#define JOURNAL_HEADER "# futility update journal"
+
+/* A SHA-256 digest in hex, plus the terminating NUL. */
+#define HASH_STR_SIZE (VB2_SHA256_DIGEST_SIZE * 2 + 1)
+
+/*
+ * Computes the SHA-256 digest of data as a hex string into hash_str.
+ * Returns 0 if success, non-zero if error.
+ */
+static int hash_string(const uint8_t *data, uint32_t size, char *hash_str)
+{
+	struct vb2_hash hash;
+	int i;
+
+	if (vb2_hash_calculate(data, size, VB2_HASH_SHA256, &hash))
+		return -1;
+	for (i = 0; i < VB2_SHA256_DIGEST_SIZE; i++)
+		sprintf(hash_str + i * 2, "%02x", hash.sha256[i]);
+	return 0;
+}
+
+/*
+ * Loads the journal at path, and marks the blocks it lists in done[] if the
+ * journal was made for an image with the target_hash and the block contents
+ * match block_hashes[].
+ * Returns the number of blocks marked.
+ */
+static int load_journal(const char *path, const char *target_hash,
+			uint32_t size, char (*block_hashes)[HASH_STR_SIZE],
+			uint8_t *done, int num_blocks)
+{
+	char line[256], hash[HASH_STR_SIZE];
+	unsigned int offset, block_size, image_size;
+	int index, count = 0;
+	FILE *fp;
+
+	fp = fopen(path, "r");
+	if (!fp) {
+		VB2_DEBUG("No journal in %s, starting a new one.\n", path);
+		return 0;
+	}
+
+	if (!fgets(line, sizeof(line), fp) ||
+	    strncmp(line, JOURNAL_HEADER, strlen(JOURNAL_HEADER)) ||
+	    !fgets(line, sizeof(line), fp) ||
+	    sscanf(line, "target %64s %u", hash, &image_size) != 2 ||
+	    image_size != size || strcmp(hash, target_hash)) {
+		INFO("Journal %s is not for this image, starting over.\n",
+		     path);
+		fclose(fp);
+		return 0;
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "done %x %x %64s", &offset, &block_size,
+			   hash) != 3 || offset % JOURNAL_BLOCK_SIZE) {
+			WARN("Ignored invalid journal entry: %s", line);
+			continue;
+		}
+		index = offset / JOURNAL_BLOCK_SIZE;
+		if (index >= num_blocks ||
+		    block_size != VB2_MIN(size - offset, JOURNAL_BLOCK_SIZE) ||
+		    strcmp(hash, block_hashes[index])) {
+			WARN("Ignored invalid journal entry: %s", line);
+			continue;
+		}
+		if (!done[index])
+			count++;
+		done[index] = 1;
+	}
+	fclose(fp);
+	return count;
+}
+
+/*
+ * Writes the header and the entries of blocks already done to a new journal.
+ * Returns the opened journal, or NULL on error.
+ */
+static FILE *start_journal(const char *path, const char *target_hash,
+			   uint32_t size, char (*block_hashes)[HASH_STR_SIZE],
+			   const uint8_t *done, int num_blocks)
+{
+	uint32_t offset;
+	FILE *fp;
+	int i;
+
+	fp = fopen(path, "w");
+	if (!fp) {
+		ERROR("Cannot create journal %s.\n", path);
+		return NULL;
+	}
+	fprintf(fp, JOURNAL_HEADER "\ntarget %s %u\n", target_hash, size);
+	for (i = 0; i < num_blocks; i++) {
+		if (!done[i])
+			continue;
+		offset = i * JOURNAL_BLOCK_SIZE;
+		fprintf(fp, "done %#x %#x %s\n", offset,
+			VB2_MIN(size - offset, JOURNAL_BLOCK_SIZE),
+			block_hashes[i]);
+	}
+	if (fflush(fp) || fsync(fileno(fp))) {
+		ERROR("Failed writing journal %s.\n", path);
+		fclose(fp);
+		return NULL;
+	}
+	return fp;
+}
+
+/*
+ * Records a written block to the journal, and syncs it to storage so the
+ * entry survives power loss.
+ * Returns 0 if success, non-zero if error.
+ */
+static int journal_block_done(FILE *fp, uint32_t offset, uint32_t size,
+			      const char *hash)
+{
+	fprintf(fp, "done %#x %#x %s\n", offset, size, hash);
+	return fflush(fp) || fsync(fileno(fp));
+}
+
+/*
+ * Emulates writing a block of firmware, through the emulated flash chip and
+ * then patching the emulation file.
+ * Returns 0 if success, non-zero if error.
+ */
+static int emulate_write_block(struct updater_config *cfg,
+			       const struct firmware_image *image,
+			       uint32_t offset, uint32_t size)
+{
+	struct flash_emulator *flash = &cfg->emulated_flash;
+	const char *filename = cfg->emulation;
+	FILE *fp;
+	int errorcnt = 0;
+
+	if (flash->size != image->size) {
+		ERROR("Emulated flash size is different (%s:%d != %d)\n",
+		      filename, flash->size, image->size);
+		return -1;
+	}
+	if (flash_emulator_write(flash, offset, image->data + offset, size,
+				 !cfg->fast_update))
+		return -1;
+
+	fp = fopen(filename, "r+b");
+	if (!fp) {
+		ERROR("Cannot open %s.\n", filename);
+		return -1;
+	}
+	if (fseek(fp, offset, SEEK_SET) ||
+	    fwrite(flash->data + offset, 1, size, fp) != size)
+		errorcnt++;
+	if (fclose(fp))
+		errorcnt++;
+	if (errorcnt)
+		ERROR("Failed writing to file: %s\n", filename);
+	return errorcnt;
+}
+
+int write_firmware_with_journal(struct updater_config *cfg,
+				const struct firmware_image *image)
+{
+	const struct firmware_image *current = &cfg->image_current;
+	char target_hash[HASH_STR_SIZE], current_hash[HASH_STR_SIZE];
+	char (*block_hashes)[HASH_STR_SIZE] = NULL;
+	const char *image_path = NULL;
+	uint8_t *done = NULL;
+	uint32_t offset, size;
+	int i, num_blocks, num_done, num_written = 0, errorcnt = 0;
+	FILE *fp = NULL;
+
+	num_blocks = (image->size + JOURNAL_BLOCK_SIZE - 1) /
+		     JOURNAL_BLOCK_SIZE;
+	block_hashes = calloc(num_blocks, sizeof(*block_hashes));
+	done = calloc(num_blocks, sizeof(*done));
+	if (!block_hashes || !done) {
+		ERROR("Failed to allocate memory for journal.\n");
+		errorcnt++;
+		goto out;
+	}
+
+	if (hash_string(image->data, image->size, target_hash)) {
+		errorcnt++;
+		goto out;
+	}
+	for (i = 0; i < num_blocks; i++) {
+		offset = i * JOURNAL_BLOCK_SIZE;
+		size = VB2_MIN(image->size - offset, JOURNAL_BLOCK_SIZE);
+		if (hash_string(image->data + offset, size, block_hashes[i])) {
+			errorcnt++;
+			goto out;
+		}
+	}
+
+	num_done = load_journal(cfg->journal, target_hash, image->size,
+				block_hashes, done, num_blocks);
+
+	/* Blocks in journal must still read back as what was written. */
+	for (i = 0; i < num_blocks && num_done; i++) {
+		if (!done[i])
+			continue;
+		offset = i * JOURNAL_BLOCK_SIZE;
+		size = VB2_MIN(image->size - offset, JOURNAL_BLOCK_SIZE);
+		if (current->data && current->size == image->size &&
+		    !hash_string(current->data + offset, size, current_hash) &&
+		    !strcmp(current_hash, block_hashes[i]))
+			continue;
+		WARN("Block at %#x in journal does not match system firmware, "
+		     "will be written again.\n", offset);
+		done[i] = 0;
+		num_done--;
+	}
+	if (num_done)
+		STATUS("Resuming update from journal %s: "
+		       "%d of %d blocks already written.\n",
+		       cfg->journal, num_done, num_blocks);
+
+	fp = start_journal(cfg->journal, target_hash, image->size,
+			   block_hashes, done, num_blocks);
+	if (!fp) {
+		errorcnt++;
+		goto out;
+	}
+
+	if (!cfg->emulation) {
+		image_path = get_firmware_image_temp_file(image,
+							  &cfg->tempfiles);
+		if (!image_path) {
+			errorcnt++;
+			goto out;
+		}
+	}
+
+	for (i = 0; i < num_blocks; i++) {
+		if (done[i])
+			continue;
+		offset = i * JOURNAL_BLOCK_SIZE;
+		size = VB2_MIN(image->size - offset, JOURNAL_BLOCK_SIZE);
+
+		if (cfg->journal_fail && num_written == cfg->journal_fail) {
+			ERROR("Injected failure before writing block at %#x.\n",
+			      offset);
+			errorcnt++;
+			break;
+		}
+
+		INFO("Writing block %d/%d (%#x bytes at %#x).\n", i + 1,
+		     num_blocks, size, offset);
+		if (cfg->emulation)
+			errorcnt += !!emulate_write_block(
+					cfg, image, offset, size);
+		else
+			errorcnt += !!write_system_firmware_range(
+					image, image_path, offset, size,
+					&cfg->tempfiles, cfg->verbosity + 1);
+		if (errorcnt)
+			break;
+		num_written++;
+
+		if (journal_block_done(fp, offset, size, block_hashes[i])) {
+			ERROR("Failed writing journal %s.\n", cfg->journal);
+			errorcnt++;
+			break;
+		}
+	}
+
+out:
+	if (fp)
+		fclose(fp);
+	/* The journal is no longer needed once the whole image is written. */
+	if (!errorcnt && unlink(cfg->journal))
+		WARN("Cannot remove journal %s.\n", cfg->journal);
+	free(block_hashes);
+	free(done);
+	return errorcnt;
+}
@@ -11,6 +11,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#include "cbfstool.h"
 #include "crossystem.h"
 #include "futility.h"
 #include "host_misc.h"
@@ -280,46 +281,46 @@ static int quirk_min_platform_version(struct updater_config *cfg)
  * Quirk to help preserving SMM store on devices without a dedicated "SMMSTORE"
  * FMAP section. These devices will store "smm_store" file in same CBFS where
  * the legacy boot loader lives (i.e, FMAP RW_LEGACY).
- * Note this currently has dependency on external program "cbstool".
+ * The CBFS is edited in place, without calling cbfstool.
  * Returns 0 if the SMM store is properly preserved, or if the system is not
- * available to do that (problem in cbfstool, or no "smm_store" in current
- * system firmware). Otherwise non-zero as failure.
+ * available to do that (no valid CBFS, or no "smm_store" in current system
+ * firmware). Otherwise non-zero as failure.
  */
 static int quirk_eve_smm_store(struct updater_config *cfg)
 {
 	const char *smm_store_name = "smm_store";
-	const char *old_store;
-	char *command;
-	const char *temp_image = get_firmware_image_temp_file(
-			&cfg->image_current, &cfg->tempfiles);
-
-	if (!temp_image)
-		return -1;
+	struct firmware_section from, to;
+	size_t offset, size;
+	vb2_error_t rv;
+
+	find_firmware_section(&from, &cfg->image_current, FMAP_RW_LEGACY);
+	find_firmware_section(&to, &cfg->image, FMAP_RW_LEGACY);
+	if (!from.data || !to.data) {
+		VB2_DEBUG("No %s section. Don't preserve.\n", FMAP_RW_LEGACY);
+		return 0;
+	}
 
-	old_store = cbfs_extract_file(temp_image, FMAP_RW_LEGACY,
-				      smm_store_name, &cfg->tempfiles);
-	if (!old_store) {
-		VB2_DEBUG("cbfstool failure or SMM store not available. "
+	if (cbfs_region_find(from.data, from.size, smm_store_name, &offset,
+			     &size)) {
+		VB2_DEBUG("CBFS failure or SMM store not available. "
 			  "Don't preserve.\n");
 		return 0;
 	}
 
-	/* Reuse temp_image */
-	temp_image = get_firmware_image_temp_file(&cfg->image, &cfg->tempfiles);
-	if (!temp_image)
-		return -1;
+	rv = cbfs_region_remove(to.data, to.size, smm_store_name);
+	if (rv && rv != VB2_ERROR_CBFS_NOT_FOUND) {
+		WARN("Cannot remove %s from %s (%#x).\n", smm_store_name,
+		     FMAP_RW_LEGACY, rv);
+		return 0;
+	}
 
 	/* crosreview.com/1165109: The offset is fixed at 0x1bf000. */
-	ASPRINTF(&command,
-		 "cbfstool \"%s\" remove -r %s -n \"%s\" 2>/dev/null; "
-		 "cbfstool \"%s\" add -r %s -n \"%s\" -f \"%s\" "
-		 " -t raw -b 0x1bf000", temp_image, FMAP_RW_LEGACY,
-		 smm_store_name, temp_image, FMAP_RW_LEGACY,
-		 smm_store_name, old_store);
-	free(host_shell(command));
-	free(command);
-
-	return reload_firmware_image(temp_image, &cfg->image);
+	rv = cbfs_region_add_raw(to.data, to.size, smm_store_name,
+				 from.data + offset, size, 0x1bf000);
+	if (rv)
+		WARN("Cannot add %s to %s (%#x).\n", smm_store_name,
+		     FMAP_RW_LEGACY, rv);
+	return 0;
 }
 
 /*
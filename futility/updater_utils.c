@@ -6,13 +6,13 @@
  */
 
 #include <assert.h>
+#include <errno.h>
 #include <limits.h>
+#include <signal.h>
 #include <sys/stat.h>
 #include <sys/types.h>
-#include <unistd.h>
-#if defined (__FreeBSD__) || defined(__OpenBSD__)
 #include <sys/wait.h>
-#endif
+#include <unistd.h>
 
 #include "2common.h"
 #include "crossystem.h"
@@ -519,16 +519,15 @@ char *host_detect_servo(int *need_prepare_ptr)
 }
 
 /*
- * A helper function to invoke flashrom(8) command.
- * Returns 0 if success, non-zero if error.
+ * Builds the shell command to invoke flashrom(8) for host_flashrom.
+ * Returns the command, which the caller must free.
  */
-static int host_flashrom(enum flashrom_ops op, const char *image_path,
-			 const char *programmer, int verbose,
-			 const char *section_name, const char *extra)
+static char *flashrom_command(enum flashrom_ops op, const char *image_path,
+			      const char *programmer, int verbose,
+			      const char *section_name, const char *extra)
 {
-	char *command, *result;
+	char *command;
 	const char *op_cmd, *dash_i = "-i", *postfix = "";
-	int r;
 
 	switch (verbose) {
 	case 0:
@@ -574,7 +573,7 @@ static int host_flashrom(enum flashrom_ops op, const char *image_path,
 
 	default:
 		assert(0);
-		return -1;
+		return NULL;
 	}
 
 	if (!extra)
@@ -584,6 +583,24 @@ static int host_flashrom(enum flashrom_ops op, const char *image_path,
 	ASPRINTF(&command, "flashrom %s %s -p %s %s %s %s %s", op_cmd,
 		 image_path, programmer, dash_i, section_name, extra,
 		 postfix);
+	return command;
+}
+
+/*
+ * A helper function to invoke flashrom(8) command.
+ * Returns 0 if success, non-zero if error.
+ */
+static int host_flashrom(enum flashrom_ops op, const char *image_path,
+			 const char *programmer, int verbose,
+			 const char *section_name, const char *extra)
+{
+	char *command, *result;
+	int r;
+
+	command = flashrom_command(op, image_path, programmer, verbose,
+				   section_name, extra);
+	if (!command)
+		return -1;
 
 	if (verbose)
 		INFO("Executing: %s\n", command);
@@ -625,20 +642,14 @@ static int host_get_wp_sw(void)
 }
 
 /*
- * Loads the active system firmware image (usually from SPI flash chip).
+ * Loads the system firmware already read to tmp_path by flashrom with result
+ * r, and reads again with verbose messages if that failed.
  * Returns 0 if success, non-zero if error.
  */
-int load_system_firmware(struct firmware_image *image,
-			 struct tempfile *tempfiles, int verbosity)
+static int finish_load_system_firmware(struct firmware_image *image,
+				       const char *tmp_path, int r,
+				       int verbosity)
 {
-	int r;
-	const char *tmp_path = create_temp_file(tempfiles);
-
-	if (!tmp_path)
-		return -1;
-
-	r = host_flashrom(FLASHROM_READ, tmp_path, image->programmer,
-			  verbosity, NULL, NULL);
 	/*
 	 * The verbosity for host_flashrom will be translated to
 	 * (verbosity-1)*'-V', and usually 3*'-V' is enough for debugging.
@@ -655,6 +666,113 @@ int load_system_firmware(struct firmware_image *image,
 	return r;
 }
 
+/*
+ * Loads the active system firmware image (usually from SPI flash chip).
+ * Returns 0 if success, non-zero if error.
+ */
+int load_system_firmware(struct firmware_image *image,
+			 struct tempfile *tempfiles, int verbosity)
+{
+	int r;
+	const char *tmp_path = create_temp_file(tempfiles);
+
+	if (!tmp_path)
+		return -1;
+
+	r = host_flashrom(FLASHROM_READ, tmp_path, image->programmer,
+			  verbosity, NULL, NULL);
+	return finish_load_system_firmware(image, tmp_path, r, verbosity);
+}
+
+/*
+ * Starts reading the active system firmware image in a background process.
+ * Returns 0 if success, non-zero if error.
+ */
+int load_system_firmware_start(struct system_firmware_read *pending,
+			       const struct firmware_image *image,
+			       struct tempfile *tempfiles, int verbosity)
+{
+	char *command, *shell_command;
+	pid_t pid;
+
+	memset(pending, 0, sizeof(*pending));
+	pending->tmp_path = create_temp_file(tempfiles);
+	if (!pending->tmp_path)
+		return -1;
+	pending->verbosity = verbosity;
+
+	command = flashrom_command(FLASHROM_READ, pending->tmp_path,
+				   image->programmer, verbosity, NULL, NULL);
+	if (!command)
+		return -1;
+	if (verbosity)
+		INFO("Executing: %s\n", command);
+	/*
+	 * Let the shell exec flashrom, so the child is flashrom itself and
+	 * cancelling can stop it directly.
+	 */
+	ASPRINTF(&shell_command, "exec %s", command);
+	free(command);
+
+	/* Don't let the child repeat what is still buffered. */
+	fflush(stdout);
+	fflush(stderr);
+	pid = fork();
+	if (pid < 0) {
+		ERROR("Cannot start reading system firmware: %s\n",
+		      strerror(errno));
+		free(shell_command);
+		return -1;
+	}
+	if (!pid) {
+		/*
+		 * The child stays in our process group, so Ctrl-C or a signal
+		 * to the whole group also stops the read.
+		 */
+		execl("/bin/sh", "sh", "-c", shell_command, (char *)NULL);
+		_exit(127);
+	}
+	free(shell_command);
+	pending->pid = pid;
+	return 0;
+}
+
+/*
+ * Waits for a read started by load_system_firmware_start and loads the
+ * system firmware into image.
+ * Returns 0 if success, non-zero if error.
+ */
+int load_system_firmware_finish(struct system_firmware_read *pending,
+				struct firmware_image *image)
+{
+	int status, r = -1;
+
+	if (!pending->pid)
+		return -1;
+	if (waitpid(pending->pid, &status, 0) == pending->pid &&
+	    WIFEXITED(status))
+		r = WEXITSTATUS(status);
+	pending->pid = 0;
+	if (r)
+		ERROR("Error code: %d\n", r);
+	return finish_load_system_firmware(image, pending->tmp_path, r,
+					   pending->verbosity);
+}
+
+/*
+ * Stops a read started by load_system_firmware_start, if it is still
+ * running, when its result is no longer needed.
+ */
+void load_system_firmware_cancel(struct system_firmware_read *pending)
+{
+	if (!pending->pid)
+		return;
+	VB2_DEBUG("Cancelled reading system firmware.\n");
+	kill(pending->pid, SIGTERM);
+	waitpid(pending->pid, NULL, 0);
+	pending->pid = 0;
+}
+
 /*
  * Writes a section from given firmware image to system firmware.
  * If section_name is NULL, write whole image.
@@ -690,6 +808,45 @@ int write_system_firmware(const struct firmware_image *image,
 	return r;
 }
 
+/*
+ * Writes the range [offset, offset + size) of given firmware image, already
+ * saved to image_path, to system firmware. The range is described to flashrom
+ * by a layout file so that other blocks are left untouched.
+ * Returns 0 if success, non-zero if error.
+ */
+int write_system_firmware_range(const struct firmware_image *image,
+				const char *image_path,
+				uint32_t offset, uint32_t size,
+				struct tempfile *tempfiles,
+				int verbosity)
+{
+	const char *layout_path = create_temp_file(tempfiles);
+	const char *region = "journal_range";
+	char *extra = NULL;
+	FILE *fp;
+	int r;
+
+	if (!layout_path)
+		return -1;
+
+	fp = fopen(layout_path, "w");
+	if (!fp) {
+		ERROR("Cannot create layout file %s.\n", layout_path);
+		return -1;
+	}
+	fprintf(fp, "%08x:%08x %s\n", offset, offset + size - 1, region);
+	if (fclose(fp)) {
+		ERROR("Failed writing layout file %s.\n", layout_path);
+		return -1;
+	}
+
+	ASPRINTF(&extra, "-l %s", layout_path);
+	r = host_flashrom(FLASHROM_WRITE, image_path, image->programmer,
+			  verbosity, region, extra);
+	free(extra);
+	return r;
+}
+
 /* Helper function to configure all properties. */
 void init_system_properties(struct system_property *props, int num)
 {
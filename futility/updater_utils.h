@@ -9,6 +9,7 @@
 #define VBOOT_REFERENCE_FUTILITY_UPDATER_UTILS_H_
 
 #include <stdio.h>
+#include <sys/types.h>
 #include "fmap.h"
 
 #define ASPRINTF(strp, ...) do { if (asprintf(strp, __VA_ARGS__) >= 0) break; \
@@ -87,6 +88,34 @@ int load_firmware_image(struct firmware_image *image, const char *file_name,
 int load_system_firmware(struct firmware_image *image,
 			 struct tempfile *tempfiles, int verbosity);
 
+/* A system firmware read running in the background. */
+struct system_firmware_read {
+	pid_t pid;
+	const char *tmp_path;
+	int verbosity;
+};
+
+/*
+ * Starts reading the active system firmware in a background process, so
+ * other work can be done until load_system_firmware_finish is called.
+ * No other flashrom command may run on the same chip until then.
+ * Returns 0 if success, non-zero if error.
+ */
+int load_system_firmware_start(struct system_firmware_read *pending,
+			       const struct firmware_image *image,
+			       struct tempfile *tempfiles, int verbosity);
+
+/*
+ * Waits for the read started by load_system_firmware_start, and loads the
+ * system firmware into image.
+ * Returns 0 if success, non-zero if error (like load_system_firmware).
+ */
+int load_system_firmware_finish(struct system_firmware_read *pending,
+				struct firmware_image *image);
+
+/* Stops the read started by load_system_firmware_start, if any. */
+void load_system_firmware_cancel(struct system_firmware_read *pending);
+
 /* Frees the allocated resource from a firmware image object. */
 void free_firmware_image(struct firmware_image *image);
 
@@ -109,6 +138,17 @@ int write_system_firmware(const struct firmware_image *image,
 			  struct tempfile *tempfiles,
 			  int verbosity);
 
+/*
+ * Writes the range [offset, offset + size) of given firmware image, already
+ * saved to image_path, to system firmware. Other blocks are left untouched.
+ * Returns 0 if success, non-zero if error.
+ */
+int write_system_firmware_range(const struct firmware_image *image,
+				const char *image_path,
+				uint32_t offset, uint32_t size,
+				struct tempfile *tempfiles,
+				int verbosity);
+
 struct firmware_section {
 	uint8_t *data;
 	size_t size;
@@ -22,39 +22,6 @@
 #include "util_misc.h"
 #include "vb1_helper.h"
 
-/****************************************************************************/
-/* Here are globals containing all the bits & pieces I'm working on.
- *
- * kernel vblock    = keyblock + kernel preamble + padding to 64K (or whatever)
- * kernel blob      = 32-bit kernel + config file + params + bootloader stub +
- *                    vmlinuz_header
- * kernel partition = kernel vblock + kernel blob
- *
- * The vb2_kernel_preamble.preamble_size includes the padding.
- */
-
-/* The keyblock, preamble, and kernel blob are kept in separate places. */
-static struct vb2_keyblock *g_keyblock;
-static struct vb2_kernel_preamble *g_preamble;
-static uint8_t *g_kernel_blob_data;
-static uint32_t g_kernel_blob_size;
-
-/* These refer to individual parts within the kernel blob. */
-static uint8_t *g_kernel_data;
-static uint32_t g_kernel_size;
-static uint8_t *g_config_data;
-static uint32_t g_config_size;
-static uint8_t *g_param_data;
-static uint32_t g_param_size;
-static uint8_t *g_bootloader_data;
-static uint32_t g_bootloader_size;
-static uint8_t *g_vmlinuz_header_data;
-static uint32_t g_vmlinuz_header_size;
-
-static uint64_t g_ondisk_bootloader_addr;
-static uint64_t g_ondisk_vmlinuz_header_addr;
-
-
 /*
  * Read the kernel command line from a file. Get rid of \n characters along
  * the way and verify that the line fits into a 4K buffer.
@@ -156,9 +123,10 @@ static int KernelSize(uint8_t *kernel_buf,
 	return kernel_size - kernel32_start;
 }
 
-/* This extracts g_kernel_* and g_param_* from a standard vmlinuz file.
+/* This extracts kb->kernel_* and kb->param_* from a standard vmlinuz file.
  * It returns nonzero on error. */
-static int PickApartVmlinuz(uint8_t *kernel_buf,
+static int PickApartVmlinuz(struct kernel_blob *kb,
+			    uint8_t *kernel_buf,
 			    uint32_t kernel_size,
 			    enum arch_t arch,
 			    uint64_t kernel_body_load_address)
@@ -188,8 +156,8 @@ static int PickApartVmlinuz(uint8_t *kernel_buf,
 		VB2_DEBUG(" kernel16_size=%#x\n", kernel32_start);
 
 		/* Copy the original zeropage data from kernel_buf into
-		 * g_param_data, then tweak a few fields for our purposes */
-		params = (struct linux_kernel_params *)(g_param_data);
+		 * kb->param_data, then tweak a few fields for our purposes */
+		params = (struct linux_kernel_params *)(kb->param_data);
 		memcpy(&(params->setup_sects), &(lh->setup_sects),
 		       offsetof(struct linux_kernel_params, e820_entries)
 		       - offsetof(struct linux_kernel_params, setup_sects));
@@ -201,7 +169,7 @@ static int PickApartVmlinuz(uint8_t *kernel_buf,
 		 * will come right after the 32-bit part of the kernel. */
 		params->cmd_line_ptr = kernel_body_load_address +
 			roundup(kernel32_size, CROS_ALIGN) +
-			find_cmdline_start(g_config_data, g_config_size);
+			find_cmdline_start(kb->config_data, kb->config_size);
 		VB2_DEBUG(" cmdline_addr=%#x\n", params->cmd_line_ptr);
 		VB2_DEBUG(" version=%#x\n", params->version);
 		VB2_DEBUG(" kernel_alignment=%#x\n", params->kernel_alignment);
@@ -225,18 +193,18 @@ static int PickApartVmlinuz(uint8_t *kernel_buf,
 
 	/* Keep just the 32-bit kernel. */
 	if (kernel32_size) {
-		g_kernel_size = kernel32_size;
-		memcpy(g_kernel_data, kernel_buf + kernel32_start,
-		       g_kernel_size);
+		kb->kernel_size = kernel32_size;
+		memcpy(kb->kernel_data, kernel_buf + kernel32_start,
+		       kb->kernel_size);
 	}
 
 	/* done */
 	return 0;
 }
 
-/* Split a kernel blob into separate g_kernel, g_param, g_config,
- * g_bootloader, and g_vmlinuz_header parts. */
-static void UnpackKernelBlob(uint8_t *kernel_blob_data)
+/* Split a kernel blob into separate kb->kernel, kb->param, kb->config,
+ * kb->bootloader, and kb->vmlinuz_header parts. */
+static void UnpackKernelBlob(struct kernel_blob *kb, uint8_t *kernel_blob_data)
 {
 	uint32_t now;
 	uint32_t vmlinuz_header_size = 0;
@@ -246,70 +214,72 @@ static void UnpackKernelBlob(uint8_t *kernel_blob_data)
 	   only describes the bootloader and vmlinuz stubs. */
 
 	/* Vmlinuz Header is at the end */
-	vb2_kernel_get_vmlinuz_header(g_preamble,
+	vb2_kernel_get_vmlinuz_header(kb->preamble,
 				      &vmlinuz_header_address,
 				      &vmlinuz_header_size);
 	if (vmlinuz_header_size) {
-		now = vmlinuz_header_address - g_preamble->body_load_address;
-		g_vmlinuz_header_size = vmlinuz_header_size;
-		g_vmlinuz_header_data = kernel_blob_data + now;
+		now = vmlinuz_header_address - kb->preamble->body_load_address;
+		kb->vmlinuz_header_size = vmlinuz_header_size;
+		kb->vmlinuz_header_data = kernel_blob_data + now;
 
 		VB2_DEBUG("vmlinuz_header_size     = %#x\n",
-			  g_vmlinuz_header_size);
+			  kb->vmlinuz_header_size);
 		VB2_DEBUG("vmlinuz_header_ofs      = %#x\n", now);
 	}
 
 	/* Where does the bootloader stub begin? */
-	now = g_preamble->bootloader_address - g_preamble->body_load_address;
+	now = kb->preamble->bootloader_address - kb->preamble->body_load_address;
 
 	/* Bootloader is at the end */
-	g_bootloader_size = g_preamble->bootloader_size;
-	g_bootloader_data = kernel_blob_data + now;
+	kb->bootloader_size = kb->preamble->bootloader_size;
+	kb->bootloader_data = kernel_blob_data + now;
 	/* TODO: What to do if this is beyond the end of the blob? */
 
-	VB2_DEBUG("bootloader_size     = %#x\n", g_bootloader_size);
+	VB2_DEBUG("bootloader_size     = %#x\n", kb->bootloader_size);
 	VB2_DEBUG("bootloader_ofs      = %#x\n", now);
 
 	/* Before that is the params */
 	now -= CROS_PARAMS_SIZE;
-	g_param_size = CROS_PARAMS_SIZE;
-	g_param_data = kernel_blob_data + now;
+	kb->param_size = CROS_PARAMS_SIZE;
+	kb->param_data = kernel_blob_data + now;
 	VB2_DEBUG("param_ofs           = %#x\n", now);
 
 	/* Before that is the config */
 	now -= CROS_CONFIG_SIZE;
-	g_config_size = CROS_CONFIG_SIZE;
-	g_config_data = kernel_blob_data + now;
+	kb->config_size = CROS_CONFIG_SIZE;
+	kb->config_data = kernel_blob_data + now;
 	VB2_DEBUG("config_ofs          = %#x\n", now);
 
 	/* The kernel starts at offset 0 and extends up to the config */
-	g_kernel_data = kernel_blob_data;
-	g_kernel_size = now;
-	VB2_DEBUG("kernel_size         = %#x\n", g_kernel_size);
+	kb->kernel_data = kernel_blob_data;
+	kb->kernel_size = now;
+	VB2_DEBUG("kernel_size         = %#x\n", kb->kernel_size);
 }
 
 
 /* Replaces the config section of the specified kernel blob.
  * Return nonzero on error. */
-int UpdateKernelBlobConfig(uint8_t *kblob_data, uint32_t kblob_size,
+int UpdateKernelBlobConfig(struct kernel_blob *kb,
+			   uint8_t *kblob_data, uint32_t kblob_size,
 			   uint8_t *config_data, uint32_t config_size)
 {
 	/* We should have already examined this blob. If not, we could do it
 	 * again, but it's more likely due to an error. */
-	if (kblob_data != g_kernel_blob_data ||
-	    kblob_size != g_kernel_blob_size) {
+	if (kblob_data != kb->blob_data ||
+	    kblob_size != kb->blob_size) {
 		fprintf(stderr, "Trying to update some other blob\n");
 		return -1;
 	}
 
-	memset(g_config_data, 0, g_config_size);
-	memcpy(g_config_data, config_data, config_size);
+	memset(kb->config_data, 0, kb->config_size);
+	memcpy(kb->config_data, config_data, config_size);
 
 	return 0;
 }
 
 /* Split a kernel partition into separate vblock and blob parts. */
-uint8_t *unpack_kernel_partition(uint8_t *kpart_data,
+uint8_t *unpack_kernel_partition(struct kernel_blob *kb,
+				 uint8_t *kpart_data,
 				 uint32_t kpart_size,
 				 uint32_t padding,
 				 struct vb2_keyblock **keyblock_ptr,
@@ -321,6 +291,8 @@ uint8_t *unpack_kernel_partition(uint8_t *kpart_data,
 	uint64_t vmlinuz_header_address = 0;
 	uint32_t now = 0;
 
+	memset(kb, 0, sizeof(*kb));
+
 	/* Validity-check the keyblock */
 	struct vb2_keyblock *keyblock = (struct vb2_keyblock *)kpart_data;
 	VB2_DEBUG("Keyblock is %#x bytes\n", keyblock->keyblock_size);
@@ -338,7 +310,7 @@ uint8_t *unpack_kernel_partition(uint8_t *kpart_data,
 	}
 
 	/* LGTM */
-	g_keyblock = keyblock;
+	kb->keyblock = keyblock;
 
 	/* And the preamble */
 	preamble = (struct vb2_kernel_preamble *)(kpart_data + now);
@@ -365,8 +337,8 @@ uint8_t *unpack_kernel_partition(uint8_t *kpart_data,
 	uint32_t flags = vb2_kernel_get_flags(preamble);
 	VB2_DEBUG(" flags = %#x\n", flags);
 
-	g_preamble = preamble;
-	g_ondisk_bootloader_addr = g_preamble->bootloader_address;
+	kb->preamble = preamble;
+	kb->ondisk_bootloader_addr = kb->preamble->bootloader_address;
 
 	vb2_kernel_get_vmlinuz_header(preamble,
 				      &vmlinuz_header_address,
@@ -375,35 +347,36 @@ uint8_t *unpack_kernel_partition(uint8_t *kpart_data,
 		VB2_DEBUG(" vmlinuz_header_address = 0x%" PRIx64 "\n",
 			  vmlinuz_header_address);
 		VB2_DEBUG(" vmlinuz_header_size = %#x\n", vmlinuz_header_size);
-		g_ondisk_vmlinuz_header_addr = vmlinuz_header_address;
+		kb->ondisk_vmlinuz_header_addr = vmlinuz_header_address;
 	}
 
 	VB2_DEBUG("kernel blob is at offset %#x\n", now);
-	g_kernel_blob_data = kpart_data + now;
-	g_kernel_blob_size = preamble->body_signature.data_size;
+	kb->blob_data = kpart_data + now;
+	kb->blob_size = preamble->body_signature.data_size;
 
 	/* Validity check */
-	if (kpart_size < now + g_kernel_blob_size) {
+	if (kpart_size < now + kb->blob_size) {
 		fprintf(stderr,
 			"kernel body size %u exceeds partition end\n",
-			g_kernel_blob_size);
+			kb->blob_size);
 		return NULL;
 	}
 
 	/* Update the blob pointers */
-	UnpackKernelBlob(g_kernel_blob_data);
+	UnpackKernelBlob(kb, kb->blob_data);
 
 	if (keyblock_ptr)
 		*keyblock_ptr = keyblock;
 	if (preamble_ptr)
 		*preamble_ptr = preamble;
 	if (blob_size_ptr)
-		*blob_size_ptr = g_kernel_blob_size;
+		*blob_size_ptr = kb->blob_size;
 
-	return g_kernel_blob_data;
+	return kb->blob_data;
 }
 
-uint8_t *SignKernelBlob(uint8_t *kernel_blob,
+uint8_t *SignKernelBlob(const struct kernel_blob *kb,
+			uint8_t *kernel_blob,
 			uint32_t kernel_size,
 			uint32_t padding,
 			int version,
@@ -417,10 +390,25 @@ uint8_t *SignKernelBlob(uint8_t *kernel_blob,
 	uint32_t min_size = padding > keyblock->keyblock_size
 		? padding - keyblock->keyblock_size : 0;
 
-	/* Sign the kernel data */
-	struct vb2_signature *body_sig = vb2_calculate_signature(kernel_blob,
-								 kernel_size,
-								 signpriv_key);
+	/* Sign the kernel data, tree-hashed if the flags ask for it */
+	uint32_t chunk_shift = (flags &
+				VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_MASK) >>
+		VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_SHIFT;
+	struct vb2_signature *body_sig;
+	if (chunk_shift &&
+	    chunk_shift < VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_MIN) {
+		fprintf(stderr, "Body chunk size must be at least %u bytes\n",
+			1U << VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_MIN);
+		return NULL;
+	}
+	if (chunk_shift)
+		body_sig = vb2_calculate_tree_signature(kernel_blob,
+							kernel_size,
+							1U << chunk_shift,
+							signpriv_key);
+	else
+		body_sig = vb2_calculate_signature(kernel_blob, kernel_size,
+						   signpriv_key);
 	if (!body_sig) {
 		fprintf(stderr, "Error calculating body signature\n");
 		return NULL;
@@ -430,11 +418,11 @@ uint8_t *SignKernelBlob(uint8_t *kernel_blob,
 	struct vb2_kernel_preamble *preamble =
 		vb2_create_kernel_preamble(version,
 					   kernel_body_load_address,
-					   g_ondisk_bootloader_addr,
-					   g_bootloader_size,
+					   kb->ondisk_bootloader_addr,
+					   kb->bootloader_size,
 					   body_sig,
-					   g_ondisk_vmlinuz_header_addr,
-					   g_vmlinuz_header_size,
+					   kb->ondisk_vmlinuz_header_addr,
+					   kb->vmlinuz_header_size,
 					   flags,
 					   min_size,
 					   signpriv_key);
@@ -499,7 +487,8 @@ int WriteSomeParts(const char *outfile,
 }
 
 /* Returns 0 on success */
-int VerifyKernelBlob(uint8_t *kernel_blob,
+int VerifyKernelBlob(const struct kernel_blob *kb,
+		     uint8_t *kernel_blob,
 		     uint32_t kernel_size,
 		     struct vb2_packed_key *signpub_key,
 		     const char *keyblock_outfile,
@@ -521,36 +510,37 @@ int VerifyKernelBlob(uint8_t *kernel_blob,
 			goto done;
 		}
 		if (VB2_SUCCESS !=
-		    vb2_verify_keyblock(g_keyblock, g_keyblock->keyblock_size,
+		    vb2_verify_keyblock(kb->keyblock,
+					kb->keyblock->keyblock_size,
 					&pubkey, &wb)) {
 			fprintf(stderr, "Error verifying keyblock.\n");
 			goto done;
 		}
 	} else if (VB2_SUCCESS !=
-		   vb2_verify_keyblock_hash(g_keyblock,
-					    g_keyblock->keyblock_size,
+		   vb2_verify_keyblock_hash(kb->keyblock,
+					    kb->keyblock->keyblock_size,
 					    &wb)) {
 		fprintf(stderr, "Error verifying keyblock.\n");
 		goto done;
 	}
 
 	printf("Keyblock:\n");
-	struct vb2_packed_key *data_key = &g_keyblock->data_key;
+	struct vb2_packed_key *data_key = &kb->keyblock->data_key;
 	printf("  Signature:           %s\n",
 	       signpub_key ? "valid" : "ignored");
-	printf("  Size:                %#x\n", g_keyblock->keyblock_size);
-	printf("  Flags:               %u ", g_keyblock->keyblock_flags);
-	if (g_keyblock->keyblock_flags & VB2_KEYBLOCK_FLAG_DEVELOPER_0)
+	printf("  Size:                %#x\n", kb->keyblock->keyblock_size);
+	printf("  Flags:               %u ", kb->keyblock->keyblock_flags);
+	if (kb->keyblock->keyblock_flags & VB2_KEYBLOCK_FLAG_DEVELOPER_0)
 		printf(" !DEV");
-	if (g_keyblock->keyblock_flags & VB2_KEYBLOCK_FLAG_DEVELOPER_1)
+	if (kb->keyblock->keyblock_flags & VB2_KEYBLOCK_FLAG_DEVELOPER_1)
 		printf(" DEV");
-	if (g_keyblock->keyblock_flags & VB2_KEYBLOCK_FLAG_RECOVERY_0)
+	if (kb->keyblock->keyblock_flags & VB2_KEYBLOCK_FLAG_RECOVERY_0)
 		printf(" !REC");
-	if (g_keyblock->keyblock_flags & VB2_KEYBLOCK_FLAG_RECOVERY_1)
+	if (kb->keyblock->keyblock_flags & VB2_KEYBLOCK_FLAG_RECOVERY_1)
 		printf(" REC");
-	if (g_keyblock->keyblock_flags & VB2_KEYBLOCK_FLAG_MINIOS_0)
+	if (kb->keyblock->keyblock_flags & VB2_KEYBLOCK_FLAG_MINIOS_0)
 		printf(" !MINIOS");
-	if (g_keyblock->keyblock_flags & VB2_KEYBLOCK_FLAG_MINIOS_1)
+	if (kb->keyblock->keyblock_flags & VB2_KEYBLOCK_FLAG_MINIOS_1)
 		printf(" MINIOS");
 	printf("\n");
 	printf("  Data key algorithm:  %u %s\n", data_key->algorithm,
@@ -567,7 +557,8 @@ int VerifyKernelBlob(uint8_t *kernel_blob,
 				keyblock_outfile, strerror(errno));
 			goto done;
 		}
-		if (1 != fwrite(g_keyblock, g_keyblock->keyblock_size, 1, f)) {
+		if (1 != fwrite(kb->keyblock, kb->keyblock->keyblock_size,
+				1, f)) {
 			fprintf(stderr, "Can't write keyblock file %s: %s\n",
 				keyblock_outfile, strerror(errno));
 			fclose(f);
@@ -590,27 +581,27 @@ int VerifyKernelBlob(uint8_t *kernel_blob,
 
 	/* Verify preamble */
 	if (VB2_SUCCESS != vb2_verify_kernel_preamble(
-			(struct vb2_kernel_preamble *)g_preamble,
-			g_preamble->preamble_size, &pubkey, &wb)) {
+			(struct vb2_kernel_preamble *)kb->preamble,
+			kb->preamble->preamble_size, &pubkey, &wb)) {
 		fprintf(stderr, "Error verifying preamble.\n");
 		goto done;
 	}
 
 	printf("Preamble:\n");
-	printf("  Size:                %#x\n", g_preamble->preamble_size);
+	printf("  Size:                %#x\n", kb->preamble->preamble_size);
 	printf("  Header version:      %u.%u\n",
-	       g_preamble->header_version_major,
-	       g_preamble->header_version_minor);
-	printf("  Kernel version:      %u\n", g_preamble->kernel_version);
+	       kb->preamble->header_version_major,
+	       kb->preamble->header_version_minor);
+	printf("  Kernel version:      %u\n", kb->preamble->kernel_version);
 	printf("  Body load address:   0x%" PRIx64 "\n",
-	       g_preamble->body_load_address);
+	       kb->preamble->body_load_address);
 	printf("  Body size:           %#x\n",
-	       g_preamble->body_signature.data_size);
+	       kb->preamble->body_signature.data_size);
 	printf("  Bootloader address:  0x%" PRIx64 "\n",
-	       g_preamble->bootloader_address);
-	printf("  Bootloader size:     %#x\n", g_preamble->bootloader_size);
+	       kb->preamble->bootloader_address);
+	printf("  Bootloader size:     %#x\n", kb->preamble->bootloader_size);
 
-	vb2_kernel_get_vmlinuz_header(g_preamble,
+	vb2_kernel_get_vmlinuz_header(kb->preamble,
 				      &vmlinuz_header_address,
 				      &vmlinuz_header_size);
 	if (vmlinuz_header_size) {
@@ -621,27 +612,33 @@ int VerifyKernelBlob(uint8_t *kernel_blob,
 	}
 
 	printf("  Flags          :       %#x\n",
-	       vb2_kernel_get_flags(g_preamble));
+	       vb2_kernel_get_flags(kb->preamble));
+	uint32_t chunk_size = vb2_kernel_get_body_chunk_size(kb->preamble);
+	if (chunk_size)
+		printf("  Body chunk size:     %#x\n", chunk_size);
 
-	if (g_preamble->kernel_version < (min_version & 0xFFFF)) {
+	if (kb->preamble->kernel_version < (min_version & 0xFFFF)) {
 		fprintf(stderr,
 			"Kernel version %u is lower than minimum %u.\n",
-			g_preamble->kernel_version, (min_version & 0xFFFF));
+			kb->preamble->kernel_version, (min_version & 0xFFFF));
 		goto done;
 	}
 
 	/* Verify body */
-	if (VB2_SUCCESS !=
-	    vb2_verify_data(kernel_blob, kernel_size,
-			    &g_preamble->body_signature,
-			    &pubkey, &wb)) {
+	if (VB2_SUCCESS != (chunk_size ?
+			    vb2_verify_data_tree(kernel_blob, kernel_size,
+						 &kb->preamble->body_signature,
+						 &pubkey, chunk_size, &wb) :
+			    vb2_verify_data(kernel_blob, kernel_size,
+					    &kb->preamble->body_signature,
+					    &pubkey, &wb))) {
 		fprintf(stderr, "Error verifying kernel body.\n");
 		goto done;
 	}
 	printf("Body verification succeeded.\n");
 
 	printf("Config:\n%s\n",
-	       kernel_blob + kernel_cmd_line_offset(g_preamble));
+	       kernel_blob + kernel_cmd_line_offset(kb->preamble));
 
 	rv = 0;
 done:
@@ -649,7 +646,8 @@ done:
 }
 
 
-uint8_t *CreateKernelBlob(uint8_t *vmlinuz_buf, uint32_t vmlinuz_size,
+uint8_t *CreateKernelBlob(struct kernel_blob *kb,
+			  uint8_t *vmlinuz_buf, uint32_t vmlinuz_size,
 			  enum arch_t arch, uint64_t kernel_body_load_address,
 			  uint8_t *config_data, uint32_t config_size,
 			  uint8_t *bootloader_data, uint32_t bootloader_size,
@@ -658,90 +656,92 @@ uint8_t *CreateKernelBlob(uint8_t *vmlinuz_buf, uint32_t vmlinuz_size,
 	uint32_t now = 0;
 	int tmp;
 
+	memset(kb, 0, sizeof(*kb));
+
 	/* We have all the parts. How much room do we need? */
 	tmp = KernelSize(vmlinuz_buf, vmlinuz_size, arch);
 	if (tmp < 0)
 		return NULL;
-	g_kernel_size = tmp;
-	g_config_size = CROS_CONFIG_SIZE;
-	g_param_size = CROS_PARAMS_SIZE;
-	g_bootloader_size = roundup(bootloader_size, CROS_ALIGN);
-	g_vmlinuz_header_size = vmlinuz_size-g_kernel_size;
-	g_kernel_blob_size =
-		roundup(g_kernel_size, CROS_ALIGN) +
-		g_config_size                      +
-		g_param_size                       +
-		g_bootloader_size                  +
-		g_vmlinuz_header_size;
+	kb->kernel_size = tmp;
+	kb->config_size = CROS_CONFIG_SIZE;
+	kb->param_size = CROS_PARAMS_SIZE;
+	kb->bootloader_size = roundup(bootloader_size, CROS_ALIGN);
+	kb->vmlinuz_header_size = vmlinuz_size-kb->kernel_size;
+	kb->blob_size =
+		roundup(kb->kernel_size, CROS_ALIGN) +
+		kb->config_size                       +
+		kb->param_size                        +
+		kb->bootloader_size                   +
+		kb->vmlinuz_header_size;
 
 	/*
 	 * Round the whole blob up so it's a multiple of sectors, even on 4k
 	 * devices.
 	 */
-	g_kernel_blob_size = roundup(g_kernel_blob_size, CROS_ALIGN);
-	VB2_DEBUG("g_kernel_blob_size  %#x\n", g_kernel_blob_size);
+	kb->blob_size = roundup(kb->blob_size, CROS_ALIGN);
+	VB2_DEBUG("blob_size  %#x\n", kb->blob_size);
 
 	/* Allocate space for the blob. */
-	g_kernel_blob_data = malloc(g_kernel_blob_size);
-	memset(g_kernel_blob_data, 0, g_kernel_blob_size);
+	kb->blob_data = malloc(kb->blob_size);
+	memset(kb->blob_data, 0, kb->blob_size);
 
 	/* Assign the sub-pointers */
-	g_kernel_data = g_kernel_blob_data + now;
-	VB2_DEBUG("g_kernel_size       %#x ofs %#x\n",
-		  g_kernel_size, now);
-	now += roundup(g_kernel_size, CROS_ALIGN);
-
-	g_config_data = g_kernel_blob_data + now;
-	VB2_DEBUG("g_config_size       %#x ofs %#x\n",
-		  g_config_size, now);
-	now += g_config_size;
-
-	g_param_data = g_kernel_blob_data + now;
-	VB2_DEBUG("g_param_size        %#x ofs %#x\n",
-		  g_param_size, now);
-	now += g_param_size;
-
-	g_bootloader_data = g_kernel_blob_data + now;
-	VB2_DEBUG("g_bootloader_size   %#x ofs %#x\n",
-		  g_bootloader_size, now);
-	g_ondisk_bootloader_addr = kernel_body_load_address + now;
-	VB2_DEBUG("g_ondisk_bootloader_addr   0x%" PRIx64 "\n",
-		  g_ondisk_bootloader_addr);
-	now += g_bootloader_size;
-
-	if (g_vmlinuz_header_size) {
-		g_vmlinuz_header_data = g_kernel_blob_data + now;
-		VB2_DEBUG("g_vmlinuz_header_size %#x ofs %#x\n",
-			  g_vmlinuz_header_size, now);
-		g_ondisk_vmlinuz_header_addr = kernel_body_load_address + now;
-		VB2_DEBUG("g_ondisk_vmlinuz_header_addr   0x%" PRIx64 "\n",
-			  g_ondisk_vmlinuz_header_addr);
+	kb->kernel_data = kb->blob_data + now;
+	VB2_DEBUG("kernel_size       %#x ofs %#x\n",
+		  kb->kernel_size, now);
+	now += roundup(kb->kernel_size, CROS_ALIGN);
+
+	kb->config_data = kb->blob_data + now;
+	VB2_DEBUG("config_size       %#x ofs %#x\n",
+		  kb->config_size, now);
+	now += kb->config_size;
+
+	kb->param_data = kb->blob_data + now;
+	VB2_DEBUG("param_size        %#x ofs %#x\n",
+		  kb->param_size, now);
+	now += kb->param_size;
+
+	kb->bootloader_data = kb->blob_data + now;
+	VB2_DEBUG("bootloader_size   %#x ofs %#x\n",
+		  kb->bootloader_size, now);
+	kb->ondisk_bootloader_addr = kernel_body_load_address + now;
+	VB2_DEBUG("ondisk_bootloader_addr   0x%" PRIx64 "\n",
+		  kb->ondisk_bootloader_addr);
+	now += kb->bootloader_size;
+
+	if (kb->vmlinuz_header_size) {
+		kb->vmlinuz_header_data = kb->blob_data + now;
+		VB2_DEBUG("vmlinuz_header_size %#x ofs %#x\n",
+			  kb->vmlinuz_header_size, now);
+		kb->ondisk_vmlinuz_header_addr = kernel_body_load_address + now;
+		VB2_DEBUG("ondisk_vmlinuz_header_addr   0x%" PRIx64 "\n",
+			  kb->ondisk_vmlinuz_header_addr);
 	}
 
 	VB2_DEBUG("end of kern_blob at kern_blob+%#x\n", now);
 
 	/* Copy the kernel and params bits into the correct places */
-	if (0 != PickApartVmlinuz(vmlinuz_buf, vmlinuz_size,
+	if (0 != PickApartVmlinuz(kb, vmlinuz_buf, vmlinuz_size,
 				  arch, kernel_body_load_address)) {
 		fprintf(stderr, "Error picking apart kernel file.\n");
-		free(g_kernel_blob_data);
-		g_kernel_blob_data = NULL;
-		g_kernel_blob_size = 0;
+		free(kb->blob_data);
+		kb->blob_data = NULL;
+		kb->blob_size = 0;
 		return NULL;
 	}
 
 	/* Copy the other bits too */
-	memcpy(g_config_data, config_data, config_size);
-	memcpy(g_bootloader_data, bootloader_data, bootloader_size);
-	if (g_vmlinuz_header_size) {
-		memcpy(g_vmlinuz_header_data,
+	memcpy(kb->config_data, config_data, config_size);
+	memcpy(kb->bootloader_data, bootloader_data, bootloader_size);
+	if (kb->vmlinuz_header_size) {
+		memcpy(kb->vmlinuz_header_data,
 		       vmlinuz_buf,
-		       g_vmlinuz_header_size);
+		       kb->vmlinuz_header_size);
 	}
 
 	if (blob_size_ptr)
-		*blob_size_ptr = g_kernel_blob_size;
-	return g_kernel_blob_data;
+		*blob_size_ptr = kb->blob_size;
+	return kb->blob_data;
 }
 
 enum futil_file_type ft_recognize_vblock1(uint8_t *buf, uint32_t len)
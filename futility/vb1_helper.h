@@ -16,13 +16,52 @@ void show_pubkey(const struct vb2_packed_key *pubkey, const char *sp);
 
 uint8_t *ReadConfigFile(const char *config_file, uint32_t *config_size);
 
-uint8_t *CreateKernelBlob(uint8_t *vmlinuz_buf, uint32_t vmlinuz_size,
+/*
+ * All the bits & pieces of one kernel being worked on.
+ *
+ * kernel vblock    = keyblock + kernel preamble + padding to 64K (or whatever)
+ * kernel blob      = 32-bit kernel + config file + params + bootloader stub +
+ *                    vmlinuz_header
+ * kernel partition = kernel vblock + kernel blob
+ *
+ * The vb2_kernel_preamble.preamble_size includes the padding.
+ *
+ * This is filled in by CreateKernelBlob() or unpack_kernel_partition() and
+ * then passed to the other functions working on the same kernel. Separate
+ * contexts may be used at the same time, including from different threads.
+ */
+struct kernel_blob {
+	/* The keyblock, preamble, and kernel blob are kept in separate places */
+	struct vb2_keyblock *keyblock;
+	struct vb2_kernel_preamble *preamble;
+	uint8_t *blob_data;
+	uint32_t blob_size;
+
+	/* These refer to individual parts within the kernel blob */
+	uint8_t *kernel_data;
+	uint32_t kernel_size;
+	uint8_t *config_data;
+	uint32_t config_size;
+	uint8_t *param_data;
+	uint32_t param_size;
+	uint8_t *bootloader_data;
+	uint32_t bootloader_size;
+	uint8_t *vmlinuz_header_data;
+	uint32_t vmlinuz_header_size;
+
+	uint64_t ondisk_bootloader_addr;
+	uint64_t ondisk_vmlinuz_header_addr;
+};
+
+uint8_t *CreateKernelBlob(struct kernel_blob *kb,
+			  uint8_t *vmlinuz_buf, uint32_t vmlinuz_size,
 			  enum arch_t arch, uint64_t kernel_body_load_address,
 			  uint8_t *config_data, uint32_t config_size,
 			  uint8_t *bootloader_data, uint32_t bootloader_size,
 			  uint32_t *blob_size_ptr);
 
-uint8_t *SignKernelBlob(uint8_t *kernel_blob,
+uint8_t *SignKernelBlob(const struct kernel_blob *kb,
+			uint8_t *kernel_blob,
 			uint32_t kernel_size,
 			uint32_t padding,
 			int version,
@@ -39,6 +78,7 @@ int WriteSomeParts(const char *outfile,
 /**
  * Unpack a kernel partition.
  *
+ * @param kb		Kernel blob context to fill in
  * @param kpart_data	Kernel partition data
  * @param kpart_size	Size of kernel partition data in bytes
  * @param padding	Expected max size of keyblock+preamble
@@ -48,17 +88,20 @@ int WriteSomeParts(const char *outfile,
  *
  * @return A pointer to the kernel data blob, or NULL if error.
  */
-uint8_t *unpack_kernel_partition(uint8_t *kpart_data,
+uint8_t *unpack_kernel_partition(struct kernel_blob *kb,
+				 uint8_t *kpart_data,
 				 uint32_t kpart_size,
 				 uint32_t padding,
 				 struct vb2_keyblock **keyblock_ptr,
 				 struct vb2_kernel_preamble **preamble_ptr,
 				 uint32_t *blob_size_ptr);
 
-int UpdateKernelBlobConfig(uint8_t *kblob_data, uint32_t kblob_size,
+int UpdateKernelBlobConfig(struct kernel_blob *kb,
+			   uint8_t *kblob_data, uint32_t kblob_size,
 			   uint8_t *config_data, uint32_t config_size);
 
-int VerifyKernelBlob(uint8_t *kernel_blob,
+int VerifyKernelBlob(const struct kernel_blob *kb,
+		     uint8_t *kernel_blob,
 		     uint32_t kernel_size,
 		     struct vb2_packed_key *signpub_key,
 		     const char *keyblock_outfile,
@@ -135,6 +135,14 @@ typedef struct CgptLegacyParams {
 	int mode;
 } CgptLegacyParams;
 
+typedef struct CgptZeroParams {
+	const char *drive_name;
+	uint64_t drive_size;
+	uint32_t partition;          /* 1-based */
+	int discard;
+	int verbose;
+} CgptZeroParams;
+
 #ifdef __cplusplus
 }
 #endif  /* __cplusplus */
@@ -37,6 +37,7 @@ int CgptRepair(CgptRepairParams *params);
 int CgptPrioritize(CgptPrioritizeParams *params);
 void CgptFind(CgptFindParams *params);
 int CgptLegacy(CgptLegacyParams *params);
+int CgptZero(CgptZeroParams *params);
 
 /* GUID conversion functions. Accepted format:
  *
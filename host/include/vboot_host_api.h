@@ -0,0 +1,274 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Re-entrant host API for loading, verifying and signing vboot images and
+ * inspecting their GPT, for services which link libvboot_host instead of
+ * running futility.
+ *
+ * Everything is reached through handles, and no function here exits or
+ * aborts; errors are returned as vb2_error_t.  Functions only touch the
+ * handles passed to them, so different threads can work at the same time.
+ * Handles are not changed after they are created, so one handle can also be
+ * shared between threads, as long as none of them frees it while the others
+ * are still using it.
+ */
+
+#ifndef VBOOT_REFERENCE_VBOOT_HOST_API_H_
+#define VBOOT_REFERENCE_VBOOT_HOST_API_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "2return_codes.h"
+#include "gpt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/*
+ * Version of this API.  It goes up whenever a function or structure here
+ * changes in a way which is not backwards compatible.
+ */
+#define VB2_HOST_API_VERSION 1
+
+/* Opaque handles */
+struct vb2_host_image;
+struct vb2_host_key;
+struct vb2_host_keyblock;
+struct vb2_host_gpt;
+
+/**
+ * Return the API version the library was built with.
+ *
+ * Callers linking the shared library should check this against
+ * VB2_HOST_API_VERSION.
+ */
+uint32_t vb2_host_api_version(void);
+
+/****************************************************************************/
+/* Images */
+
+/**
+ * Load an image from a file.
+ *
+ * The whole file is read into memory, so the file may be changed or
+ * overwritten (including by vb2_host_image_save()) while the image is in use.
+ *
+ * @param filename	File to read
+ * @param image_ptr	On success, points to the new image
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t vb2_host_image_load(const char *filename,
+				struct vb2_host_image **image_ptr);
+
+/**
+ * Create an image from a copy of a buffer.
+ *
+ * @param buf		Image data
+ * @param size		Size of image data in bytes
+ * @param image_ptr	On success, points to the new image
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t vb2_host_image_from_buffer(const void *buf, size_t size,
+				       struct vb2_host_image **image_ptr);
+
+/**
+ * Get the contents of an image.
+ *
+ * @param image		Image
+ * @param size_ptr	Size of the image data in bytes
+ * @return The image data, which is valid until the image is freed.
+ */
+const uint8_t *vb2_host_image_data(const struct vb2_host_image *image,
+				   size_t *size_ptr);
+
+/**
+ * Write an image to a file.
+ *
+ * @param image		Image to write
+ * @param filename	File to write
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t vb2_host_image_save(const struct vb2_host_image *image,
+				const char *filename);
+
+/**
+ * Free an image.
+ *
+ * @param image		Image to free; ok to pass NULL (ignored).
+ */
+void vb2_host_image_free(struct vb2_host_image *image);
+
+/****************************************************************************/
+/* Keys */
+
+/**
+ * Load a public key from a .vbpubk file.
+ *
+ * @param filename	File to read
+ * @param key_ptr	On success, points to the new key
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t vb2_host_public_key_load(const char *filename,
+				     struct vb2_host_key **key_ptr);
+
+/**
+ * Load a private key from a .vbprivk file or a PKCS#11 token.
+ *
+ * @param name		File to read, or "pkcs11:<module>:<slot>:<label>"
+ * @param key_ptr	On success, points to the new key
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t vb2_host_private_key_load(const char *name,
+				      struct vb2_host_key **key_ptr);
+
+/**
+ * Free a key.
+ *
+ * @param key		Key to free; ok to pass NULL (ignored).
+ */
+void vb2_host_key_free(struct vb2_host_key *key);
+
+/**
+ * Load a keyblock from a file.  Its hash is checked, but not its signature.
+ *
+ * @param filename	File to read
+ * @param keyblock_ptr	On success, points to the new keyblock
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t vb2_host_keyblock_load(const char *filename,
+				   struct vb2_host_keyblock **keyblock_ptr);
+
+/**
+ * Free a keyblock.
+ *
+ * @param keyblock	Keyblock to free; ok to pass NULL (ignored).
+ */
+void vb2_host_keyblock_free(struct vb2_host_keyblock *keyblock);
+
+/****************************************************************************/
+/* Kernel partitions */
+
+/* What vb2_host_kernel_verify() found in a kernel partition */
+struct vb2_host_kernel_info {
+	/* Keyblock flags (VB2_KEYBLOCK_FLAG_*) */
+	uint32_t keyblock_flags;
+	/* Version of the data key in the keyblock */
+	uint32_t data_key_version;
+	/* Kernel version from the preamble */
+	uint32_t kernel_version;
+	/* Preamble flags */
+	uint32_t flags;
+	/* Offset of the kernel body in the partition */
+	uint32_t body_offset;
+	/* Size of the signed kernel body */
+	uint32_t body_size;
+	/* Addresses the body and bootloader are loaded at */
+	uint64_t body_load_address;
+	uint64_t bootloader_address;
+	uint32_t bootloader_size;
+};
+
+/**
+ * Verify a kernel partition: its keyblock, preamble and body.
+ *
+ * Nothing in the image is changed, even temporarily.
+ *
+ * @param kernel	Kernel partition image
+ * @param key		Key to verify the keyblock signature with.  If NULL,
+ *			only the keyblock hash is checked.
+ * @param info		If not NULL, filled in from the verified partition
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t vb2_host_kernel_verify(const struct vb2_host_image *kernel,
+				   const struct vb2_host_key *key,
+				   struct vb2_host_kernel_info *info);
+
+/**
+ * Re-sign a kernel partition with a new keyblock and data key, the way
+ * "vbutil_kernel --repack" does.
+ *
+ * The partition must be intact (see vb2_host_kernel_verify(), without a key).
+ * The kernel version, addresses, flags and body offset are kept, so the new
+ * keyblock and preamble must fit in front of the existing body.
+ *
+ * @param kernel	Kernel partition image
+ * @param keyblock	New keyblock
+ * @param signing_key	Private key matching the data key in the keyblock
+ * @param signed_ptr	On success, points to the new kernel partition image
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t vb2_host_kernel_sign(const struct vb2_host_image *kernel,
+				 const struct vb2_host_keyblock *keyblock,
+				 const struct vb2_host_key *signing_key,
+				 struct vb2_host_image **signed_ptr);
+
+/****************************************************************************/
+/* GPT */
+
+/*
+ * Size of a partition label in UTF-8, including the terminating NUL.  The 36
+ * UTF-16 units of an entry name take at most 108 bytes in UTF-8.
+ */
+#define VB2_HOST_GPT_LABEL_SIZE 109
+
+/* One partition entry */
+struct vb2_host_gpt_entry {
+	Guid type;
+	Guid unique;
+	uint64_t starting_lba;
+	uint64_t ending_lba;
+	uint64_t attributes;
+	/* ChromeOS kernel attributes, unpacked from attributes */
+	int priority;
+	int tries;
+	int successful;
+	char label[VB2_HOST_GPT_LABEL_SIZE];
+};
+
+/**
+ * Read the GPT of a disk image.
+ *
+ * The primary GPT is used if it is valid, otherwise the secondary one.
+ *
+ * @param disk		Disk image, made of 512-byte sectors
+ * @param gpt_ptr	On success, points to the new GPT
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t vb2_host_gpt_open(const struct vb2_host_image *disk,
+			      struct vb2_host_gpt **gpt_ptr);
+
+/**
+ * Get the number of entries in the GPT, including unused ones.
+ *
+ * @param gpt		GPT
+ * @return The number of entries.
+ */
+uint32_t vb2_host_gpt_num_entries(const struct vb2_host_gpt *gpt);
+
+/**
+ * Get a partition entry.
+ *
+ * @param gpt		GPT
+ * @param index		Entry index, from 0; partition numbers start at 1.
+ * @param entry		Filled in from the entry
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t vb2_host_gpt_get_entry(const struct vb2_host_gpt *gpt,
+				   uint32_t index,
+				   struct vb2_host_gpt_entry *entry);
+
+/**
+ * Free a GPT.
+ *
+ * @param gpt		GPT to free; ok to pass NULL (ignored).
+ */
+void vb2_host_gpt_free(struct vb2_host_gpt *gpt);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
+
+#endif  /* VBOOT_REFERENCE_VBOOT_HOST_API_H_ */
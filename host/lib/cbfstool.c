@@ -67,3 +67,278 @@ vb2_error_t cbfstool_truncate(const char *file, const char *region,
 
 	return VB2_SUCCESS;
 }
+
+/*
+ * CBFS file header, as in coreboot's cbfs_serialized.h.  All fields are big
+ * endian.  Headers start on CBFS_ALIGNMENT boundaries, followed by the name,
+ * optional attributes and then the data at header + offset.
+ */
+#define CBFS_FILE_MAGIC "LARCHIVE"
+#define CBFS_FILE_HEADER_SIZE 24
+#define CBFS_ALIGNMENT 64
+#define CBFS_ATTRIBUTE_ALIGN 4
+
+#define CBFS_TYPE_DELETED 0x00000000
+#define CBFS_TYPE_RAW 0x50
+#define CBFS_TYPE_NULL 0xffffffff
+
+#define CBFS_FILE_ATTR_TAG_COMPRESSION 0x42435a4c
+
+#define CBFS_LEN_OFFSET 8
+#define CBFS_TYPE_OFFSET 12
+#define CBFS_ATTR_OFFSET 16
+#define CBFS_DATA_OFFSET 20
+
+#define CBFS_ALIGN_UP(x, a) (((x) + (a) - 1) / (a) * (a))
+#define CBFS_ALIGN_DOWN(x, a) ((x) / (a) * (a))
+
+/* Size of the header of an empty entry, which has an empty name */
+#define CBFS_EMPTY_HEADER_SIZE \
+	(CBFS_FILE_HEADER_SIZE + CBFS_ALIGN_UP(1, CBFS_ATTRIBUTE_ALIGN))
+
+struct cbfs_entry {
+	size_t start;		/* Offset of the header in the region */
+	size_t data;		/* Offset of the data in the region */
+	size_t end;		/* Offset of the next header */
+	uint32_t len;
+	uint32_t type;
+	uint32_t attr;		/* Offset of attributes from start, or 0 */
+	const char *name;
+};
+
+static uint32_t get_be32(const uint8_t *p)
+{
+	return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+static int cbfs_is_empty(const struct cbfs_entry *e)
+{
+	return e->type == CBFS_TYPE_NULL || e->type == CBFS_TYPE_DELETED;
+}
+
+/*
+ * Parse the entry at offset start.  Returns 1 if there is an entry, 0 if
+ * the CBFS ends here, or -1 if the entry is malformed.
+ */
+static int cbfs_parse_entry(const uint8_t *region, size_t region_size,
+			    size_t start, struct cbfs_entry *e)
+{
+	const uint8_t *h = region + start;
+	uint32_t data_offset;
+
+	if (start + CBFS_FILE_HEADER_SIZE > region_size ||
+	    memcmp(h, CBFS_FILE_MAGIC, strlen(CBFS_FILE_MAGIC)))
+		return 0;
+
+	e->start = start;
+	e->len = get_be32(h + CBFS_LEN_OFFSET);
+	e->type = get_be32(h + CBFS_TYPE_OFFSET);
+	e->attr = get_be32(h + CBFS_ATTR_OFFSET);
+	data_offset = get_be32(h + CBFS_DATA_OFFSET);
+	e->name = (const char *)h + CBFS_FILE_HEADER_SIZE;
+
+	if (data_offset <= CBFS_FILE_HEADER_SIZE ||
+	    data_offset > region_size - start ||
+	    e->len > region_size - start - data_offset ||
+	    !memchr(e->name, '\0', data_offset - CBFS_FILE_HEADER_SIZE) ||
+	    (e->attr && (e->attr <= CBFS_FILE_HEADER_SIZE ||
+			 e->attr > data_offset))) {
+		VB2_DEBUG("Malformed CBFS entry at %#zx\n", start);
+		return -1;
+	}
+
+	e->data = start + data_offset;
+	e->end = VB2_MIN(CBFS_ALIGN_UP(e->data + e->len, CBFS_ALIGNMENT),
+			 region_size);
+	return 1;
+}
+
+/* Returns 1 if found, 0 if not found, or -1 if the CBFS is malformed. */
+static int cbfs_lookup(const uint8_t *region, size_t region_size,
+		       const char *name, struct cbfs_entry *e)
+{
+	size_t offset = 0;
+	int rv;
+
+	while ((rv = cbfs_parse_entry(region, region_size, offset, e)) > 0) {
+		if (!cbfs_is_empty(e) && !strcmp(e->name, name))
+			return 1;
+		offset = e->end;
+	}
+	return rv;
+}
+
+/* Returns non-zero if the entry has a compression attribute. */
+static int cbfs_is_compressed(const uint8_t *region,
+			      const struct cbfs_entry *e)
+{
+	size_t offset = e->start + e->attr;
+	uint32_t tag, len;
+
+	if (!e->attr)
+		return 0;
+
+	while (offset + 8 <= e->data) {
+		tag = get_be32(region + offset);
+		len = get_be32(region + offset + 4);
+		if (len < 8 || len > e->data - offset)
+			break;
+		if (tag == CBFS_FILE_ATTR_TAG_COMPRESSION && len >= 12 &&
+		    get_be32(region + offset + 8))
+			return 1;
+		offset += len;
+	}
+	return 0;
+}
+
+/* Write an empty entry covering [start, end), erasing its contents. */
+static void cbfs_put_empty(uint8_t *region, size_t start, size_t end)
+{
+	uint8_t *h = region + start;
+
+	memset(h, 0xff, end - start);
+	memcpy(h, CBFS_FILE_MAGIC, strlen(CBFS_FILE_MAGIC));
+	put_be32(h + CBFS_LEN_OFFSET, end - start - CBFS_EMPTY_HEADER_SIZE);
+	put_be32(h + CBFS_TYPE_OFFSET, CBFS_TYPE_NULL);
+	put_be32(h + CBFS_ATTR_OFFSET, 0);
+	put_be32(h + CBFS_DATA_OFFSET, CBFS_EMPTY_HEADER_SIZE);
+	memset(h + CBFS_FILE_HEADER_SIZE, 0,
+	       CBFS_EMPTY_HEADER_SIZE - CBFS_FILE_HEADER_SIZE);
+}
+
+vb2_error_t cbfs_region_find(const uint8_t *region, size_t region_size,
+			     const char *name, size_t *data_offset,
+			     size_t *data_size)
+{
+	struct cbfs_entry e;
+	int rv;
+
+	rv = cbfs_lookup(region, region_size, name, &e);
+	if (rv < 0)
+		return VB2_ERROR_CBFS_CORRUPT;
+	if (!rv)
+		return VB2_ERROR_CBFS_NOT_FOUND;
+	if (cbfs_is_compressed(region, &e)) {
+		VB2_DEBUG("CBFS file %s is compressed\n", name);
+		return VB2_ERROR_CBFS_COMPRESSED;
+	}
+
+	*data_offset = e.data;
+	*data_size = e.len;
+	return VB2_SUCCESS;
+}
+
+vb2_error_t cbfs_region_remove(uint8_t *region, size_t region_size,
+			       const char *name)
+{
+	struct cbfs_entry e;
+	size_t offset = 0, run_start = 0;
+	int in_run = 0, found = 0;
+	int rv;
+
+	/*
+	 * Like cbfstool, merge the file with the empty entries around it.
+	 * Only the run of empty entries containing the file is rewritten.
+	 */
+	while ((rv = cbfs_parse_entry(region, region_size, offset, &e)) > 0) {
+		int is_target = !found && !cbfs_is_empty(&e) &&
+			!strcmp(e.name, name);
+
+		if (cbfs_is_empty(&e) || is_target) {
+			if (!in_run)
+				run_start = e.start;
+			in_run = 1;
+			found |= is_target;
+		} else {
+			if (found)
+				break;
+			in_run = 0;
+		}
+		offset = e.end;
+	}
+	if (rv < 0)
+		return VB2_ERROR_CBFS_CORRUPT;
+	if (!found)
+		return VB2_ERROR_CBFS_NOT_FOUND;
+
+	VB2_DEBUG("Removing %s, empty space %#zx-%#zx\n", name, run_start,
+		  offset);
+	cbfs_put_empty(region, run_start, offset);
+	return VB2_SUCCESS;
+}
+
+vb2_error_t cbfs_region_add_raw(uint8_t *region, size_t region_size,
+				const char *name, const void *data,
+				size_t data_size, size_t data_offset)
+{
+	struct cbfs_entry e;
+	size_t header_size, start, end, offset = 0;
+	uint8_t *h;
+	int rv;
+
+	rv = cbfs_lookup(region, region_size, name, &e);
+	if (rv < 0)
+		return VB2_ERROR_CBFS_CORRUPT;
+	if (rv > 0)
+		return VB2_ERROR_CBFS_EXISTS;
+
+	header_size = CBFS_FILE_HEADER_SIZE +
+		CBFS_ALIGN_UP(strlen(name) + 1, CBFS_ATTRIBUTE_ALIGN);
+	if (data_offset < header_size || data_offset > region_size ||
+	    data_size > region_size - data_offset)
+		return VB2_ERROR_CBFS_NO_SPACE;
+
+	/*
+	 * The header goes on the last aligned boundary leaving room for the
+	 * name; the gap up to the data is padding after the name.
+	 */
+	start = CBFS_ALIGN_DOWN(data_offset - header_size, CBFS_ALIGNMENT);
+	end = data_offset + data_size;
+
+	/* Find the empty entry holding the whole file */
+	while ((rv = cbfs_parse_entry(region, region_size, offset, &e)) > 0) {
+		if (e.start <= start && end <= e.end)
+			break;
+		offset = e.end;
+	}
+	if (rv < 0)
+		return VB2_ERROR_CBFS_CORRUPT;
+	if (!rv || !cbfs_is_empty(&e)) {
+		VB2_DEBUG("No empty space for %s at %#zx-%#zx\n", name,
+			  data_offset, end);
+		return VB2_ERROR_CBFS_NO_SPACE;
+	}
+
+	VB2_DEBUG("Adding %s at %#zx-%#zx\n", name, data_offset, end);
+
+	/* Keep the space before and after the new file as empty entries */
+	if (start > e.start)
+		cbfs_put_empty(region, e.start, start);
+	end = CBFS_ALIGN_UP(end, CBFS_ALIGNMENT);
+	if (end < e.end && e.end - end >= CBFS_EMPTY_HEADER_SIZE)
+		cbfs_put_empty(region, end, e.end);
+	else
+		end = e.end;
+
+	h = region + start;
+	memset(h, 0, data_offset - start);
+	memcpy(h, CBFS_FILE_MAGIC, strlen(CBFS_FILE_MAGIC));
+	put_be32(h + CBFS_LEN_OFFSET, data_size);
+	put_be32(h + CBFS_TYPE_OFFSET, CBFS_TYPE_RAW);
+	put_be32(h + CBFS_ATTR_OFFSET, 0);
+	put_be32(h + CBFS_DATA_OFFSET, data_offset - start);
+	strcpy((char *)h + CBFS_FILE_HEADER_SIZE, name);
+	memcpy(region + data_offset, data, data_size);
+	memset(region + data_offset + data_size, 0xff,
+	       end - data_offset - data_size);
+
+	return VB2_SUCCESS;
+}
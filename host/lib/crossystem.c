@@ -743,9 +743,10 @@ static int vb2_nv_index(const uint8_t *buf, uint32_t buf_sz, int vbnv_size)
 	/* The size of the buffer should be an even multiple of the
 	   VBNV size. */
 	if (buf_sz % vbnv_size != 0) {
-		VB2_DIE("The VBNV in flash (%u bytes) is not an even multiple "
-			"of the VBNV size (%u bytes).  This is likely a "
-			"firmware bug.\n", buf_sz, vbnv_size);
+		fprintf(stderr, "The VBNV in flash (%u bytes) is not an even "
+			"multiple of the VBNV size (%u bytes).  This is likely "
+			"a firmware bug.\n", buf_sz, vbnv_size);
+		return -1;
 	}
 
 	memset(blank, 0xff, sizeof(blank));
@@ -8,8 +8,8 @@
 
 #include "vboot_host.h"
 
-static int lookup_helper(const char *str, const char *table[], size_t size,
-			 unsigned int *out)
+static int lookup_helper(const char *str, const char *const table[],
+			 size_t size, unsigned int *out)
 {
 	unsigned int algo;
 	char *e;
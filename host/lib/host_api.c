@@ -0,0 +1,597 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Re-entrant host API (see vboot_host_api.h).
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../cgpt/cgpt.h"
+#include "2common.h"
+#include "2rsa.h"
+#include "2sysincludes.h"
+#include "cgptlib_internal.h"
+#include "gpt_misc.h"
+#include "host_common.h"
+#include "host_key21.h"
+#include "host_key.h"
+#include "host_misc.h"
+#include "host_signature.h"
+#include "vboot_host_api.h"
+
+struct vb2_host_image {
+	uint8_t *data;
+	size_t size;
+};
+
+/* Exactly one of packed and priv is set. */
+struct vb2_host_key {
+	struct vb2_packed_key *packed;
+	struct vb2_private_key *priv;
+};
+
+struct vb2_host_keyblock {
+	struct vb2_keyblock *keyblock;
+};
+
+struct vb2_host_gpt {
+	GptData gpt;
+};
+
+uint32_t vb2_host_api_version(void)
+{
+	return VB2_HOST_API_VERSION;
+}
+
+/****************************************************************************/
+/* Images */
+
+static vb2_error_t new_image(size_t size, struct vb2_host_image **image_ptr)
+{
+	struct vb2_host_image *image;
+
+	image = calloc(1, sizeof(*image));
+	if (!image)
+		return VB2_ERROR_HOST_API_ALLOC;
+	/* Always allocate something, so that data is never NULL */
+	image->data = malloc(size ? size : 1);
+	if (!image->data) {
+		free(image);
+		return VB2_ERROR_HOST_API_ALLOC;
+	}
+	image->size = size;
+
+	*image_ptr = image;
+	return VB2_SUCCESS;
+}
+
+vb2_error_t vb2_host_image_load(const char *filename,
+				struct vb2_host_image **image_ptr)
+{
+	struct vb2_host_image *image;
+	struct stat st;
+	size_t offset;
+	ssize_t got;
+	int fd;
+
+	*image_ptr = NULL;
+
+	fd = open(filename, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		VB2_DEBUG("Unable to open %s\n", filename);
+		return VB2_ERROR_READ_FILE_OPEN;
+	}
+	if (fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+		VB2_DEBUG("Unable to stat %s\n", filename);
+		close(fd);
+		return VB2_ERROR_READ_FILE_SIZE;
+	}
+
+	/*
+	 * Read the whole file into memory instead of mapping it.  A mapping
+	 * would fault if the file were truncated, including by saving an
+	 * image back over it with vb2_host_image_save().
+	 */
+	if (new_image(st.st_size, &image)) {
+		close(fd);
+		return VB2_ERROR_HOST_API_ALLOC;
+	}
+	for (offset = 0; offset < image->size; offset += got) {
+		got = read(fd, image->data + offset, image->size - offset);
+		if (got < 0 && errno == EINTR) {
+			got = 0;
+			continue;
+		}
+		if (got <= 0) {
+			VB2_DEBUG("Unable to read %s\n", filename);
+			close(fd);
+			vb2_host_image_free(image);
+			return VB2_ERROR_READ_FILE_DATA;
+		}
+	}
+	close(fd);
+
+	*image_ptr = image;
+	return VB2_SUCCESS;
+}
+
+vb2_error_t vb2_host_image_from_buffer(const void *buf, size_t size,
+				       struct vb2_host_image **image_ptr)
+{
+	*image_ptr = NULL;
+	VB2_TRY(new_image(size, image_ptr));
+	memcpy((*image_ptr)->data, buf, size);
+	return VB2_SUCCESS;
+}
+
+const uint8_t *vb2_host_image_data(const struct vb2_host_image *image,
+				   size_t *size_ptr)
+{
+	*size_ptr = image->size;
+	return image->data;
+}
+
+vb2_error_t vb2_host_image_save(const struct vb2_host_image *image,
+				const char *filename)
+{
+	FILE *f;
+	int err;
+
+	f = fopen(filename, "wb");
+	if (!f) {
+		VB2_DEBUG("Unable to open %s for writing\n", filename);
+		return VB2_ERROR_WRITE_FILE_OPEN;
+	}
+	err = image->size && 1 != fwrite(image->data, image->size, 1, f);
+	err |= fclose(f);
+	if (err) {
+		VB2_DEBUG("Unable to write to %s\n", filename);
+		unlink(filename);
+		return VB2_ERROR_WRITE_FILE_DATA;
+	}
+	return VB2_SUCCESS;
+}
+
+void vb2_host_image_free(struct vb2_host_image *image)
+{
+	if (!image)
+		return;
+	free(image->data);
+	free(image);
+}
+
+/****************************************************************************/
+/* Keys */
+
+vb2_error_t vb2_host_public_key_load(const char *filename,
+				     struct vb2_host_key **key_ptr)
+{
+	struct vb2_host_key *key;
+
+	*key_ptr = NULL;
+
+	key = calloc(1, sizeof(*key));
+	if (!key)
+		return VB2_ERROR_HOST_API_ALLOC;
+	key->packed = vb2_read_packed_key(filename);
+	if (!key->packed) {
+		VB2_DEBUG("Unable to read public key %s\n", filename);
+		free(key);
+		return VB2_ERROR_HOST_API_PUBLIC_KEY;
+	}
+
+	*key_ptr = key;
+	return VB2_SUCCESS;
+}
+
+vb2_error_t vb2_host_private_key_load(const char *name,
+				      struct vb2_host_key **key_ptr)
+{
+	struct vb2_host_key *key;
+
+	*key_ptr = NULL;
+
+	key = calloc(1, sizeof(*key));
+	if (!key)
+		return VB2_ERROR_HOST_API_ALLOC;
+	key->priv = vb2_read_private_key(name);
+	if (!key->priv) {
+		VB2_DEBUG("Unable to read private key %s\n", name);
+		free(key);
+		return VB2_ERROR_HOST_API_PRIVATE_KEY;
+	}
+
+	*key_ptr = key;
+	return VB2_SUCCESS;
+}
+
+void vb2_host_key_free(struct vb2_host_key *key)
+{
+	if (!key)
+		return;
+	free(key->packed);
+	vb2_free_private_key(key->priv);
+	free(key);
+}
+
+/*
+ * Work buffer for the verification functions, on the heap to spare the
+ * stacks of callers' threads.
+ */
+static uint8_t *new_workbuf(struct vb2_workbuf *wb)
+{
+	uint8_t *workbuf = malloc(VB2_KERNEL_WORKBUF_RECOMMENDED_SIZE);
+
+	if (workbuf)
+		vb2_workbuf_init(wb, workbuf,
+				 VB2_KERNEL_WORKBUF_RECOMMENDED_SIZE);
+	return workbuf;
+}
+
+vb2_error_t vb2_host_keyblock_load(const char *filename,
+				   struct vb2_host_keyblock **keyblock_ptr)
+{
+	struct vb2_host_keyblock *keyblock;
+	struct vb2_workbuf wb;
+	uint8_t *workbuf;
+	uint8_t *data;
+	uint32_t size;
+	vb2_error_t rv;
+
+	*keyblock_ptr = NULL;
+
+	VB2_TRY(vb2_read_file(filename, &data, &size));
+
+	keyblock = calloc(1, sizeof(*keyblock));
+	workbuf = new_workbuf(&wb);
+	if (!keyblock || !workbuf) {
+		rv = VB2_ERROR_HOST_API_ALLOC;
+		goto fail;
+	}
+
+	keyblock->keyblock = (struct vb2_keyblock *)data;
+	rv = vb2_verify_keyblock_hash(keyblock->keyblock, size, &wb);
+	if (rv) {
+		VB2_DEBUG("Invalid keyblock %s\n", filename);
+		goto fail;
+	}
+
+	free(workbuf);
+	*keyblock_ptr = keyblock;
+	return VB2_SUCCESS;
+
+fail:
+	free(workbuf);
+	free(keyblock);
+	free(data);
+	return rv;
+}
+
+void vb2_host_keyblock_free(struct vb2_host_keyblock *keyblock)
+{
+	if (!keyblock)
+		return;
+	free(keyblock->keyblock);
+	free(keyblock);
+}
+
+/****************************************************************************/
+/* Kernel partitions */
+
+/*
+ * Verify a kernel partition, and point to its preamble.  The verification
+ * functions take non-const pointers, but none of them write to the data they
+ * check.
+ */
+static vb2_error_t verify_kernel(const struct vb2_host_image *kernel,
+				 const struct vb2_host_key *key,
+				 struct vb2_host_kernel_info *info,
+				 struct vb2_kernel_preamble **preamble_ptr,
+				 struct vb2_workbuf *wb)
+{
+	struct vb2_keyblock *keyblock;
+	struct vb2_kernel_preamble *preamble;
+	struct vb2_public_key pubkey;
+	uint32_t size, chunk_size;
+	uint8_t *body;
+
+	/* Kernel partitions are far smaller than 4 GB */
+	size = kernel->size > UINT32_MAX ? UINT32_MAX : kernel->size;
+	if (size < sizeof(*keyblock))
+		return VB2_ERROR_HOST_API_KERNEL_SIZE;
+	keyblock = (struct vb2_keyblock *)kernel->data;
+
+	if (key) {
+		if (!key->packed)
+			return VB2_ERROR_HOST_API_KEY_TYPE;
+		VB2_TRY(vb2_unpack_key(&pubkey, key->packed));
+		VB2_TRY(vb2_verify_keyblock(keyblock, size, &pubkey, wb));
+	} else {
+		VB2_TRY(vb2_verify_keyblock_hash(keyblock, size, wb));
+	}
+
+	if (size - keyblock->keyblock_size < sizeof(*preamble))
+		return VB2_ERROR_HOST_API_KERNEL_SIZE;
+	preamble = (struct vb2_kernel_preamble *)
+		(kernel->data + keyblock->keyblock_size);
+	VB2_TRY(vb2_unpack_key(&pubkey, &keyblock->data_key));
+	VB2_TRY(vb2_verify_kernel_preamble(preamble,
+					   size - keyblock->keyblock_size,
+					   &pubkey, wb));
+
+	info->keyblock_flags = keyblock->keyblock_flags;
+	info->data_key_version = keyblock->data_key.key_version;
+	info->kernel_version = preamble->kernel_version;
+	info->flags = vb2_kernel_get_flags(preamble);
+	info->body_offset = keyblock->keyblock_size + preamble->preamble_size;
+	info->body_size = preamble->body_signature.data_size;
+	info->body_load_address = preamble->body_load_address;
+	info->bootloader_address = preamble->bootloader_address;
+	info->bootloader_size = preamble->bootloader_size;
+
+	if (info->body_offset > size ||
+	    info->body_size > size - info->body_offset)
+		return VB2_ERROR_HOST_API_KERNEL_BODY;
+	body = kernel->data + info->body_offset;
+
+	chunk_size = vb2_kernel_get_body_chunk_size(preamble);
+	if (chunk_size)
+		VB2_TRY(vb2_verify_data_tree(body, info->body_size,
+					     &preamble->body_signature,
+					     &pubkey, chunk_size, wb));
+	else
+		VB2_TRY(vb2_verify_data(body, info->body_size,
+					&preamble->body_signature,
+					&pubkey, wb));
+
+	if (preamble_ptr)
+		*preamble_ptr = preamble;
+	return VB2_SUCCESS;
+}
+
+vb2_error_t vb2_host_kernel_verify(const struct vb2_host_image *kernel,
+				   const struct vb2_host_key *key,
+				   struct vb2_host_kernel_info *info)
+{
+	struct vb2_host_kernel_info local_info;
+	struct vb2_workbuf wb;
+	uint8_t *workbuf;
+	vb2_error_t rv;
+
+	workbuf = new_workbuf(&wb);
+	if (!workbuf)
+		return VB2_ERROR_HOST_API_ALLOC;
+	rv = verify_kernel(kernel, key, info ? info : &local_info, NULL, &wb);
+	free(workbuf);
+	return rv;
+}
+
+vb2_error_t vb2_host_kernel_sign(const struct vb2_host_image *kernel,
+				 const struct vb2_host_keyblock *keyblock,
+				 const struct vb2_host_key *signing_key,
+				 struct vb2_host_image **signed_ptr)
+{
+	const struct vb2_private_key *priv = signing_key->priv;
+	struct vb2_host_kernel_info info;
+	struct vb2_kernel_preamble *preamble;
+	struct vb2_kernel_preamble *new_preamble = NULL;
+	struct vb2_signature *body_sig = NULL;
+	struct vb2_host_image *image;
+	struct vb2_workbuf wb;
+	uint8_t *workbuf;
+	uint8_t *body;
+	uint64_t vmlinuz_header_address;
+	uint32_t vmlinuz_header_size;
+	uint32_t keyblock_size = keyblock->keyblock->keyblock_size;
+	uint32_t chunk_size;
+	vb2_error_t rv;
+
+	*signed_ptr = NULL;
+
+	if (!priv)
+		return VB2_ERROR_HOST_API_KEY_TYPE;
+
+	workbuf = new_workbuf(&wb);
+	if (!workbuf)
+		return VB2_ERROR_HOST_API_ALLOC;
+	rv = verify_kernel(kernel, NULL, &info, &preamble, &wb);
+	free(workbuf);
+	if (rv)
+		return rv;
+
+	/* The body stays where it is, so the vblock keeps its size. */
+	if (keyblock_size >= info.body_offset)
+		return VB2_ERROR_HOST_API_VBLOCK_SIZE;
+
+	body = kernel->data + info.body_offset;
+	chunk_size = vb2_kernel_get_body_chunk_size(preamble);
+	vb2_kernel_get_vmlinuz_header(preamble, &vmlinuz_header_address,
+				      &vmlinuz_header_size);
+
+	if (chunk_size)
+		body_sig = vb2_calculate_tree_signature(body, info.body_size,
+							chunk_size, priv);
+	else
+		body_sig = vb2_calculate_signature(body, info.body_size, priv);
+	if (body_sig)
+		new_preamble = vb2_create_kernel_preamble(
+			info.kernel_version,
+			info.body_load_address,
+			info.bootloader_address,
+			info.bootloader_size,
+			body_sig,
+			vmlinuz_header_address,
+			vmlinuz_header_size,
+			info.flags,
+			info.body_offset - keyblock_size,
+			priv);
+
+	if (!body_sig) {
+		rv = VB2_ERROR_HOST_API_SIGN_BODY;
+		goto done;
+	}
+	if (!new_preamble) {
+		rv = VB2_ERROR_HOST_API_SIGN_PREAMBLE;
+		goto done;
+	}
+	if (new_preamble->preamble_size > info.body_offset - keyblock_size) {
+		rv = VB2_ERROR_HOST_API_VBLOCK_SIZE;
+		goto done;
+	}
+
+	rv = new_image(kernel->size, &image);
+	if (rv)
+		goto done;
+	memset(image->data, 0, info.body_offset);
+	memcpy(image->data, keyblock->keyblock, keyblock_size);
+	memcpy(image->data + keyblock_size, new_preamble,
+	       new_preamble->preamble_size);
+	/* Keep the body and anything after it as it was */
+	memcpy(image->data + info.body_offset, body,
+	       kernel->size - info.body_offset);
+	*signed_ptr = image;
+
+done:
+	free(new_preamble);
+	free(body_sig);
+	return rv;
+}
+
+/****************************************************************************/
+/* GPT */
+
+#define GPT_SECTOR_BYTES 512
+
+/* Copy the entries a header points to, if the header is valid. */
+static void load_gpt_entries(const struct vb2_host_image *disk,
+			     GptHeader *header, int is_secondary,
+			     uint64_t sectors, uint8_t *entries)
+{
+	size_t entries_bytes;
+
+	if (CheckHeader(header, is_secondary, sectors, sectors, 0,
+			GPT_SECTOR_BYTES))
+		return;
+
+	entries_bytes = CalculateEntriesSectors(header, GPT_SECTOR_BYTES) *
+		GPT_SECTOR_BYTES;
+	if (entries_bytes > GPT_ENTRIES_ALLOC_SIZE)
+		entries_bytes = GPT_ENTRIES_ALLOC_SIZE;
+	if (header->entries_lba >= sectors ||
+	    entries_bytes > (sectors - header->entries_lba) * GPT_SECTOR_BYTES)
+		return;
+	memcpy(entries, disk->data + header->entries_lba * GPT_SECTOR_BYTES,
+	       entries_bytes);
+}
+
+vb2_error_t vb2_host_gpt_open(const struct vb2_host_image *disk,
+			      struct vb2_host_gpt **gpt_ptr)
+{
+	struct vb2_host_gpt *gpt;
+	GptData *g;
+	uint64_t sectors = disk->size / GPT_SECTOR_BYTES;
+
+	*gpt_ptr = NULL;
+
+	if (disk->size % GPT_SECTOR_BYTES ||
+	    sectors < GPT_PMBR_SECTORS + 2 * GPT_HEADER_SECTORS)
+		return VB2_ERROR_HOST_API_GPT_SIZE;
+
+	gpt = calloc(1, sizeof(*gpt));
+	if (!gpt)
+		return VB2_ERROR_HOST_API_ALLOC;
+	g = &gpt->gpt;
+	g->sector_bytes = GPT_SECTOR_BYTES;
+	g->streaming_drive_sectors = sectors;
+	g->gpt_drive_sectors = sectors;
+	g->primary_header = calloc(1, GPT_SECTOR_BYTES);
+	g->secondary_header = calloc(1, GPT_SECTOR_BYTES);
+	g->primary_entries = calloc(1, GPT_ENTRIES_ALLOC_SIZE);
+	g->secondary_entries = calloc(1, GPT_ENTRIES_ALLOC_SIZE);
+	if (!g->primary_header || !g->secondary_header ||
+	    !g->primary_entries || !g->secondary_entries) {
+		vb2_host_gpt_free(gpt);
+		return VB2_ERROR_HOST_API_ALLOC;
+	}
+
+	memcpy(g->primary_header,
+	       disk->data + GPT_PMBR_SECTORS * GPT_SECTOR_BYTES,
+	       GPT_SECTOR_BYTES);
+	memcpy(g->secondary_header,
+	       disk->data + (sectors - GPT_HEADER_SECTORS) * GPT_SECTOR_BYTES,
+	       GPT_SECTOR_BYTES);
+	load_gpt_entries(disk, (GptHeader *)g->primary_header, 0, sectors,
+			 g->primary_entries);
+	load_gpt_entries(disk, (GptHeader *)g->secondary_header, 1, sectors,
+			 g->secondary_entries);
+
+	if (GPT_SUCCESS != GptValidityCheck(g) || !g->valid_entries) {
+		vb2_host_gpt_free(gpt);
+		return VB2_ERROR_HOST_API_GPT_INVALID;
+	}
+
+	*gpt_ptr = gpt;
+	return VB2_SUCCESS;
+}
+
+/* Header of the GPT copy whose entries are used */
+static const GptHeader *gpt_header(const struct vb2_host_gpt *gpt)
+{
+	return (const GptHeader *)((gpt->gpt.valid_headers & MASK_PRIMARY) ?
+				   gpt->gpt.primary_header :
+				   gpt->gpt.secondary_header);
+}
+
+uint32_t vb2_host_gpt_num_entries(const struct vb2_host_gpt *gpt)
+{
+	return gpt_header(gpt)->number_of_entries;
+}
+
+vb2_error_t vb2_host_gpt_get_entry(const struct vb2_host_gpt *gpt,
+				   uint32_t index,
+				   struct vb2_host_gpt_entry *entry)
+{
+	const GptHeader *header = gpt_header(gpt);
+	const uint8_t *entries;
+	const GptEntry *e;
+
+	if (index >= header->number_of_entries)
+		return VB2_ERROR_HOST_API_GPT_INDEX;
+
+	entries = (gpt->gpt.valid_entries & MASK_PRIMARY) ?
+		gpt->gpt.primary_entries : gpt->gpt.secondary_entries;
+	e = (const GptEntry *)(entries + index * header->size_of_entry);
+
+	memset(entry, 0, sizeof(*entry));
+	memcpy(&entry->type, &e->type, sizeof(entry->type));
+	memcpy(&entry->unique, &e->unique, sizeof(entry->unique));
+	entry->starting_lba = e->starting_lba;
+	entry->ending_lba = e->ending_lba;
+	entry->attributes = e->attrs.whole;
+	entry->priority = GetEntryPriority(e);
+	entry->tries = GetEntryTries(e);
+	entry->successful = GetEntrySuccessful(e);
+	if (CGPT_OK != UTF16ToUTF8(e->name, ARRAY_SIZE(e->name),
+				   (uint8_t *)entry->label,
+				   sizeof(entry->label)))
+		entry->label[0] = '\0';
+	return VB2_SUCCESS;
+}
+
+void vb2_host_gpt_free(struct vb2_host_gpt *gpt)
+{
+	if (!gpt)
+		return;
+	free(gpt->gpt.primary_header);
+	free(gpt->gpt.secondary_header);
+	free(gpt->gpt.primary_entries);
+	free(gpt->gpt.secondary_entries);
+	free(gpt);
+}
@@ -19,6 +19,7 @@
 #include "host_key21.h"
 #include "host_key.h"
 #include "host_misc.h"
+#include "pkcs11_key.h"
 
 enum vb2_crypto_algorithm vb2_get_crypto_algorithm(
 	enum vb2_hash_algorithm hash_alg,
@@ -35,12 +36,13 @@ enum vb2_crypto_algorithm vb2_get_crypto_algorithm(
 		+ (hash_alg - VB2_HASH_SHA1);
 };
 
-struct vb2_private_key *vb2_read_private_key(const char *filename)
+struct vb2_private_key *vb2_unpack_private_key(const uint8_t *buf,
+					       uint32_t bufsize)
 {
-	uint8_t *buf = NULL;
-	uint32_t bufsize = 0;
-	if (VB2_SUCCESS != vb2_read_file(filename, &buf, &bufsize)) {
-		VB2_DEBUG("unable to read from file %s\n", filename);
+	uint64_t alg;
+
+	if (bufsize < sizeof(alg)) {
+		VB2_DEBUG("Private key buffer too small\n");
 		return NULL;
 	}
 
@@ -48,11 +50,10 @@ struct vb2_private_key *vb2_read_private_key(const char *filename)
 		(struct vb2_private_key *)calloc(sizeof(*key), 1);
 	if (!key) {
 		VB2_DEBUG("Unable to allocate private key\n");
-		free(buf);
 		return NULL;
 	}
 
-	uint64_t alg = *(uint64_t *)buf;
+	memcpy(&alg, buf, sizeof(alg));
 	key->hash_alg = vb2_crypto_to_hash(alg);
 	key->sig_alg = vb2_crypto_to_signature(alg);
 	const unsigned char *start = buf + sizeof(alg);
@@ -62,11 +63,91 @@ struct vb2_private_key *vb2_read_private_key(const char *filename)
 
 	if (!key->rsa_private_key) {
 		VB2_DEBUG("Unable to parse RSA private key\n");
-		free(buf);
 		free(key);
 		return NULL;
 	}
 
+	return key;
+}
+
+struct vb2_private_key *vb2_read_private_key_pkcs11(const char *name)
+{
+	const size_t prefix_len = strlen(PKCS11_KEY_PREFIX);
+	enum vb2_hash_algorithm hash_alg = VB2_HASH_SHA256;
+	struct vb2_private_key *key = NULL;
+	struct pkcs11_key *p11_key;
+	char *spec, *slot, *label, *hash, *end;
+	unsigned long slot_id;
+
+	if (strncmp(name, PKCS11_KEY_PREFIX, prefix_len)) {
+		VB2_DEBUG("Not a PKCS#11 key: %s\n", name);
+		return NULL;
+	}
+
+	/* <module>:<slot>:<label>[:<hash>] */
+	spec = strdup(name + prefix_len);
+	if (!spec)
+		return NULL;
+	slot = strchr(spec, ':');
+	label = slot ? strchr(++slot, ':') : NULL;
+	if (!label || slot == spec + 1 || label == slot) {
+		VB2_DEBUG("Invalid PKCS#11 key: %s\n", name);
+		goto out;
+	}
+	slot[-1] = '\0';
+	*label++ = '\0';
+	hash = strchr(label, ':');
+	if (hash)
+		*hash++ = '\0';
+
+	slot_id = strtoul(slot, &end, 0);
+	if (*end || !*label) {
+		VB2_DEBUG("Invalid PKCS#11 key: %s\n", name);
+		goto out;
+	}
+	if (hash && !vb2_lookup_hash_alg(hash, &hash_alg)) {
+		VB2_DEBUG("Invalid hash algorithm in PKCS#11 key: %s\n", name);
+		goto out;
+	}
+
+	if (VB2_SUCCESS != pkcs11_get_key(&p11_key, spec, slot_id, label))
+		goto out;
+
+	key = (struct vb2_private_key *)calloc(sizeof(*key), 1);
+	if (!key) {
+		pkcs11_free_key(p11_key);
+		goto out;
+	}
+	key->key_location = VB2_PRIVATE_KEY_PKCS11;
+	key->p11_key = p11_key;
+	key->hash_alg = hash_alg;
+	key->sig_alg = pkcs11_get_sig_alg(p11_key);
+	if (key->sig_alg == VB2_SIG_INVALID) {
+		VB2_DEBUG("Unsupported PKCS#11 key: %s\n", name);
+		vb2_free_private_key(key);
+		key = NULL;
+	}
+
+ out:
+	free(spec);
+	return key;
+}
+
+struct vb2_private_key *vb2_read_private_key(const char *filename)
+{
+	uint8_t *buf = NULL;
+	uint32_t bufsize = 0;
+
+	if (!strncmp(filename, PKCS11_KEY_PREFIX, strlen(PKCS11_KEY_PREFIX)))
+		return vb2_read_private_key_pkcs11(filename);
+
+	if (VB2_SUCCESS != vb2_read_file(filename, &buf, &bufsize)) {
+		VB2_DEBUG("unable to read from file %s\n", filename);
+		return NULL;
+	}
+
+	struct vb2_private_key *key = vb2_unpack_private_key(buf, bufsize);
+
 	free(buf);
 	return key;
 }
@@ -117,12 +198,19 @@ void vb2_free_private_key(struct vb2_private_key *key)
 		return;
 	if (key->rsa_private_key)
 		RSA_free(key->rsa_private_key);
+	if (key->p11_key)
+		pkcs11_free_key(key->p11_key);
 	free(key);
 }
 
 vb2_error_t vb2_write_private_key(const char *filename,
 				  const struct vb2_private_key *key)
 {
+	if (key->key_location != VB2_PRIVATE_KEY_LOCAL) {
+		fprintf(stderr, "Only local private keys can be written\n");
+		return VB2_ERROR_PRIVATE_KEY_WRITE_RSA;
+	}
+
 	/* Convert back to legacy vb1 algorithm enum */
 	uint64_t alg = vb2_get_crypto_algorithm(key->hash_alg, key->sig_alg);
 	if (alg == VB2_ALG_COUNT) {
@@ -0,0 +1,321 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Host-side cache of parsed private keys.
+ */
+
+#include <openssl/bio.h>
+#include <openssl/pem.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "2common.h"
+#include "2sha.h"
+#include "2sysincludes.h"
+#include "host_common.h"
+#include "host_key21.h"
+#include "host_keyring.h"
+#include "host_misc.h"
+
+struct keyring_path {
+	char *path;
+	dev_t dev;
+	ino_t ino;
+	off_t size;
+	struct timespec mtime;
+	struct keyring_path *next;
+};
+
+struct keyring_entry {
+	uint8_t digest[VB2_SHA256_DIGEST_SIZE];
+	enum vb2_keyring_format format;
+	enum vb2_crypto_algorithm algorithm;
+	struct vb2_private_key *key;
+	/* Paths known to hold this key, as of their last stat() */
+	struct keyring_path *paths;
+	struct keyring_entry *next;
+};
+
+static struct keyring_entry *keyring;
+static struct vb2_keyring_stats keyring_stats;
+
+/* Algorithm only distinguishes PEM keys; other formats carry their own. */
+static enum vb2_crypto_algorithm entry_algorithm(
+	enum vb2_keyring_format format, enum vb2_crypto_algorithm algorithm)
+{
+	return format == VB2_KEYRING_PEM ? algorithm : VB2_ALG_COUNT;
+}
+
+static int path_matches(const struct keyring_path *p, const char *filename,
+			const struct stat *st)
+{
+	return !strcmp(p->path, filename) &&
+		p->dev == st->st_dev && p->ino == st->st_ino &&
+		p->size == st->st_size &&
+		p->mtime.tv_sec == st->st_mtim.tv_sec &&
+		p->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+static struct keyring_entry *find_by_path(
+	const char *filename, enum vb2_keyring_format format,
+	enum vb2_crypto_algorithm algorithm, const struct stat *st)
+{
+	struct keyring_entry *e;
+	struct keyring_path *p;
+
+	for (e = keyring; e; e = e->next) {
+		if (e->format != format || e->algorithm != algorithm)
+			continue;
+		for (p = e->paths; p; p = p->next) {
+			if (path_matches(p, filename, st))
+				return e;
+		}
+	}
+	return NULL;
+}
+
+static struct keyring_entry *find_by_digest(
+	const uint8_t *digest, enum vb2_keyring_format format,
+	enum vb2_crypto_algorithm algorithm)
+{
+	struct keyring_entry *e;
+
+	for (e = keyring; e; e = e->next) {
+		if (e->format == format && e->algorithm == algorithm &&
+		    !memcmp(e->digest, digest, sizeof(e->digest)))
+			return e;
+	}
+	return NULL;
+}
+
+/* Forget any stale record of filename, then remember it for entry e. */
+static void remember_path(struct keyring_entry *e, const char *filename,
+			  const struct stat *st)
+{
+	struct keyring_entry *i;
+	struct keyring_path **pp, *p;
+
+	for (i = keyring; i; i = i->next) {
+		if (i->format != e->format || i->algorithm != e->algorithm)
+			continue;
+		pp = &i->paths;
+		while ((p = *pp)) {
+			if (!strcmp(p->path, filename)) {
+				*pp = p->next;
+				free(p->path);
+				free(p);
+			} else {
+				pp = &p->next;
+			}
+		}
+	}
+
+	p = calloc(1, sizeof(*p));
+	if (!p)
+		return;
+	p->path = strdup(filename);
+	if (!p->path) {
+		free(p);
+		return;
+	}
+	p->dev = st->st_dev;
+	p->ino = st->st_ino;
+	p->size = st->st_size;
+	p->mtime = st->st_mtim;
+	p->next = e->paths;
+	e->paths = p;
+}
+
+static struct vb2_private_key *unpack_pem(const uint8_t *buf, uint32_t size,
+					  enum vb2_crypto_algorithm algorithm)
+{
+	struct vb2_private_key *key;
+	BIO *bio;
+
+	if (algorithm >= VB2_ALG_COUNT) {
+		VB2_DEBUG("Invalid algorithm for PEM key\n");
+		return NULL;
+	}
+
+	key = calloc(1, sizeof(*key));
+	if (!key)
+		return NULL;
+
+	bio = BIO_new_mem_buf(buf, size);
+	if (!bio) {
+		free(key);
+		return NULL;
+	}
+	key->rsa_private_key = PEM_read_bio_RSAPrivateKey(bio, NULL, NULL,
+							  NULL);
+	BIO_free(bio);
+
+	if (!key->rsa_private_key) {
+		VB2_DEBUG("Unable to parse PEM private key\n");
+		free(key);
+		return NULL;
+	}
+
+	key->hash_alg = vb2_crypto_to_hash(algorithm);
+	key->sig_alg = vb2_crypto_to_signature(algorithm);
+	return key;
+}
+
+static struct vb2_private_key *unpack_key(const uint8_t *buf, uint32_t size,
+					  enum vb2_keyring_format format,
+					  enum vb2_crypto_algorithm algorithm)
+{
+	struct vb2_private_key *key = NULL;
+
+	switch (format) {
+	case VB2_KEYRING_VBPRIVK:
+		return vb2_unpack_private_key(buf, size);
+	case VB2_KEYRING_PEM:
+		return unpack_pem(buf, size, algorithm);
+	case VB2_KEYRING_VB21:
+		if (vb21_private_key_unpack(&key, buf, size))
+			return NULL;
+		return key;
+	}
+
+	return NULL;
+}
+
+static struct keyring_entry *load_buffer(const uint8_t *buf, uint32_t size,
+					 enum vb2_keyring_format format,
+					 enum vb2_crypto_algorithm algorithm)
+{
+	uint8_t digest[VB2_SHA256_DIGEST_SIZE];
+	struct keyring_entry *e;
+
+	if (vb2_digest_buffer(buf, size, VB2_HASH_SHA256,
+			      digest, sizeof(digest)))
+		return NULL;
+
+	e = find_by_digest(digest, format, algorithm);
+	if (e) {
+		keyring_stats.content_hits++;
+		return e;
+	}
+
+	e = calloc(1, sizeof(*e));
+	if (!e)
+		return NULL;
+
+	e->key = unpack_key(buf, size, format, algorithm);
+	if (!e->key) {
+		free(e);
+		return NULL;
+	}
+
+	memcpy(e->digest, digest, sizeof(e->digest));
+	e->format = format;
+	e->algorithm = algorithm;
+	e->next = keyring;
+	keyring = e;
+	keyring_stats.loads++;
+	return e;
+}
+
+const struct vb2_private_key *vb2_keyring_load_buffer(
+	const uint8_t *buf, uint32_t size, enum vb2_keyring_format format,
+	enum vb2_crypto_algorithm algorithm)
+{
+	struct keyring_entry *e;
+
+	e = load_buffer(buf, size, format, entry_algorithm(format, algorithm));
+	return e ? e->key : NULL;
+}
+
+const struct vb2_private_key *vb2_keyring_read(
+	const char *filename, enum vb2_keyring_format format,
+	enum vb2_crypto_algorithm algorithm)
+{
+	struct keyring_entry *e;
+	struct stat st;
+	uint8_t *buf = NULL;
+	uint32_t size = 0;
+
+	algorithm = entry_algorithm(format, algorithm);
+
+	if (stat(filename, &st)) {
+		VB2_DEBUG("unable to stat %s\n", filename);
+		return NULL;
+	}
+
+	e = find_by_path(filename, format, algorithm, &st);
+	if (e) {
+		keyring_stats.path_hits++;
+		return e->key;
+	}
+
+	if (VB2_SUCCESS != vb2_read_file(filename, &buf, &size)) {
+		VB2_DEBUG("unable to read from file %s\n", filename);
+		return NULL;
+	}
+
+	e = load_buffer(buf, size, format, algorithm);
+	free(buf);
+	if (!e)
+		return NULL;
+
+	remember_path(e, filename, &st);
+	return e->key;
+}
+
+const struct vb2_private_key *vb2_keyring_read_private_key(
+	const char *filename)
+{
+	return vb2_keyring_read(filename, VB2_KEYRING_VBPRIVK, VB2_ALG_COUNT);
+}
+
+const struct vb2_private_key *vb2_keyring_read_private_key_pem(
+	const char *filename, enum vb2_crypto_algorithm algorithm)
+{
+	return vb2_keyring_read(filename, VB2_KEYRING_PEM, algorithm);
+}
+
+vb2_error_t vb21_keyring_private_key_read(
+	const struct vb2_private_key **key_ptr, const char *filename)
+{
+	*key_ptr = vb2_keyring_read(filename, VB2_KEYRING_VB21,
+				    VB2_ALG_COUNT);
+	return *key_ptr ? VB2_SUCCESS : VB2_ERROR_KEYRING_READ;
+}
+
+const struct vb2_private_key *vb2_keyring_find(
+	const uint8_t digest[VB2_SHA256_DIGEST_SIZE],
+	enum vb2_keyring_format format, enum vb2_crypto_algorithm algorithm)
+{
+	struct keyring_entry *e;
+
+	e = find_by_digest(digest, format, entry_algorithm(format, algorithm));
+	return e ? e->key : NULL;
+}
+
+void vb2_keyring_get_stats(struct vb2_keyring_stats *stats)
+{
+	*stats = keyring_stats;
+}
+
+void vb2_keyring_clear(void)
+{
+	struct keyring_entry *e;
+	struct keyring_path *p;
+
+	while ((e = keyring)) {
+		keyring = e->next;
+		while ((p = e->paths)) {
+			e->paths = p->next;
+			free(p->path);
+			free(p);
+		}
+		vb2_private_key_free(e->key);
+		free(e);
+	}
+
+	memset(&keyring_stats, 0, sizeof(keyring_stats));
+}
@@ -20,7 +20,25 @@
 #include "2sha.h"
 #include "2sysincludes.h"
 #include "host_common.h"
+#include "host_key21.h"
 #include "host_signature21.h"
+#include "pkcs11_key.h"
+
+/* Sign [inbuf] in-process with the PKCS#11 key named [key_name], so no
+ * external signer has to be run.  Returns -1 on error, 0 on success.
+ */
+static int sign_pkcs11(uint32_t size, const uint8_t *inbuf, uint8_t *outbuf,
+		       uint32_t outbufsize, const char *key_name)
+{
+	struct vb2_private_key *key = vb2_read_private_key_pkcs11(key_name);
+	int rv;
+
+	if (!key)
+		return -1;
+	rv = pkcs11_sign(key->p11_key, inbuf, size, outbuf, outbufsize);
+	vb2_free_private_key(key);
+	return rv ? -1 : 0;
+}
 
 /* Invoke [external_signer] command with [pem_file] as an argument, contents of
  * [inbuf] passed redirected to stdin, and the stdout of the command is put
@@ -34,6 +52,9 @@ static int sign_external(uint32_t size, const uint8_t *inbuf, uint8_t *outbuf,
 	int p_to_c[2], c_to_p[2];  /* pipe descriptors */
 	pid_t pid;
 
+	if (!strncmp(pem_file, PKCS11_KEY_PREFIX, strlen(PKCS11_KEY_PREFIX)))
+		return sign_pkcs11(size, inbuf, outbuf, outbufsize, pem_file);
+
 	VB2_DEBUG("Will invoke \"%s %s\" to perform signing.\n"
 		 "Input to the signer will be provided on standard in.\n"
 		 "Output of the signer will be read from standard out.\n",
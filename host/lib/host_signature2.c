@@ -22,6 +22,7 @@
 #include "host_common.h"
 #include "host_key21.h"
 #include "host_signature21.h"
+#include "pkcs11_key.h"
 
 struct vb2_signature *vb2_alloc_signature(uint32_t sig_size,
 					  uint32_t data_size)
@@ -79,11 +80,11 @@ struct vb2_signature *vb2_sha512_signature(const uint8_t *data, uint32_t size)
 	return sig;
 }
 
-struct vb2_signature *vb2_calculate_signature(
-		const uint8_t *data, uint32_t size,
-		const struct vb2_private_key *key)
+/* Sign a digest of size bytes of data with key. */
+static struct vb2_signature *sign_digest(const uint8_t *digest,
+					 uint32_t size,
+					 const struct vb2_private_key *key)
 {
-	uint8_t digest[VB2_MAX_DIGEST_SIZE];
 	uint32_t digest_size = vb2_digest_size(key->hash_alg);
 
 	uint32_t digest_info_size = 0;
@@ -92,11 +93,6 @@ struct vb2_signature *vb2_calculate_signature(
 					   &digest_info, &digest_info_size))
 		return NULL;
 
-	/* Calculate the digest */
-	if (VB2_SUCCESS != vb2_digest_buffer(data, size, key->hash_alg,
-					     digest, digest_size))
-		return NULL;
-
 	/* Prepend the digest info to the digest */
 	int signature_digest_len = digest_size + digest_info_size;
 	uint8_t *signature_digest = malloc(signature_digest_len);
@@ -115,11 +111,18 @@ struct vb2_signature *vb2_calculate_signature(
 	}
 
 	/* Sign the signature_digest into our output buffer */
-	int rv = RSA_private_encrypt(signature_digest_len,    /* Input length */
-				     signature_digest,        /* Input data */
-				     vb2_signature_data_mutable(sig),  /* Output sig */
-				     key->rsa_private_key,    /* Key to use */
-				     RSA_PKCS1_PADDING);      /* Padding */
+	int rv;
+	if (key->key_location == VB2_PRIVATE_KEY_PKCS11)
+		rv = pkcs11_sign(key->p11_key, signature_digest,
+				 signature_digest_len,
+				 vb2_signature_data_mutable(sig),
+				 sig->sig_size) ? -1 : 0;
+	else
+		rv = RSA_private_encrypt(signature_digest_len,
+					 signature_digest,
+					 vb2_signature_data_mutable(sig),
+					 key->rsa_private_key,
+					 RSA_PKCS1_PADDING);
 	free(signature_digest);
 
 	if (-1 == rv) {
@@ -131,3 +134,39 @@ struct vb2_signature *vb2_calculate_signature(
 	/* Return the signature */
 	return sig;
 }
+
+struct vb2_signature *vb2_calculate_signature(
+		const uint8_t *data, uint32_t size,
+		const struct vb2_private_key *key)
+{
+	uint8_t digest[VB2_MAX_DIGEST_SIZE];
+	uint32_t digest_size = vb2_digest_size(key->hash_alg);
+
+	/* Calculate the digest */
+	if (VB2_SUCCESS != vb2_digest_buffer(data, size, key->hash_alg,
+					     digest, digest_size))
+		return NULL;
+
+	return sign_digest(digest, size, key);
+}
+
+struct vb2_signature *vb2_calculate_tree_signature(
+		const uint8_t *data, uint32_t size, uint32_t chunk_size,
+		const struct vb2_private_key *key)
+{
+	uint8_t workbuf[VB2_TREE_DIGEST_WORKBUF_BYTES]
+		__attribute__((aligned(VB2_WORKBUF_ALIGN)));
+	struct vb2_workbuf wb;
+	uint8_t digest[VB2_MAX_DIGEST_SIZE];
+	uint32_t digest_size = vb2_digest_size(key->hash_alg);
+
+	vb2_workbuf_init(&wb, workbuf, sizeof(workbuf));
+
+	/* Calculate the tree digest */
+	if (VB2_SUCCESS != vb2_tree_digest(data, size, chunk_size,
+					   key->hash_alg, 1, digest,
+					   digest_size, &wb))
+		return NULL;
+
+	return sign_digest(digest, size, key);
+}
@@ -10,3 +10,49 @@
 
 vb2_error_t cbfstool_truncate(const char *file, const char *region,
 			      size_t *new_size);
+
+/*
+ * Native access to a CBFS held in memory, for example an FMAP region of a
+ * firmware image.  These handle uncompressed files only, and don't need the
+ * cbfstool program.
+ */
+
+/**
+ * Find a file in a CBFS region.
+ *
+ * @param region	CBFS region contents
+ * @param region_size	Size of the region in bytes
+ * @param name		File name to look for
+ * @param data_offset	Returns the offset of the file data in the region
+ * @param data_size	Returns the size of the file data
+ * @return VB2_SUCCESS, or non-zero error code if error (for example
+ * VB2_ERROR_CBFS_COMPRESSED if the data can't be used as it is).
+ */
+vb2_error_t cbfs_region_find(const uint8_t *region, size_t region_size,
+			     const char *name, size_t *data_offset,
+			     size_t *data_size);
+
+/**
+ * Remove a file from a CBFS region, like "cbfstool remove".  The space is
+ * merged with any empty neighbours and erased to 0xff.
+ *
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t cbfs_region_remove(uint8_t *region, size_t region_size,
+			       const char *name);
+
+/**
+ * Add a raw file with its data at a fixed offset, like
+ * "cbfstool add -t raw -b <data_offset>".  The space must be empty.
+ *
+ * @param region	CBFS region contents
+ * @param region_size	Size of the region in bytes
+ * @param name		File name
+ * @param data		File data
+ * @param data_size	Size of the file data
+ * @param data_offset	Offset in the region where the data must start
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t cbfs_region_add_raw(uint8_t *region, size_t region_size,
+				const char *name, const void *data,
+				size_t data_size, size_t data_offset);
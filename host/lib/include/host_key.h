@@ -59,6 +59,17 @@ vb2_error_t vb2_write_private_key(const char *filename,
 				  const struct vb2_private_key *key);
 
 
+/**
+ * Unpack a private key from a buffer holding .vbprivk file contents.
+ *
+ * @param buf		Buffer containing the key file contents
+ * @param bufsize	Size of buffer in bytes
+ *
+ * @return The private key or NULL if error.  Caller must free() it.
+ */
+struct vb2_private_key *vb2_unpack_private_key(const uint8_t *buf,
+					       uint32_t bufsize);
+
 /**
  * Read a private key from a .vbprivk file.
  *
@@ -68,6 +79,18 @@ vb2_error_t vb2_write_private_key(const char *filename,
  */
 struct vb2_private_key *vb2_read_private_key(const char *filename);
 
+/**
+ * Look up a private key held in a PKCS#11 token.
+ *
+ * @param name		Key name, "pkcs11:<module>:<slot>:<label>[:<hash>]",
+ *			where hash defaults to SHA256.  vb2_read_private_key()
+ *			also accepts such names.
+ *
+ * @return The private key or NULL if error.  Caller must free it with
+ * vb2_free_private_key().
+ */
+struct vb2_private_key *vb2_read_private_key_pkcs11(const char *name);
+
 /**
  * Allocate a new public key.
  * @param key_size	Size of key data the key can hold
@@ -0,0 +1,143 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Host-side cache of parsed private keys.
+ *
+ * Parsing a private key (reading the file, DER/PEM decoding, and having
+ * OpenSSL set up its Montgomery/CRT and blinding state on the first
+ * signature) costs far more than a single signature.  The keyring keeps each
+ * parsed key for the lifetime of the process, so tools that sign repeatedly
+ * with the same key only pay that cost once.
+ *
+ * Keys are looked up by file path first.  A path hit is only trusted if the
+ * file still has the same inode, size and modification time; otherwise the
+ * file is re-read and looked up by the SHA-256 of its contents, so the same
+ * key reached through a different path (or a copy) is not parsed twice.
+ *
+ * Keys returned by the keyring are owned by it.  Callers must not free them
+ * or modify them.  The keyring is not thread-safe.
+ */
+
+#ifndef VBOOT_REFERENCE_HOST_KEYRING_H_
+#define VBOOT_REFERENCE_HOST_KEYRING_H_
+
+#include "2crypto.h"
+#include "2return_codes.h"
+#include "2sha.h"
+
+struct vb2_private_key;
+
+/* Private key file formats understood by the keyring */
+enum vb2_keyring_format {
+	/* .vbprivk (vb1 packed private key) */
+	VB2_KEYRING_VBPRIVK = 0,
+	/* .pem; algorithm is supplied by the caller */
+	VB2_KEYRING_PEM,
+	/* .vbprik2 (vb21 packed private key) */
+	VB2_KEYRING_VB21,
+};
+
+/* Keyring usage counters, for tests and benchmarks */
+struct vb2_keyring_stats {
+	uint32_t path_hits;	/* Found by path, file unchanged */
+	uint32_t content_hits;	/* Found by content hash */
+	uint32_t loads;		/* Parsed a new key */
+};
+
+/**
+ * Get a private key from a buffer holding key file contents.
+ *
+ * If a key with the same contents (and algorithm, for PEM) is already on the
+ * keyring, returns that key without parsing the buffer again.
+ *
+ * @param buf		Key file contents
+ * @param size		Size of buffer in bytes
+ * @param format	Format of buffer contents
+ * @param algorithm	Algorithm to associate with the key, for
+ *			VB2_KEYRING_PEM (enum vb2_crypto_algorithm); ignored
+ *			for other formats.
+ *
+ * @return The private key or NULL if error.  Owned by the keyring.
+ */
+const struct vb2_private_key *vb2_keyring_load_buffer(
+	const uint8_t *buf, uint32_t size, enum vb2_keyring_format format,
+	enum vb2_crypto_algorithm algorithm);
+
+/**
+ * Get a private key from a file, loading it on first use.
+ *
+ * @param filename	Key file to read
+ * @param format	Format of key file
+ * @param algorithm	Algorithm to associate with the key, for
+ *			VB2_KEYRING_PEM (enum vb2_crypto_algorithm); ignored
+ *			for other formats.
+ *
+ * @return The private key or NULL if error.  Owned by the keyring.
+ */
+const struct vb2_private_key *vb2_keyring_read(
+	const char *filename, enum vb2_keyring_format format,
+	enum vb2_crypto_algorithm algorithm);
+
+/**
+ * Get a private key from a .vbprivk file.  Cached vb2_read_private_key().
+ *
+ * @param filename	Key file to read
+ *
+ * @return The private key or NULL if error.  Owned by the keyring.
+ */
+const struct vb2_private_key *vb2_keyring_read_private_key(
+	const char *filename);
+
+/**
+ * Get a private key from a .pem file.  Cached vb2_read_private_key_pem().
+ *
+ * @param filename	Key file to read
+ * @param algorithm	Algorithm to associate with the key
+ *			(enum vb2_crypto_algorithm)
+ *
+ * @return The private key or NULL if error.  Owned by the keyring.
+ */
+const struct vb2_private_key *vb2_keyring_read_private_key_pem(
+	const char *filename, enum vb2_crypto_algorithm algorithm);
+
+/**
+ * Get a private key from a .vbprik2 file.  Cached vb21_private_key_read().
+ *
+ * @param key_ptr	Destination for key.  Owned by the keyring.
+ * @param filename	Key file to read
+ *
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t vb21_keyring_private_key_read(
+	const struct vb2_private_key **key_ptr, const char *filename);
+
+/**
+ * Look up a key already on the keyring by the hash of its file contents.
+ *
+ * @param digest	SHA-256 digest of the key file contents
+ * @param format	Format the key was loaded as
+ * @param algorithm	Algorithm the key was loaded with, for
+ *			VB2_KEYRING_PEM; ignored for other formats.
+ *
+ * @return The private key, or NULL if not on the keyring.
+ */
+const struct vb2_private_key *vb2_keyring_find(
+	const uint8_t digest[VB2_SHA256_DIGEST_SIZE],
+	enum vb2_keyring_format format, enum vb2_crypto_algorithm algorithm);
+
+/**
+ * Get the keyring usage counters.
+ *
+ * @param stats		Destination for counters
+ */
+void vb2_keyring_get_stats(struct vb2_keyring_stats *stats);
+
+/**
+ * Free all keys on the keyring and reset the usage counters.
+ *
+ * Any key pointers previously returned by the keyring become invalid.
+ */
+void vb2_keyring_clear(void);
+
+#endif  /* VBOOT_REFERENCE_HOST_KEYRING_H_ */
@@ -69,12 +69,30 @@ struct vb2_signature *vb2_sha512_signature(const uint8_t *data, uint32_t size);
 struct vb2_signature *vb2_calculate_signature(
 	const uint8_t *data, uint32_t size, const struct vb2_private_key *key);
 
+/**
+ * Calculate a signature for the tree digest of the data.
+ *
+ * See vb2_tree_digest() for how the digest is calculated.
+ *
+ * @param data		Pointer to data to sign
+ * @param size		Length of data in bytes
+ * @param chunk_size	Size of tree hash chunks in bytes
+ * @param key		Private key to use to sign data
+ *
+ * @return The signature, or NULL if error.  Caller must free() it.
+ */
+struct vb2_signature *vb2_calculate_tree_signature(
+	const uint8_t *data, uint32_t size, uint32_t chunk_size,
+	const struct vb2_private_key *key);
+
 /**
  * Calculate a signature for the data using an external signer.
  *
  * @param data			Pointer to data to sign
  * @param size			Length of data in bytes
- * @param key_file		Name of file containing private key
+ * @param key_file		Name of file containing private key, or name of
+ *				a PKCS#11 key (see vb2_read_private_key_pkcs11())
+ *				to sign with in-process instead
  * @param key_algorithm		Key algorithm
  * @param external_signer	Path to external signer program
  *
@@ -0,0 +1,71 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Private keys held in a PKCS#11 token (for example an HSM), which sign data
+ * without the key ever leaving the token.
+ */
+
+#ifndef VBOOT_REFERENCE_PKCS11_KEY_H_
+#define VBOOT_REFERENCE_PKCS11_KEY_H_
+
+#include "2crypto.h"
+#include "2return_codes.h"
+#include "2sysincludes.h"
+
+/* Private key names starting with this are looked up in a PKCS#11 token. */
+#define PKCS11_KEY_PREFIX "pkcs11:"
+
+/* Environment variable holding the PIN to log in to tokens with. */
+#define PKCS11_PIN_ENV "VBOOT_PKCS11_PIN"
+
+struct pkcs11_key;
+
+/**
+ * Find a private key in a PKCS#11 token.
+ *
+ * The module is loaded, and a session on the slot opened and logged in with
+ * the PIN from $VBOOT_PKCS11_PIN (if set), only the first time a key is looked
+ * up.  Later keys on the same slot share that session, which is kept until the
+ * process exits.  The functions here may be called from several threads; they
+ * take turns using the shared modules and sessions.
+ *
+ * @param key_ptr	Destination for newly allocated key; this must be
+ *			freed with pkcs11_free_key().
+ * @param lib_path	Path to the PKCS#11 module
+ * @param slot_id	Slot of the token holding the key
+ * @param label		Label (CKA_LABEL) of the private key
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t pkcs11_get_key(struct pkcs11_key **key_ptr, const char *lib_path,
+			   unsigned long slot_id, const char *label);
+
+/**
+ * Get the signature algorithm of a key, from its modulus and exponent.
+ *
+ * @param key		Key to check
+ * @return The signature algorithm, or VB2_SIG_INVALID if not supported.
+ */
+enum vb2_signature_algorithm pkcs11_get_sig_alg(const struct pkcs11_key *key);
+
+/**
+ * Sign data with PKCS #1 v1.5 padding, like RSA_private_encrypt() does.
+ *
+ * @param key		Key to sign with
+ * @param data		Data to sign; usually a digest info and digest
+ * @param data_size	Size of data in bytes
+ * @param sig		Destination for signature
+ * @param sig_size	Size of signature in bytes
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t pkcs11_sign(const struct pkcs11_key *key, const uint8_t *data,
+			uint32_t data_size, uint8_t *sig, uint32_t sig_size);
+
+/**
+ * Free a key.  This does not close the session it was found in.
+ *
+ * @param key		Key to free
+ */
+void pkcs11_free_key(struct pkcs11_key *key);
+
+#endif  /* VBOOT_REFERENCE_PKCS11_KEY_H_ */
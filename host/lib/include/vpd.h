@@ -0,0 +1,75 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Reader for the VPD 2.0 key/value pairs stored in firmware images.
+ */
+
+#ifndef VBOOT_REFERENCE_VPD_H_
+#define VBOOT_REFERENCE_VPD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "2common.h"
+#include "2return_codes.h"
+
+/* One key/value pair, both NUL-terminated */
+struct vpd_entry {
+	char *key;
+	char *value;
+};
+
+/* All the key/value pairs of a VPD, in the order they are stored */
+struct vpd {
+	struct vpd_entry *entries;
+	size_t num_entries;
+};
+
+/**
+ * Parse the VPD 2.0 data in a buffer.
+ *
+ * The data may start with a gVpdInfo header, or with an SMBIOS entry point
+ * that puts the header at its fixed offset, as the vpd utility writes them.
+ * Without either, the entries start at the beginning of the buffer.  Parsing
+ * stops at a terminator, at erased flash or at the end of the data.
+ *
+ * @param vpd		Filled in with the entries; call vpd_free() when done,
+ *			even if this fails.
+ * @param data		VPD data
+ * @param size		Size of VPD data in bytes
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t vpd_parse(struct vpd *vpd, const uint8_t *data, size_t size);
+
+/**
+ * Parse the VPD 2.0 data in an FMAP section (e.g. RO_VPD) of an image.
+ *
+ * @param vpd		Filled in with the entries; call vpd_free() when done,
+ *			even if this fails.
+ * @param image		Firmware image containing an FMAP
+ * @param size		Size of image in bytes
+ * @param section	Name of the FMAP section holding the VPD
+ * @return VB2_SUCCESS, or non-zero error code if error.
+ */
+vb2_error_t vpd_parse_section(struct vpd *vpd, uint8_t *image, size_t size,
+			      const char *section);
+
+/**
+ * Look up a value.
+ *
+ * @param vpd		Parsed VPD
+ * @param key		Key to look up
+ * @return The value, or NULL if the key is not in the VPD.  The value stays
+ * valid until vpd_free() is called.
+ */
+const char *vpd_get_value(const struct vpd *vpd, const char *key);
+
+/**
+ * Free the entries of a VPD.
+ *
+ * @param vpd		VPD to clear
+ */
+void vpd_free(struct vpd *vpd);
+
+#endif  /* VBOOT_REFERENCE_VPD_H_ */
@@ -0,0 +1,373 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Private keys held in a PKCS#11 token.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "2common.h"
+#include "2rsa.h"
+#include "2sysincludes.h"
+#include "host_common.h"
+#include "pkcs11_key.h"
+
+#ifdef HAVE_NSS
+
+#include <dlfcn.h>
+#include <pkcs11.h>
+#include <pthread.h>
+
+/* A session on a slot, kept open until the process exits. */
+struct pkcs11_session {
+	CK_SLOT_ID slot_id;
+	CK_SESSION_HANDLE handle;
+	struct pkcs11_session *next;
+};
+
+/* A loaded PKCS#11 module, and the sessions opened through it. */
+struct pkcs11_module {
+	char *lib_path;
+	void *handle;
+	CK_FUNCTION_LIST_PTR p11;
+	struct pkcs11_session *sessions;
+	struct pkcs11_module *next;
+};
+
+struct pkcs11_key {
+	struct pkcs11_module *module;
+	CK_SESSION_HANDLE session;
+	CK_OBJECT_HANDLE handle;
+};
+
+static struct pkcs11_module *modules;
+
+/*
+ * The modules and their sessions are shared by the whole process, and a
+ * PKCS#11 session must only be used by one thread at a time, so everything
+ * that touches them holds this lock.
+ */
+static pthread_mutex_t pkcs11_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Closes all sessions and unloads all modules; registered with atexit(). */
+static void pkcs11_unload_modules(void)
+{
+	struct pkcs11_module *m;
+	struct pkcs11_session *s;
+
+	while ((m = modules)) {
+		modules = m->next;
+		while ((s = m->sessions)) {
+			m->sessions = s->next;
+			m->p11->C_CloseSession(s->handle);
+			free(s);
+		}
+		m->p11->C_Finalize(NULL);
+		dlclose(m->handle);
+		free(m->lib_path);
+		free(m);
+	}
+}
+
+static struct pkcs11_module *pkcs11_load_module(const char *lib_path)
+{
+	static int registered;
+	struct pkcs11_module *m;
+	CK_C_GetFunctionList get_function_list;
+	CK_RV rv;
+
+	for (m = modules; m; m = m->next) {
+		if (!strcmp(m->lib_path, lib_path))
+			return m;
+	}
+
+	m = calloc(1, sizeof(*m));
+	if (!m)
+		return NULL;
+
+	m->handle = dlopen(lib_path, RTLD_NOW | RTLD_LOCAL);
+	if (!m->handle) {
+		fprintf(stderr, "Unable to load PKCS#11 module %s: %s\n",
+			lib_path, dlerror());
+		free(m);
+		return NULL;
+	}
+
+	get_function_list = (CK_C_GetFunctionList)dlsym(m->handle,
+							"C_GetFunctionList");
+	if (!get_function_list ||
+	    get_function_list(&m->p11) != CKR_OK) {
+		fprintf(stderr, "%s is not a PKCS#11 module\n", lib_path);
+		dlclose(m->handle);
+		free(m);
+		return NULL;
+	}
+
+	rv = m->p11->C_Initialize(NULL);
+	if (rv != CKR_OK && rv != CKR_CRYPTOKI_ALREADY_INITIALIZED) {
+		fprintf(stderr, "C_Initialize() of %s failed: %#lx\n",
+			lib_path, (unsigned long)rv);
+		dlclose(m->handle);
+		free(m);
+		return NULL;
+	}
+
+	m->lib_path = strdup(lib_path);
+	if (!m->lib_path) {
+		m->p11->C_Finalize(NULL);
+		dlclose(m->handle);
+		free(m);
+		return NULL;
+	}
+
+	if (!registered) {
+		atexit(pkcs11_unload_modules);
+		registered = 1;
+	}
+	m->next = modules;
+	modules = m;
+	return m;
+}
+
+static struct pkcs11_session *pkcs11_open_session(struct pkcs11_module *m,
+						  CK_SLOT_ID slot_id)
+{
+	struct pkcs11_session *s;
+	const char *pin;
+	CK_RV rv;
+
+	for (s = m->sessions; s; s = s->next) {
+		if (s->slot_id == slot_id)
+			return s;
+	}
+
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return NULL;
+
+	rv = m->p11->C_OpenSession(slot_id, CKF_SERIAL_SESSION, NULL, NULL,
+				   &s->handle);
+	if (rv != CKR_OK) {
+		fprintf(stderr, "C_OpenSession() on slot %lu failed: %#lx\n",
+			(unsigned long)slot_id, (unsigned long)rv);
+		free(s);
+		return NULL;
+	}
+
+	pin = getenv(PKCS11_PIN_ENV);
+	if (pin) {
+		rv = m->p11->C_Login(s->handle, CKU_USER, (CK_UTF8CHAR_PTR)pin,
+				     strlen(pin));
+		if (rv != CKR_OK && rv != CKR_USER_ALREADY_LOGGED_IN) {
+			fprintf(stderr, "C_Login() on slot %lu failed: %#lx\n",
+				(unsigned long)slot_id, (unsigned long)rv);
+			m->p11->C_CloseSession(s->handle);
+			free(s);
+			return NULL;
+		}
+	}
+
+	s->slot_id = slot_id;
+	s->next = m->sessions;
+	m->sessions = s;
+	return s;
+}
+
+static vb2_error_t pkcs11_find_key(struct pkcs11_key **key_ptr,
+				   const char *lib_path, unsigned long slot_id,
+				   const char *label)
+{
+	struct pkcs11_module *m;
+	struct pkcs11_session *s;
+	struct pkcs11_key *key;
+	CK_OBJECT_CLASS class = CKO_PRIVATE_KEY;
+	CK_KEY_TYPE key_type = CKK_RSA;
+	CK_ATTRIBUTE template[] = {
+		{CKA_CLASS, &class, sizeof(class)},
+		{CKA_KEY_TYPE, &key_type, sizeof(key_type)},
+		{CKA_LABEL, (CK_VOID_PTR)label, strlen(label)},
+	};
+	CK_OBJECT_HANDLE handle;
+	CK_ULONG count = 0;
+	CK_RV rv;
+
+	*key_ptr = NULL;
+
+	m = pkcs11_load_module(lib_path);
+	if (!m)
+		return VB2_ERROR_PKCS11_LOAD;
+
+	s = pkcs11_open_session(m, slot_id);
+	if (!s)
+		return VB2_ERROR_PKCS11_SESSION;
+
+	rv = m->p11->C_FindObjectsInit(s->handle, template,
+				       ARRAY_SIZE(template));
+	if (rv == CKR_OK) {
+		rv = m->p11->C_FindObjects(s->handle, &handle, 1, &count);
+		m->p11->C_FindObjectsFinal(s->handle);
+	}
+	if (rv != CKR_OK || count != 1) {
+		fprintf(stderr, "Unable to find private key '%s' on slot %lu\n",
+			label, slot_id);
+		return VB2_ERROR_PKCS11_FIND_KEY;
+	}
+
+	key = calloc(1, sizeof(*key));
+	if (!key)
+		return VB2_ERROR_PKCS11_FIND_KEY;
+	key->module = m;
+	key->session = s->handle;
+	key->handle = handle;
+
+	*key_ptr = key;
+	return VB2_SUCCESS;
+}
+
+vb2_error_t pkcs11_get_key(struct pkcs11_key **key_ptr, const char *lib_path,
+			   unsigned long slot_id, const char *label)
+{
+	vb2_error_t rv;
+
+	pthread_mutex_lock(&pkcs11_lock);
+	rv = pkcs11_find_key(key_ptr, lib_path, slot_id, label);
+	pthread_mutex_unlock(&pkcs11_lock);
+	return rv;
+}
+
+/* Reads a big-endian attribute of key into a newly allocated buffer. */
+static uint8_t *pkcs11_get_attribute(const struct pkcs11_key *key,
+				     CK_ATTRIBUTE_TYPE type, CK_ULONG *size)
+{
+	CK_FUNCTION_LIST_PTR p11 = key->module->p11;
+	CK_ATTRIBUTE attr = {type, NULL, 0};
+	uint8_t *value;
+
+	if (p11->C_GetAttributeValue(key->session, key->handle, &attr, 1) !=
+	    CKR_OK || attr.ulValueLen == (CK_ULONG)-1)
+		return NULL;
+
+	value = malloc(attr.ulValueLen);
+	if (!value)
+		return NULL;
+	attr.pValue = value;
+	if (p11->C_GetAttributeValue(key->session, key->handle, &attr, 1) !=
+	    CKR_OK) {
+		free(value);
+		return NULL;
+	}
+
+	/* Skip leading zeros */
+	*size = attr.ulValueLen;
+	while (*size && !value[attr.ulValueLen - *size])
+		(*size)--;
+	memmove(value, value + attr.ulValueLen - *size, *size);
+	return value;
+}
+
+enum vb2_signature_algorithm pkcs11_get_sig_alg(const struct pkcs11_key *key)
+{
+	uint8_t *modulus, *exponent;
+	CK_ULONG modulus_size = 0, exponent_size = 0, i;
+	uint64_t exp = 0;
+	uint32_t bits;
+
+	pthread_mutex_lock(&pkcs11_lock);
+	modulus = pkcs11_get_attribute(key, CKA_MODULUS, &modulus_size);
+	exponent = pkcs11_get_attribute(key, CKA_PUBLIC_EXPONENT,
+					&exponent_size);
+	pthread_mutex_unlock(&pkcs11_lock);
+	if (!modulus || !exponent || exponent_size > sizeof(exp)) {
+		free(modulus);
+		free(exponent);
+		return VB2_SIG_INVALID;
+	}
+
+	for (i = 0; i < exponent_size; i++)
+		exp = (exp << 8) | exponent[i];
+	bits = modulus_size * 8;
+	free(modulus);
+	free(exponent);
+
+	/* Same as vb2_rsa_sig_alg() does for local keys */
+	switch (exp) {
+	case 3:
+		switch (bits) {
+		case 2048:
+			return VB2_SIG_RSA2048_EXP3;
+		case 3072:
+			return VB2_SIG_RSA3072_EXP3;
+		}
+		break;
+	case 65537:
+		switch (bits) {
+		case 1024:
+			return VB2_SIG_RSA1024;
+		case 2048:
+			return VB2_SIG_RSA2048;
+		case 4096:
+			return VB2_SIG_RSA4096;
+		case 8192:
+			return VB2_SIG_RSA8192;
+		}
+	}
+
+	return VB2_SIG_INVALID;
+}
+
+vb2_error_t pkcs11_sign(const struct pkcs11_key *key, const uint8_t *data,
+			uint32_t data_size, uint8_t *sig, uint32_t sig_size)
+{
+	CK_FUNCTION_LIST_PTR p11 = key->module->p11;
+	CK_MECHANISM mechanism = {CKM_RSA_PKCS, NULL, 0};
+	CK_ULONG size = sig_size;
+	CK_RV rv;
+
+	pthread_mutex_lock(&pkcs11_lock);
+	rv = p11->C_SignInit(key->session, &mechanism, key->handle);
+	if (rv == CKR_OK)
+		rv = p11->C_Sign(key->session, (CK_BYTE_PTR)data, data_size,
+				 sig, &size);
+	pthread_mutex_unlock(&pkcs11_lock);
+	if (rv != CKR_OK || size != sig_size) {
+		fprintf(stderr, "C_Sign() failed: %#lx\n", (unsigned long)rv);
+		return VB2_ERROR_PKCS11_SIGN;
+	}
+
+	return VB2_SUCCESS;
+}
+
+void pkcs11_free_key(struct pkcs11_key *key)
+{
+	free(key);
+}
+
+#else  /* HAVE_NSS */
+
+vb2_error_t pkcs11_get_key(struct pkcs11_key **key_ptr, const char *lib_path,
+			   unsigned long slot_id, const char *label)
+{
+	fprintf(stderr, "Built without PKCS#11 support\n");
+	*key_ptr = NULL;
+	return VB2_ERROR_PKCS11_UNSUPPORTED;
+}
+
+enum vb2_signature_algorithm pkcs11_get_sig_alg(const struct pkcs11_key *key)
+{
+	return VB2_SIG_INVALID;
+}
+
+vb2_error_t pkcs11_sign(const struct pkcs11_key *key, const uint8_t *data,
+			uint32_t data_size, uint8_t *sig, uint32_t sig_size)
+{
+	return VB2_ERROR_PKCS11_UNSUPPORTED;
+}
+
+void pkcs11_free_key(struct pkcs11_key *key)
+{
+}
+
+#endif  /* HAVE_NSS */
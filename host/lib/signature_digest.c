@@ -3,7 +3,7 @@
  * found in the LICENSE file.
  */
 
-#include <openssl/pem.h>
+#include <openssl/rsa.h>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -14,6 +14,7 @@
 #include "2sha.h"
 #include "2sysincludes.h"
 #include "host_common.h"
+#include "host_keyring.h"
 #include "host_signature21.h"
 #include "signature_digest.h"
 
@@ -60,8 +61,7 @@ uint8_t* SignatureBuf(const uint8_t* buf, uint64_t len, const char* key_file,
 		      unsigned int algorithm)
 {
 	const enum vb2_hash_algorithm hash_alg = vb2_crypto_to_hash(algorithm);
-	FILE* key_fp = NULL;
-	RSA* key = NULL;
+	const struct vb2_private_key *key = NULL;
 	uint8_t* signature = NULL;
 	uint8_t* signature_digest = SignatureDigest(buf, len, algorithm);
 	if (!signature_digest) {
@@ -83,14 +83,9 @@ uint8_t* SignatureBuf(const uint8_t* buf, uint64_t len, const char* key_file,
 
 	int signature_digest_len = digest_size + digestinfo_size;
 
-	key_fp  = fopen(key_file, "r");
-	if (!key_fp) {
-		fprintf(stderr, "SignatureBuf(): Couldn't open key file: %s\n",
-			key_file);
-		free(signature_digest);
-		return NULL;
-	}
-	if ((key = PEM_read_RSAPrivateKey(key_fp, NULL, NULL, NULL)))
+	/* Parsed keys are kept on the keyring, so repeated signs are cheap */
+	key = vb2_keyring_read_private_key_pem(key_file, algorithm);
+	if (key)
 		signature = (uint8_t *)malloc(
 		    vb2_rsa_sig_size(vb2_crypto_to_signature(algorithm)));
 	else
@@ -101,14 +96,11 @@ uint8_t* SignatureBuf(const uint8_t* buf, uint64_t len, const char* key_file,
 				signature_digest_len,  /* Input length. */
 				signature_digest,  /* Input data. */
 				signature,  /* Output signature. */
-				key,  /* Key to use. */
+				key->rsa_private_key,  /* Key to use. */
 				RSA_PKCS1_PADDING))  /* Padding to use. */
 			fprintf(stderr, "SignatureBuf(): "
 				"RSA_private_encrypt() failed.\n");
 	}
-	fclose(key_fp);
-	if (key)
-		RSA_free(key);
 	free(signature_digest);
 	return signature;
 }
@@ -0,0 +1,197 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Reader for the VPD 2.0 key/value pairs stored in firmware images.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "2common.h"
+#include "2return_codes.h"
+#include "fmap.h"
+#include "vpd.h"
+
+/* Entry types */
+#define VPD_TYPE_TERMINATOR		0x00
+#define VPD_TYPE_STRING			0x01
+#define VPD_TYPE_INFO			0xfe
+#define VPD_TYPE_IMPLICIT_TERMINATOR	0xff
+
+/*
+ * The gVpdInfo header is itself an info entry whose 4-byte value is the size
+ * of the entries following it.
+ */
+#define VPD_INFO_MAGIC "\xfe\x09\x01gVpdInfo\x04"
+#define VPD_INFO_MAGIC_SIZE 12
+#define VPD_INFO_SIZE (VPD_INFO_MAGIC_SIZE + 4)
+
+/* Legacy layout: an SMBIOS entry point, with the header at a fixed offset */
+#define VPD_SMBIOS_SIGNATURE "_SM_"
+#define VPD_SMBIOS_SIGNATURE_SIZE 4
+#define VPD_SMBIOS_INFO_OFFSET 0x600
+
+/* Longest length encoding that fits in 32 bits */
+#define VPD_MAX_LEN_BYTES 5
+
+/*
+ * Decode a length stored 7 bits per byte, most significant first, with the
+ * top bit set on all but the last byte.  Returns the number of bytes used, or
+ * 0 if the encoding runs past the end of the data or is too long.
+ */
+static size_t decode_len(const uint8_t *p, size_t avail, uint32_t *len)
+{
+	uint32_t value = 0;
+	size_t i;
+
+	for (i = 0; i < avail && i < VPD_MAX_LEN_BYTES; i++) {
+		value = (value << 7) | (p[i] & 0x7f);
+		if (!(p[i] & 0x80)) {
+			*len = value;
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Read one length-prefixed string.  On success, points *str_ptr at it, stores
+ * its size and advances *pos past it.
+ */
+static vb2_error_t read_string(const uint8_t *data, size_t end, size_t *pos,
+			       const uint8_t **str_ptr, uint32_t *size_ptr)
+{
+	size_t used = decode_len(data + *pos, end - *pos, size_ptr);
+
+	if (!used || *size_ptr > end - *pos - used)
+		return VB2_ERROR_VPD_TRUNCATED;
+	*str_ptr = data + *pos + used;
+	*pos += used + *size_ptr;
+	return VB2_SUCCESS;
+}
+
+static vb2_error_t add_entry(struct vpd *vpd,
+			     const uint8_t *key, uint32_t key_size,
+			     const uint8_t *value, uint32_t value_size)
+{
+	struct vpd_entry *entries;
+	struct vpd_entry *e;
+
+	entries = realloc(vpd->entries,
+			  (vpd->num_entries + 1) * sizeof(*entries));
+	if (!entries)
+		return VB2_ERROR_VPD_ALLOC;
+	vpd->entries = entries;
+
+	e = &entries[vpd->num_entries];
+	e->key = strndup((const char *)key, key_size);
+	e->value = strndup((const char *)value, value_size);
+	if (!e->key || !e->value) {
+		free(e->key);
+		free(e->value);
+		return VB2_ERROR_VPD_ALLOC;
+	}
+	vpd->num_entries++;
+	return VB2_SUCCESS;
+}
+
+vb2_error_t vpd_parse(struct vpd *vpd, const uint8_t *data, size_t size)
+{
+	size_t pos = 0, end = size;
+	vb2_error_t rv;
+
+	vpd->entries = NULL;
+	vpd->num_entries = 0;
+
+	if (size >= VPD_SMBIOS_INFO_OFFSET &&
+	    !memcmp(data, VPD_SMBIOS_SIGNATURE, VPD_SMBIOS_SIGNATURE_SIZE))
+		pos = VPD_SMBIOS_INFO_OFFSET;
+
+	if (end - pos >= VPD_INFO_SIZE &&
+	    !memcmp(data + pos, VPD_INFO_MAGIC, VPD_INFO_MAGIC_SIZE)) {
+		const uint8_t *p = data + pos + VPD_INFO_MAGIC_SIZE;
+		uint32_t info_size = p[0] | p[1] << 8 | p[2] << 16 |
+			(uint32_t)p[3] << 24;
+
+		pos += VPD_INFO_SIZE;
+		if (info_size > end - pos) {
+			VB2_DEBUG("gVpdInfo size %#x too big\n", info_size);
+			return VB2_ERROR_VPD_INFO_SIZE;
+		}
+		end = pos + info_size;
+	}
+
+	while (pos < end) {
+		const uint8_t *key, *value;
+		uint32_t key_size, value_size;
+		uint8_t type = data[pos++];
+
+		if (type == VPD_TYPE_TERMINATOR ||
+		    type == VPD_TYPE_IMPLICIT_TERMINATOR)
+			break;
+		if (type != VPD_TYPE_STRING && type != VPD_TYPE_INFO) {
+			VB2_DEBUG("Unknown VPD entry type %#x at %#zx\n",
+				  type, pos - 1);
+			return VB2_ERROR_VPD_TYPE;
+		}
+
+		rv = read_string(data, end, &pos, &key, &key_size);
+		if (!rv)
+			rv = read_string(data, end, &pos, &value, &value_size);
+		if (rv) {
+			VB2_DEBUG("VPD entry truncated at %#zx\n", pos);
+			return rv;
+		}
+
+		if (type == VPD_TYPE_STRING) {
+			rv = add_entry(vpd, key, key_size, value, value_size);
+			if (rv)
+				return rv;
+		}
+	}
+
+	return VB2_SUCCESS;
+}
+
+vb2_error_t vpd_parse_section(struct vpd *vpd, uint8_t *image, size_t size,
+			      const char *section)
+{
+	FmapAreaHeader *ah;
+	uint8_t *data;
+
+	vpd->entries = NULL;
+	vpd->num_entries = 0;
+
+	data = fmap_find_by_name(image, size, NULL, section, &ah);
+	if (!data || ah->area_offset > size ||
+	    ah->area_size > size - ah->area_offset) {
+		VB2_DEBUG("No %s section in image\n", section);
+		return VB2_ERROR_VPD_SECTION;
+	}
+	return vpd_parse(vpd, data, ah->area_size);
+}
+
+const char *vpd_get_value(const struct vpd *vpd, const char *key)
+{
+	size_t i;
+
+	for (i = 0; i < vpd->num_entries; i++) {
+		if (!strcmp(vpd->entries[i].key, key))
+			return vpd->entries[i].value;
+	}
+	return NULL;
+}
+
+void vpd_free(struct vpd *vpd)
+{
+	size_t i;
+
+	for (i = 0; i < vpd->num_entries; i++) {
+		free(vpd->entries[i].key);
+		free(vpd->entries[i].value);
+	}
+	free(vpd->entries);
+	vpd->entries = NULL;
+	vpd->num_entries = 0;
+}
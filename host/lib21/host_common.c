@@ -164,6 +164,13 @@ const struct vb2_id *vb2_hash_id(enum vb2_hash_algorithm hash_alg)
 			static const struct vb2_id id = VB2_ID_NONE_SHA512;
 			return &id;
 		}
+#endif
+#if VB2_SUPPORT_BLAKE3
+	case VB2_HASH_BLAKE3:
+		{
+			static const struct vb2_id id = VB2_ID_NONE_BLAKE3;
+			return &id;
+		}
 #endif
 	default:
 		return NULL;
@@ -18,6 +18,7 @@
 #include "host_key21.h"
 #include "host_misc.h"
 #include "openssl_compat.h"
+#include "pkcs11_key.h"
 
 void vb2_private_key_free(struct vb2_private_key *key)
 {
@@ -27,6 +28,9 @@ void vb2_private_key_free(struct vb2_private_key *key)
 	if (key->rsa_private_key)
 		RSA_free(key->rsa_private_key);
 
+	if (key->p11_key)
+		pkcs11_free_key(key->p11_key);
+
 	if (key->desc)
 		free(key->desc);
 
@@ -277,6 +281,19 @@ vb2_error_t vb2_private_key_hash(const struct vb2_private_key **key_ptr,
 			*key_ptr = &key;
 			return VB2_SUCCESS;
 		}
+#endif
+#if VB2_SUPPORT_BLAKE3
+	case VB2_HASH_BLAKE3:
+		{
+			static const struct vb2_private_key key = {
+				.hash_alg = VB2_HASH_BLAKE3,
+				.sig_alg = VB2_SIG_NONE,
+				.desc = (char *)"Unsigned BLAKE3",
+				.id = VB2_ID_NONE_BLAKE3,
+			};
+			*key_ptr = &key;
+			return VB2_SUCCESS;
+		}
 #endif
 	default:
 		return VB2_ERROR_PRIVATE_KEY_HASH;
@@ -485,6 +502,11 @@ vb2_error_t vb2_public_key_hash(struct vb2_public_key *key,
 	case VB2_HASH_SHA512:
 		key->desc = "Unsigned SHA-512";
 		break;
+#endif
+#if VB2_SUPPORT_BLAKE3
+	case VB2_HASH_BLAKE3:
+		key->desc = "Unsigned BLAKE3";
+		break;
 #endif
 	default:
 		return VB2_ERROR_PUBLIC_KEY_HASH;
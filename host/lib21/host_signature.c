@@ -16,6 +16,7 @@
 #include "host_key21.h"
 #include "host_misc.h"
 #include "host_signature21.h"
+#include "pkcs11_key.h"
 
 vb2_error_t vb2_digest_info(enum vb2_hash_algorithm hash_alg,
 			    const uint8_t **buf_ptr, uint32_t *size_ptr)
@@ -151,6 +152,14 @@ vb2_error_t vb21_sign_data(struct vb21_signature **sig_ptr, const uint8_t *data,
 	if (s.sig_alg == VB2_SIG_NONE) {
 		/* Bare hash signature is just the digest */
 		memcpy(buf + s.sig_offset, sig_digest, sig_digest_size);
+	} else if (key->key_location == VB2_PRIVATE_KEY_PKCS11) {
+		/* Sign in the token holding the key */
+		if (pkcs11_sign(key->p11_key, sig_digest, sig_digest_size,
+				buf + s.sig_offset, s.sig_size)) {
+			free(sig_digest);
+			free(buf);
+			return VB2_SIGN_DATA_RSA_ENCRYPT;
+		}
 	} else {
 		/* RSA-encrypt the signature */
 		if (RSA_private_encrypt(sig_digest_size,
@@ -14,10 +14,19 @@
 
 struct vb2_public_key;
 struct vb21_packed_key;
+struct pkcs11_key;
+
+/* Where the private key data is held. */
+enum vb2_private_key_location {
+	VB2_PRIVATE_KEY_LOCAL = 0,		/* In rsa_private_key */
+	VB2_PRIVATE_KEY_PKCS11,			/* In a PKCS#11 token */
+};
 
 /* Private key data, in-memory format for use in signing calls. */
 struct vb2_private_key {
+	enum vb2_private_key_location key_location;
 	struct rsa_st *rsa_private_key;		/* Private key data */
+	struct pkcs11_key *p11_key;		/* PKCS#11 key handle */
 	enum vb2_hash_algorithm hash_alg;	/* Hash algorithm */
 	enum vb2_signature_algorithm sig_alg;	/* Signature algorithm */
 	char *desc;				/* Description */
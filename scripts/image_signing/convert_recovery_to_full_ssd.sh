@@ -44,9 +44,6 @@ unzip -o $IMAGE_ZIP chromiumos_base_image.bin -d ${work_dir}
 mv ${work_dir}/chromiumos_base_image.bin ${SSD_IMAGE}
 
 kerna_offset=$(partoffset ${RECOVERY_IMAGE} 2)
-kernb_offset=$(partoffset ${RECOVERY_IMAGE} 4)
-# Kernel partition sizes should be the same.
-kern_size=$(partsize ${RECOVERY_IMAGE} 2)
 
 rootfs=$(make_temp_file)
 echo "Replacing RootFS on the SSD with that of the RECOVERY image"
@@ -70,6 +67,5 @@ sudo umount ${stateful_dir}
 
 # Zero out Kernel B partition.
 echo "Zeroing out Kernel partition B"
-sudo dd if=/dev/zero of=${SSD_IMAGE} seek=${kernb_offset} bs=512 \
-  count=${kern_size} conv=notrunc
+sudo "${GPT}" zero -i 4 "${SSD_IMAGE}"
 echo "${RECOVERY_IMAGE} was converted to a factory SSD image: ${SSD_IMAGE}"
@@ -65,7 +65,6 @@ sudo dd if="${tmp_vblock}" of="${loop_kerna}" bs=512 conv=notrunc
 
 # Zero out Kernel B partition.
 info "Zeroing out Kernel partition B"
-# This will throw a "disk is full" error, so ignore it.
-sudo cp /dev/zero "${loop_kernb}" 2>/dev/null || :
+sudo "${GPT}" zero -i 4 "${loopdev}"
 
 info "${IMAGE} was converted to an SSD image."
@@ -36,114 +36,6 @@ to_int32() {
            print (struct.unpack('i', d)[0])"
 }
 
-# Functions allowing to determine the base address of a binary blob in ihex
-# format. Invoked in a subprocess through () to be able to use stdout as the
-# return values.
-
-# In ihex format binary data is represented as a set of records. Each record
-# is a text string of hex values in ASCII. All records start with a header
-# which determines the record contents.
-#
-# The most common record type is the data record, its header includes the 16
-# bit address of where the record data will have to be placed in the physical
-# address space. Naturally 16 bits is not enough as of last thirty years, some
-# special types of record are used to specify the segment base of there the
-# 16 bit address is used as the offset.
-#
-# The segment base is still represented as a 16 bit value, depending on the
-# record type the base is shifted right ether 4 (record type 02) or 16 (record
-# type 04) bits.
-#
-# The first two records of the ihex binary blob are a segment record and a
-# data record. Combining the segment value from the first record and the
-# address value from the second record one can determine the base address
-# where the blob is supposed to be placed.
-#
-# See https://en.wikipedia.org/wiki/Intel_HEX for further details.
-parse_segment() {
-  local string="$1"
-
-  if [[ "${string}" =~ ^:020000 && "${#string}" -eq 15 ]]; then
-    local type="${string:7:2}"
-    local value="0x${string:9:4}"
-    local segment
-
-    case "${type}" in
-      (02)
-        segment=$(( value << 4 ))
-        ;;
-      (04)
-        segment=$(( value << 16 ))
-        ;;
-      (*)
-        error "unknown segment record type ${type}"
-        ;;
-    esac
-    printf "0x%x" "${segment}"
-  else
-    error "unexpected segment record: ${string}"
-  fi
-}
-
-# The second record in the ihex binary blob is mapped to the lowest 16 bit
-# address in the segment.
-parse_data() {
-  local string="$1"
-
-  if [[ "${string}" =~ ^:10 && "${#string}" -eq 43 ]]; then
-    echo "0x${string:3:4}"
-  else
-    error "unexpected data record: ${string}"
-  fi
-}
-
-# Given an ihex binary blob determine its base address as a sum of the segment
-# address and the offset of the first record into the segment.
-get_hex_base() {
-  local hexf="$1"
-  local strings
-  local segment
-  local base_offset
-
-  # Some ihex blobs include <cr><lf>, drop <cr> to allow for fixed size check.
-  mapfile -t strings < <(head -2 "${hexf}" | sed 's/\x0d//')
-
-  if [[ ${#strings[@]} != 2 ]]; then
-    error "input file ${hexf} too short"
-    return
-  fi
-  segment="$(parse_segment "${strings[0]}")"
-  base_offset="$(parse_data "${strings[1]}")"
-
-  if [[ -n "${segment}" && -n "${base_offset}" ]]; then
-    printf "%d\n" $(( segment + base_offset ))
-  else
-    error "${hexf} does not seem to be a valid ihex module."
-  fi
-}
-
-# Paste a binary blob into a larger binary file at a given offset.
-paste_bin() {
-  local file="${1}"
-  local blob="${2}"
-  local image_base="${3}"
-  local hex_base="${4}"
-  local file_size
-  local blob_size
-  local offset
-
-
-  file_size="$(stat -c '%s' "${file}")"
-  blob_size="$(stat -c '%s' "${blob}")"
-  offset="$(( hex_base - image_base ))"
-
-  if [[ $(( blob_size + offset )) -ge ${file_size} ]];then
-    die \
-      "Can't fit ${blob_size} bytes at offset ${offset} into ${file_size} bytes"
-  fi
-  dd if="${blob}" of="${file}" seek="${offset}" bs=1 conv=notrunc
-}
-
 # This function accepts one argument, the name of the GSC manifest file which
 # needs to be verified and in certain cases altered.
 #
@@ -255,12 +147,11 @@ verify_and_prepare_gsc_manifest() {
       "board_id_flags = '${bid_flags}' target = '${INSN_TARGET}'"
 }
 
-# This function accepts two arguments, names of two binary files.
+# This function accepts two arguments, names of two files.
 #
 # It searches the first passed-in file for the first 8 bytes of the second
-# passed in file. The od utility is used to generate full hex dump of the
-# first file (16 bytes per line) and the first 8 bytes of the second file.
-# grep is used to check if the pattern is present in the full dump.
+# passed in file. If the first file is in ihex format, it is searched after
+# conversion to binary.
 find_blob_in_blob() {
   if [[ $# -ne 2 ]]; then
     die "Usage: find_blob_in_blob <haystack> <needle>"
@@ -268,21 +159,8 @@ find_blob_in_blob() {
 
   local main_blob="$1"
   local pattern_blob="$2"
-  local pattern
-  # Show without offsets, single byte hex, no compression of zero runs.
-  local od_options=("-An" "-tx1" "-v")
 
-  # Get the first 8 bytes of the pattern blob.
-  pattern="$(od "${od_options[@]}" -N8 "${pattern_blob}")"
-
-  # Eliminate all newlines to be able to search the entire body as one unit.
-  if od "${od_options[@]}" "${main_blob}" | \
-     tr -d '\n' |
-     grep -q -F "${pattern}"; then
-    return 0
-  fi
-
-  return 1
+  ${FUTILITY} gsc_image --contains "${pattern_blob}" "${main_blob}"
 }
 
 # This function accepts two arguments, names of the two ELF files.
@@ -327,12 +205,13 @@ determine_rma_key_base() {
   echo "${base_name}.${curve}"
 }
 
-# Sign GSC RW firmware ELF images into a combined GSC firmware image
-# using the provided production keys and manifests.
+# Sign GSC RW firmware ELF images using the provided production keys and
+# manifests. The signed images are saved in ihex format in <output_dir> as
+# rw_0.hex and rw_1.hex.
 sign_rw() {
-  if [[ $# -ne 9 ]]; then
+  if [[ $# -ne 8 ]]; then
     die "Usage: sign_rw <key_file> <manifest> <fuses>" \
-        "<rma_key_dir> <rw_a> <rw_b> <output> <generation> <image_base>"
+        "<rma_key_dir> <rw_a> <rw_b> <output_dir> <generation>"
   fi
 
   local key_file="$1"
@@ -340,15 +219,13 @@ sign_rw() {
   local fuses_file="$3"
   local rma_key_dir="$4"
   local rws=( "$5" "$6" )
-  local result_file="$7"
+  local output_dir="$7"
   local generation="$8"
-  local image_base="$9"
   local base_name
   local rma_key_base=""
   local signer_command_params
-  local temp_dir
+  local i=0
 
-  temp_dir="$(make_temp_dir)"
   signer_command_params=(-x "${fuses_file}" --key "${key_file}")
 
   case "${generation}"  in
@@ -396,34 +273,25 @@ sign_rw() {
   fi
 
   for rw in "${rws[@]}"; do
-    local hex_signed="${temp_dir}/hex_signed"
-    local bin_signed="${temp_dir}/bin_signed"
-    local hex_base
+    local hex_signed="${output_dir}/rw_$(( i++ )).hex"
 
     # Make sure output files are not owned by root.
-    touch "${bin_signed}" "${hex_signed}"
+    touch "${hex_signed}"
     if ! gsc-codesigner "${signer_command_params[@]}" \
         -i "${rw}" -o "${hex_signed}"; then
       die "gsc-codesigner ${signer_command_params[*]}" \
         "-i ${rw} -o ${hex_signed} failed"
     fi
 
-    if ! objcopy -I ihex "${hex_signed}" -O binary "${bin_signed}"; then
-      die "Failed to convert ${rw} from hex to bin"
-    fi
-
     if [[ -n "${rma_key_base}" ]]; then
-      if find_blob_in_blob  "${bin_signed}" "${rma_key_base}.test"; then
+      if find_blob_in_blob  "${hex_signed}" "${rma_key_base}.test"; then
         die "test RMA key in the signed image!"
       fi
 
-      if ! find_blob_in_blob "${bin_signed}" "${rma_key_base}.prod"; then
+      if ! find_blob_in_blob "${hex_signed}" "${rma_key_base}.prod"; then
         die "prod RMA key not in the signed image!"
       fi
     fi
-
-    hex_base="$(get_hex_base "${hex_signed}")"
-    paste_bin "${result_file}" "${bin_signed}" "${image_base}" "${hex_base}"
   done
 
   if strings "${rw}" | grep -q "DBG/${base_name}"; then
@@ -515,39 +383,30 @@ sign_gsc_firmware() {
 
   verify_and_prepare_gsc_manifest "${manifest_file}"
 
-  dd if=/dev/zero bs="${IMAGE_SIZE}" count=1 status=none |
-    tr '\000' '\377' > "${output_file}"
-  if [[ "$(stat -c '%s' "${output_file}")" != "${IMAGE_SIZE}" ]]; then
-    die "Failed creating ${output_file}"
-  fi
-
   if ! sign_rw "${key_file}" "${manifest_file}" "${fuses_file}" \
        "${rma_key_dir}" "${rw_a}" "${rw_b}" \
-       "${output_file}" "${generation}" "${IMAGE_BASE}"; then
+       "${temp_dir}" "${generation}"; then
     die "Failed invoking sign_rw for ${rw_a} and ${rw_b}"
   fi
 
-  local f
-  for f in "${ro_a_hex}" "${ro_b_hex}"; do
-    local hex_base
-    local bin
-
-    hex_base="$(get_hex_base "${f}")"
-    bin="${temp_dir}/bin"
-
-    if [[ -z ${hex_base} ]]; then
-      die "Failed retrieving base address from ${f}"
-    fi
+  if [[ "${generation}" == "h" ]]; then
+    local f
+    local bin="${temp_dir}/bin"
 
-    if ! objcopy -I ihex "${f}" -O binary "${bin}"; then
-      die "Failed to convert ${f} from hex to bin"
-    fi
-    if [[ "${generation}" == "h" ]]; then
+    for f in "${ro_a_hex}" "${ro_b_hex}"; do
+      if ! objcopy -I ihex "${f}" -O binary "${bin}"; then
+        die "Failed to convert ${f} from hex to bin"
+      fi
       verify_ro "${bin}" "${key_file}"
-    fi
+    done
+  fi
 
-    paste_bin "${output_file}" "${bin}" "${IMAGE_BASE}" "${hex_base}"
-  done
+  # Place all four blobs into an erased flash image in one pass.
+  if ! ${FUTILITY} gsc_image --base "${IMAGE_BASE}" --size "${IMAGE_SIZE}" \
+       "${output_file}" "${ro_a_hex}" "${ro_b_hex}" \
+       "${temp_dir}/rw_0.hex" "${temp_dir}/rw_1.hex"; then
+    die "Failed creating ${output_file}"
+  fi
 
   # Tell the signer how to rename the @CHIP@ portion of the output.
   echo "${chip_name}" > "${output_file}.rename"
@@ -13,6 +13,7 @@
 #include "crc32_test.h"
 #include "gpt.h"
 #include "test_common.h"
+#include "vboot_host.h"
 
 /*
  * Testing partition layout (sector_bytes=512)
@@ -1333,6 +1334,91 @@ static int GetNextTriesTest(void)
 	return TEST_OK;
 }
 
+static int PreferKernelTest(void)
+{
+	GptData *gpt = GetEmptyGptData();
+	GptEntry *e1 = (GptEntry *)(gpt->primary_entries);
+	uint64_t start, size;
+
+	/* Preferred kernel first, then the rest in priority order */
+	BuildTestGptData(gpt);
+	FillEntry(e1 + KERNEL_A, 1, 2, 1, 0);
+	FillEntry(e1 + KERNEL_B, 1, 2, 1, 0);
+	RefreshCrc32(gpt);
+	GptInit(gpt);
+
+	EXPECT(GPT_SUCCESS ==
+	       GptPreferKernelEntry(gpt, KERNEL_B, &start, &size));
+	EXPECT(KERNEL_B == gpt->current_kernel);
+	EXPECT(134 == start);
+	EXPECT(99 == size);
+	EXPECT(GPT_SUCCESS == GptNextKernelEntry(gpt, &start, &size));
+	EXPECT(KERNEL_A == gpt->current_kernel);
+	EXPECT(GPT_SUCCESS == GptNextKernelEntry(gpt, &start, &size));
+	EXPECT(KERNEL_B == gpt->current_kernel);
+	EXPECT(GPT_ERROR_NO_VALID_KERNEL ==
+	       GptNextKernelEntry(gpt, &start, &size));
+
+	/* Only before the scan has started */
+	GptInit(gpt);
+	EXPECT(GPT_SUCCESS == GptNextKernelEntry(gpt, &start, &size));
+	EXPECT(GPT_ERROR_NO_VALID_KERNEL ==
+	       GptPreferKernelEntry(gpt, KERNEL_B, &start, &size));
+	EXPECT(KERNEL_A == gpt->current_kernel);
+
+	/* Not a kernel, or out of range */
+	GptInit(gpt);
+	EXPECT(GPT_ERROR_NO_VALID_KERNEL ==
+	       GptPreferKernelEntry(gpt, KERNEL_X, &start, &size));
+	EXPECT(GPT_ERROR_NO_VALID_KERNEL ==
+	       GptPreferKernelEntry(gpt, 9999, &start, &size));
+	EXPECT(-1 == gpt->current_kernel);
+
+	/* Must have booted successfully and not be disabled */
+	FillEntry(e1 + KERNEL_B, 1, 2, 0, 5);
+	RefreshCrc32(gpt);
+	GptInit(gpt);
+	EXPECT(GPT_ERROR_NO_VALID_KERNEL ==
+	       GptPreferKernelEntry(gpt, KERNEL_B, &start, &size));
+	FillEntry(e1 + KERNEL_B, 1, 0, 1, 0);
+	RefreshCrc32(gpt);
+	GptInit(gpt);
+	EXPECT(GPT_ERROR_NO_VALID_KERNEL ==
+	       GptPreferKernelEntry(gpt, KERNEL_B, &start, &size));
+
+	/* Doesn't jump ahead of a higher priority kernel on trial */
+	FillEntry(e1 + KERNEL_A, 1, 3, 0, 6);
+	FillEntry(e1 + KERNEL_B, 1, 2, 1, 0);
+	RefreshCrc32(gpt);
+	GptInit(gpt);
+	EXPECT(GPT_ERROR_NO_VALID_KERNEL ==
+	       GptPreferKernelEntry(gpt, KERNEL_B, &start, &size));
+	FillEntry(e1 + KERNEL_A, 1, 1, 0, 6);
+	RefreshCrc32(gpt);
+	GptInit(gpt);
+	EXPECT(GPT_SUCCESS ==
+	       GptPreferKernelEntry(gpt, KERNEL_B, &start, &size));
+
+	/* Nor ahead of a higher priority kernel which has booted */
+	FillEntry(e1 + KERNEL_A, 1, 3, 1, 0);
+	RefreshCrc32(gpt);
+	GptInit(gpt);
+	EXPECT(GPT_ERROR_NO_VALID_KERNEL ==
+	       GptPreferKernelEntry(gpt, KERNEL_B, &start, &size));
+	EXPECT(GPT_SUCCESS == GptNextKernelEntry(gpt, &start, &size));
+	EXPECT(KERNEL_A == gpt->current_kernel);
+
+	/* But a higher priority kernel which can't boot doesn't count */
+	FillEntry(e1 + KERNEL_A, 1, 3, 0, 0);
+	RefreshCrc32(gpt);
+	GptInit(gpt);
+	EXPECT(GPT_SUCCESS ==
+	       GptPreferKernelEntry(gpt, KERNEL_B, &start, &size));
+	EXPECT(KERNEL_B == gpt->current_kernel);
+
+	return TEST_OK;
+}
+
 static int GptUpdateTest(void)
 {
 	GptData *gpt = GetEmptyGptData();
@@ -1498,6 +1584,113 @@ static int DuplicateUniqueGuidTest(void)
 	return TEST_OK;
 }
 
+/* Entries matching a partition index query, found by scanning the table */
+static int ScanEntries(struct drive *drive, enum drive_index_key key,
+		       const void *value, const char *label, int *found)
+{
+	char partlabel[GPT_PARTNAME_LEN];
+	GptEntry *e;
+	int i, n = 0;
+
+	for (i = 0; i < GetNumberOfEntries(drive); i++) {
+		e = GetEntry(&drive->gpt, ANY_VALID, i);
+		if (key == DRIVE_INDEX_UNIQUE && !GuidEqual(&e->unique, value))
+			continue;
+		if (key == DRIVE_INDEX_TYPE && !GuidEqual(&e->type, value))
+			continue;
+		if (key == DRIVE_INDEX_LABEL &&
+		    (CGPT_OK != UTF16ToUTF8(e->name, ARRAY_SIZE(e->name),
+					    (uint8_t *)partlabel,
+					    sizeof(partlabel)) ||
+		     strncmp(label, partlabel, sizeof(partlabel))))
+			continue;
+		found[n++] = i;
+	}
+	return n;
+}
+
+/* Check that the index returns the same entries, in order, as a scan */
+static int IndexMatchesScan(struct drive *drive, enum drive_index_key key,
+			    const void *value, const char *label)
+{
+	int expect[128], n, i, k;
+
+	n = ScanEntries(drive, key, value, label, expect);
+	i = -1;
+	for (k = 0; k < n; k++) {
+		i = DriveIndexFind(drive, key, value, i);
+		if (i != expect[k])
+			return 0;
+	}
+	return DriveIndexFind(drive, key, value, i) == -1 &&
+		(n || DriveIndexFind(drive, key, value, -1) == -1);
+}
+
+/* Test the cgpt partition index against scanning the entries */
+static int PartitionIndexTest(void)
+{
+	static const char *labels[] = {
+		"KERN-A", "ROOT-A", "", "STATE",
+		"xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx",   /* fills the name */
+	};
+	static const char *queries[] = {
+		"KERN-A", "ROOT-A", "", "STATE", "KERN", "KERN-A ", "missing",
+		"xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx",
+		"xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx",  /* too long */
+	};
+	struct drive drive;
+	GptEntry *e;
+	uint16_t name[DRIVE_INDEX_NAME_UNITS];
+	Guid guid;
+	int i, j;
+
+	memset(&drive, 0, sizeof(drive));
+	memcpy(&drive.gpt, GetEmptyGptData(), sizeof(drive.gpt));
+	BuildTestGptData(&drive.gpt);
+
+	/* Fill the whole table, with types, GUIDs and labels repeated */
+	e = (GptEntry *)drive.gpt.primary_entries;
+	for (i = 0; i < 128; i++) {
+		SetGuid(&e[i].type, i % 3);
+		SetGuid(&e[i].unique, i % 50);
+		memset(e[i].name, 0, sizeof(e[i].name));
+		for (j = 0; j < ARRAY_SIZE(e[i].name) && labels[i % 5][j]; j++)
+			e[i].name[j] = labels[i % 5][j];
+	}
+
+	for (i = 0; i < 4; i++) {
+		SetGuid(&guid, i);
+		EXPECT(IndexMatchesScan(&drive, DRIVE_INDEX_TYPE, &guid, NULL));
+	}
+	for (i = 0; i < 52; i++) {
+		SetGuid(&guid, i);
+		EXPECT(IndexMatchesScan(&drive, DRIVE_INDEX_UNIQUE, &guid,
+					NULL));
+	}
+	for (i = 0; i < ARRAY_SIZE(queries); i++) {
+		if (CGPT_OK != DriveIndexLabel(queries[i], name)) {
+			/* Only a label too long for any entry may fail */
+			EXPECT(strlen(queries[i]) > ARRAY_SIZE(e->name));
+			continue;
+		}
+		EXPECT(IndexMatchesScan(&drive, DRIVE_INDEX_LABEL, name,
+					queries[i]));
+	}
+
+	/* Once the entries change, the index has to be reset */
+	SetGuid(&guid, 60);
+	SetGuid(&e[7].unique, 60);
+	EXPECT(DriveIndexFind(&drive, DRIVE_INDEX_UNIQUE, &guid, -1) == -1);
+	DriveIndexReset(&drive);
+	EXPECT(DriveIndexFind(&drive, DRIVE_INDEX_UNIQUE, &guid, -1) == 7);
+	EXPECT(IndexMatchesScan(&drive, DRIVE_INDEX_UNIQUE, &guid, NULL));
+
+	DriveIndexReset(&drive);
+	EXPECT(drive.index == NULL);
+
+	return TEST_OK;
+}
+
 /* Test getting the current kernel GUID */
 static int GetKernelGuidTest(void)
 {
@@ -1627,9 +1820,11 @@ int main(int argc, char *argv[])
 		{ TEST_CASE(GetNextNormalTest), },
 		{ TEST_CASE(GetNextPrioTest), },
 		{ TEST_CASE(GetNextTriesTest), },
+		{ TEST_CASE(PreferKernelTest), },
 		{ TEST_CASE(GptUpdateTest), },
 		{ TEST_CASE(UpdateInvalidKernelTypeTest), },
 		{ TEST_CASE(DuplicateUniqueGuidTest), },
+		{ TEST_CASE(PartitionIndexTest), },
 		{ TEST_CASE(TestCrc32TestVectors), },
 		{ TEST_CASE(GetKernelGuidTest), },
 		{ TEST_CASE(ErrorTextTest), },
@@ -0,0 +1,61 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Compare the CRC-8 implementations on NV storage and secdata sized buffers.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "2common.h"
+#include "2crc8.h"
+#include "2sysincludes.h"
+#include "timer_utils.h"
+
+#define NUM_ITERATIONS 200000
+
+static const struct {
+	const char *name;
+	uint8_t (*crc8)(const void *data, uint32_t size);
+} impls[] = {
+	{"bitwise", vb2_crc8_bitwise},
+	{"nibble", vb2_crc8_nibble},
+	{"byte", vb2_crc8_byte},
+};
+
+/* NV storage V1 and V2 records, and a larger buffer for comparison */
+static const uint32_t sizes[] = {15, 63, 255};
+
+int main(int argc, char *argv[])
+{
+	uint8_t buf[256];
+	ClockTimerState ct;
+	uint32_t msecs;
+	volatile uint8_t sink = 0;
+	int i, j, k;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i * 37 + 11;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		for (j = 0; j < ARRAY_SIZE(impls); j++) {
+			StartTimer(&ct);
+			for (k = 0; k < NUM_ITERATIONS; k++) {
+				buf[0] = k;
+				sink ^= impls[j].crc8(buf, sizes[i]);
+			}
+			StopTimer(&ct);
+			msecs = GetDurationMsecs(&ct);
+
+			fprintf(stderr, "# %s, %u bytes: %u ms\n",
+				impls[j].name, sizes[i], msecs);
+			fprintf(stdout, "nsecs_per_crc_%s_%u:%f\n",
+				impls[j].name, sizes[i],
+				msecs * 1e6 / NUM_ITERATIONS);
+		}
+	}
+
+	return 0;
+}
@@ -22,6 +22,8 @@ TESTS="
 ${SCRIPT_DIR}/futility/test_create.sh
 ${SCRIPT_DIR}/futility/test_dump_fmap.sh
 ${SCRIPT_DIR}/futility/test_gbb_utility.sh
+${SCRIPT_DIR}/futility/test_gsc_image.sh
+${SCRIPT_DIR}/futility/test_keyset_check.sh
 ${SCRIPT_DIR}/futility/test_load_fmap.sh
 ${SCRIPT_DIR}/futility/test_main.sh
 ${SCRIPT_DIR}/futility/test_rwsig.sh
@@ -0,0 +1,157 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for futil_copy_file().
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "2common.h"
+#include "futility.h"
+#include "host_misc.h"
+#include "test_common.h"
+
+/* Not a multiple of the copy buffer or of a page */
+#define BIG_FILE_SIZE (3 * 1024 * 1024 + 123)
+
+static uint8_t *make_data(uint32_t size)
+{
+	uint8_t *data = malloc(size);
+	uint32_t i;
+
+	for (i = 0; i < size; i++)
+		data[i] = (i * 7 + (i >> 11)) & 0xff;
+	return data;
+}
+
+static int same_contents(const char *name, const uint8_t *data,
+			 uint32_t size)
+{
+	uint8_t *buf;
+	uint32_t len;
+	int rv;
+
+	if (vb2_read_file(name, &buf, &len))
+		return 0;
+	rv = len == size && !memcmp(buf, data, size);
+	free(buf);
+	return rv;
+}
+
+static void copy_tests(const char *dir)
+{
+	char in[1024], out[1024];
+	enum futil_copy_method m;
+	uint8_t *data = make_data(BIG_FILE_SIZE);
+	struct stat sb;
+	mode_t mask;
+	pid_t pid;
+	int rv, status;
+
+	mask = umask(0);
+	umask(mask);
+
+	printf("Testing in %s\n", dir);
+	snprintf(in, sizeof(in), "%s/copy_file_test.%d.in", dir, getpid());
+	snprintf(out, sizeof(out), "%s/copy_file_test.%d.out", dir, getpid());
+	unlink(out);
+
+	TEST_SUCC(vb2_write_file(in, data, BIG_FILE_SIZE), "Write input");
+	chmod(in, 0640);
+
+	/* Each method, and whatever it falls back to */
+	for (m = FUTIL_COPY_CLONE; m <= FUTIL_COPY_BUFFERED; m++) {
+		unlink(out);
+		rv = futil_copy_file(in, out, m);
+		printf("  starting at method %d used method %d\n", m, rv);
+		TEST_TRUE(rv >= (int)m && rv <= FUTIL_COPY_BUFFERED,
+			  "Copy uses this method or a fallback");
+		TEST_TRUE(same_contents(out, data, BIG_FILE_SIZE),
+			  "  contents");
+	}
+	TEST_EQ(futil_copy_file(in, out, FUTIL_COPY_BUFFERED),
+		FUTIL_COPY_BUFFERED, "Buffered copy has no fallback");
+
+	TEST_SUCC(stat(out, &sb), "  stat output");
+	TEST_EQ(sb.st_mode & 0777, 0640 & ~mask,
+		"  new file gets input permissions");
+
+	/* Overwriting a longer file truncates it */
+	TEST_SUCC(vb2_write_file(in, data, 100), "Shrink input");
+	for (m = FUTIL_COPY_CLONE; m <= FUTIL_COPY_BUFFERED; m++) {
+		TEST_TRUE(futil_copy_file(in, out, m) >= 0,
+			  "Copy over longer file");
+		TEST_TRUE(same_contents(out, data, 100), "  truncated");
+		TEST_SUCC(vb2_write_file(out, data, BIG_FILE_SIZE),
+			  "  restore long output");
+	}
+
+	/* Empty file */
+	TEST_SUCC(truncate(in, 0), "Empty input");
+	for (m = FUTIL_COPY_CLONE; m <= FUTIL_COPY_BUFFERED; m++) {
+		TEST_TRUE(futil_copy_file(in, out, m) >= 0,
+			  "Copy empty file");
+		TEST_SUCC(stat(out, &sb), "  stat output");
+		TEST_EQ(sb.st_size, 0, "  empty");
+	}
+
+	/* A pipe has no size, so it is read until the writer closes it */
+	unlink(in);
+	TEST_SUCC(mkfifo(in, 0600), "Make FIFO");
+	pid = fork();
+	if (!pid)
+		_exit(vb2_write_file(in, data, BIG_FILE_SIZE) ? 1 : 0);
+	TEST_EQ(futil_copy_file(in, out, FUTIL_COPY_CLONE),
+		FUTIL_COPY_BUFFERED, "Copy from FIFO");
+	TEST_EQ(waitpid(pid, &status, 0), pid, "  writer done");
+	TEST_TRUE(WIFEXITED(status) && !WEXITSTATUS(status), "  writer ok");
+	TEST_TRUE(same_contents(out, data, BIG_FILE_SIZE), "  contents");
+	unlink(in);
+
+	/* A character device */
+	TEST_EQ(futil_copy_file("/dev/null", out, FUTIL_COPY_CLONE),
+		FUTIL_COPY_BUFFERED, "Copy from /dev/null");
+	TEST_SUCC(stat(out, &sb), "  stat output");
+	TEST_EQ(sb.st_size, 0, "  empty");
+
+	/* Errors */
+	TEST_SUCC(vb2_write_file(in, data, 100), "Restore input");
+	TEST_EQ(futil_copy_file(in, in, FUTIL_COPY_CLONE), -1,
+		"Copy onto itself");
+	TEST_TRUE(same_contents(in, data, 100), "  input intact");
+	TEST_EQ(futil_copy_file("no/such/file", out, FUTIL_COPY_CLONE), -1,
+		"Copy missing file");
+	TEST_EQ(futil_copy_file(dir, out, FUTIL_COPY_CLONE), -1,
+		"Copy directory");
+	TEST_EQ(futil_copy_file(in, "no/such/dir/file", FUTIL_COPY_CLONE), -1,
+		"Copy to missing directory");
+
+	unlink(in);
+	unlink(out);
+	free(data);
+}
+
+int main(int argc, char *argv[])
+{
+	struct stat sb;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <temp_dir>\n", argv[0]);
+		return -1;
+	}
+
+	copy_tests(argv[1]);
+
+	/* tmpfs can't reflink, which exercises the first fallback */
+	if (!stat("/dev/shm", &sb) && S_ISDIR(sb.st_mode) &&
+	    !access("/dev/shm", W_OK))
+		copy_tests("/dev/shm");
+
+	return !gTestSuccess;
+}
@@ -0,0 +1,118 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for the emulated flash chip used by the firmware updater.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "flash_emulator.h"
+#include "test_common.h"
+
+#define FLASH_SIZE (64 * 1024)
+
+static const struct flash_timing test_timing = {
+	.erase_block_size = 4096,
+	.page_size = 256,
+	.read_bandwidth = 1024 * 1024,
+	.erase_us = 1000,
+	.program_us = 10,
+};
+
+static uint8_t image[FLASH_SIZE], buf[FLASH_SIZE];
+
+static void reset_flash(struct flash_emulator *flash)
+{
+	flash_emulator_free(flash);
+	TEST_SUCC(flash_emulator_init(flash, image, sizeof(image)),
+		  "Init emulated flash");
+	flash->timing = test_timing;
+}
+
+static void flash_emulator_tests(void)
+{
+	struct flash_emulator flash = {0};
+	uint8_t zeros[8192] = {0};
+
+	memset(image, 0xff, sizeof(image));
+	reset_flash(&flash);
+
+	/* Reads */
+	TEST_SUCC(flash_emulator_read(&flash, 0, 1024, buf), "Read");
+	TEST_EQ(buf[0], 0xff, "  contents");
+	TEST_EQ(flash.stats.read_bytes, 1024, "  bytes");
+	TEST_EQ(flash.stats.time_us, 976, "  time");
+	TEST_NEQ(flash_emulator_read(&flash, FLASH_SIZE - 1, 2, buf), 0,
+		 "Read past end");
+
+	/* Programming erased flash needs no erase. */
+	reset_flash(&flash);
+	TEST_SUCC(flash_emulator_write(&flash, 4096, zeros, 512, 0),
+		  "Write to erased block");
+	TEST_EQ(flash.stats.erase_blocks, 0, "  no erase");
+	TEST_EQ(flash.stats.program_pages, 2, "  pages");
+	TEST_EQ(flash.stats.read_bytes, 4096, "  reads the block");
+	TEST_EQ(flash.stats.time_us, 3906 + 2 * 10, "  time");
+	TEST_EQ(flash.data[4096 + 511], 0, "  contents");
+	TEST_EQ(flash.data[4096 + 512], 0xff, "  rest of block kept");
+
+	/* Writing the same data again changes nothing. */
+	memset(&flash.stats, 0, sizeof(flash.stats));
+	TEST_SUCC(flash_emulator_write(&flash, 4096, zeros, 512, 1),
+		  "Write unchanged data");
+	TEST_EQ(flash.stats.erase_blocks, 0, "  no erase");
+	TEST_EQ(flash.stats.program_pages, 0, "  no program");
+	TEST_EQ(flash.stats.read_bytes, 4096 + 512, "  reads and verifies");
+
+	/* Setting bits needs an erase, and reprograms the rest of block. */
+	memset(&flash.stats, 0, sizeof(flash.stats));
+	memset(buf, 0xff, 256);
+	TEST_SUCC(flash_emulator_write(&flash, 4096, buf, 256, 0),
+		  "Write needing erase");
+	TEST_EQ(flash.stats.erase_blocks, 1, "  erase");
+	TEST_EQ(flash.stats.program_pages, 1, "  program old page back");
+	TEST_EQ(flash.stats.time_us, 3906 + 1000 + 10, "  time");
+	TEST_EQ(flash.data[4096], 0xff, "  contents");
+	TEST_EQ(flash.data[4096 + 256], 0, "  rest of block kept");
+
+	/* Unaligned writes touch each block they overlap. */
+	reset_flash(&flash);
+	TEST_SUCC(flash_emulator_write(&flash, 4000, zeros, 4500, 0),
+		  "Unaligned write");
+	TEST_EQ(flash.stats.read_bytes, 3 * 4096, "  reads 3 blocks");
+	TEST_EQ(flash.stats.program_pages, 1 + 16 + 2, "  pages");
+	TEST_EQ(flash.data[3999], 0xff, "  start");
+	TEST_EQ(flash.data[4000], 0, "  start");
+	TEST_EQ(flash.data[8499], 0, "  end");
+	TEST_EQ(flash.data[8500], 0xff, "  end");
+
+	TEST_NEQ(flash_emulator_write(&flash, FLASH_SIZE - 10, zeros, 20, 0),
+		 0, "Write past end");
+
+	/* Write protection */
+	reset_flash(&flash);
+	flash.wp_start = 32768;
+	flash.wp_size = 16384;
+	TEST_NEQ(flash_emulator_write(&flash, 32768 - 256, zeros, 512, 0),
+		 0, "Write overlapping WP range");
+	TEST_NEQ(flash_emulator_write(&flash, 49152 - 1, zeros, 1, 0),
+		 0, "Write at end of WP range");
+	TEST_EQ(flash.stats.program_pages, 0, "  nothing written");
+	TEST_EQ(flash.data[32768 - 256], 0xff, "  contents kept");
+	TEST_SUCC(flash_emulator_write(&flash, 32768 - 512, zeros, 512, 0),
+		  "Write just before WP range");
+	TEST_SUCC(flash_emulator_write(&flash, 49152, zeros, 512, 0),
+		  "Write just after WP range");
+
+	flash_emulator_free(&flash);
+}
+
+int main(int argc, char *argv[])
+{
+	flash_emulator_tests();
+
+	return gTestSuccess ? 0 : 255;
+}
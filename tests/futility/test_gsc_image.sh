@@ -0,0 +1,90 @@
+#!/bin/bash -eux
+# Copyright 2021 The Chromium OS Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+me=${0##*/}
+TMP="$me.tmp"
+
+# Work in scratch directory
+cd "$OUTDIR"
+
+# Four bytes at 0x1000, using a linear address record and <cr><lf>.
+printf ':020000040000FA\r\n:0410000001020304E2\r\n:00000001FF\r\n' \
+  > "${TMP}.a.hex"
+# Eight bytes at 0x1080, using a segment address record.
+printf ':020000020100FB\n:08008000677363206B657921B1\n:00000001FF\n' \
+  > "${TMP}.b.hex"
+# One byte at 0x1100.
+printf ':020000020100FB\n:01010000AA54\n:00000001FF\n' > "${TMP}.c.hex"
+# Four bytes at 0x1040 and 0x1050, with a hole in between.
+printf ':020000020100FB\n:0200400011228B\n:02005000334437\n:00000001FF\n' \
+  > "${TMP}.d.hex"
+printf 'gsc key!and more' > "${TMP}.pattern"
+
+# Expected image: erased flash with both blobs in place.
+{
+  printf '\001\002\003\004'
+  head -c $(( 0x80 - 4 )) /dev/zero | tr '\000' '\377'
+  printf 'gsc key!'
+  head -c $(( 0x80 - 8 )) /dev/zero | tr '\000' '\377'
+} > "${TMP}.expect"
+
+"$FUTILITY" gsc_image --base 0x1000 --size 0x100 "${TMP}.bin" \
+  "${TMP}.a.hex" "${TMP}.b.hex"
+cmp "${TMP}.expect" "${TMP}.bin"
+
+# A hole inside a blob is zero-filled, unlike the erased flash around it.
+{
+  head -c $(( 0x40 )) /dev/zero | tr '\000' '\377'
+  printf '\021\042'
+  head -c $(( 0x0e )) /dev/zero
+  printf '\063\104'
+  head -c $(( 0x100 - 0x52 )) /dev/zero | tr '\000' '\377'
+} > "${TMP}.expect.d"
+"$FUTILITY" gsc_image -b 0x1000 -s 0x100 "${TMP}.bin" "${TMP}.d.hex"
+cmp "${TMP}.expect.d" "${TMP}.bin"
+
+# Same image as the objcopy and dd commands sign_gsc_firmware.sh used before
+if type objcopy >/dev/null 2>&1; then
+  head -c $(( 0x100 )) /dev/zero | tr '\000' '\377' > "${TMP}.objcopy"
+  for hex_base in a:0 b:128 d:64; do
+    objcopy -I ihex "${TMP}.${hex_base%:*}.hex" -O binary "${TMP}.blob"
+    dd if="${TMP}.blob" of="${TMP}.objcopy" seek="${hex_base#*:}" bs=1 \
+      conv=notrunc
+  done
+  "$FUTILITY" gsc_image -b 0x1000 -s 0x100 "${TMP}.bin" \
+    "${TMP}.a.hex" "${TMP}.b.hex" "${TMP}.d.hex"
+  cmp "${TMP}.objcopy" "${TMP}.bin"
+fi
+
+# Data past the end of the image
+if "$FUTILITY" gsc_image -b 0x1000 -s 0x100 "${TMP}.bad" \
+  "${TMP}.a.hex" "${TMP}.c.hex"; then false; fi
+"$FUTILITY" gsc_image -b 0x1000 -s 0x101 "${TMP}.bin" "${TMP}.c.hex"
+
+# Data before the start of the image
+if "$FUTILITY" gsc_image -b 0x1001 -s 0x100 "${TMP}.bad" \
+  "${TMP}.a.hex"; then false; fi
+
+# Bad checksum
+sed 's/E2/E3/' "${TMP}.a.hex" > "${TMP}.bad.hex"
+if "$FUTILITY" gsc_image -b 0x1000 -s 0x100 "${TMP}.bad" \
+  "${TMP}.bad.hex"; then false; fi
+
+# Not ihex, or missing arguments
+if "$FUTILITY" gsc_image -b 0x1000 -s 0x100 "${TMP}.bad" \
+  "${TMP}.pattern"; then false; fi
+if "$FUTILITY" gsc_image -s 0x100 "${TMP}.bad" "${TMP}.a.hex"; then false; fi
+
+# Pattern search in ihex and binary files
+"$FUTILITY" gsc_image --contains "${TMP}.pattern" "${TMP}.b.hex"
+"$FUTILITY" gsc_image -c "${TMP}.pattern" "${TMP}.b.hex" "${TMP}.expect"
+if "$FUTILITY" gsc_image -c "${TMP}.pattern" "${TMP}.a.hex"; then false; fi
+if "$FUTILITY" gsc_image -c "${TMP}.pattern" "${TMP}.b.hex" \
+  "${TMP}.a.hex"; then false; fi
+if "$FUTILITY" gsc_image -c "${TMP}.c.hex" "${TMP}.b.hex"; then false; fi
+
+# cleanup
+rm -rf "${TMP}"*
+exit 0
@@ -0,0 +1,70 @@
+#!/bin/bash -eux
+# Copyright 2021 The Chromium OS Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+me=${0##*/}
+TMP="$me.tmp"
+
+# Work in scratch directory
+cd "$OUTDIR"
+
+DEVKEYS=${SRCDIR}/tests/devkeys
+
+# The dev keyset is consistent.
+"${FUTILITY}" keyset_check "${DEVKEYS}" > "${TMP}.out"
+grep -q ': OK$' "${TMP}.out"
+
+# Bad usage.
+if "${FUTILITY}" keyset_check; then false; fi
+if "${FUTILITY}" keyset_check "${TMP}.nonexistent"; then false; fi
+
+# Work on a copy of the public half.
+KEYS="${TMP}.keys"
+rm -rf "${KEYS}"
+mkdir "${KEYS}"
+cp "${DEVKEYS}"/*.vbpubk "${DEVKEYS}"/*.keyblock "${DEVKEYS}"/key.versions \
+  "${KEYS}"
+
+# Every problem is reported in one run.
+sed -i 's/^firmware_key_version=.*/firmware_key_version=2/' \
+  "${KEYS}/key.versions"
+cp "${DEVKEYS}/recovery_kernel.keyblock" "${KEYS}/kernel.keyblock"
+if "${FUTILITY}" keyset_check "${KEYS}" > "${TMP}.out"; then false; fi
+grep -q 'firmware data key version 1 does not match key.versions firmware key version 2' \
+  "${TMP}.out"
+grep -q "kernel.keyblock doesn't hold kernel_data_key.vbpubk" "${TMP}.out"
+grep -q 'kernel.keyblock is not signed by kernel_subkey.vbpubk' "${TMP}.out"
+grep -q ': 3 problems found$' "${TMP}.out"
+cp "${DEVKEYS}/kernel.keyblock" "${DEVKEYS}/key.versions" "${KEYS}"
+
+# Convert to an LOEM keyset, with two copies of the firmware keys.
+for n in 1 2; do
+  cp "${KEYS}/root_key.vbpubk" "${KEYS}/root_key.loem${n}.vbpubk"
+  cp "${KEYS}/firmware_data_key.vbpubk" \
+    "${KEYS}/firmware_data_key.loem${n}.vbpubk"
+  cp "${KEYS}/firmware.keyblock" "${KEYS}/firmware.loem${n}.keyblock"
+done
+rm "${KEYS}"/root_key.vbpubk "${KEYS}"/firmware_data_key.vbpubk \
+  "${KEYS}"/firmware.keyblock
+printf '[loem]\n1 = ACME\n2 = WIDGET\n' > "${KEYS}/loem.ini"
+"${FUTILITY}" keyset_check -v "${KEYS}" > "${TMP}.out"
+grep -q 'firmware.loem2.keyblock is signed by root_key.loem2.vbpubk' \
+  "${TMP}.out"
+
+# A bad LOEM keyblock is caught.
+cp "${DEVKEYS}/kernel.keyblock" "${KEYS}/firmware.loem2.keyblock"
+if "${FUTILITY}" keyset_check "${KEYS}" > "${TMP}.out"; then false; fi
+grep -q 'firmware.loem2.keyblock is not signed by root_key.loem2.vbpubk' \
+  "${TMP}.out"
+if grep -q 'loem1' "${TMP}.out"; then false; fi
+
+# A listed LOEM key which is missing is caught.
+cp "${KEYS}/firmware.loem1.keyblock" "${KEYS}/firmware.loem2.keyblock"
+echo '3 = GADGET' >> "${KEYS}/loem.ini"
+if "${FUTILITY}" keyset_check "${KEYS}" > "${TMP}.out"; then false; fi
+grep -q "can't read keyblock .*/firmware.loem3.keyblock" "${TMP}.out"
+
+# cleanup
+rm -rf "${TMP}"*
+exit 0
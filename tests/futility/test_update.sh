@@ -64,6 +64,15 @@ patch_file() {
 	printf "${data}" | dd of="${file}" bs=1 seek="${offset}" conv=notrunc
 }
 
+# Writes a VPD with only 'whitelabel_tag' set to RO_VPD of an image.
+set_wl_tag() {
+	local file="$1"
+	local tag="$2"
+	local len="$(printf '\\%03o' "${#tag}")"
+
+	patch_file "${file}" RO_VPD 0 "\001\016whitelabel_tag${len}${tag}\000"
+}
+
 # PEPPY and LINK have different platform element ("Google_Link" and
 # "Google_Peppy") in firmware ID so we want to hack them by changing
 # "Google_" to "Google.".
@@ -229,6 +238,49 @@ test_update "Full update (Preserve VPD using FMAP_AREA_PRESERVE)" \
 	"${FROM_IMAGE}" "${TMP}.expected.full.empty_rw_vpd" \
 	-i "${TO_IMAGE_WIPE_RW_VPD}" --wp=0 --sys_props 0,0x10001,1
 
+# Test Full update with a write journal, interrupted by injected failures.
+JOURNAL="${TMP}.journal"
+rm -f "${JOURNAL}"
+test_update "Full update (journal)" \
+	"${FROM_IMAGE}" "${TMP}.expected.full" \
+	-i "${TO_IMAGE}" --wp=0 --sys_props 0,0x10001,1 --journal "${JOURNAL}"
+[ ! -e "${JOURNAL}" ]
+
+test_update "Full update (journal, interrupted)" \
+	"${FROM_IMAGE}" "!Injected failure before writing block at 0x300000" \
+	-i "${TO_IMAGE}" --wp=0 --sys_props 0,0x10001,1 --journal "${JOURNAL}" \
+	--journal_fail=3
+[ "$(grep -c "^done " "${JOURNAL}")" = 3 ]
+cmp -n 3145728 "${TMP}.emu" "${TMP}.expected.full"
+cp -f "${TMP}.emu" "${TMP}.emu.interrupted"
+cp -f "${JOURNAL}" "${JOURNAL}.interrupted"
+
+msg="$("${FUTILITY}" update --emulate "${TMP}.emu" -i "${TO_IMAGE}" --wp=0 \
+	--sys_props 0,0x10001,1 --journal "${JOURNAL}" 2>&1)"
+grep -qF "3 of 8 blocks already written" <<<"${msg}"
+[ "$(grep -c "Writing block" <<<"${msg}")" = 5 ]
+cmp "${TMP}.emu" "${TMP}.expected.full"
+[ ! -e "${JOURNAL}" ]
+
+# Blocks in journal which do not read back the same are written again.
+cp -f "${TMP}.emu.interrupted" "${TMP}.emu"
+cp -f "${JOURNAL}.interrupted" "${JOURNAL}"
+printf '\x5a' | dd of="${TMP}.emu" bs=1 seek=$((0x100000)) conv=notrunc \
+	2>/dev/null
+msg="$("${FUTILITY}" update --emulate "${TMP}.emu" -i "${TO_IMAGE}" --wp=0 \
+	--sys_props 0,0x10001,1 --journal "${JOURNAL}" 2>&1)"
+grep -qF "Block at 0x100000 in journal does not match" <<<"${msg}"
+grep -qF "2 of 8 blocks already written" <<<"${msg}"
+cmp "${TMP}.emu" "${TMP}.expected.full"
+
+# A journal for another image is not used.
+cp -f "${TMP}.emu.interrupted" "${TMP}.emu"
+cp -f "${JOURNAL}.interrupted" "${JOURNAL}"
+msg="$("${FUTILITY}" update --emulate "${TMP}.emu" -i "${TO_IMAGE_GBB12}" \
+	--wp=0 --sys_props 0,0x10001,1 --journal "${JOURNAL}" 2>&1)"
+grep -qF "is not for this image" <<<"${msg}"
+cmp "${TMP}.emu" "${TMP}.expected.full.gbb12"
+
 
 # Test RW-only update.
 test_update "RW update" \
@@ -318,6 +370,115 @@ test_update "Legacy update" \
 	"${FROM_IMAGE}" "${TMP}.expected.legacy" \
 	-i "${TO_IMAGE}" --mode=legacy
 
+# Test reading system firmware in the background, using a fake flashrom whose
+# read does not finish until the test opens a gate (a FIFO). The timeout only
+# bounds a broken updater, which would otherwise wait for the read forever.
+# The read is a single process waiting on a line from the gate, so like the
+# real flashrom, SIGTERM stops it without leaving anything behind.
+FAKE_FLASHROM_DIR="${PWD}/${TMP}.fake_flashrom"
+FAKE_FLASH="${PWD}/${TMP}.fake_flash"
+READ_GATE="${PWD}/${TMP}.read_gate"
+READ_STARTED="${PWD}/${TMP}.read_started"
+mkdir -p "${FAKE_FLASHROM_DIR}"
+cat >"${FAKE_FLASHROM_DIR}/flashrom" <<EOF
+#!/bin/bash
+case "\$1" in
+-r)
+	exec 3<>"${READ_GATE}"
+	[ ! -p "${READ_STARTED}" ] || : >"${READ_STARTED}"
+	if ! read -r -t 60 -u 3 _; then
+		touch "${FAKE_FLASH}.timeout"
+		exit 1
+	fi
+	cp -f "${FAKE_FLASH}" "\$2"
+	touch "${FAKE_FLASH}.read"
+	;;
+-w)
+	cp -f "\$2" "${FAKE_FLASH}"
+	;;
+*)
+	exit 1
+	;;
+esac
+EOF
+chmod +x "${FAKE_FLASHROM_DIR}/flashrom"
+
+# The gate only opens once the target image is being checked, so this can
+# only pass if that happens while the read is still pending.
+echo "*** Test Item: Full update (background read)"
+cp -f "${FROM_IMAGE}" "${FAKE_FLASH}"
+rm -f "${READ_GATE}" "${FAKE_FLASH}.timeout"
+mkfifo "${READ_GATE}"
+PATH="${FAKE_FLASHROM_DIR}:${PATH}" "${FUTILITY}" update -i "${TO_IMAGE}" \
+	--wp=0 --sys_props 0,0x10001,1 2>&1 |
+	while IFS= read -r line; do
+		echo "${line}"
+		case "${line}" in
+		*"Checking target image..."*)
+			echo >"${READ_GATE}"
+			;;
+		esac
+	done
+[ ! -e "${FAKE_FLASH}.timeout" ]
+cmp "${FAKE_FLASH}" "${TMP}.expected.full"
+
+# A target failing its own checks cancels the read. The gate never opens, so
+# the updater can only return before the timeout if it stopped the read.
+echo "*** Test Item: Full update (background read cancelled)"
+cp -f "${FROM_IMAGE}" "${FAKE_FLASH}"
+rm -f "${READ_GATE}" "${FAKE_FLASH}.read" "${FAKE_FLASH}.timeout"
+mkfifo "${READ_GATE}"
+msg="$(! PATH="${FAKE_FLASHROM_DIR}:${PATH}" "${FUTILITY}" update \
+	-i "${TO_IMAGE}" --wp=0 --sys_props 1,0x20001,1 2>&1)"
+grep -qF "Data key version rollback detected (2->1)" <<<"${msg}"
+timeout 1 sh -c ": >'${READ_GATE}'" && exit 1
+[ ! -e "${FAKE_FLASH}.timeout" ]
+[ ! -e "${FAKE_FLASH}.read" ]
+cmp "${FAKE_FLASH}" "${FROM_IMAGE}"
+
+# The read stays in the updater's process group, so a signal to the group
+# (like Ctrl-C) stops it too. Afterwards nothing may be left reading the gate.
+echo "*** Test Item: Full update (background read, updater killed)"
+cp -f "${FROM_IMAGE}" "${FAKE_FLASH}"
+rm -f "${READ_GATE}" "${FAKE_FLASH}.read" "${FAKE_FLASH}.timeout"
+mkfifo "${READ_GATE}" "${READ_STARTED}"
+PATH="${FAKE_FLASHROM_DIR}:${PATH}" setsid "${FUTILITY}" update \
+	-i "${TO_IMAGE}" --wp=0 --sys_props 0,0x10001,1 >/dev/null 2>&1 &
+updater_pid=$!
+cat "${READ_STARTED}"
+kill -TERM -- "-${updater_pid}"
+wait "${updater_pid}" && exit 1
+timeout 1 sh -c ": >'${READ_GATE}'" && exit 1
+[ ! -e "${FAKE_FLASH}.read" ]
+cmp "${FAKE_FLASH}" "${FROM_IMAGE}"
+rm -f "${READ_GATE}" "${READ_STARTED}"
+
+# Test modelled flash time and operations of each update mode, to catch
+# updater changes that make flashing slower.
+test_flash_time() {
+	local test_name="$1"
+	local ms bytes blocks pages
+	local msg
+
+	read -r ms bytes blocks pages <<<"$2"
+	shift 2
+	cp -f "${FROM_IMAGE}" "${TMP}.emu"
+	echo "*** Test Item: ${test_name}"
+	msg="$("${FUTILITY}" update --emulate "${TMP}.emu" "$@" 2>&1)"
+	grep -qF "(emulation) Flash time: ${ms} ms (read ${bytes} bytes, \
+erased ${blocks} blocks, programmed ${pages} pages)." <<<"${msg}"
+}
+
+# Expected: <ms> <bytes read> <blocks erased> <pages programmed>
+test_flash_time "Flash time (Full update)" "54685 25165824 931 13987" \
+	-i "${TO_IMAGE}" --wp=0 --sys_props 0,0x10001,1
+test_flash_time "Flash time (Full update, --fast)" "53685 16777216 931 13987" \
+	-i "${TO_IMAGE}" --wp=0 --sys_props 0,0x10001,1 --fast
+test_flash_time "Flash time (RW update)" "16847 16547840 267 4086" \
+	-i "${TO_IMAGE}" --wp=1 --sys_props 0,0x10001,1
+test_flash_time "Flash time (RW update, try)" "7868 10354688 119 1827" \
+	-i "${TO_IMAGE}" -t --wp=1 --sys_props 0,0x10001,1
+
 # Test quirks
 test_update "Full update (wrong size)" \
 	"${FROM_IMAGE}.large" "!Image size is different" \
@@ -359,9 +520,7 @@ test_update "Full update (--quirks no_check_platform)" \
 
 # Test archive and manifest.
 A="${TMP}.archive"
-mkdir -p "${A}/bin"
-echo 'echo "${WL_TAG}"' >"${A}/bin/vpd"
-chmod +x "${A}/bin/vpd"
+mkdir -p "${A}"
 
 cp -f "${LINK_BIOS}" "${A}/bios.bin"
 echo "TEST: Manifest (--manifest, bios.bin)"
@@ -409,16 +568,19 @@ test_update "Full update (--archive, WL, single package)" \
 	"${A}/image.bin" "${LINK_BIOS}" \
 	-a "${A}" --wp=0 --sys_props 0,0x10001,1,3 --signature_id=WL
 
-WL_TAG="WL" PATH="${A}/bin:${PATH}" \
-	test_update "Full update (--archive, WL, fake vpd)" \
-	"${A}/image.bin" "${LINK_BIOS}" \
+# RO_VPD is preserved, so the expected image has the same VPD.
+cp -f "${A}/image.bin" "${TMP}.wl_from"
+cp -f "${LINK_BIOS}" "${TMP}.wl_expected"
+set_wl_tag "${TMP}.wl_from" "WL"
+set_wl_tag "${TMP}.wl_expected" "WL"
+test_update "Full update (--archive, WL, VPD)" \
+	"${TMP}.wl_from" "${TMP}.wl_expected" \
 	-a "${A}" --wp=0 --sys_props 0,0x10001,1,3
 
 echo "TEST: Output (-a, --mode=output)"
 mkdir -p "${TMP}.outa"
-cp -f "${A}/image.bin" "${TMP}.emu"
-WL_TAG="WL" PATH="${A}/bin:${PATH}" \
-	${FUTILITY} update -a "${A}" --mode=output --emu="${TMP}.emu" \
+cp -f "${TMP}.wl_from" "${TMP}.emu"
+${FUTILITY} update -a "${A}" --mode=output --emu="${TMP}.emu" \
 	--output_dir="${TMP}.outa"
 cmp "${LINK_BIOS}" "${TMP}.outa/image.bin"
 
@@ -449,9 +611,12 @@ test_update "Full update (--archive, model=whitetip, signature_id=WL)" \
 	-a "${A}" --wp=0 --sys_props 0,0x10001,1,3 --model=whitetip \
 	--signature_id=whitetip-wl
 
-WL_TAG="wl" PATH="${A}/bin:${PATH}" \
-	test_update "Full update (-a, model=WL, fake VPD)" \
-	"${FROM_IMAGE}.al" "${LINK_BIOS}" \
+cp -f "${FROM_IMAGE}.al" "${TMP}.wl_from"
+cp -f "${LINK_BIOS}" "${TMP}.wl_expected"
+set_wl_tag "${TMP}.wl_from" "wl"
+set_wl_tag "${TMP}.wl_expected" "wl"
+test_update "Full update (-a, model=WL, VPD)" \
+	"${TMP}.wl_from" "${TMP}.wl_expected" \
 	-a "${A}" --wp=0 --sys_props 0,0x10001,1,3 --model=whitetip
 
 # WL-Unibuild without default keys
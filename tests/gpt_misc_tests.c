@@ -8,6 +8,7 @@
 #include "2api.h"
 #include "cgptlib.h"
 #include "cgptlib_internal.h"
+#include "crc32.h"
 #include "gpt.h"
 #include "test_common.h"
 
@@ -129,6 +130,7 @@ static void ReadWriteGptTest(void)
 
 	g.sector_bytes = MOCK_SECTOR_SIZE;
 	g.streaming_drive_sectors = g.gpt_drive_sectors = MOCK_SECTOR_COUNT;
+	g.flags = 0;
 	g.valid_headers = g.valid_entries = MASK_BOTH;
 
 	ResetMocks();
@@ -370,9 +372,179 @@ static void ReadWriteGptTest(void)
 
 }
 
+/**
+ * Make the entries CRCs in the mock disk headers match the entries.
+ */
+static void SetupGptEntriesCrc(void)
+{
+	GptHeader *h;
+
+	h = mock_gpt_primary;
+	h->entries_crc32 = Crc32(&mock_disk[MOCK_SECTOR_SIZE * h->entries_lba],
+				 h->number_of_entries * h->size_of_entry);
+	h->header_crc32 = HeaderCrc(h);
+
+	h = mock_gpt_secondary;
+	h->entries_crc32 = Crc32(&mock_disk[MOCK_SECTOR_SIZE * h->entries_lba],
+				 h->number_of_entries * h->size_of_entry);
+	h->header_crc32 = HeaderCrc(h);
+}
+
+static void ResetLazyGptData(GptData *g, uint32_t flags)
+{
+	memset(g, 0, sizeof(*g));
+	g->sector_bytes = MOCK_SECTOR_SIZE;
+	g->streaming_drive_sectors = g->gpt_drive_sectors = MOCK_SECTOR_COUNT;
+	g->flags = flags;
+}
+
+/**
+ * Test deferring the secondary GPT
+ */
+static void LazySecondaryTest(void)
+{
+	GptData g;
+
+	/* Good primary GPT is all that gets read */
+	ResetMocks();
+	SetupGptEntriesCrc();
+	ResetLazyGptData(&g, GPT_FLAG_LAZY_SECONDARY);
+	TEST_EQ(AllocAndReadGptData(handle, &g), 0, "Lazy AllocAndRead");
+	TEST_CALLS("VbExDiskRead(h, 1, 1)\n"
+		   "VbExDiskRead(h, 2, 32)\n");
+	TEST_EQ(g.deferred, MASK_SECONDARY, "  secondary deferred");
+	TEST_EQ(GptInit(&g), GPT_SUCCESS, "  GptInit");
+	TEST_EQ(g.modified, 0, "  nothing to repair");
+	TEST_EQ(CheckHeader((GptHeader *)g.secondary_header, 1,
+			    g.streaming_drive_sectors, g.gpt_drive_sectors, 0,
+			    g.sector_bytes),
+		0, "  secondary header made up in memory");
+	ResetCallLog();
+	TEST_EQ(WriteAndFreeGptData(handle, &g), 0, "  WriteAndFree");
+	TEST_CALLS("");
+
+	/* Without the flag, both copies are read */
+	ResetMocks();
+	SetupGptEntriesCrc();
+	ResetLazyGptData(&g, 0);
+	TEST_EQ(AllocAndReadGptData(handle, &g), 0, "Eager AllocAndRead");
+	TEST_CALLS("VbExDiskRead(h, 1, 1)\n"
+		   "VbExDiskRead(h, 2, 32)\n"
+		   "VbExDiskRead(h, 1023, 1)\n"
+		   "VbExDiskRead(h, 991, 32)\n");
+	TEST_EQ(g.deferred, 0, "  nothing deferred");
+	WriteAndFreeGptData(handle, &g);
+
+	/* Modified GPT checks the secondary header, then writes both */
+	ResetMocks();
+	SetupGptEntriesCrc();
+	ResetLazyGptData(&g, GPT_FLAG_LAZY_SECONDARY);
+	AllocAndReadGptData(handle, &g);
+	GptInit(&g);
+	SetEntryPriority((GptEntry *)g.primary_entries, 1);
+	GptModified(&g);
+	ResetCallLog();
+	TEST_EQ(WriteAndFreeGptData(handle, &g), 0, "Lazy modified");
+	TEST_CALLS("VbExDiskWrite(h, 1, 1)\n"
+		   "VbExDiskWrite(h, 2, 32)\n"
+		   "VbExDiskRead(h, 1023, 1)\n"
+		   "VbExDiskWrite(h, 1023, 1)\n"
+		   "VbExDiskWrite(h, 991, 32)\n");
+	TEST_EQ(CheckHeader(mock_gpt_secondary, 1, MOCK_SECTOR_COUNT,
+			    MOCK_SECTOR_COUNT, 0, MOCK_SECTOR_SIZE),
+		0, "  secondary header is valid");
+	TEST_EQ(CheckEntries((GptEntry *)&mock_disk[MOCK_SECTOR_SIZE * 991],
+			     mock_gpt_secondary),
+		0, "  secondary entries are valid");
+
+	/* Secondary GPT marked to be ignored is left alone */
+	ResetMocks();
+	SetupGptEntriesCrc();
+	memcpy(mock_gpt_secondary->signature, GPT_HEADER_SIGNATURE_IGNORED,
+	       GPT_HEADER_SIGNATURE_SIZE);
+	ResetLazyGptData(&g, GPT_FLAG_LAZY_SECONDARY);
+	AllocAndReadGptData(handle, &g);
+	GptInit(&g);
+	GptModified(&g);
+	ResetCallLog();
+	TEST_EQ(WriteAndFreeGptData(handle, &g), 0, "Lazy modified ignored");
+	TEST_CALLS("VbExDiskWrite(h, 1, 1)\n"
+		   "VbExDiskWrite(h, 2, 32)\n"
+		   "VbExDiskRead(h, 1023, 1)\n");
+
+	/* Bad primary header falls back to reading the secondary */
+	ResetMocks();
+	SetupGptEntriesCrc();
+	memset(mock_gpt_primary, 0, sizeof(*mock_gpt_primary));
+	ResetLazyGptData(&g, GPT_FLAG_LAZY_SECONDARY);
+	TEST_EQ(AllocAndReadGptData(handle, &g), 0, "Lazy primary invalid");
+	TEST_CALLS("VbExDiskRead(h, 1, 1)\n"
+		   "VbExDiskRead(h, 1023, 1)\n"
+		   "VbExDiskRead(h, 991, 32)\n");
+	TEST_EQ(g.deferred, 0, "  nothing deferred");
+	TEST_EQ(GptInit(&g), GPT_SUCCESS, "  GptInit");
+	TEST_EQ(g.modified, GPT_MODIFIED_HEADER1 | GPT_MODIFIED_ENTRIES1,
+		"  primary repaired");
+	WriteAndFreeGptData(handle, &g);
+
+	/* So do bad primary entries */
+	ResetMocks();
+	SetupGptEntriesCrc();
+	mock_disk[MOCK_SECTOR_SIZE * 2] ^= 1;
+	ResetLazyGptData(&g, GPT_FLAG_LAZY_SECONDARY);
+	TEST_EQ(AllocAndReadGptData(handle, &g), 0,
+		"Lazy primary entries invalid");
+	TEST_CALLS("VbExDiskRead(h, 1, 1)\n"
+		   "VbExDiskRead(h, 2, 32)\n"
+		   "VbExDiskRead(h, 1023, 1)\n"
+		   "VbExDiskRead(h, 991, 32)\n");
+	TEST_EQ(GptInit(&g), GPT_SUCCESS, "  GptInit");
+	TEST_EQ(g.modified, GPT_MODIFIED_ENTRIES1, "  primary repaired");
+	WriteAndFreeGptData(handle, &g);
+
+	/* And errors reading the primary entries */
+	ResetMocks();
+	SetupGptEntriesCrc();
+	disk_read_to_fail = 2;
+	ResetLazyGptData(&g, GPT_FLAG_LAZY_SECONDARY);
+	TEST_EQ(AllocAndReadGptData(handle, &g), 0,
+		"Lazy primary entries read error");
+	TEST_CALLS("VbExDiskRead(h, 1, 1)\n"
+		   "VbExDiskRead(h, 2, 32)\n"
+		   "VbExDiskRead(h, 1023, 1)\n"
+		   "VbExDiskRead(h, 991, 32)\n");
+	WriteAndFreeGptData(handle, &g);
+
+	/* A damaged secondary GPT is only repaired without the flag */
+	ResetMocks();
+	SetupGptEntriesCrc();
+	memset(mock_gpt_secondary, 0, sizeof(*mock_gpt_secondary));
+	ResetLazyGptData(&g, GPT_FLAG_LAZY_SECONDARY);
+	AllocAndReadGptData(handle, &g);
+	TEST_EQ(GptInit(&g), GPT_SUCCESS, "Lazy secondary invalid");
+	TEST_EQ(g.modified, 0, "  not repaired");
+	ResetCallLog();
+	WriteAndFreeGptData(handle, &g);
+	TEST_CALLS("");
+
+	ResetLazyGptData(&g, 0);
+	AllocAndReadGptData(handle, &g);
+	TEST_EQ(GptInit(&g), GPT_SUCCESS, "Eager secondary invalid");
+	TEST_EQ(g.modified, GPT_MODIFIED_HEADER2 | GPT_MODIFIED_ENTRIES2,
+		"  repaired");
+	ResetCallLog();
+	WriteAndFreeGptData(handle, &g);
+	TEST_CALLS("VbExDiskWrite(h, 1023, 1)\n"
+		   "VbExDiskWrite(h, 991, 32)\n");
+	TEST_EQ(CheckHeader(mock_gpt_secondary, 1, MOCK_SECTOR_COUNT,
+			    MOCK_SECTOR_COUNT, 0, MOCK_SECTOR_SIZE),
+		0, "  secondary header is valid");
+}
+
 int main(void)
 {
 	ReadWriteGptTest();
+	LazySecondaryTest();
 
 	return gTestSuccess ? 0 : 255;
 }
@@ -56,6 +56,21 @@ static void test_hmac_by_openssl(enum vb2_hash_algorithm alg,
 	TEST_SUCC(memcmp(mac, md, md_size), "HMAC digests match");
 }
 
+/* OpenSSL has no BLAKE3, so check against values computed elsewhere. */
+static void test_hmac_blake3(const void *key, uint32_t key_size,
+			     const void *msg, uint32_t msg_size,
+			     const uint8_t *expect)
+{
+	uint8_t mac[VB2_MAX_DIGEST_SIZE];
+	char test_name[256];
+
+	sprintf(test_name, "%s: HMAC-BLAKE3 (key_size=%d)", __func__, key_size);
+	TEST_SUCC(hmac(VB2_HASH_BLAKE3, key, key_size, msg, msg_size, mac,
+		       sizeof(mac)), test_name);
+	TEST_SUCC(memcmp(mac, expect, VB2_BLAKE3_DIGEST_SIZE),
+		  "HMAC digests match");
+}
+
 static void test_hmac_error(void)
 {
 	uint8_t mac[VB2_MAX_DIGEST_SIZE];
@@ -84,7 +99,28 @@ static void test_hmac(void)
 {
 	int alg;
 
+	const uint8_t blake3_short_key[] = {
+		0x37, 0x42, 0xda, 0x5c, 0x89, 0xb7, 0xc0, 0xc3,
+		0x76, 0xc0, 0xaf, 0x2f, 0x21, 0x1b, 0xd5, 0x9f,
+		0x97, 0xae, 0xaa, 0x28, 0x2f, 0x21, 0xdc, 0xcb,
+		0x0c, 0x03, 0x08, 0xb7, 0x70, 0x3a, 0xc9, 0x59,
+	};
+	const uint8_t blake3_long_key[] = {
+		0xc4, 0x96, 0x29, 0xc1, 0x67, 0x1a, 0x7e, 0x3a,
+		0x10, 0xf6, 0x81, 0x57, 0x80, 0xd1, 0xbc, 0xfb,
+		0xb9, 0xe7, 0x49, 0xaa, 0xff, 0x6b, 0x50, 0x37,
+		0x6b, 0x41, 0x92, 0x85, 0x03, 0x11, 0xd5, 0x06,
+	};
+	const uint8_t blake3_empty[] = {
+		0xc8, 0x36, 0x6b, 0x21, 0x2f, 0xa0, 0xd0, 0x95,
+		0xe9, 0x9d, 0x6f, 0xe8, 0x61, 0xbd, 0x55, 0x41,
+		0x87, 0x71, 0x49, 0x42, 0xaa, 0xb9, 0x2d, 0x9f,
+		0x02, 0xdb, 0xcc, 0xb9, 0xd8, 0x96, 0xe2, 0x19,
+	};
+
 	for (alg = 1; alg < VB2_HASH_ALG_COUNT; alg++) {
+		if (alg == VB2_HASH_BLAKE3)
+			continue;
 		/* Try short key */
 		test_hmac_by_openssl(alg, short_key, strlen(short_key),
 				     message, strlen(message));
@@ -94,6 +130,12 @@ static void test_hmac(void)
 		/* Try empty key and message */
 		test_hmac_by_openssl(alg, "", 0, "", 0);
 	}
+
+	test_hmac_blake3(short_key, strlen(short_key), message, strlen(message),
+			 blake3_short_key);
+	test_hmac_blake3(long_key, strlen(long_key), message, strlen(message),
+			 blake3_long_key);
+	test_hmac_blake3("", 0, "", 0, blake3_empty);
 }
 
 int main(void)
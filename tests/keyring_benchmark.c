@@ -0,0 +1,93 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Compare the cost of repeated signatures with a key loaded from disk for
+ * every signature against the same key held on the keyring.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "2common.h"
+#include "2sysincludes.h"
+#include "host_common.h"
+#include "host_keyring.h"
+#include "timer_utils.h"
+
+#define TEST_DATA_SIZE 4096
+#define NUM_SIGNATURES 200
+
+static const char *const key_names[] = {
+	"key_rsa2048.sha256.vbprivk",
+	"key_rsa4096.sha256.vbprivk",
+	"key_rsa8192.sha512.vbprivk",
+};
+
+static uint32_t time_signatures(const char *fname, const uint8_t *data,
+				int use_keyring)
+{
+	ClockTimerState ct;
+	struct vb2_private_key *fresh;
+	const struct vb2_private_key *key;
+	struct vb2_signature *sig;
+	int i;
+
+	vb2_keyring_clear();
+	StartTimer(&ct);
+	for (i = 0; i < NUM_SIGNATURES; i++) {
+		if (use_keyring) {
+			key = vb2_keyring_read_private_key(fname);
+			fresh = NULL;
+		} else {
+			key = fresh = vb2_read_private_key(fname);
+		}
+		if (!key) {
+			fprintf(stderr, "Unable to read %s\n", fname);
+			exit(1);
+		}
+		sig = vb2_calculate_signature(data, TEST_DATA_SIZE, key);
+		free(sig);
+		vb2_free_private_key(fresh);
+	}
+	StopTimer(&ct);
+	vb2_keyring_clear();
+
+	return GetDurationMsecs(&ct);
+}
+
+int main(int argc, char *argv[])
+{
+	char fname[1024];
+	uint8_t *data;
+	uint32_t msecs_read, msecs_keyring;
+	int i;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <keys_dir>\n", argv[0]);
+		return -1;
+	}
+
+	data = calloc(TEST_DATA_SIZE, 1);
+
+	for (i = 0; i < ARRAY_SIZE(key_names); i++) {
+		snprintf(fname, sizeof(fname), "%s/%s", argv[1], key_names[i]);
+
+		msecs_read = time_signatures(fname, data, 0);
+		msecs_keyring = time_signatures(fname, data, 1);
+
+		fprintf(stderr,
+			"# %s: %d signatures, read each time = %u ms, "
+			"keyring = %u ms\n",
+			key_names[i], NUM_SIGNATURES, msecs_read,
+			msecs_keyring);
+		fprintf(stdout, "usecs_per_sig_read_%s:%f\n", key_names[i],
+			msecs_read * 1000.0 / NUM_SIGNATURES);
+		fprintf(stdout, "usecs_per_sig_keyring_%s:%f\n", key_names[i],
+			msecs_keyring * 1000.0 / NUM_SIGNATURES);
+	}
+
+	free(data);
+	return 0;
+}
@@ -0,0 +1,131 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Compare RSA verification through vb2_rsa_verify_digest(), where callers
+ * which still need the signature afterwards must copy it first, against
+ * vb2_rsa_verify_digest_inplace(), which leaves the signature intact.
+ *
+ * This is built with -fno-builtin-memcpy, along with its own copy of the RSA
+ * code, and linked with --wrap=memcpy.  Every memcpy() made by the benchmark
+ * or by the RSA verification goes through a wrapper which counts the bytes.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "2common.h"
+#include "2packed_key.h"
+#include "2rsa.h"
+#include "2sha.h"
+#include "2sysincludes.h"
+#include "host_common.h"
+#include "timer_utils.h"
+
+#define NUM_VERIFIES 1000
+
+static uint64_t bytes_copied;
+
+void *__real_memcpy(void *dest, const void *src, size_t n);
+void *__wrap_memcpy(void *dest, const void *src, size_t n);
+
+void *__wrap_memcpy(void *dest, const void *src, size_t n)
+{
+	bytes_copied += n;
+	return __real_memcpy(dest, src, n);
+}
+
+static const char *const key_names[] = {
+	"key_rsa2048.sha256",
+	"key_rsa4096.sha256",
+	"key_rsa8192.sha512",
+};
+
+int main(int argc, char *argv[])
+{
+	uint8_t workbuf[VB2_VERIFY_DIGEST_WORKBUF_BYTES]
+		 __attribute__((aligned(VB2_WORKBUF_ALIGN)));
+	uint8_t sig_copy[8192 / 8];
+	uint8_t digest[VB2_MAX_DIGEST_SIZE];
+	uint8_t data[4096] = {0};
+	char fname[1024];
+	struct vb2_workbuf wb;
+	struct vb2_private_key *prik;
+	struct vb2_packed_key *pubk;
+	struct vb2_public_key key;
+	struct vb2_signature *sig;
+	ClockTimerState ct;
+	uint64_t copied;
+	uint32_t msecs;
+	int i, j;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <keys_dir>\n", argv[0]);
+		return -1;
+	}
+
+	vb2_workbuf_init(&wb, workbuf, sizeof(workbuf));
+
+	for (i = 0; i < ARRAY_SIZE(key_names); i++) {
+		snprintf(fname, sizeof(fname), "%s/%s.vbprivk",
+			 argv[1], key_names[i]);
+		prik = vb2_read_private_key(fname);
+		snprintf(fname, sizeof(fname), "%s/%s.vbpubk",
+			 argv[1], key_names[i]);
+		pubk = vb2_read_packed_key(fname);
+		if (!prik || !pubk || vb2_unpack_key(&key, pubk)) {
+			fprintf(stderr, "Unable to read key %s\n",
+				key_names[i]);
+			return 1;
+		}
+
+		sig = vb2_calculate_signature(data, sizeof(data), prik);
+		vb2_digest_buffer(data, sizeof(data), key.hash_alg,
+				  digest, sizeof(digest));
+
+		/* Caller keeps its signature by verifying a copy */
+		bytes_copied = 0;
+		StartTimer(&ct);
+		for (j = 0; j < NUM_VERIFIES; j++) {
+			memcpy(sig_copy, vb2_signature_data(sig),
+			       sig->sig_size);
+			if (vb2_rsa_verify_digest(&key, sig_copy, digest, &wb))
+				return 1;
+		}
+		StopTimer(&ct);
+		copied = bytes_copied;
+		msecs = GetDurationMsecs(&ct);
+		fprintf(stderr, "# %s copy+verify: %u ms, %llu bytes copied\n",
+			key_names[i], msecs, (unsigned long long)copied);
+		fprintf(stdout, "usecs_per_verify_copy_%s:%f\n", key_names[i],
+			msecs * 1000.0 / NUM_VERIFIES);
+		fprintf(stdout, "bytes_copied_copy_%s:%llu\n", key_names[i],
+			(unsigned long long)copied);
+
+		/* Verify straight from the caller's buffer */
+		bytes_copied = 0;
+		StartTimer(&ct);
+		for (j = 0; j < NUM_VERIFIES; j++) {
+			if (vb2_rsa_verify_digest_inplace(
+				    &key, vb2_signature_data(sig), digest,
+				    workbuf, sizeof(workbuf)))
+				return 1;
+		}
+		StopTimer(&ct);
+		copied = bytes_copied;
+		msecs = GetDurationMsecs(&ct);
+		fprintf(stderr, "# %s in place: %u ms, %llu bytes copied\n",
+			key_names[i], msecs, (unsigned long long)copied);
+		fprintf(stdout, "usecs_per_verify_inplace_%s:%f\n",
+			key_names[i], msecs * 1000.0 / NUM_VERIFIES);
+		fprintf(stdout, "bytes_copied_inplace_%s:%llu\n", key_names[i],
+			(unsigned long long)copied);
+
+		free(sig);
+		free(pubk);
+		vb2_free_private_key(prik);
+	}
+
+	return 0;
+}
@@ -336,6 +336,36 @@ $CGPT create $MTD ${DEV}
 $CGPT legacy $MTD -p ${DEV}
 run_prioritize_tests 2>/dev/null
 
+echo "Test cgpt zero command..."
+$CGPT create $MTD ${DEV}
+$CGPT add $MTD -b ${KERN_START} -s ${KERN_SIZE} -t kernel -i 2 ${DEV}
+$CGPT add $MTD -b ${ROOTFS_START} -s ${ROOTFS_SIZE} -t rootfs -i 3 ${DEV}
+assert_fail $CGPT zero $MTD ${DEV}
+assert_fail $CGPT zero $MTD -i 1 ${DEV}
+if [ -z "$MTD" ]; then
+  # Fill everything between the GPTs with 0xff so zeroing can be seen.
+  tr '\000' '\377' < /dev/zero | dd of=${DEV} bs=512 seek=34 \
+    count=$((NUM_SECTORS - 67)) conv=notrunc iflag=fullblock 2>/dev/null
+  count_ff() {
+    dd if=${DEV} bs=512 skip=$1 count=$2 2>/dev/null | tr -d '\000' | wc -c
+  }
+  count_zero() {
+    dd if=${DEV} bs=512 skip=$1 count=$2 2>/dev/null | tr -d '\377' | wc -c
+  }
+  $CGPT zero -i 2 ${DEV}
+  [ "$(count_ff ${KERN_START} ${KERN_SIZE})" = "0" ] || error
+  [ "$(count_zero $((KERN_START - 1)) 1)" = "0" ] || error
+  [ "$(count_zero $((KERN_START + KERN_SIZE)) 1)" = "0" ] || error
+  [ "$(count_zero ${ROOTFS_START} ${ROOTFS_SIZE})" = "0" ] || error
+  $CGPT zero -d -i 3 ${DEV}
+  [ "$(count_ff ${ROOTFS_START} ${ROOTFS_SIZE})" = "0" ] || error
+  [ "$(count_zero $((ROOTFS_START + ROOTFS_SIZE)) 1)" = "0" ] || error
+  ($CGPT show $MTD ${DEV} | grep -q INVALID) && error
+else
+  # Partitions aren't on the drive holding the GPT.
+  assert_fail $CGPT zero $MTD -i 2 ${DEV}
+fi
+
 # Now make sure that we don't need write access if we're just looking.
 echo "Test read vs read-write access..."
 chmod 0444 ${DEV}
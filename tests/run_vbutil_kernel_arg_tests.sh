@@ -191,6 +191,89 @@ else
   echo -e "${COL_GREEN}PASSED${COL_STOP}"
 fi
 
+# Pack the A/B and recovery variants of one kernel in a single batch, and make
+# sure each one comes out the same as packing it on its own.
+CONFIG_B="${TMPDIR}/config_b.txt"
+echo "$(cat "${CONFIG}") cros_b" > "${CONFIG_B}"
+BATCH_LIST="${TMPDIR}/batch.list"
+cat > "${BATCH_LIST}" <<EOF
+# outfile keyblock signprivate config
+${TMPDIR}/batch_a.bin
+${TMPDIR}/batch_b.bin - - ${CONFIG_B}
+${TMPDIR}/batch_rec.bin ${USB_KEYBLOCK} ${USB_SIGNPRIVATE}
+EOF
+
+pack_serial() {
+  "${FUTILITY}" vbutil_kernel \
+    --pack "$1" \
+    --keyblock "$2" \
+    --signprivate "$3" \
+    --config "$4" \
+    --version 1 \
+    --bootloader "${SMALL}" \
+    --vmlinuz "${BIG}" \
+    --arch arm >/dev/null
+}
+pack_serial "${TMPDIR}/serial_a.bin" "${SSD_KEYBLOCK}" "${SSD_SIGNPRIVATE}" \
+  "${CONFIG}"
+pack_serial "${TMPDIR}/serial_b.bin" "${SSD_KEYBLOCK}" "${SSD_SIGNPRIVATE}" \
+  "${CONFIG_B}"
+pack_serial "${TMPDIR}/serial_rec.bin" "${USB_KEYBLOCK}" "${USB_SIGNPRIVATE}" \
+  "${CONFIG}"
+
+echo -n "pack batch ... "
+: $(( tests++ ))
+if "${FUTILITY}" vbutil_kernel \
+  --pack-batch "${BATCH_LIST}" \
+  --jobs 3 \
+  --keyblock "${SSD_KEYBLOCK}" \
+  --signprivate "${SSD_SIGNPRIVATE}" \
+  --config "${CONFIG}" \
+  --version 1 \
+  --bootloader "${SMALL}" \
+  --vmlinuz "${BIG}" \
+  --arch arm >/dev/null; then
+  echo -e "${COL_GREEN}PASSED${COL_STOP}"
+else
+  echo -e "${COL_RED}FAILED${COL_STOP}"
+  : $(( errs++ ))
+fi
+
+for v in a b rec; do
+  echo -n "compare batch_${v}.bin ... "
+  : $(( tests++ ))
+  if cmp "${TMPDIR}/serial_${v}.bin" "${TMPDIR}/batch_${v}.bin"; then
+    echo -e "${COL_GREEN}PASSED${COL_STOP}"
+  else
+    echo -e "${COL_RED}FAILED${COL_STOP}"
+    : $(( errs++ ))
+  fi
+done
+
+# A bad entry makes the batch fail, but the other kernels are still packed.
+rm -f "${TMPDIR}/batch_a.bin"
+echo "${TMPDIR}/batch_bad.bin - ${TMPDIR}/nonexistent.vbprivk" \
+  >> "${BATCH_LIST}"
+echo -n "pack batch with bad key ... "
+: $(( tests++ ))
+if "${FUTILITY}" vbutil_kernel \
+  --pack-batch "${BATCH_LIST}" \
+  --keyblock "${SSD_KEYBLOCK}" \
+  --signprivate "${SSD_SIGNPRIVATE}" \
+  --config "${CONFIG}" \
+  --version 1 \
+  --bootloader "${SMALL}" \
+  --vmlinuz "${BIG}" \
+  --arch arm >/dev/null 2>&1; then
+  echo -e "${COL_RED}FAILED${COL_STOP}"
+  : $(( errs++ ))
+elif ! cmp "${TMPDIR}/serial_a.bin" "${TMPDIR}/batch_a.bin"; then
+  echo -e "${COL_RED}FAILED${COL_STOP}"
+  : $(( errs++ ))
+else
+  echo -e "${COL_GREEN}PASSED${COL_STOP}"
+fi
+
 # Summary
 ME=$(basename "$0")
 if [ "$errs" -ne 0 ]; then
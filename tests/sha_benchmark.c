@@ -6,7 +6,11 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef ARMV8_SHA_EXT
+#include <sys/auxv.h>
+#endif
 
+#include "2api.h"
 #include "2common.h"
 #include "2sha.h"
 #include "2sysincludes.h"
@@ -15,12 +19,19 @@
 
 #define TEST_BUFFER_SIZE 4000000
 
+#if defined(ARMV8_SHA_EXT) && !defined(HWCAP_SHA2)
+#define HWCAP_SHA2 (1 << 6)
+#endif
+
 int main(int argc, char *argv[]) {
 	int i;
 	double speed;
 	uint32_t msecs;
 	uint8_t *buffer = malloc(TEST_BUFFER_SIZE);
 	uint8_t digest[VB2_MAX_DIGEST_SIZE];
+	uint8_t expect[VB2_SHA256_DIGEST_SIZE];
+	int hwcrypto = 1;
+	int rv = 0;
 	ClockTimerState ct;
 
 	/* Iterate through all the hash functions. */
@@ -41,6 +52,41 @@ int main(int argc, char *argv[]) {
 			vb2_get_hash_algorithm_name(i), speed);
 	}
 
+#ifdef ARMV8_SHA_EXT
+	/* The ARMv8 implementation would take SIGILL on this CPU */
+	if (!(getauxval(AT_HWCAP) & HWCAP_SHA2)) {
+		fprintf(stderr, "# ARMv8 SHA-256 instructions not supported, "
+			"skipping hwcrypto\n");
+		hwcrypto = 0;
+	}
+#endif
+
+	/* SHA-256 through the hwcrypto interface, if this build provides it */
+	if (hwcrypto &&
+	    vb2ex_hwcrypto_digest_init(VB2_HASH_SHA256, TEST_BUFFER_SIZE) ==
+	    VB2_SUCCESS) {
+		StartTimer(&ct);
+		vb2ex_hwcrypto_digest_extend(buffer, TEST_BUFFER_SIZE);
+		vb2ex_hwcrypto_digest_finalize(digest, VB2_SHA256_DIGEST_SIZE);
+		StopTimer(&ct);
+
+		msecs = GetDurationMsecs(&ct);
+		speed = ((TEST_BUFFER_SIZE / 10e6)
+			 / (msecs / 10e3)); /* Mbytes/sec */
+
+		fprintf(stderr,
+			"# SHA256 hwcrypto Time taken = %u ms, "
+			"Speed = %f Mbytes/sec\n", msecs, speed);
+		fprintf(stdout, "mbytes_per_sec_SHA256_hwcrypto:%f\n", speed);
+
+		vb2_digest_buffer(buffer, TEST_BUFFER_SIZE, VB2_HASH_SHA256,
+				  expect, sizeof(expect));
+		if (memcmp(digest, expect, sizeof(expect))) {
+			fprintf(stderr, "# SHA256 hwcrypto digest mismatch\n");
+			rv = 1;
+		}
+	}
+
 	free(buffer);
-	return 0;
+	return rv;
 }
@@ -0,0 +1,170 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for asynchronous TPM commands in the host stub, against a fake TPM
+ * device node (a pseudo-terminal) which answers after a fixed delay.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "2api.h"
+#include "test_common.h"
+#include "tlcl.h"
+#include "tlcl_internal.h"
+
+/* How long the fake TPM takes to answer each command */
+#define LATENCY_MS 300
+
+static pid_t fake_tpm_pid = -1;
+
+static long now_ms(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000L + tv.tv_usec / 1000;
+}
+
+/*
+ * Answer each command after LATENCY_MS, with the command's ordinal as the
+ * return code so that tests can match responses to requests.
+ */
+static void fake_tpm(int master)
+{
+	uint8_t buf[TPM_MAX_COMMAND_SIZE];
+	uint32_t ordinal;
+
+	for (;;) {
+		if (read(master, buf, sizeof(buf)) < 10)
+			_exit(0);
+		FromTpmUint32(buf + 6, &ordinal);
+		usleep(LATENCY_MS * 1000);
+		ToTpmUint16(buf, TPM_TAG_RSP_COMMAND);
+		ToTpmUint32(buf + 2, 10);
+		ToTpmUint32(buf + 6, ordinal);
+		if (write(master, buf, 10) != 10)
+			_exit(1);
+	}
+}
+
+static int start_fake_tpm(void)
+{
+	struct termios tio;
+	int master;
+
+	master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master < 0 || grantpt(master) || unlockpt(master))
+		return -1;
+
+	/* Pass bytes through untouched, like a TPM character device. */
+	if (tcgetattr(master, &tio))
+		return -1;
+	cfmakeraw(&tio);
+	if (tcsetattr(master, TCSANOW, &tio))
+		return -1;
+
+	setenv("TPM_DEVICE_PATH", ptsname(master), 1);
+	setenv("TPM_NO_EXIT", "1", 1);
+
+	fake_tpm_pid = fork();
+	if (fake_tpm_pid < 0)
+		return -1;
+	if (!fake_tpm_pid)
+		fake_tpm(master);
+	close(master);
+	return 0;
+}
+
+static void stop_fake_tpm(void)
+{
+	if (fake_tpm_pid > 0) {
+		kill(fake_tpm_pid, SIGTERM);
+		waitpid(fake_tpm_pid, NULL, 0);
+	}
+}
+
+static void make_command(uint8_t *cmd, uint32_t ordinal)
+{
+	memset(cmd, 0, 10);
+	ToTpmUint16(cmd, TPM_TAG_RQU_COMMAND);
+	ToTpmUint32(cmd + 2, 10);
+	ToTpmUint32(cmd + 6, ordinal);
+}
+
+static void async_tests(void)
+{
+	uint8_t cmd[10], cmd2[10], rsp[TPM_MAX_COMMAND_SIZE];
+	uint32_t rsp_size;
+	long start;
+
+	make_command(cmd, 0x11);
+	make_command(cmd2, 0x22);
+
+	TEST_SUCC(vb2ex_tpm_init(), "Open fake TPM");
+	TEST_EQ(TlclPollFd(), -1, "No poll fd when idle");
+	TEST_EQ(TlclPoll(0), 0, "Nothing to poll when idle");
+
+	/* Submitting must not wait for the TPM. */
+	start = now_ms();
+	TEST_SUCC(TlclSubmit(cmd), "Submit");
+	TEST_TRUE(now_ms() - start < LATENCY_MS / 2, "  returns at once");
+	TEST_TRUE(TlclPollFd() >= 0, "  poll fd");
+	TEST_EQ(TlclPoll(0), 0, "  not ready yet");
+	TEST_EQ(TlclSubmit(cmd2), TPM_E_INTERNAL_INCONSISTENCY,
+		"  second submit refused");
+	rsp_size = sizeof(rsp);
+	TEST_EQ(vb2ex_tpm_send_recv(cmd2, 10, rsp, &rsp_size),
+		TPM_E_INTERNAL_INCONSISTENCY, "  send/receive refused");
+	TEST_EQ(TlclPoll(-1), 1, "  poll until ready");
+	TEST_TRUE(now_ms() - start >= LATENCY_MS - 50, "  after the latency");
+	TEST_EQ(TlclCollect(rsp, sizeof(rsp)), 0x11, "Collect");
+	TEST_EQ(TlclPollFd(), -1, "  idle again");
+
+	/* Work done between submit and collect overlaps the TPM. */
+	start = now_ms();
+	TEST_SUCC(TlclSubmit(cmd2), "Submit and work");
+	usleep(LATENCY_MS * 1000);
+	TEST_EQ(TlclCollect(rsp, sizeof(rsp)), 0x22, "  collect");
+	TEST_TRUE(now_ms() - start < LATENCY_MS * 3 / 2, "  overlapped");
+
+	/* Collect waits for the response itself. */
+	start = now_ms();
+	TEST_SUCC(TlclSubmit(cmd), "Submit and collect");
+	TEST_EQ(TlclCollect(rsp, sizeof(rsp)), 0x11, "  collect");
+	TEST_TRUE(now_ms() - start >= LATENCY_MS - 50, "  waited");
+
+	TEST_EQ(TlclCollect(rsp, sizeof(rsp)), TPM_E_INTERNAL_INCONSISTENCY,
+		"Collect with nothing in flight");
+
+	/* The blocking path still works afterwards. */
+	TEST_EQ(TlclSendReceive(cmd2, rsp, sizeof(rsp)), 0x22,
+		"Send/receive after async");
+
+	/* Closing the device drops an unfinished request. */
+	TEST_SUCC(TlclSubmit(cmd), "Submit then close");
+	TEST_SUCC(vb2ex_tpm_close(), "  close");
+	TEST_EQ(TlclPollFd(), -1, "  nothing in flight");
+}
+
+int main(void)
+{
+	if (start_fake_tpm()) {
+		fprintf(stderr, "Can't create fake TPM: %s\n", strerror(errno));
+		return 255;
+	}
+
+	async_tests();
+
+	stop_fake_tpm();
+	return gTestSuccess ? 0 : 255;
+}
@@ -11,6 +11,7 @@
 #include <string.h>
 
 #include "2api.h"
+#include "2common.h"
 #include "host_common.h"
 #include "test_common.h"
 #include "tlcl.h"
@@ -28,6 +29,7 @@ struct srcall
 	uint8_t rsp_buf[32];  /* Default response buffer, if not overridden */
 	int req_size;  /* Request size */
 	uint32_t req_cmd;  /* Request command code */
+	uint8_t req_head[32];  /* Start of request, before the response lands */
 	int rsp_size;  /* Response size */
 	vb2_error_t retval;  /* Value to return */
 };
@@ -52,6 +54,7 @@ static void ResetMocks(void)
 	ncalls = 0;
 }
 
+#ifndef TPM2_MODE
 /**
  * Set response code and length for call <call_idx>.
  */
@@ -62,6 +65,7 @@ static void SetResponse(int call_idx, uint32_t response_code, int rsp_size)
 	c->rsp_size = rsp_size;
 	ToTpmUint32(c->rsp_buf + 6, response_code);
 }
+#endif
 
 /* Mocks */
 
@@ -85,6 +89,8 @@ uint32_t vb2ex_tpm_send_recv(const uint8_t *request, uint32_t request_length,
 
 	/* Parse out the command code */
 	FromTpmUint32(request + 6, &c->req_cmd);
+	memcpy(c->req_head, request,
+	       VB2_MIN(request_length, sizeof(c->req_head)));
 
 	// KLUDGE - remove
 	printf("TSR [%d] %#x\n", ncalls-1, c->req_cmd);
@@ -97,12 +103,47 @@ uint32_t vb2ex_tpm_send_recv(const uint8_t *request, uint32_t request_length,
 	return c->retval;
 }
 
+uint32_t vb2ex_tpm_submit(const uint8_t *request, uint32_t request_length)
+{
+	struct srcall *c = calls + ncalls;
+
+	c->req = request;
+	c->req_size = request_length;
+	FromTpmUint32(request + 6, &c->req_cmd);
+
+	return c->retval;
+}
+
+int vb2ex_tpm_poll_fd(void)
+{
+	return -1;
+}
+
+int vb2ex_tpm_poll(int timeout_ms)
+{
+	return 1;
+}
+
+uint32_t vb2ex_tpm_collect(uint8_t *response, uint32_t *response_length)
+{
+	struct srcall *c = calls + ncalls++;
+
+	memset(response, 0, *response_length);
+	if (c->rsp_size)
+		memcpy(response, c->rsp, c->rsp_size);
+	*response_length = c->rsp_size;
+
+	return c->retval;
+}
+
 vb2_error_t vb2ex_tpm_get_random(uint8_t *buf, uint32_t length)
 {
 	memset(buf, 0xa5, length);
 	return VB2_SUCCESS;
 }
 
+#ifndef TPM2_MODE
+
 /**
  * Test assorted tlcl functions
  */
@@ -146,6 +187,27 @@ static void TlclTest(void)
 	TEST_EQ(TlclSendReceive(buf, buf2, sizeof(buf2)), 123,
 		"SendReceive error response");
 
+	ResetMocks();
+	ToTpmUint32(buf + 2, 10);
+	TEST_EQ(TlclSubmit(buf), 0, "Submit");
+	TEST_PTR_EQ(calls[0].req, buf, "Submit req ptr");
+	TEST_EQ(calls[0].req_size, 10, "Submit size");
+	SetResponse(0, 123, 10);
+	TEST_EQ(TlclCollect(buf2, sizeof(buf2)), 123,
+		"Collect error response");
+	TEST_EQ(ncalls, 1, "  one call");
+
+	ResetMocks();
+	calls[0].retval = VB2_ERROR_MOCK;
+	ToTpmUint32(buf + 2, 10);
+	TEST_EQ(TlclSubmit(buf), VB2_ERROR_MOCK, "Submit fail");
+
+	ResetMocks();
+	calls[0].retval = VB2_ERROR_MOCK;
+	SetResponse(0, 123, 10);
+	TEST_EQ(TlclCollect(buf2, sizeof(buf2)), VB2_ERROR_MOCK,
+		"Collect fail");
+
 	// TODO: continue self test (if needed or doing)
 	// TODO: then retry doing self test
 
@@ -469,6 +531,63 @@ static void PcrTest(void)
 	TEST_EQ(calls[0].req_cmd, TPM_ORD_Extend, "  cmd");
 }
 
+/**
+ * Test TlclPCRReadMultiple
+ */
+static void PcrReadMultipleTest(void)
+{
+	uint8_t buf[3 * kPcrDigestLength];
+	uint32_t digest_size = 0;
+	uint32_t index;
+	int i;
+
+	ResetMocks();
+	for (i = 0; i < 3; i++) {
+		SetResponse(i, 0, kTpmResponseHeaderLength + kPcrDigestLength);
+		memset(calls[i].rsp_buf + kTpmResponseHeaderLength, 0x10 + i,
+		       kPcrDigestLength);
+	}
+	TEST_EQ(TlclPCRReadMultiple(0x80000005, TPM_ALG_SHA1, buf,
+				    sizeof(buf), &digest_size),
+		0, "PCRReadMultiple");
+	TEST_EQ(digest_size, kPcrDigestLength, "  digest size");
+	TEST_EQ(ncalls, 3, "  one command per PCR");
+	TEST_EQ(calls[1].req_cmd, TPM_ORD_PcrRead, "  cmd");
+	FromTpmUint32(calls[0].req_head + 10, &index);
+	TEST_EQ(index, 0, "  first index");
+	FromTpmUint32(calls[1].req_head + 10, &index);
+	TEST_EQ(index, 2, "  second index");
+	FromTpmUint32(calls[2].req_head + 10, &index);
+	TEST_EQ(index, 31, "  third index");
+	TEST_EQ(buf[0], 0x10, "  first digest");
+	TEST_EQ(buf[kPcrDigestLength], 0x11, "  second digest");
+	TEST_EQ(buf[3 * kPcrDigestLength - 1], 0x12, "  third digest");
+
+	ResetMocks();
+	TEST_EQ(TlclPCRReadMultiple(0, TPM_ALG_SHA1, buf, 0, &digest_size),
+		0, "PCRReadMultiple none");
+	TEST_EQ(ncalls, 0, "  no commands");
+
+	ResetMocks();
+	TEST_EQ(TlclPCRReadMultiple(0x7, TPM_ALG_SHA1, buf, sizeof(buf) - 1,
+				    &digest_size),
+		TPM_E_BUFFER_SIZE, "PCRReadMultiple too small");
+	TEST_EQ(ncalls, 0, "  no commands");
+
+	ResetMocks();
+	TEST_EQ(TlclPCRReadMultiple(0x1, 0x000b, buf, sizeof(buf),
+				    &digest_size),
+		TPM_E_BADINDEX, "PCRReadMultiple SHA-256 bank");
+
+	ResetMocks();
+	SetResponse(0, 0, kTpmResponseHeaderLength + kPcrDigestLength);
+	SetResponse(1, TPM_E_BADINDEX, kTpmResponseHeaderLength);
+	TEST_EQ(TlclPCRReadMultiple(0x7, TPM_ALG_SHA1, buf, sizeof(buf),
+				    &digest_size),
+		TPM_E_BADINDEX, "PCRReadMultiple error");
+	TEST_EQ(ncalls, 2, "  stops at the error");
+}
+
 /**
  * Test TlclGetSpaceInfo.
  */
@@ -1152,14 +1271,341 @@ static void ReadDelegationFamilyTableTest(void) {
 	ToTpmUint32(response + kTpmResponseHeaderLength, 0x1e);
 }
 
+#else  /* TPM2_MODE */
+
+/* Room for a GetCapability response holding MAX_TPM_PROPERTIES properties */
+static uint8_t cap_rsp[MAXCALLS][32 + 8 * MAX_TPM_PROPERTIES];
+
+/**
+ * Set call <call_idx> to return the <count> TPM properties in <props>.
+ */
+static void SetCapResponse(int call_idx, int more_data,
+			   const TPMS_TAGGED_PROPERTY *props, uint32_t count)
+{
+	struct srcall *c = calls + call_idx;
+	uint8_t *p = cap_rsp[call_idx];
+	uint32_t i;
+
+	c->rsp = p;
+	c->rsp_size = 19 + 8 * count;
+	ToTpmUint16(p, TPM_ST_NO_SESSIONS);
+	ToTpmUint32(p + 2, c->rsp_size);
+	ToTpmUint32(p + 6, TPM_SUCCESS);
+	p[10] = more_data;
+	ToTpmUint32(p + 11, TPM_CAP_TPM_PROPERTIES);
+	ToTpmUint32(p + 15, count);
+	for (i = 0; i < count; i++) {
+		ToTpmUint32(p + 19 + 8 * i, props[i].property);
+		ToTpmUint32(p + 23 + 8 * i, props[i].value);
+	}
+}
+
+/**
+ * Return GetCapability parameter <n> (capability, property, count) of call
+ * <call_idx>.
+ */
+static uint32_t CapParam(int call_idx, int n)
+{
+	uint32_t value;
+
+	FromTpmUint32(calls[call_idx].req_head + 10 + 4 * n, &value);
+	return value;
+}
+
+static const TPMS_TAGGED_PROPERTY version_props[] = {
+	{TPM_PT_MANUFACTURER, 0x4e4f4e45},
+	{TPM_PT_VENDOR_STRING_1, 0x41424344},
+	{TPM_PT_VENDOR_STRING_1 + 1, 0x45464700},
+	{TPM_PT_VENDOR_STRING_1 + 2, 0},
+	{TPM_PT_VENDOR_STRING_4, 0},
+	{TPM_PT_VENDOR_STRING_4 + 1, 0},
+	{TPM_PT_FIRMWARE_VERSION_1, 0x00010002},
+	{TPM_PT_FIRMWARE_VERSION_2, 0x00030004},
+};
+
+/**
+ * Test batched TPM property reads
+ */
+static void CapabilityTest(void)
+{
+	TPMS_TAGGED_PROPERTY props[3];
+	TPM_PERMANENT_FLAGS pflags;
+	TPM_STCLEAR_FLAGS vflags;
+	uint32_t vendor, value;
+	uint64_t firmware_version;
+	uint8_t vs[32];
+	size_t vs_size;
+
+	ResetMocks();
+	SetCapResponse(0, 0, version_props, ARRAY_SIZE(version_props));
+	vs_size = sizeof(vs);
+	TEST_EQ(TlclGetVersion(&vendor, &firmware_version, vs, &vs_size), 0,
+		"GetVersion");
+	TEST_EQ(ncalls, 1, "  one transaction");
+	TEST_EQ(calls[0].req_cmd, TPM2_GetCapability, "  cmd");
+	TEST_EQ(CapParam(0, 0), TPM_CAP_TPM_PROPERTIES, "  capability");
+	TEST_EQ(CapParam(0, 1), TPM_PT_MANUFACTURER, "  property");
+	TEST_EQ(CapParam(0, 2), ARRAY_SIZE(version_props), "  count");
+	TEST_EQ(vendor, 0x4e4f4e45, "  vendor");
+	TEST_TRUE(firmware_version == 0x0001000200030004ULL,
+		  "  firmware_version");
+	TEST_EQ(vs_size, 7, "  vendor specific size");
+	TEST_EQ(memcmp(vs, "ABCDEFG", 7), 0, "  vendor specific data");
+
+	ResetMocks();
+	SetCapResponse(0, 1, version_props, 3);
+	SetCapResponse(1, 0, version_props + 3, ARRAY_SIZE(version_props) - 3);
+	vs_size = sizeof(vs);
+	TEST_EQ(TlclGetVersion(&vendor, &firmware_version, vs, &vs_size), 0,
+		"GetVersion - split response");
+	TEST_EQ(ncalls, 2, "  two transactions");
+	TEST_EQ(CapParam(1, 1), TPM_PT_VENDOR_STRING_1 + 2, "  property");
+	TEST_EQ(CapParam(1, 2), ARRAY_SIZE(version_props) - 3, "  count");
+	TEST_TRUE(firmware_version == 0x0001000200030004ULL,
+		  "  firmware_version");
+	TEST_EQ(vs_size, 7, "  vendor specific size");
+
+	ResetMocks();
+	props[0] = version_props[0];
+	props[1] = version_props[6];
+	props[2] = version_props[7];
+	SetCapResponse(0, 0, props, 3);
+	vs_size = sizeof(vs);
+	TEST_EQ(TlclGetVersion(&vendor, &firmware_version, vs, &vs_size), 0,
+		"GetVersion - no vendor strings");
+	TEST_EQ(ncalls, 1, "  one transaction");
+	TEST_EQ(vs_size, 0, "  vendor specific size");
+
+	ResetMocks();
+	SetCapResponse(0, 0, version_props, 6);
+	TEST_EQ(TlclGetVersion(&vendor, &firmware_version, NULL, NULL),
+		TPM_E_IOERROR, "GetVersion - no firmware version");
+
+	ResetMocks();
+	props[0] = version_props[1];
+	props[1] = version_props[0];
+	SetCapResponse(0, 1, props, 2);
+	TEST_EQ(TlclGetVersion(&vendor, &firmware_version, NULL, NULL),
+		TPM_E_IOERROR, "GetVersion - out of order");
+
+	ResetMocks();
+	calls[0].retval = VB2_ERROR_MOCK;
+	TEST_EQ(TlclGetVersion(&vendor, &firmware_version, NULL, NULL),
+		VB2_ERROR_MOCK, "GetVersion - error");
+
+	ResetMocks();
+	props[0].property = TPM_PT_PERMANENT;
+	props[0].value = 0x12345678;
+	SetCapResponse(0, 0, props, 1);
+	TEST_EQ(TlclGetPermanentFlags(&pflags), 0, "GetPermanentFlags");
+	TEST_EQ(ncalls, 1, "  one transaction");
+	TEST_EQ(CapParam(0, 1), TPM_PT_PERMANENT, "  property");
+	TEST_EQ(CapParam(0, 2), 1, "  count");
+	memcpy(&value, &pflags, sizeof(value));
+	TEST_EQ(value, 0x12345678, "  flags");
+
+	ResetMocks();
+	props[0].property = TPM_PT_STARTUP_CLEAR;
+	props[0].value = 0x87654321;
+	SetCapResponse(0, 0, props, 1);
+	TEST_EQ(TlclGetSTClearFlags(&vflags), 0, "GetSTClearFlags");
+	TEST_EQ(CapParam(0, 1), TPM_PT_STARTUP_CLEAR, "  property");
+	memcpy(&value, &vflags, sizeof(value));
+	TEST_EQ(value, 0x87654321, "  flags");
+
+	ResetMocks();
+	SetCapResponse(0, 0, props, 1);
+	TEST_EQ(TlclGetPermanentFlags(&pflags), TPM_E_IOERROR,
+		"GetPermanentFlags - wrong property");
+
+	ResetMocks();
+	SetCapResponse(0, 0, props, 1);
+	TEST_EQ(TlclLibInit(), 0, "LibInit");
+	TEST_EQ(ncalls, 1, "  one transaction");
+	TEST_EQ(CapParam(0, 1), TPM_PT_STARTUP_CLEAR, "  property");
+}
+
+/* Room for a PCR_Read response filling the TPM buffer */
+static uint8_t pcr_rsp[MAXCALLS][TPM_BUFFER_SIZE];
+
+/**
+ * Set call <call_idx> to return the PCRs in <select> from <bank>, each
+ * <digest_size> bytes filled with its PCR index.
+ */
+static void SetPcrReadResponse(int call_idx, uint16_t bank, uint32_t select,
+			       uint16_t digest_size)
+{
+	struct srcall *c = calls + call_idx;
+	uint8_t *p = pcr_rsp[call_idx];
+	uint32_t count = 0;
+	int size = 28;
+	int i;
+
+	for (i = 0; i < 24; i++) {
+		if (!(select & (1 << i)))
+			continue;
+		ToTpmUint16(p + size, digest_size);
+		memset(p + size + 2, i, digest_size);
+		size += 2 + digest_size;
+		count++;
+	}
+
+	c->rsp = p;
+	c->rsp_size = size;
+	ToTpmUint16(p, TPM_ST_NO_SESSIONS);
+	ToTpmUint32(p + 2, size);
+	ToTpmUint32(p + 6, TPM_SUCCESS);
+	ToTpmUint32(p + 10, 0x42);  /* pcrUpdateCounter */
+	ToTpmUint32(p + 14, 1);
+	ToTpmUint16(p + 18, bank);
+	p[20] = 3;
+	p[21] = select;
+	p[22] = select >> 8;
+	p[23] = select >> 16;
+	ToTpmUint32(p + 24, count);
+}
+
+/**
+ * Return the PCR selection bitmap sent by call <call_idx>.
+ */
+static uint32_t PcrReadSelect(int call_idx)
+{
+	const uint8_t *p = calls[call_idx].req_head;
+
+	return p[17] | p[18] << 8 | p[19] << 16;
+}
+
+/**
+ * Test PCR reads
+ */
+static void PcrReadTest(void)
+{
+	uint8_t buf[24 * SHA256_DIGEST_SIZE];
+	uint32_t digest_size = 0;
+	uint16_t bank;
+	int i, ok;
+
+	ResetMocks();
+	SetPcrReadResponse(0, TPM_ALG_SHA256, 0x00003f, SHA256_DIGEST_SIZE);
+	SetPcrReadResponse(1, TPM_ALG_SHA256, 0x000fc0, SHA256_DIGEST_SIZE);
+	SetPcrReadResponse(2, TPM_ALG_SHA256, 0x03f000, SHA256_DIGEST_SIZE);
+	SetPcrReadResponse(3, TPM_ALG_SHA256, 0xfc0000, SHA256_DIGEST_SIZE);
+	TEST_EQ(TlclPCRReadMultiple(0xffffff, TPM_ALG_SHA256, buf, sizeof(buf),
+				    &digest_size),
+		0, "PCRReadMultiple SHA-256");
+	TEST_EQ(digest_size, SHA256_DIGEST_SIZE, "  digest size");
+	TEST_EQ(ncalls, 4, "  as many PCRs per command as fit");
+	TEST_EQ(calls[0].req_cmd, TPM2_PCR_Read, "  cmd");
+	FromTpmUint16(calls[0].req_head + 14, &bank);
+	TEST_EQ(bank, TPM_ALG_SHA256, "  bank");
+	TEST_EQ(calls[0].req_head[16], 3, "  selection size");
+	TEST_EQ(PcrReadSelect(0), 0x00003f, "  first selection");
+	TEST_EQ(PcrReadSelect(3), 0xfc0000, "  last selection");
+	for (i = 0, ok = 1; i < 24; i++)
+		ok &= buf[i * SHA256_DIGEST_SIZE] == i &&
+			buf[(i + 1) * SHA256_DIGEST_SIZE - 1] == i;
+	TEST_TRUE(ok, "  digests");
+
+	ResetMocks();
+	SetPcrReadResponse(0, TPM_ALG_SHA1, 0x0000ff, SHA1_DIGEST_SIZE);
+	SetPcrReadResponse(1, TPM_ALG_SHA1, 0x00ff00, SHA1_DIGEST_SIZE);
+	SetPcrReadResponse(2, TPM_ALG_SHA1, 0xff0000, SHA1_DIGEST_SIZE);
+	TEST_EQ(TlclPCRReadMultiple(0xffffff, TPM_ALG_SHA1, buf, sizeof(buf),
+				    &digest_size),
+		0, "PCRReadMultiple SHA-1");
+	TEST_EQ(digest_size, SHA1_DIGEST_SIZE, "  digest size");
+	TEST_EQ(ncalls, 3, "  eight PCRs per command");
+	TEST_EQ(PcrReadSelect(1), 0x00ff00, "  second selection");
+	for (i = 0, ok = 1; i < 24; i++)
+		ok &= buf[i * SHA1_DIGEST_SIZE] == i &&
+			buf[(i + 1) * SHA1_DIGEST_SIZE - 1] == i;
+	TEST_TRUE(ok, "  digests");
+
+	ResetMocks();
+	SetPcrReadResponse(0, TPM_ALG_SHA1, 0x00000f, SHA1_DIGEST_SIZE);
+	SetPcrReadResponse(1, TPM_ALG_SHA1, 0x000030, SHA1_DIGEST_SIZE);
+	TEST_EQ(TlclPCRReadMultiple(0x000033, TPM_ALG_SHA1, buf, sizeof(buf),
+				    &digest_size),
+		TPM_E_INVALID_RESPONSE, "PCRReadMultiple unrequested PCR");
+
+	ResetMocks();
+	SetPcrReadResponse(0, TPM_ALG_SHA1, 0x000003, SHA1_DIGEST_SIZE);
+	SetPcrReadResponse(1, TPM_ALG_SHA1, 0x800010, SHA1_DIGEST_SIZE);
+	TEST_EQ(TlclPCRReadMultiple(0x800013, TPM_ALG_SHA1, buf, sizeof(buf),
+				    &digest_size),
+		0, "PCRReadMultiple short response");
+	TEST_EQ(ncalls, 2, "  two commands");
+	TEST_EQ(PcrReadSelect(0), 0x800013, "  first selection");
+	TEST_EQ(PcrReadSelect(1), 0x800010, "  rest of selection");
+	TEST_EQ(buf[0], 0, "  PCR 0");
+	TEST_EQ(buf[SHA1_DIGEST_SIZE], 1, "  PCR 1");
+	TEST_EQ(buf[2 * SHA1_DIGEST_SIZE], 4, "  PCR 4");
+	TEST_EQ(buf[3 * SHA1_DIGEST_SIZE], 23, "  PCR 23");
+
+	ResetMocks();
+	SetPcrReadResponse(0, TPM_ALG_SHA256, 0, SHA256_DIGEST_SIZE);
+	TEST_EQ(TlclPCRReadMultiple(0x000001, TPM_ALG_SHA256, buf, sizeof(buf),
+				    &digest_size),
+		TPM_E_BADINDEX, "PCRReadMultiple nothing returned");
+
+	ResetMocks();
+	SetPcrReadResponse(0, TPM_ALG_SHA1, 0x000001, SHA1_DIGEST_SIZE);
+	TEST_EQ(TlclPCRReadMultiple(0x000001, TPM_ALG_SHA256, buf, sizeof(buf),
+				    &digest_size),
+		TPM_E_INVALID_RESPONSE, "PCRReadMultiple wrong bank");
+
+	ResetMocks();
+	SetPcrReadResponse(0, TPM_ALG_SHA256, 0x000001, SHA1_DIGEST_SIZE);
+	TEST_EQ(TlclPCRReadMultiple(0x000001, TPM_ALG_SHA256, buf, sizeof(buf),
+				    &digest_size),
+		TPM_E_INVALID_RESPONSE, "PCRReadMultiple wrong digest size");
+
+	ResetMocks();
+	SetPcrReadResponse(0, TPM_ALG_SHA256, 0x000003, SHA256_DIGEST_SIZE);
+	ToTpmUint32(pcr_rsp[0] + 24, 1);
+	TEST_EQ(TlclPCRReadMultiple(0x000003, TPM_ALG_SHA256, buf, sizeof(buf),
+				    &digest_size),
+		TPM_E_READ_FAILURE, "PCRReadMultiple digest count");
+
+	ResetMocks();
+	TEST_EQ(TlclPCRReadMultiple(0x000003, TPM_ALG_SHA256, buf,
+				    2 * SHA256_DIGEST_SIZE - 1, &digest_size),
+		TPM_E_BUFFER_SIZE, "PCRReadMultiple too small");
+	TEST_EQ(TlclPCRReadMultiple(0x1000000, TPM_ALG_SHA256, buf,
+				    sizeof(buf), &digest_size),
+		TPM_E_BADINDEX, "PCRReadMultiple PCR 24");
+	TEST_EQ(TlclPCRReadMultiple(0x000001, TPM_ALG_NULL, buf, sizeof(buf),
+				    &digest_size),
+		TPM_E_BADINDEX, "PCRReadMultiple unknown bank");
+	TEST_EQ(ncalls, 0, "  no commands");
+
+	ResetMocks();
+	SetPcrReadResponse(0, TPM_ALG_SHA256, 0x000008, SHA256_DIGEST_SIZE);
+	TEST_EQ(TlclPCRRead(3, buf, TPM_PCR_DIGEST), 0, "PCRRead");
+	TEST_EQ(ncalls, 1, "  one command");
+	TEST_EQ(PcrReadSelect(0), 0x000008, "  selection");
+	TEST_EQ(buf[TPM_PCR_DIGEST - 1], 3, "  digest");
+
+	ResetMocks();
+	TEST_EQ(TlclPCRRead(24, buf, TPM_PCR_DIGEST), TPM_E_BADINDEX,
+		"PCRRead bad index");
+}
+
+#endif  /* TPM2_MODE */
+
 int main(void)
 {
+#ifdef TPM2_MODE
+	CapabilityTest();
+	PcrReadTest();
+#else
 	TlclTest();
 	SendCommandTest();
 	ReadWriteTest();
 	DefineSpaceExTest();
 	InitNvAuthPolicyTest();
 	PcrTest();
+	PcrReadMultipleTest();
 	GetSpaceInfoTest();
 	FlagsTest();
 	RandomTest();
@@ -1168,6 +1614,7 @@ int main(void)
 	ReadPubekTest();
 	TakeOwnershipTest();
 	ReadDelegationFamilyTableTest();
+#endif
 
 	return gTestSuccess ? 0 : 255;
 }
@@ -126,6 +126,8 @@ static void reset_common_data(enum reset_type t)
 		kpre = (struct vb2_kernel_preamble *)
 			vb2_member_of(sd, sd->preamble_offset);
 		sdata = (uint8_t *)kpre + sizeof(*kpre);
+		kpre->header_version_minor = 0;
+		kpre->flags = 0;
 
 		sig = &kpre->body_signature;
 		sig->data_size = sizeof(kernel_data);
@@ -220,6 +222,28 @@ vb2_error_t vb2_verify_digest(const struct vb2_public_key *key,
 	return VB2_SUCCESS;
 }
 
+/*
+ * Re-sign the mock kernel body as a tree digest with chunks of
+ * (1 << chunk_shift) bytes.
+ */
+static void set_tree_body_signature(uint32_t chunk_shift)
+{
+	struct vb2_signature *sig = &kpre->body_signature;
+	struct vb2_workbuf wb;
+
+	kpre->header_version_minor = 2;
+	kpre->flags = chunk_shift << VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_SHIFT;
+	sig->sig_size = VB2_SHA256_DIGEST_SIZE;
+
+	vb2_workbuf_from_ctx(ctx, &wb);
+	TEST_SUCC(vb2_tree_digest((const uint8_t *)kernel_data,
+				  sizeof(kernel_data), 1 << chunk_shift,
+				  VB2_HASH_SHA256, 0,
+				  (uint8_t *)sig + sig->sig_offset,
+				  VB2_SHA256_DIGEST_SIZE, &wb),
+		  "tree digest of kernel data");
+}
+
 /* Tests */
 
 static void load_kernel_vblock_tests(void)
@@ -315,6 +339,36 @@ static void verify_kernel_data_tests(void)
 					  sizeof(kernel_data)),
 		VB2_ERROR_VDATA_VERIFY_DIGEST, "verify hash digest");
 	kernel_data[3] ^= 0xd0;
+
+	/* Tree-hashed body, 4KB chunks */
+	reset_common_data(FOR_PHASE2);
+	set_tree_body_signature(12);
+	TEST_SUCC(vb2api_verify_kernel_data(ctx, kernel_data,
+					    sizeof(kernel_data)),
+		  "verify tree data good");
+
+	reset_common_data(FOR_PHASE2);
+	set_tree_body_signature(12);
+	kernel_data[0x4004] ^= 0xd0;
+	TEST_EQ(vb2api_verify_kernel_data(ctx, kernel_data,
+					  sizeof(kernel_data)),
+		VB2_ERROR_VDATA_VERIFY_DIGEST, "verify tree last chunk");
+	kernel_data[0x4004] ^= 0xd0;
+
+	/* Flat signature doesn't verify as a tree digest */
+	reset_common_data(FOR_PHASE2);
+	kpre->header_version_minor = 2;
+	kpre->flags = 12 << VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_SHIFT;
+	TEST_EQ(vb2api_verify_kernel_data(ctx, kernel_data,
+					  sizeof(kernel_data)),
+		VB2_ERROR_VDATA_VERIFY_DIGEST, "verify tree flat signature");
+
+	/* Tree flag is ignored by old preambles */
+	reset_common_data(FOR_PHASE2);
+	kpre->flags = 12 << VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_SHIFT;
+	TEST_SUCC(vb2api_verify_kernel_data(ctx, kernel_data,
+					    sizeof(kernel_data)),
+		  "verify tree flag needs minor version 2");
 }
 
 static void phase3_tests(void)
@@ -18,6 +18,9 @@ vb2_error_t hwcrypto_modexp_return_value = VB2_SUCCESS;
 vb2_error_t vb2ex_hwcrypto_modexp(const struct vb2_public_key *key,
 				  uint8_t *inout,
 				  uint32_t *workbuf32, int exp) {
+	/* Scribble on the buffer, as the real thing would */
+	if (hwcrypto_modexp_return_value == VB2_SUCCESS)
+		memset(inout, 0x5a, key->arrsize * sizeof(uint32_t));
 	return hwcrypto_modexp_return_value;
 }
 
@@ -81,12 +84,17 @@ static void test_verify_digest(struct vb2_public_key *key) {
 	hwcrypto_modexp_return_value = VB2_SUCCESS;
 	TEST_NEQ(vb2_rsa_verify_digest(key, sig, test_message_sha1_hash, &wb),
 		VB2_SUCCESS, "vb2_rsa_verify_digest() hwcrypto modexp fails");
+	TEST_NEQ(memcmp(sig, signatures[0], sizeof(sig)), 0,
+		 "  hwcrypto modexp decrypts in place");
 
+	/* Unsupported hwcrypto needs no more workbuf than SW, and no copy */
 	memcpy(sig, signatures[0], sizeof(sig));
-	vb2_workbuf_init(&wb, workbuf, sizeof(workbuf));
+	vb2_workbuf_init(&wb, workbuf, sizeof(sig) * 3);
 	hwcrypto_modexp_return_value = VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
 	TEST_SUCC(vb2_rsa_verify_digest(key, sig, test_message_sha1_hash, &wb),
 		"vb2_rsa_verify_digest() hwcrypto modexp fallback to sw");
+	TEST_EQ(memcmp(sig, signatures[0], sizeof(sig)), 0,
+		"  signature left intact");
 	key->allow_hwcrypto = 0;
 
 	memcpy(sig, signatures[0], sizeof(sig));
@@ -122,6 +130,93 @@ static void test_verify_digest(struct vb2_public_key *key) {
 		VB2_ERROR_RSA_PADDING, "vb2_rsa_verify_digest() bad sig end");
 }
 
+/**
+ * Test vb2_rsa_verify_digest_inplace().
+ */
+static void test_verify_digest_inplace(struct vb2_public_key *key)
+{
+	uint8_t scratch[VB2_VERIFY_DIGEST_WORKBUF_BYTES]
+		 __attribute__((aligned(VB2_WORKBUF_ALIGN)));
+	uint8_t sig[RSA1024NUMBYTES];
+	uint32_t scratch_size = vb2_rsa_verify_scratch_size(key->sig_alg);
+	enum vb2_signature_algorithm orig_key_alg = key->sig_alg;
+	int unexpected_success;
+	int i;
+
+	TEST_EQ(scratch_size, 3 * RSA1024NUMBYTES,
+		"vb2_rsa_verify_scratch_size()");
+	TEST_EQ(vb2_rsa_verify_scratch_size(VB2_SIG_INVALID), 0,
+		"vb2_rsa_verify_scratch_size() bad alg");
+
+	memcpy(sig, signatures[0], sizeof(sig));
+	TEST_SUCC(vb2_rsa_verify_digest_inplace(key, sig,
+						test_message_sha1_hash,
+						scratch, scratch_size),
+		  "vb2_rsa_verify_digest_inplace() good");
+	TEST_EQ(memcmp(sig, signatures[0], sizeof(sig)), 0,
+		"  signature left intact");
+	TEST_SUCC(vb2_rsa_verify_digest_inplace(key, sig,
+						test_message_sha1_hash,
+						scratch, scratch_size),
+		  "  verifies again");
+
+	/* Verify straight from the test vectors; they are never copied */
+	unexpected_success = 0;
+	for (i = 1; i < sizeof(signatures) / sizeof(signatures[0]); i++) {
+		if (!vb2_rsa_verify_digest_inplace(key, signatures[i],
+						   test_message_sha1_hash,
+						   scratch, scratch_size)) {
+			fprintf(stderr,
+				"RSA Padding Test vector %d FAILED!\n", i);
+			unexpected_success++;
+		}
+	}
+	TEST_EQ(unexpected_success, 0, "  invalid sigs");
+
+	/* Hardware modexp is never used in place */
+	key->allow_hwcrypto = 1;
+	hwcrypto_modexp_return_value = VB2_SUCCESS;
+	TEST_SUCC(vb2_rsa_verify_digest_inplace(key, sig,
+						test_message_sha1_hash,
+						scratch, scratch_size),
+		  "vb2_rsa_verify_digest_inplace() ignores hwcrypto");
+	key->allow_hwcrypto = 0;
+
+	TEST_EQ(vb2_rsa_verify_digest_inplace(key, sig,
+					      test_message_sha1_hash,
+					      scratch, scratch_size - 1),
+		VB2_ERROR_RSA_VERIFY_WORKBUF,
+		"vb2_rsa_verify_digest_inplace() small scratch");
+	TEST_EQ(vb2_rsa_verify_digest_inplace(key, sig,
+					      test_message_sha1_hash,
+					      NULL, scratch_size),
+		VB2_ERROR_RSA_VERIFY_PARAM,
+		"vb2_rsa_verify_digest_inplace() no scratch");
+
+	key->sig_alg = VB2_SIG_INVALID;
+	TEST_EQ(vb2_rsa_verify_digest_inplace(key, sig,
+					      test_message_sha1_hash,
+					      scratch, sizeof(scratch)),
+		VB2_ERROR_RSA_VERIFY_ALGORITHM,
+		"vb2_rsa_verify_digest_inplace() bad key alg");
+	key->sig_alg = orig_key_alg;
+
+	key->arrsize *= 2;
+	TEST_EQ(vb2_rsa_verify_digest_inplace(key, sig,
+					      test_message_sha1_hash,
+					      scratch, sizeof(scratch)),
+		VB2_ERROR_RSA_VERIFY_SIG_LEN,
+		"vb2_rsa_verify_digest_inplace() bad sig len");
+	key->arrsize /= 2;
+
+	sig[RSA1024NUMBYTES - 3] ^= 0x56;
+	TEST_EQ(vb2_rsa_verify_digest_inplace(key, sig,
+					      test_message_sha1_hash,
+					      scratch, scratch_size),
+		VB2_ERROR_RSA_PADDING,
+		"vb2_rsa_verify_digest_inplace() bad sig");
+}
+
 int main(int argc, char *argv[])
 {
 	struct vb2_public_key k2;
@@ -146,6 +241,7 @@ int main(int argc, char *argv[])
 	/* Run tests */
 	test_signatures(&k2);
 	test_verify_digest(&k2);
+	test_verify_digest_inplace(&k2);
 
 	/* Clean up and exit */
 	free(pk);
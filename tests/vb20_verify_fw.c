@@ -5,9 +5,13 @@
  * Routines for verifying a firmware image's signature.
  */
 
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "2common.h"
 #include "2misc.h"
@@ -17,6 +21,12 @@ const char *gbb_fname;
 const char *vblock_fname;
 const char *body_fname;
 
+/* With --map, the GBB and vblock files are mapped read-only */
+static const void *gbb_map;
+static uint32_t gbb_map_size;
+static const void *vblock_map;
+static uint32_t vblock_map_size;
+
 /**
  * Local implementation which reads resources from individual files.  Could be
  * more elegant and read from bios.bin, if we understood the fmap.
@@ -59,6 +69,59 @@ vb2_error_t vb2ex_read_resource(struct vb2_context *c,
 	return got_size == size ? VB2_SUCCESS : VB2_ERROR_UNKNOWN;
 }
 
+/**
+ * Local implementation which hands out the files mapped by --map.  They are
+ * mapped read-only, so anything trying to modify them in place will fault.
+ */
+vb2_error_t vb2ex_map_resource(struct vb2_context *c,
+			       enum vb2_resource_index index,
+			       const void **buf_ptr, uint32_t *size_ptr)
+{
+	switch (index) {
+	case VB2_RES_GBB:
+		*buf_ptr = gbb_map;
+		*size_ptr = gbb_map_size;
+		break;
+	case VB2_RES_FW_VBLOCK:
+		*buf_ptr = vblock_map;
+		*size_ptr = vblock_map_size;
+		break;
+	default:
+		return VB2_ERROR_UNKNOWN;
+	}
+
+	return *buf_ptr ? VB2_SUCCESS : VB2_ERROR_EX_UNIMPLEMENTED;
+}
+
+/**
+ * Map a file read-only.
+ */
+static vb2_error_t map_file(const char *fname, const void **buf_ptr,
+			    uint32_t *size_ptr)
+{
+	struct stat st;
+	void *buf;
+	int fd;
+
+	fd = open(fname, O_RDONLY);
+	if (fd < 0)
+		return VB2_ERROR_TEST_INPUT_FILE;
+
+	if (fstat(fd, &st) || !st.st_size || st.st_size > UINT32_MAX) {
+		close(fd);
+		return VB2_ERROR_TEST_INPUT_FILE;
+	}
+
+	buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (buf == MAP_FAILED)
+		return VB2_ERROR_TEST_INPUT_FILE;
+
+	*buf_ptr = buf;
+	*size_ptr = st.st_size;
+	return VB2_SUCCESS;
+}
+
 vb2_error_t vb2ex_tpm_clear_owner(struct vb2_context *c)
 {
 	// TODO: implement
@@ -141,7 +204,7 @@ static vb2_error_t hash_body(struct vb2_context *c)
 
 static void print_help(const char *progname)
 {
-	printf("Usage: %s <gbb> <vblock> <body>\n", progname);
+	printf("Usage: %s [--map] <gbb> <vblock> <body>\n", progname);
 }
 
 int main(int argc, char *argv[])
@@ -150,8 +213,15 @@ int main(int argc, char *argv[])
 		__attribute__((aligned(VB2_WORKBUF_ALIGN)));
 	struct vb2_context *ctx;
 	struct vb2_shared_data *sd;
+	int map = 0;
 	vb2_error_t rv;
 
+	if (argc > 1 && !strcmp(argv[1], "--map")) {
+		map = 1;
+		argc--;
+		argv++;
+	}
+
 	if (argc < 4) {
 		print_help(argv[0]);
 		return 1;
@@ -162,6 +232,14 @@ int main(int argc, char *argv[])
 	vblock_fname = argv[2];
 	body_fname = argv[3];
 
+	if (map) {
+		if (map_file(gbb_fname, &gbb_map, &gbb_map_size) ||
+		    map_file(vblock_fname, &vblock_map, &vblock_map_size)) {
+			printf("Failed to map input files.\n");
+			return 1;
+		}
+	}
+
 	/* Intialize workbuf with sentinel value to see how much we'll use. */
 	uint32_t *ptr = (uint32_t *)workbuf;
 	while ((uint8_t *)ptr + sizeof(*ptr) <= workbuf + sizeof(workbuf))
@@ -163,6 +163,46 @@ static void sig_tests(const struct alg_combo *combo,
 	vb2_public_key_free(pubk);
 }
 
+/* BLAKE3 has no DigestInfo, so it can only be used for bare hashes */
+static void blake3_tests(const char *keys_dir)
+{
+	struct vb2_private_key *prik;
+	const struct vb2_private_key *prihash;
+	struct vb2_public_key pubhash;
+	struct vb21_signature *sig;
+	char pemfile[1024];
+
+	uint8_t workbuf[VB2_VERIFY_DATA_WORKBUF_BYTES]
+		 __attribute__((aligned(VB2_WORKBUF_ALIGN)));
+	struct vb2_workbuf wb;
+
+	vb2_workbuf_init(&wb, workbuf, sizeof(workbuf));
+
+	TEST_SUCC(vb2_private_key_hash(&prihash, VB2_HASH_BLAKE3),
+		  "BLAKE3 private hash key");
+	TEST_SUCC(vb2_public_key_hash(&pubhash, VB2_HASH_BLAKE3),
+		  "BLAKE3 public hash key");
+
+	TEST_SUCC(vb21_sign_data(&sig, test_data, test_size, prihash, NULL),
+		  "Sign with BLAKE3 hash");
+	TEST_EQ(sig->hash_alg, VB2_HASH_BLAKE3, "  hash_alg");
+	TEST_EQ(sig->sig_size, VB2_BLAKE3_DIGEST_SIZE, "  sig_size");
+	TEST_SUCC(vb21_verify_data(test_data, test_size, sig, &pubhash, &wb),
+		  "Verify with BLAKE3 hash");
+	TEST_NEQ(vb21_verify_data(test_data, test_size - 1, sig, &pubhash,
+				  &wb),
+		 VB2_SUCCESS, "Verify with BLAKE3 hash, wrong data");
+	free(sig);
+
+	snprintf(pemfile, sizeof(pemfile), "%s/key_rsa2048.pem", keys_dir);
+	TEST_SUCC(vb2_private_key_read_pem(&prik, pemfile), "Read private key");
+	prik->hash_alg = VB2_HASH_BLAKE3;
+	prik->sig_alg = VB2_SIG_RSA2048;
+	TEST_EQ(vb21_sign_data(&sig, test_data, test_size, prik, NULL),
+		VB2_SIGN_DATA_DIGEST_INFO, "Sign RSA/BLAKE3");
+	vb2_private_key_free(prik);
+}
+
 static int test_algorithm(const struct alg_combo *combo, const char *keys_dir)
 {
 	int rsa_bits = vb2_rsa_sig_size(combo->sig_alg) * 8;
@@ -190,6 +230,7 @@ int main(int argc, char *argv[]) {
 			if (test_algorithm(test_algs + i, argv[1]))
 				return 1;
 		}
+		blake3_tests(argv[1]);
 	} else {
 		fprintf(stderr, "Usage: %s <keys_dir>", argv[0]);
 		return -1;
@@ -0,0 +1,70 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* BLAKE3 tests for the vectorized chunk hashing in 2blake3_simd.c. */
+
+#include <stdio.h>
+
+#include "2common.h"
+#include "2sha.h"
+#include "2sha_private.h"
+#include "2sysincludes.h"
+#include "sha_test_vectors.h"
+#include "test_common.h"
+
+static uint8_t input[BLAKE3_TEST_INPUT_SIZE];
+
+static void hash_chunks_tests(void)
+{
+	uint32_t cvs[BLAKE3_MAX_CHUNKS][8];
+	uint32_t expect[8];
+	int i;
+
+	/* Chunks hashed together must match the same chunks hashed alone */
+	vb2_blake3_hash_chunks(input, BLAKE3_MAX_CHUNKS, 5, cvs);
+	for (i = 0; i < BLAKE3_MAX_CHUNKS; i++) {
+		vb2_blake3_hash_chunks(input + i * VB2_BLAKE3_CHUNK_SIZE, 1,
+				       5 + i, &expect);
+		TEST_EQ(memcmp(cvs[i], expect, sizeof(expect)), 0,
+			"Chunk chaining value");
+	}
+
+	/* The chunk counter is 64 bits */
+	vb2_blake3_hash_chunks(input, 2, 0xffffffffULL, cvs);
+	vb2_blake3_hash_chunks(input + VB2_BLAKE3_CHUNK_SIZE, 1,
+			       0x100000000ULL, &expect);
+	TEST_EQ(memcmp(cvs[1], expect, sizeof(expect)), 0,
+		"Chunk counter carry");
+	TEST_NEQ(memcmp(cvs[0], expect, sizeof(expect)), 0,
+		 "Chunk counter affects chaining value");
+}
+
+static void blake3_tests(void)
+{
+	uint8_t digest[VB2_BLAKE3_DIGEST_SIZE];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(blake3_lengths); i++) {
+		TEST_SUCC(vb2_digest_buffer(input, blake3_lengths[i],
+					    VB2_HASH_BLAKE3,
+					    digest, sizeof(digest)),
+			  "vb2_digest_buffer() BLAKE3");
+		TEST_EQ(memcmp(digest, blake3_results[i], sizeof(digest)),
+			0, "BLAKE3 digest");
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	int i;
+
+	for (i = 0; i < sizeof(input); i++)
+		input[i] = i % 251;
+
+	hash_chunks_tests();
+	blake3_tests();
+
+	return gTestSuccess ? 0 : 255;
+}
@@ -500,6 +500,29 @@ static void test_verify_kernel_preamble(
 	TEST_SUCC(vb2_verify_kernel_preamble(h, hsize, &rsa, &wb),
 		  "vb2_verify_kernel_preamble() no vmlinuz_header");
 
+	memcpy(h, hdr, hsize);
+	TEST_EQ(vb2_kernel_get_body_chunk_size(h), 0,
+		"vb2_kernel_get_body_chunk_size() flat");
+	h->flags |= 16 << VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_SHIFT;
+	TEST_EQ(vb2_kernel_get_body_chunk_size(h), 0x10000,
+		"vb2_kernel_get_body_chunk_size() 64KB");
+	resign_kernel_preamble(h, private_key);
+	TEST_SUCC(vb2_verify_kernel_preamble(h, hsize, &rsa, &wb),
+		  "vb2_verify_kernel_preamble() body chunk size");
+
+	memcpy(h, hdr, hsize);
+	h->flags |= 11 << VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_SHIFT;
+	resign_kernel_preamble(h, private_key);
+	TEST_EQ(vb2_verify_kernel_preamble(h, hsize, &rsa, &wb),
+		VB2_ERROR_PREAMBLE_BODY_CHUNK_SIZE,
+		"vb2_verify_kernel_preamble() body chunk size too small");
+
+	memcpy(h, hdr, hsize);
+	h->header_version_minor = 1;
+	h->flags |= 16 << VB2_KERNEL_PREAMBLE_BODY_CHUNK_SHIFT_SHIFT;
+	TEST_EQ(vb2_kernel_get_body_chunk_size(h), 0,
+		"vb2_kernel_get_body_chunk_size() old preamble");
+
 	/* TODO: verify with extra padding at end of header. */
 
 	free(h);
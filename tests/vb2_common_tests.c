@@ -227,7 +227,7 @@ static void test_helper_functions(void)
 	}
 
 	{
-		uint8_t *p = (uint8_t *)test_helper_functions;
+		static uint8_t pbuf[64]; uint8_t *p = pbuf + 16;
 		TEST_EQ((int)vb2_offset_of(p, p), 0, "vb2_offset_of() equal");
 		TEST_EQ((int)vb2_offset_of(p, p+10), 10,
 			"vb2_offset_of() positive");
@@ -236,7 +236,7 @@ static void test_helper_functions(void)
 	}
 
 	{
-		uint8_t *p = (uint8_t *)test_helper_functions;
+		static uint8_t pbuf[64]; uint8_t *p = pbuf + 16;
 		TEST_SUCC(vb2_verify_member_inside(p, 20, p, 6, 11, 3),
 			  "vb2_verify_member_inside() ok 1");
 		TEST_SUCC(vb2_verify_member_inside(p, 20, p+4, 4, 8, 4),
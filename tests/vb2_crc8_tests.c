@@ -0,0 +1,90 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for CRC-8 implementations.
+ */
+
+#include "2crc8.h"
+#include "2sysincludes.h"
+#include "test_common.h"
+
+/* Known values; CRC-8 ITU without the final XOR (aka CRC-8/SMBUS) */
+static void known_value_tests(void)
+{
+	const uint8_t zeroes[16] = {0};
+
+	TEST_EQ(vb2_crc8("123456789", 9), 0xf4, "CRC-8 check value");
+	TEST_EQ(vb2_crc8(zeroes, sizeof(zeroes)), 0, "CRC-8 of zeroes");
+	TEST_EQ(vb2_crc8(zeroes, 0), 0, "CRC-8 of nothing");
+}
+
+/*
+ * Every table entry is used and every (CRC, data byte) pair is reached by
+ * some two-byte buffer, so agreeing on all of them means the implementations
+ * agree on buffers of any length.
+ */
+static void equivalence_tests(void)
+{
+	uint8_t buf[2];
+	int mismatch_nibble = 0, mismatch_byte = 0, mismatch_crc8 = 0;
+	uint32_t i;
+
+	for (i = 0; i < 0x10000; i++) {
+		uint8_t expect;
+
+		buf[0] = i >> 8;
+		buf[1] = i;
+
+		expect = vb2_crc8_bitwise(buf, 1);
+		if (vb2_crc8_nibble(buf, 1) != expect)
+			mismatch_nibble++;
+		if (vb2_crc8_byte(buf, 1) != expect)
+			mismatch_byte++;
+		if (vb2_crc8(buf, 1) != expect)
+			mismatch_crc8++;
+
+		expect = vb2_crc8_bitwise(buf, 2);
+		if (vb2_crc8_nibble(buf, 2) != expect)
+			mismatch_nibble++;
+		if (vb2_crc8_byte(buf, 2) != expect)
+			mismatch_byte++;
+		if (vb2_crc8(buf, 2) != expect)
+			mismatch_crc8++;
+	}
+
+	TEST_EQ(mismatch_nibble, 0, "Nibble table matches bitwise");
+	TEST_EQ(mismatch_byte, 0, "Byte table matches bitwise");
+	TEST_EQ(mismatch_crc8, 0, "vb2_crc8() matches bitwise");
+}
+
+/* Longer buffers, including NV storage and secdata sized ones */
+static void length_tests(void)
+{
+	uint8_t buf[256];
+	uint32_t i;
+	int mismatch = 0;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i * 37 + 11;
+
+	for (i = 0; i <= sizeof(buf); i++) {
+		uint8_t expect = vb2_crc8_bitwise(buf, i);
+
+		if (vb2_crc8_nibble(buf, i) != expect ||
+		    vb2_crc8_byte(buf, i) != expect ||
+		    vb2_crc8(buf, i) != expect)
+			mismatch++;
+	}
+
+	TEST_EQ(mismatch, 0, "Implementations match for lengths 0-256");
+}
+
+int main(int argc, char *argv[])
+{
+	known_value_tests();
+	equivalence_tests();
+	length_tests();
+
+	return gTestSuccess ? 0 : 255;
+}
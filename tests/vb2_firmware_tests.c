@@ -47,8 +47,11 @@ static struct {
 } mock_vblock;
 
 static int mock_read_res_fail_on_call;
+static int mock_read_res_calls;
+static int mock_map_resource;
 static int mock_unpack_key_retval;
 static int mock_verify_keyblock_retval;
+static int mock_flash_changes;
 static int mock_verify_preamble_retval;
 
 /* Type of test to reset for */
@@ -79,8 +82,11 @@ static void reset_common_data(enum reset_type t)
 	vb2_secdata_kernel_init(ctx);
 
 	mock_read_res_fail_on_call = 0;
+	mock_read_res_calls = 0;
+	mock_map_resource = 0;
 	mock_unpack_key_retval = VB2_SUCCESS;
 	mock_verify_keyblock_retval = VB2_SUCCESS;
+	mock_flash_changes = 0;
 	mock_verify_preamble_retval = VB2_SUCCESS;
 
 	/* Set up mock data for verifying keyblock */
@@ -128,6 +134,7 @@ vb2_error_t vb2ex_read_resource(struct vb2_context *c,
 	uint8_t *rptr;
 	uint32_t rsize;
 
+	mock_read_res_calls++;
 	if (--mock_read_res_fail_on_call == 0)
 		return VB2_ERROR_EX_READ_RESOURCE_INDEX;
 
@@ -151,6 +158,29 @@ vb2_error_t vb2ex_read_resource(struct vb2_context *c,
 	return VB2_SUCCESS;
 }
 
+vb2_error_t vb2ex_map_resource(struct vb2_context *c,
+			       enum vb2_resource_index index,
+			       const void **buf_ptr, uint32_t *size_ptr)
+{
+	if (!mock_map_resource)
+		return VB2_ERROR_EX_UNIMPLEMENTED;
+
+	switch(index) {
+	case VB2_RES_GBB:
+		*buf_ptr = &mock_gbb;
+		*size_ptr = sizeof(mock_gbb);
+		break;
+	case VB2_RES_FW_VBLOCK:
+		*buf_ptr = &mock_vblock;
+		*size_ptr = sizeof(mock_vblock);
+		break;
+	default:
+		return VB2_ERROR_EX_READ_RESOURCE_INDEX;
+	}
+
+	return VB2_SUCCESS;
+}
+
 vb2_error_t vb2_unpack_key_buffer(struct vb2_public_key *key,
 				  const uint8_t *buf, uint32_t size)
 {
@@ -159,12 +189,23 @@ vb2_error_t vb2_unpack_key_buffer(struct vb2_public_key *key,
 }
 
 static struct vb2_public_key last_used_key;
+static const void *last_verified;
 
 vb2_error_t vb2_verify_keyblock(struct vb2_keyblock *block, uint32_t size,
 				const struct vb2_public_key *key,
 				const struct vb2_workbuf *wb)
 {
 	memcpy(&last_used_key, key, sizeof(struct vb2_public_key));
+	last_verified = block;
+
+	/* Flash contents change right after the signature is checked */
+	if (mock_flash_changes) {
+		mock_vblock.k.kb.keyblock_size = 0;
+		mock_vblock.k.kb.data_key.key_version = 0xffff;
+		mock_vblock.k.kb.data_key.key_size = 0;
+		strcpy(mock_vblock.k.data_key_data, "evil key data!!");
+	}
+
 	return mock_verify_keyblock_retval;
 }
 
@@ -174,6 +215,7 @@ vb2_error_t vb2_verify_fw_preamble(struct vb2_fw_preamble *preamble,
 				   const struct vb2_workbuf *wb)
 {
 	memcpy(&last_used_key, key, sizeof(struct vb2_public_key));
+	last_verified = preamble;
 	return mock_verify_preamble_retval;
 }
 
@@ -440,10 +482,121 @@ static void verify_preamble_tests(void)
 	TEST_EQ(v, 0x20002, "no roll forward");
 }
 
+static void map_resource_tests(void)
+{
+	struct vb2_keyblock *kb = &mock_vblock.k.kb;
+	struct vb2_fw_preamble *pre = &mock_vblock.p.pre;
+	struct vb2_packed_key *k;
+	int expected_offset;
+
+	/* Keyblock is copied in one piece, and the copy verified */
+	reset_common_data(FOR_KEYBLOCK);
+	mock_map_resource = 1;
+	expected_offset = sd->workbuf_used;
+	TEST_SUCC(vb2_load_fw_keyblock(ctx), "mapped keyblock verify");
+	TEST_EQ(mock_read_res_calls, 0, "  nothing read");
+	TEST_PTR_NEQ(last_verified, kb, "  not verified in place");
+	TEST_EQ(sd->fw_version, 0x20000, "  keyblock version");
+	TEST_EQ(sd->vblock_preamble_offset, sizeof(mock_vblock.k),
+		"  preamble offset");
+	TEST_EQ(sd->data_key_offset, expected_offset,
+		"  data key offset");
+	k = vb2_member_of(sd, sd->data_key_offset);
+	TEST_EQ(k->key_size, sizeof(mock_vblock.k.data_key_data),
+		"  data key size");
+	TEST_EQ(memcmp(vb2_member_of(k, k->key_offset),
+		       mock_vblock.k.data_key_data,
+		       sizeof(mock_vblock.k.data_key_data)),
+		0, "  data key data");
+	TEST_EQ(sd->workbuf_used,
+		vb2_wb_round_up(sd->data_key_offset + sd->data_key_size),
+		"  workbuf used");
+
+	/* Only what was verified is used, whatever flash says afterwards */
+	reset_common_data(FOR_KEYBLOCK);
+	mock_map_resource = 1;
+	mock_flash_changes = 1;
+	TEST_SUCC(vb2_load_fw_keyblock(ctx), "mapped keyblock changes");
+	TEST_EQ(sd->fw_version, 0x20000, "  verified keyblock version");
+	TEST_EQ(sd->vblock_preamble_offset, sizeof(mock_vblock.k),
+		"  verified preamble offset");
+	k = vb2_member_of(sd, sd->data_key_offset);
+	TEST_EQ(k->key_size, sizeof(mock_vblock.k.data_key_data),
+		"  verified data key size");
+	TEST_EQ(strcmp((const char *)vb2_member_of(k, k->key_offset),
+		       "data key data!!"), 0, "  verified data key data");
+
+	/* Root key is not copied, but the keyblock is */
+	reset_common_data(FOR_KEYBLOCK);
+	sd->workbuf_used = sd->workbuf_size -
+			   vb2_wb_round_up(sizeof(mock_vblock.k));
+	TEST_EQ(vb2_load_fw_keyblock(ctx),
+		VB2_ERROR_FW_KEYBLOCK_WORKBUF,
+		"keyblock read not enough workbuf");
+	mock_map_resource = 1;
+	TEST_SUCC(vb2_load_fw_keyblock(ctx), "  mapped has enough");
+
+	reset_common_data(FOR_KEYBLOCK);
+	mock_map_resource = 1;
+	sd->workbuf_used = sd->workbuf_size + VB2_WORKBUF_ALIGN -
+			   vb2_wb_round_up(sizeof(mock_vblock.k));
+	TEST_EQ(vb2_load_fw_keyblock(ctx),
+		VB2_ERROR_FW_KEYBLOCK_WORKBUF,
+		"mapped keyblock not enough workbuf");
+
+	reset_common_data(FOR_KEYBLOCK);
+	mock_map_resource = 1;
+	kb->keyblock_size = sizeof(mock_vblock) + 1;
+	TEST_EQ(vb2_load_fw_keyblock(ctx),
+		VB2_ERROR_FW_KEYBLOCK_MAP,
+		"mapped keyblock past end");
+
+	reset_common_data(FOR_KEYBLOCK);
+	mock_map_resource = 1;
+	mock_verify_keyblock_retval = VB2_ERROR_KEYBLOCK_MAGIC;
+	TEST_EQ(vb2_load_fw_keyblock(ctx),
+		VB2_ERROR_KEYBLOCK_MAGIC,
+		"mapped keyblock verify keyblock");
+
+	/* Preamble persists, so is copied in one piece and verified there */
+	reset_common_data(FOR_PREAMBLE);
+	mock_map_resource = 1;
+	mock_read_res_calls = 0;
+	expected_offset = sd->workbuf_used;
+	TEST_SUCC(vb2_load_fw_preamble(ctx), "mapped preamble good");
+	TEST_EQ(mock_read_res_calls, 0, "  nothing read");
+	TEST_EQ(sd->preamble_offset, expected_offset, "  preamble offset");
+	TEST_EQ(sd->preamble_size, pre->preamble_size, "  preamble size");
+	TEST_PTR_EQ(last_verified, vb2_member_of(sd, sd->preamble_offset),
+		    "  copy verified");
+	TEST_EQ(memcmp(last_verified, pre, sizeof(mock_vblock.p)), 0,
+		"  copy matches");
+	TEST_EQ(sd->fw_version, 0x20002, "  combined version");
+	TEST_EQ(sd->workbuf_used,
+		vb2_wb_round_up(sd->preamble_offset + sd->preamble_size),
+		"  workbuf used");
+
+	reset_common_data(FOR_PREAMBLE);
+	mock_map_resource = 1;
+	pre->preamble_size = sizeof(mock_vblock);
+	TEST_EQ(vb2_load_fw_preamble(ctx),
+		VB2_ERROR_FW_PREAMBLE2_MAP,
+		"mapped preamble past end");
+
+	reset_common_data(FOR_PREAMBLE);
+	mock_map_resource = 1;
+	sd->workbuf_used = sd->workbuf_size + VB2_WORKBUF_ALIGN -
+			   vb2_wb_round_up(sizeof(mock_vblock.p));
+	TEST_EQ(vb2_load_fw_preamble(ctx),
+		VB2_ERROR_FW_PREAMBLE2_WORKBUF,
+		"mapped preamble not enough workbuf");
+}
+
 int main(int argc, char* argv[])
 {
 	verify_keyblock_tests();
 	verify_preamble_tests();
+	map_resource_tests();
 
 	return gTestSuccess ? 0 : 255;
 }
@@ -44,6 +44,12 @@ algo_to_sha()
 	esac
 }
 
+# Workbuf high watermark reported by vb2_verify_fw
+watermark()
+{
+	sed -n 's/.*high watermark = \([0-9]*\).*/\1/p' "$1"
+}
+
 run_test()
 {
 	local root_algo=$1
@@ -89,7 +95,17 @@ run_test()
 		"(root=${root_algo}, fw=${fw_algo}, kernel=${kern_algo})"
 
 	# Verify the firmware using vboot2 checks
-	${BUILD_RUN}/tests/vb20_verify_fw gbb.test vblock.test body.test
+	${BUILD_RUN}/tests/vb20_verify_fw gbb.test vblock.test body.test \
+		> verify.log
+	cat verify.log
+
+	# Again, with the GBB and vblock mapped read-only
+	${BUILD_RUN}/tests/vb20_verify_fw --map gbb.test vblock.test body.test \
+		> verify_map.log
+	cat verify_map.log
+
+	# Mapping never needs more work buffer than reading
+	[ "$(watermark verify_map.log)" -le "$(watermark verify.log)" ]
 
 	happy 'vb2_verify_fw succeeded'
 }
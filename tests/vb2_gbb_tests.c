@@ -10,13 +10,15 @@
 #include "test_common.h"
 
 /* Mock data */
-static char gbb_data[4096 + sizeof(struct vb2_gbb_header)];
+static char gbb_data[4096 + sizeof(struct vb2_gbb_header)]
+	__attribute__((aligned(sizeof(uint32_t))));
 static struct vb2_gbb_header *gbb = (struct vb2_gbb_header *)gbb_data;
 static struct vb2_packed_key *rootkey;
 static struct vb2_context *ctx;
 static struct vb2_workbuf wb;
 static uint8_t workbuf[VB2_KERNEL_WORKBUF_RECOMMENDED_SIZE]
 	__attribute__((aligned(VB2_WORKBUF_ALIGN)));
+static int mock_map_resource;
 
 static void set_gbb_hwid(const char *hwid, size_t size)
 {
@@ -49,6 +51,8 @@ static void reset_common_data(void)
 	const char hwid_src[] = "Test HWID";
 	set_gbb_hwid(hwid_src, sizeof(hwid_src));
 
+	mock_map_resource = 0;
+
 	TEST_SUCC(vb2api_init(workbuf, sizeof(workbuf), &ctx),
 		  "vb2api_init failed");
 	vb2_workbuf_from_ctx(ctx, &wb);
@@ -83,6 +87,18 @@ vb2_error_t vb2ex_read_resource(struct vb2_context *c,
 	return VB2_SUCCESS;
 }
 
+vb2_error_t vb2ex_map_resource(struct vb2_context *c,
+			       enum vb2_resource_index index,
+			       const void **buf_ptr, uint32_t *size_ptr)
+{
+	if (!mock_map_resource || index != VB2_RES_GBB)
+		return VB2_ERROR_EX_UNIMPLEMENTED;
+
+	*buf_ptr = gbb_data;
+	*size_ptr = sizeof(gbb_data);
+	return VB2_SUCCESS;
+}
+
 /* Tests */
 static void flag_tests(void)
 {
@@ -255,6 +271,63 @@ static void key_tests(void)
 	TEST_EQ(size, sizeof(*rootkey), "  correct size returned");
 }
 
+static void mapped_key_tests(void)
+{
+	struct vb2_packed_key *keyp;
+	struct vb2_workbuf wborig;
+	const char key_data[] = "HELLOWORLD";
+	uint32_t size;
+
+	/* Copies just the key, not the padding after it */
+	reset_common_data();
+	mock_map_resource = 1;
+	wborig = wb;
+	rootkey->key_size = sizeof(key_data);
+	memcpy((void *)rootkey + rootkey->key_offset,
+	       key_data, sizeof(key_data));
+	gbb->rootkey_size = rootkey->key_offset + rootkey->key_size + 64;
+	TEST_SUCC(vb2_gbb_read_root_key(ctx, &keyp, &size, &wb),
+		  "mapped rootkey");
+	TEST_PTR_EQ(keyp, wborig.buf, "  copied to workbuf");
+	TEST_EQ(memcmp(rootkey, keyp, rootkey->key_offset + rootkey->key_size),
+		0, "  copied key data successfully");
+	TEST_EQ(size, rootkey->key_offset + rootkey->key_size,
+		"  correct size returned");
+	TEST_EQ(wborig.size - wb.size, vb2_wb_round_up(size),
+		"  workbuf used for key only");
+
+	reset_common_data();
+	mock_map_resource = 1;
+	wborig = wb;
+	rootkey->key_size = 2;
+	gbb->rootkey_size = rootkey->key_offset + rootkey->key_size - 1;
+	TEST_EQ(vb2_gbb_read_root_key(ctx, &keyp, &size, &wb),
+		VB2_ERROR_INSIDE_DATA_OUTSIDE,
+		"mapped rootkey size exceeds gbb.rootkey size");
+	TEST_TRUE(wb.buf == wborig.buf,
+		  "  workbuf restored on error");
+
+	reset_common_data();
+	mock_map_resource = 1;
+	wborig = wb;
+	rootkey->key_size = sizeof(key_data);
+	gbb->rootkey_size = rootkey->key_offset + rootkey->key_size;
+	wb.size = gbb->rootkey_size - 1;
+	TEST_EQ(vb2_gbb_read_root_key(ctx, &keyp, &size, &wb),
+		VB2_ERROR_GBB_WORKBUF,
+		"mapped rootkey too big for workbuf");
+	TEST_TRUE(wb.buf == wborig.buf,
+		  "  workbuf restored on error");
+
+	/* Falls back to reading if the key is outside the mapping */
+	reset_common_data();
+	mock_map_resource = 1;
+	gbb->rootkey_offset = sizeof(gbb_data) + 1;
+	TEST_EQ(vb2_gbb_read_root_key(ctx, &keyp, &size, &wb),
+		VB2_ERROR_EX_READ_RESOURCE_SIZE,
+		"mapped rootkey offset too large");
+}
+
 static void hwid_tests(void)
 {
 	char hwid[VB2_GBB_HWID_MAX_SIZE];
@@ -349,6 +422,7 @@ int main(int argc, char* argv[])
 {
 	flag_tests();
 	key_tests();
+	mapped_key_tests();
 	hwid_tests();
 
 	return gTestSuccess ? 0 : 255;
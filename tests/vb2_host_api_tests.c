@@ -0,0 +1,520 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for the re-entrant host API, linked against the shared library
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "../cgpt/cgpt.h"
+#include "2common.h"
+#include "host_common.h"
+#include "host_key.h"
+#include "host_misc.h"
+#include "host_signature.h"
+#include "test_common.h"
+#include "vboot_host.h"
+#include "vboot_host_api.h"
+
+#define KERNEL_VERSION 2
+#define BODY_SIZE 0x30000
+#define BODY_OFFSET 0x10000
+#define BODY_LOAD_ADDRESS 0x100000
+#define BOOTLOADER_SIZE 0x1000
+#define BOOTLOADER_ADDRESS (BODY_LOAD_ADDRESS + BODY_SIZE - BOOTLOADER_SIZE)
+#define DISK_SECTORS 4096
+
+#define NUM_THREADS 8
+#define NUM_ITERATIONS 20
+
+static char kernel_file[1024];
+static char disk_file[1024];
+static char save_file[1024];
+static char kernel_keyblock_file[1024];
+static char kernel_data_key_file[1024];
+static char kernel_subkey_file[1024];
+static char recovery_keyblock_file[1024];
+static char recovery_data_key_file[1024];
+static char recovery_key_file[1024];
+
+static uint8_t *kernel_buf;
+static uint32_t kernel_size;
+
+/* cgpt's own GenerateGuid() is only a stub in the library */
+int GenerateGuid(Guid *newguid)
+{
+	static uint8_t counter;
+	memset(newguid, 0, sizeof(*newguid));
+	newguid->u.raw[0] = ++counter;
+	newguid->u.raw[15] = 0x80;
+	return CGPT_OK;
+}
+
+static int make_kernel(void)
+{
+	struct vb2_private_key *key;
+	struct vb2_signature *body_sig;
+	struct vb2_kernel_preamble *preamble;
+	uint8_t *keyblock;
+	uint32_t keyblock_size;
+	uint8_t *body;
+	int i;
+
+	if (vb2_read_file(kernel_keyblock_file, &keyblock, &keyblock_size))
+		return 1;
+	key = vb2_read_private_key(kernel_data_key_file);
+	if (!key)
+		return 1;
+
+	kernel_size = BODY_OFFSET + BODY_SIZE;
+	kernel_buf = calloc(1, kernel_size);
+	body = kernel_buf + BODY_OFFSET;
+	for (i = 0; i < BODY_SIZE; i++)
+		body[i] = (uint8_t)(i * 7 + (i >> 8));
+
+	body_sig = vb2_calculate_signature(body, BODY_SIZE, key);
+	preamble = vb2_create_kernel_preamble(
+		KERNEL_VERSION, BODY_LOAD_ADDRESS, BOOTLOADER_ADDRESS,
+		BOOTLOADER_SIZE, body_sig, 0, 0, 0,
+		BODY_OFFSET - keyblock_size, key);
+	if (!preamble)
+		return 1;
+	memcpy(kernel_buf, keyblock, keyblock_size);
+	memcpy(kernel_buf + keyblock_size, preamble, preamble->preamble_size);
+
+	free(preamble);
+	free(body_sig);
+	vb2_free_private_key(key);
+	free(keyblock);
+
+	return vb2_write_file(kernel_file, kernel_buf, kernel_size);
+}
+
+static int add_partition(uint32_t partition, const char *label,
+			 const Guid *type, uint64_t begin, int priority)
+{
+	CgptAddParams params = {
+		.drive_name = disk_file,
+		.partition = partition,
+		.begin = begin,
+		.size = 1024,
+		.type_guid = *type,
+		.label = label,
+		.priority = priority,
+		.tries = 1,
+		.set_begin = 1,
+		.set_size = 1,
+		.set_type = 1,
+		.set_priority = priority != 0,
+		.set_tries = priority != 0,
+	};
+
+	return CgptAdd(&params);
+}
+
+static int make_disk(void)
+{
+	CgptCreateParams params = {
+		.drive_name = disk_file,
+	};
+	uint8_t *zero = calloc(DISK_SECTORS, 512);
+	int rv;
+
+	rv = vb2_write_file(disk_file, zero, DISK_SECTORS * 512);
+	free(zero);
+	if (rv)
+		return 1;
+
+	return CgptCreate(&params) ||
+		add_partition(1, "KERN-A", &guid_chromeos_kernel, 64, 2) ||
+		add_partition(2, "ROOT-A", &guid_chromeos_rootfs, 1088, 0);
+}
+
+static void image_tests(void)
+{
+	struct vb2_host_image *image;
+	struct vb2_host_image *copy;
+	const uint8_t *data;
+	size_t size;
+
+	TEST_EQ(vb2_host_api_version(), VB2_HOST_API_VERSION, "API version");
+
+	TEST_NEQ(vb2_host_image_load("/no/such/file", &image), VB2_SUCCESS,
+		 "Load missing image");
+	TEST_PTR_EQ(image, NULL, "  image");
+
+	TEST_SUCC(vb2_host_image_load(kernel_file, &image), "Load image");
+	data = vb2_host_image_data(image, &size);
+	TEST_EQ(size, kernel_size, "  size");
+	TEST_EQ(memcmp(data, kernel_buf, size), 0, "  data");
+
+	TEST_SUCC(vb2_host_image_save(image, save_file), "Save image");
+	TEST_SUCC(vb2_host_image_load(save_file, &copy), "Reload image");
+	data = vb2_host_image_data(copy, &size);
+	TEST_EQ(size, kernel_size, "  size");
+	TEST_EQ(memcmp(data, kernel_buf, size), 0, "  data");
+
+	/* The loaded image doesn't depend on the file it came from */
+	TEST_SUCC(truncate(save_file, 0), "Truncate source");
+	data = vb2_host_image_data(copy, &size);
+	TEST_EQ(size, kernel_size, "  size");
+	TEST_EQ(memcmp(data, kernel_buf, size), 0, "  data");
+	TEST_SUCC(vb2_host_image_save(copy, save_file), "Save over source");
+	vb2_host_image_free(copy);
+	TEST_SUCC(vb2_host_image_load(save_file, &copy), "Reload image");
+	data = vb2_host_image_data(copy, &size);
+	TEST_EQ(size, kernel_size, "  size");
+	TEST_EQ(memcmp(data, kernel_buf, size), 0, "  data");
+	vb2_host_image_free(copy);
+	vb2_host_image_free(image);
+
+	TEST_SUCC(vb2_host_image_from_buffer("abc", 3, &image),
+		  "Image from buffer");
+	data = vb2_host_image_data(image, &size);
+	TEST_EQ(size, 3, "  size");
+	TEST_EQ(memcmp(data, "abc", 3), 0, "  data");
+	vb2_host_image_free(image);
+
+	vb2_host_image_free(NULL);
+}
+
+static void key_tests(void)
+{
+	struct vb2_host_key *key;
+	struct vb2_host_keyblock *keyblock;
+
+	TEST_SUCC(vb2_host_public_key_load(kernel_subkey_file, &key),
+		  "Load public key");
+	vb2_host_key_free(key);
+	TEST_NEQ(vb2_host_public_key_load("/no/such/file", &key), VB2_SUCCESS,
+		 "Load missing public key");
+	TEST_PTR_EQ(key, NULL, "  key");
+
+	TEST_SUCC(vb2_host_private_key_load(kernel_data_key_file, &key),
+		  "Load private key");
+	vb2_host_key_free(key);
+	TEST_NEQ(vb2_host_private_key_load("/no/such/file", &key),
+		 VB2_SUCCESS, "Load missing private key");
+	TEST_PTR_EQ(key, NULL, "  key");
+
+	TEST_SUCC(vb2_host_keyblock_load(kernel_keyblock_file, &keyblock),
+		  "Load keyblock");
+	vb2_host_keyblock_free(keyblock);
+	TEST_NEQ(vb2_host_keyblock_load(kernel_subkey_file, &keyblock),
+		 VB2_SUCCESS, "Load keyblock from public key");
+	TEST_PTR_EQ(keyblock, NULL, "  keyblock");
+
+	vb2_host_key_free(NULL);
+	vb2_host_keyblock_free(NULL);
+}
+
+static void kernel_tests(void)
+{
+	struct vb2_host_image *kernel, *bad, *resigned;
+	struct vb2_host_key *subkey, *recovery_key, *priv;
+	struct vb2_host_keyblock *keyblock;
+	struct vb2_host_kernel_info info;
+	const uint8_t *data;
+	uint8_t *buf;
+	size_t size;
+
+	vb2_host_image_load(kernel_file, &kernel);
+	vb2_host_public_key_load(kernel_subkey_file, &subkey);
+	vb2_host_public_key_load(recovery_key_file, &recovery_key);
+	vb2_host_private_key_load(recovery_data_key_file, &priv);
+	vb2_host_keyblock_load(recovery_keyblock_file, &keyblock);
+
+	memset(&info, 0, sizeof(info));
+	TEST_SUCC(vb2_host_kernel_verify(kernel, subkey, &info),
+		  "Verify kernel");
+	TEST_EQ(info.kernel_version, KERNEL_VERSION, "  kernel version");
+	TEST_EQ(info.body_offset, BODY_OFFSET, "  body offset");
+	TEST_EQ(info.body_size, BODY_SIZE, "  body size");
+	TEST_EQ(info.body_load_address, BODY_LOAD_ADDRESS,
+		"  body load address");
+	TEST_EQ(info.bootloader_address, BOOTLOADER_ADDRESS,
+		"  bootloader address");
+	TEST_EQ(info.bootloader_size, BOOTLOADER_SIZE, "  bootloader size");
+	data = vb2_host_image_data(kernel, &size);
+	TEST_EQ(memcmp(data, kernel_buf, size), 0, "  image unchanged");
+
+	TEST_SUCC(vb2_host_kernel_verify(kernel, NULL, NULL),
+		  "Verify kernel without key");
+	TEST_NEQ(vb2_host_kernel_verify(kernel, recovery_key, NULL),
+		 VB2_SUCCESS, "Verify kernel with wrong key");
+	TEST_EQ(vb2_host_kernel_verify(kernel, priv, NULL),
+		VB2_ERROR_HOST_API_KEY_TYPE, "Verify kernel with private key");
+
+	buf = malloc(kernel_size);
+	memcpy(buf, kernel_buf, kernel_size);
+	buf[BODY_OFFSET + BODY_SIZE / 2] ^= 0x5a;
+	vb2_host_image_from_buffer(buf, kernel_size, &bad);
+	TEST_NEQ(vb2_host_kernel_verify(kernel, subkey, NULL) ||
+		 vb2_host_kernel_verify(bad, subkey, NULL), VB2_SUCCESS,
+		 "Verify kernel with bad body");
+	vb2_host_image_free(bad);
+	free(buf);
+
+	vb2_host_image_from_buffer(kernel_buf, 64, &bad);
+	TEST_EQ(vb2_host_kernel_verify(bad, NULL, NULL),
+		VB2_ERROR_HOST_API_KERNEL_SIZE, "Verify truncated kernel");
+	vb2_host_image_free(bad);
+
+	TEST_SUCC(vb2_host_kernel_sign(kernel, keyblock, priv, &resigned),
+		  "Sign kernel");
+	data = vb2_host_image_data(resigned, &size);
+	TEST_EQ(size, kernel_size, "  size");
+	TEST_EQ(memcmp(data + BODY_OFFSET, kernel_buf + BODY_OFFSET,
+		       BODY_SIZE), 0, "  body");
+	memset(&info, 0, sizeof(info));
+	TEST_SUCC(vb2_host_kernel_verify(resigned, recovery_key, &info),
+		  "  verify with new key");
+	TEST_EQ(info.kernel_version, KERNEL_VERSION, "  kernel version");
+	TEST_EQ(info.body_offset, BODY_OFFSET, "  body offset");
+	TEST_EQ(info.bootloader_address, BOOTLOADER_ADDRESS,
+		"  bootloader address");
+	TEST_NEQ(vb2_host_kernel_verify(resigned, subkey, NULL), VB2_SUCCESS,
+		 "  verify with old key");
+	vb2_host_image_free(resigned);
+
+	TEST_EQ(vb2_host_kernel_sign(kernel, keyblock, subkey, &resigned),
+		VB2_ERROR_HOST_API_KEY_TYPE, "Sign kernel with public key");
+	TEST_PTR_EQ(resigned, NULL, "  image");
+
+	vb2_host_keyblock_free(keyblock);
+	vb2_host_key_free(priv);
+	vb2_host_key_free(recovery_key);
+	vb2_host_key_free(subkey);
+	vb2_host_image_free(kernel);
+}
+
+static void gpt_tests(void)
+{
+	struct vb2_host_image *disk, *bad;
+	struct vb2_host_gpt *gpt;
+	struct vb2_host_gpt_entry entry;
+	const uint8_t *data;
+	uint8_t *buf;
+	size_t size;
+
+	vb2_host_image_load(disk_file, &disk);
+
+	TEST_SUCC(vb2_host_gpt_open(disk, &gpt), "Open GPT");
+	TEST_EQ(vb2_host_gpt_num_entries(gpt), 128, "  entries");
+
+	TEST_SUCC(vb2_host_gpt_get_entry(gpt, 0, &entry), "  entry 0");
+	TEST_STR_EQ(entry.label, "KERN-A", "  label");
+	TEST_EQ(memcmp(&entry.type, &guid_chromeos_kernel, sizeof(Guid)), 0,
+		"  type");
+	TEST_EQ(entry.starting_lba, 64, "  start");
+	TEST_EQ(entry.ending_lba, 64 + 1024 - 1, "  end");
+	TEST_EQ(entry.priority, 2, "  priority");
+	TEST_EQ(entry.tries, 1, "  tries");
+	TEST_EQ(entry.successful, 0, "  successful");
+
+	TEST_SUCC(vb2_host_gpt_get_entry(gpt, 1, &entry), "  entry 1");
+	TEST_STR_EQ(entry.label, "ROOT-A", "  label");
+	TEST_EQ(memcmp(&entry.type, &guid_chromeos_rootfs, sizeof(Guid)), 0,
+		"  type");
+
+	TEST_SUCC(vb2_host_gpt_get_entry(gpt, 2, &entry), "  entry 2");
+	TEST_STR_EQ(entry.label, "", "  unused");
+
+	TEST_EQ(vb2_host_gpt_get_entry(gpt, 128, &entry),
+		VB2_ERROR_HOST_API_GPT_INDEX, "  entry out of range");
+	vb2_host_gpt_free(gpt);
+
+	/* Fall back to the secondary GPT */
+	data = vb2_host_image_data(disk, &size);
+	buf = malloc(size);
+	memcpy(buf, data, size);
+	memset(buf + 512, 0, 512);
+	vb2_host_image_from_buffer(buf, size, &bad);
+	TEST_SUCC(vb2_host_gpt_open(bad, &gpt), "Open GPT bad primary");
+	TEST_SUCC(vb2_host_gpt_get_entry(gpt, 0, &entry), "  entry 0");
+	TEST_STR_EQ(entry.label, "KERN-A", "  label");
+	vb2_host_gpt_free(gpt);
+	vb2_host_image_free(bad);
+
+	/* Neither copy is valid */
+	memset(buf + size - 512, 0, 512);
+	vb2_host_image_from_buffer(buf, size, &bad);
+	TEST_EQ(vb2_host_gpt_open(bad, &gpt), VB2_ERROR_HOST_API_GPT_INVALID,
+		"Open GPT bad primary and secondary");
+	TEST_PTR_EQ(gpt, NULL, "  gpt");
+	vb2_host_image_free(bad);
+
+	vb2_host_image_from_buffer(buf, 1000, &bad);
+	TEST_EQ(vb2_host_gpt_open(bad, &gpt), VB2_ERROR_HOST_API_GPT_SIZE,
+		"Open GPT partial sector");
+	vb2_host_image_free(bad);
+	free(buf);
+
+	vb2_host_gpt_free(NULL);
+	vb2_host_image_free(disk);
+}
+
+/* Handles shared by all the stress test threads */
+struct shared {
+	struct vb2_host_image *kernel;
+	struct vb2_host_image *disk;
+	struct vb2_host_image *resigned;
+	struct vb2_host_key *subkey;
+	struct vb2_host_key *recovery_key;
+	struct vb2_host_key *priv;
+	struct vb2_host_keyblock *keyblock;
+};
+
+struct thread_state {
+	pthread_t thread;
+	const struct shared *shared;
+	int failures;
+};
+
+static int stress_once(const struct shared *s)
+{
+	struct vb2_host_kernel_info info;
+	struct vb2_host_image *resigned;
+	struct vb2_host_key *key;
+	struct vb2_host_gpt *gpt;
+	struct vb2_host_gpt_entry entry;
+	const uint8_t *expect, *data;
+	size_t expect_size, size;
+	int failures = 0;
+
+	if (vb2_host_kernel_verify(s->kernel, s->subkey, &info) ||
+	    info.body_size != BODY_SIZE)
+		failures++;
+
+	if (vb2_host_kernel_sign(s->kernel, s->keyblock, s->priv, &resigned)) {
+		failures++;
+	} else {
+		expect = vb2_host_image_data(s->resigned, &expect_size);
+		data = vb2_host_image_data(resigned, &size);
+		if (size != expect_size || memcmp(data, expect, size))
+			failures++;
+		if (vb2_host_kernel_verify(resigned, s->recovery_key, NULL))
+			failures++;
+		vb2_host_image_free(resigned);
+	}
+
+	if (vb2_host_gpt_open(s->disk, &gpt)) {
+		failures++;
+	} else {
+		if (vb2_host_gpt_get_entry(gpt, 1, &entry) ||
+		    strcmp(entry.label, "ROOT-A"))
+			failures++;
+		vb2_host_gpt_free(gpt);
+	}
+
+	if (vb2_host_private_key_load(recovery_data_key_file, &key))
+		failures++;
+	vb2_host_key_free(key);
+
+	return failures;
+}
+
+static void *stress_thread(void *arg)
+{
+	struct thread_state *t = arg;
+	int i;
+
+	for (i = 0; i < NUM_ITERATIONS; i++)
+		t->failures += stress_once(t->shared);
+	return NULL;
+}
+
+static void stress_tests(void)
+{
+	struct thread_state threads[NUM_THREADS];
+	struct shared s;
+	const uint8_t *data;
+	size_t size;
+	char name[64];
+	int i;
+
+	vb2_host_image_load(kernel_file, &s.kernel);
+	vb2_host_image_load(disk_file, &s.disk);
+	vb2_host_public_key_load(kernel_subkey_file, &s.subkey);
+	vb2_host_public_key_load(recovery_key_file, &s.recovery_key);
+	vb2_host_private_key_load(recovery_data_key_file, &s.priv);
+	vb2_host_keyblock_load(recovery_keyblock_file, &s.keyblock);
+	TEST_SUCC(vb2_host_kernel_sign(s.kernel, s.keyblock, s.priv,
+				       &s.resigned), "Sign reference kernel");
+
+	for (i = 0; i < NUM_THREADS; i++) {
+		threads[i].shared = &s;
+		threads[i].failures = 0;
+		TEST_EQ(pthread_create(&threads[i].thread, NULL,
+				       stress_thread, &threads[i]), 0,
+			"Start thread");
+	}
+	for (i = 0; i < NUM_THREADS; i++) {
+		pthread_join(threads[i].thread, NULL);
+		snprintf(name, sizeof(name), "Thread %d", i);
+		TEST_EQ(threads[i].failures, 0, name);
+	}
+
+	data = vb2_host_image_data(s.kernel, &size);
+	TEST_EQ(memcmp(data, kernel_buf, size), 0, "Shared image unchanged");
+
+	vb2_host_image_free(s.resigned);
+	vb2_host_keyblock_free(s.keyblock);
+	vb2_host_key_free(s.priv);
+	vb2_host_key_free(s.recovery_key);
+	vb2_host_key_free(s.subkey);
+	vb2_host_image_free(s.disk);
+	vb2_host_image_free(s.kernel);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *keys_dir, *tmp_dir;
+
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <keys_dir> <tmp_dir>\n", argv[0]);
+		return -1;
+	}
+	keys_dir = argv[1];
+	tmp_dir = argv[2];
+
+	snprintf(kernel_file, sizeof(kernel_file), "%s/host_api_kernel.bin",
+		 tmp_dir);
+	snprintf(disk_file, sizeof(disk_file), "%s/host_api_disk.bin",
+		 tmp_dir);
+	snprintf(save_file, sizeof(save_file), "%s/host_api_save.bin",
+		 tmp_dir);
+	snprintf(kernel_keyblock_file, sizeof(kernel_keyblock_file),
+		 "%s/kernel.keyblock", keys_dir);
+	snprintf(kernel_data_key_file, sizeof(kernel_data_key_file),
+		 "%s/kernel_data_key.vbprivk", keys_dir);
+	snprintf(kernel_subkey_file, sizeof(kernel_subkey_file),
+		 "%s/kernel_subkey.vbpubk", keys_dir);
+	snprintf(recovery_keyblock_file, sizeof(recovery_keyblock_file),
+		 "%s/recovery_kernel.keyblock", keys_dir);
+	snprintf(recovery_data_key_file, sizeof(recovery_data_key_file),
+		 "%s/recovery_kernel_data_key.vbprivk", keys_dir);
+	snprintf(recovery_key_file, sizeof(recovery_key_file),
+		 "%s/recovery_key.vbpubk", keys_dir);
+
+	if (make_kernel() || make_disk()) {
+		fprintf(stderr, "Unable to create test images\n");
+		return -1;
+	}
+
+	image_tests();
+	key_tests();
+	kernel_tests();
+	gpt_tests();
+	stress_tests();
+
+	unlink(kernel_file);
+	unlink(disk_file);
+	unlink(save_file);
+	free(kernel_buf);
+
+	return gTestSuccess ? 0 : 255;
+}
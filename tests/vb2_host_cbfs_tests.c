@@ -0,0 +1,189 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for native CBFS access in host/lib/cbfstool.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "2common.h"
+#include "2return_codes.h"
+#include "cbfstool.h"
+#include "fmap.h"
+#include "host_misc.h"
+#include "test_common.h"
+
+#define REGION_SIZE 0x4000
+
+static uint8_t region[REGION_SIZE];
+static uint8_t blank[REGION_SIZE];
+static uint8_t file_data[0x200];
+
+/* An empty CBFS, as "cbfstool create" leaves an FMAP region. */
+static void reset_region(void)
+{
+	static const uint8_t empty_header[] = {
+		'L', 'A', 'R', 'C', 'H', 'I', 'V', 'E',
+		0x00, 0x00, 0x3f, 0xe4,		/* len */
+		0xff, 0xff, 0xff, 0xff,		/* type */
+		0x00, 0x00, 0x00, 0x00,		/* attributes_offset */
+		0x00, 0x00, 0x00, 0x1c,		/* offset */
+		0x00, 0x00, 0x00, 0x00,		/* filename */
+	};
+	int i;
+
+	memset(region, 0xff, sizeof(region));
+	memcpy(region, empty_header, sizeof(empty_header));
+	memcpy(blank, region, sizeof(blank));
+	for (i = 0; i < sizeof(file_data); i++)
+		file_data[i] = i;
+}
+
+static void synthetic_tests(void)
+{
+	size_t offset, size;
+
+	reset_region();
+	TEST_EQ(cbfs_region_find(region, sizeof(region), "a", &offset, &size),
+		VB2_ERROR_CBFS_NOT_FOUND, "Find in empty CBFS");
+	TEST_EQ(cbfs_region_remove(region, sizeof(region), "a"),
+		VB2_ERROR_CBFS_NOT_FOUND, "Remove from empty CBFS");
+
+	TEST_SUCC(cbfs_region_add_raw(region, sizeof(region), "a", file_data,
+				      100, 0x1000), "Add a");
+	TEST_SUCC(cbfs_region_find(region, sizeof(region), "a", &offset,
+				   &size), "  find a");
+	TEST_EQ(offset, 0x1000, "  offset");
+	TEST_EQ(size, 100, "  size");
+	TEST_EQ(memcmp(region + offset, file_data, size), 0, "  data");
+	TEST_EQ(cbfs_region_find(region, sizeof(region), "", &offset, &size),
+		VB2_ERROR_CBFS_NOT_FOUND, "  empty entries aren't files");
+
+	TEST_EQ(cbfs_region_add_raw(region, sizeof(region), "a", file_data,
+				    100, 0x2000),
+		VB2_ERROR_CBFS_EXISTS, "Add a again");
+	TEST_EQ(cbfs_region_add_raw(region, sizeof(region), "b", file_data,
+				    100, 0x1020),
+		VB2_ERROR_CBFS_NO_SPACE, "Add overlapping data");
+	TEST_EQ(cbfs_region_add_raw(region, sizeof(region), "b", file_data,
+				    100, 0x1080),
+		VB2_ERROR_CBFS_NO_SPACE, "Add with no room for the header");
+	TEST_EQ(cbfs_region_add_raw(region, sizeof(region), "b", file_data,
+				    100, 0x10),
+		VB2_ERROR_CBFS_NO_SPACE, "Add before the start");
+	TEST_EQ(cbfs_region_add_raw(region, sizeof(region), "b", file_data,
+				    0x200, REGION_SIZE - 0x100),
+		VB2_ERROR_CBFS_NO_SPACE, "Add past the end");
+
+	TEST_SUCC(cbfs_region_add_raw(region, sizeof(region), "b", file_data,
+				      sizeof(file_data), 0x10c0),
+		  "Add b right after a");
+	TEST_SUCC(cbfs_region_find(region, sizeof(region), "b", &offset,
+				   &size), "  find b");
+	TEST_EQ(offset, 0x10c0, "  offset");
+	TEST_EQ(memcmp(region + offset, file_data, size), 0, "  data");
+	TEST_SUCC(cbfs_region_find(region, sizeof(region), "a", &offset,
+				   &size), "  a still there");
+
+	TEST_SUCC(cbfs_region_remove(region, sizeof(region), "a"),
+		  "Remove a");
+	TEST_EQ(cbfs_region_find(region, sizeof(region), "a", &offset, &size),
+		VB2_ERROR_CBFS_NOT_FOUND, "  a gone");
+	TEST_SUCC(cbfs_region_find(region, sizeof(region), "b", &offset,
+				   &size), "  b still there");
+	TEST_SUCC(cbfs_region_add_raw(region, sizeof(region), "a", file_data,
+				      64, 0x40), "  reuse a's space");
+	TEST_SUCC(cbfs_region_remove(region, sizeof(region), "a"),
+		  "  remove a again");
+
+	TEST_SUCC(cbfs_region_remove(region, sizeof(region), "b"),
+		  "Remove b");
+	TEST_EQ(memcmp(region, blank, sizeof(region)), 0,
+		"  back to an empty CBFS");
+
+	/* Malformed header: data offset inside the fixed header */
+	TEST_SUCC(cbfs_region_add_raw(region, sizeof(region), "a", file_data,
+				      100, 0x1000), "Add a");
+	region[0xfc0 + 23] = 0x10;
+	TEST_EQ(cbfs_region_find(region, sizeof(region), "a", &offset, &size),
+		VB2_ERROR_CBFS_CORRUPT, "Find in corrupt CBFS");
+	TEST_EQ(cbfs_region_remove(region, sizeof(region), "a"),
+		VB2_ERROR_CBFS_CORRUPT, "Remove from corrupt CBFS");
+	TEST_EQ(cbfs_region_add_raw(region, sizeof(region), "b", file_data,
+				    100, 0x2000),
+		VB2_ERROR_CBFS_CORRUPT, "Add to corrupt CBFS");
+}
+
+/* Same edits as the eve_smm_store updater quirk, on a real image. */
+static void image_tests(const char *image_file)
+{
+	uint8_t *image, *legacy, *coreboot, *saved;
+	uint32_t image_size;
+	FmapAreaHeader *ah;
+	size_t offset, size;
+
+	if (vb2_read_file(image_file, &image, &image_size)) {
+		TEST_TRUE(0, "Read image");
+		return;
+	}
+
+	legacy = fmap_find_by_name(image, image_size, NULL, "RW_LEGACY", &ah);
+	TEST_PTR_NEQ(legacy, NULL, "Find RW_LEGACY");
+	if (!legacy)
+		goto done;
+	saved = malloc(ah->area_size);
+	memcpy(saved, legacy, ah->area_size);
+
+	TEST_SUCC(cbfs_region_find(legacy, ah->area_size, "altfw/list",
+				   &offset, &size), "Find altfw/list");
+	TEST_EQ(size, 40, "  size");
+	TEST_SUCC(cbfs_region_find(legacy, ah->area_size, "header pointer",
+				   &offset, &size), "Find last file");
+
+	TEST_SUCC(cbfs_region_add_raw(legacy, ah->area_size, "smm_store",
+				      file_data, sizeof(file_data), 0x1bf000),
+		  "Add smm_store at 0x1bf000");
+	TEST_SUCC(cbfs_region_find(legacy, ah->area_size, "smm_store",
+				   &offset, &size), "  find smm_store");
+	TEST_EQ(offset, 0x1bf000, "  offset");
+	TEST_SUCC(cbfs_region_find(legacy, ah->area_size, "header pointer",
+				   &offset, &size), "  last file still there");
+	TEST_SUCC(cbfs_region_remove(legacy, ah->area_size, "smm_store"),
+		  "Remove smm_store");
+	TEST_EQ(memcmp(legacy, saved, ah->area_size), 0,
+		"  RW_LEGACY restored");
+	free(saved);
+
+	coreboot = fmap_find_by_name(image, image_size, NULL, "COREBOOT", &ah);
+	TEST_PTR_NEQ(coreboot, NULL, "Find COREBOOT");
+	if (!coreboot)
+		goto done;
+	TEST_SUCC(cbfs_region_find(coreboot, ah->area_size, "config",
+				   &offset, &size), "Find config");
+	TEST_EQ(memcmp(coreboot + offset, "# This image", 12), 0,
+		"  contents");
+	TEST_EQ(cbfs_region_find(coreboot, ah->area_size, "locale_en.bin",
+				 &offset, &size),
+		VB2_ERROR_CBFS_COMPRESSED, "Find compressed file");
+	TEST_SUCC(cbfs_region_find(coreboot, ah->area_size, "bootblock",
+				   &offset, &size), "Find file after gap");
+
+done:
+	free(image);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <bios_image>\n", argv[0]);
+		return -1;
+	}
+
+	synthetic_tests();
+	image_tests(argv[1]);
+
+	return gTestSuccess ? 0 : 255;
+}
@@ -7,6 +7,7 @@
 
 #include "2common.h"
 #include "host_common.h"
+#include "host_key21.h"
 #include "test_common.h"
 
 /* Public key utility functions */
@@ -60,9 +61,45 @@ static void public_key_tests(void)
 		"vb2_copy_packed_key data");
 }
 
+/* Private keys in PKCS#11 tokens */
+static void pkcs11_key_tests(void)
+{
+	struct vb2_private_key key = {
+		.key_location = VB2_PRIVATE_KEY_PKCS11,
+		.hash_alg = VB2_HASH_SHA256,
+		.sig_alg = VB2_SIG_RSA2048,
+	};
+
+	TEST_PTR_EQ(vb2_read_private_key_pkcs11("/no/such/file.vbprivk"), NULL,
+		    "pkcs11 key without prefix");
+	TEST_PTR_EQ(vb2_read_private_key_pkcs11("pkcs11:"), NULL,
+		    "pkcs11 key empty");
+	TEST_PTR_EQ(vb2_read_private_key_pkcs11("pkcs11:lib.so:0"), NULL,
+		    "pkcs11 key no label");
+	TEST_PTR_EQ(vb2_read_private_key_pkcs11("pkcs11::0:label"), NULL,
+		    "pkcs11 key empty module");
+	TEST_PTR_EQ(vb2_read_private_key_pkcs11("pkcs11:lib.so::label"), NULL,
+		    "pkcs11 key empty slot");
+	TEST_PTR_EQ(vb2_read_private_key_pkcs11("pkcs11:lib.so:x:label"), NULL,
+		    "pkcs11 key bad slot");
+	TEST_PTR_EQ(vb2_read_private_key_pkcs11("pkcs11:lib.so:0:"), NULL,
+		    "pkcs11 key empty label");
+	TEST_PTR_EQ(vb2_read_private_key_pkcs11("pkcs11:lib.so:0:label:MD5"),
+		    NULL, "pkcs11 key bad hash");
+	TEST_PTR_EQ(vb2_read_private_key_pkcs11(
+			"pkcs11:/no/such/lib.so:0:label:SHA512"),
+		    NULL, "pkcs11 key bad module");
+	TEST_PTR_EQ(vb2_read_private_key("pkcs11:/no/such/lib.so:0:label"),
+		    NULL, "vb2_read_private_key() pkcs11 key");
+
+	TEST_NEQ(vb2_write_private_key("/dev/null", &key), VB2_SUCCESS,
+		 "vb2_write_private_key() pkcs11 key");
+}
+
 int main(int argc, char* argv[])
 {
 	public_key_tests();
+	pkcs11_key_tests();
 
 	return gTestSuccess ? 0 : 255;
 }
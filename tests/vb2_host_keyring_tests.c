@@ -0,0 +1,233 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for host library private key cache
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "2common.h"
+#include "2rsa.h"
+#include "2sysincludes.h"
+#include "host_common.h"
+#include "host_common21.h"
+#include "host_key21.h"
+#include "host_keyring.h"
+#include "host_signature21.h"
+#include "signature_digest.h"
+#include "test_common.h"
+
+static const uint8_t test_data[] = "Some test data";
+
+static void check_stats(uint32_t path_hits, uint32_t content_hits,
+			uint32_t loads, const char *desc)
+{
+	struct vb2_keyring_stats stats;
+
+	vb2_keyring_get_stats(&stats);
+	TEST_EQ(stats.path_hits, path_hits, desc);
+	TEST_EQ(stats.content_hits, content_hits, "  content hits");
+	TEST_EQ(stats.loads, loads, "  loads");
+}
+
+static void vbprivk_tests(const char *keys_dir, const char *temp_dir)
+{
+	char fname[1024], tname[1024], fname4096[1024];
+	const struct vb2_private_key *key, *key2;
+	struct vb2_private_key *fresh;
+	struct vb2_signature *sig, *sig2;
+	uint8_t digest[VB2_SHA256_DIGEST_SIZE];
+	uint8_t *buf;
+	uint32_t size;
+
+	sprintf(fname, "%s/key_rsa2048.sha256.vbprivk", keys_dir);
+	sprintf(fname4096, "%s/key_rsa4096.sha256.vbprivk", keys_dir);
+	sprintf(tname, "%s/keyring_test.vbprivk", temp_dir);
+
+	vb2_keyring_clear();
+	key = vb2_keyring_read_private_key(fname);
+	TEST_PTR_NEQ(key, NULL, "Keyring read vbprivk");
+	TEST_EQ(key->sig_alg, VB2_SIG_RSA2048, "  sig_alg");
+	TEST_EQ(key->hash_alg, VB2_HASH_SHA256, "  hash_alg");
+	check_stats(0, 0, 1, "  first read parses the key");
+
+	key2 = vb2_keyring_read_private_key(fname);
+	TEST_PTR_EQ(key2, key, "Keyring read vbprivk again");
+	check_stats(1, 0, 1, "  second read hits by path");
+
+	/* Cached key signs exactly like a freshly loaded one */
+	fresh = vb2_read_private_key(fname);
+	sig = vb2_calculate_signature(test_data, sizeof(test_data), key);
+	sig2 = vb2_calculate_signature(test_data, sizeof(test_data), fresh);
+	TEST_PTR_NEQ(sig, NULL, "  sign with cached key");
+	TEST_PTR_NEQ(sig2, NULL, "  sign with fresh key");
+	if (sig && sig2)
+		TEST_EQ(memcmp(vb2_signature_data(sig),
+			       vb2_signature_data(sig2), sig->sig_size), 0,
+			"  signatures match");
+	free(sig);
+	free(sig2);
+	vb2_free_private_key(fresh);
+
+	/* Lookup by content */
+	TEST_SUCC(vb2_read_file(fname, &buf, &size), "  read key file");
+	TEST_PTR_EQ(vb2_keyring_load_buffer(buf, size, VB2_KEYRING_VBPRIVK,
+					    VB2_ALG_COUNT),
+		    key, "Keyring load buffer hits by content");
+	check_stats(1, 1, 1, "  content hit");
+	vb2_digest_buffer(buf, size, VB2_HASH_SHA256, digest, sizeof(digest));
+	TEST_PTR_EQ(vb2_keyring_find(digest, VB2_KEYRING_VBPRIVK,
+				     VB2_ALG_COUNT),
+		    key, "Keyring find by digest");
+	TEST_PTR_EQ(vb2_keyring_find(digest, VB2_KEYRING_VB21, VB2_ALG_COUNT),
+		    NULL, "  not found as other format");
+
+	/* A copy at another path is the same key */
+	TEST_SUCC(vb2_write_file(tname, buf, size), "  write copy");
+	free(buf);
+	TEST_PTR_EQ(vb2_keyring_read_private_key(tname), key,
+		    "Keyring read copy");
+	check_stats(1, 2, 1, "  copy hits by content");
+	TEST_PTR_EQ(vb2_keyring_read_private_key(tname), key,
+		    "Keyring read copy again");
+	check_stats(2, 2, 1, "  copy now hits by path");
+
+	/* Replacing the file at that path is noticed */
+	TEST_SUCC(vb2_read_file(fname4096, &buf, &size), "  read other key");
+	TEST_SUCC(vb2_write_file(tname, buf, size), "  overwrite copy");
+	free(buf);
+	key2 = vb2_keyring_read_private_key(tname);
+	TEST_PTR_NEQ(key2, NULL, "Keyring read replaced file");
+	TEST_PTR_NEQ(key2, key, "  is a different key");
+	TEST_EQ(key2->sig_alg, VB2_SIG_RSA4096, "  sig_alg");
+	check_stats(2, 2, 2, "  replaced file is parsed");
+	TEST_PTR_EQ(vb2_keyring_read_private_key(fname), key,
+		    "  original path still cached");
+
+	/* Errors */
+	TEST_PTR_EQ(vb2_keyring_read_private_key("no_such_file"), NULL,
+		    "Keyring read missing file");
+	TEST_PTR_EQ(vb2_keyring_load_buffer(test_data, sizeof(test_data),
+					    VB2_KEYRING_VBPRIVK,
+					    VB2_ALG_COUNT),
+		    NULL, "Keyring load garbage");
+	TEST_PTR_EQ(vb2_keyring_load_buffer(test_data, 4, VB2_KEYRING_VBPRIVK,
+					    VB2_ALG_COUNT),
+		    NULL, "Keyring load too small");
+
+	vb2_keyring_clear();
+	check_stats(0, 0, 0, "Keyring clear resets stats");
+	TEST_PTR_NEQ(vb2_keyring_read_private_key(fname), NULL,
+		     "  read after clear");
+	check_stats(0, 0, 1, "  parsed again");
+
+	unlink(tname);
+	vb2_keyring_clear();
+}
+
+static void pem_tests(const char *keys_dir)
+{
+	char fname[1024];
+	const struct vb2_private_key *key, *key2;
+	struct vb2_private_key *fresh;
+	struct vb2_signature *sig;
+	uint8_t *sigbuf;
+	enum vb2_crypto_algorithm alg =
+		vb2_get_crypto_algorithm(VB2_HASH_SHA256, VB2_SIG_RSA2048);
+	enum vb2_crypto_algorithm alg2 =
+		vb2_get_crypto_algorithm(VB2_HASH_SHA512, VB2_SIG_RSA2048);
+
+	sprintf(fname, "%s/key_rsa2048.pem", keys_dir);
+
+	vb2_keyring_clear();
+	key = vb2_keyring_read_private_key_pem(fname, alg);
+	TEST_PTR_NEQ(key, NULL, "Keyring read pem");
+	TEST_EQ(key->hash_alg, VB2_HASH_SHA256, "  hash_alg");
+	TEST_PTR_EQ(vb2_keyring_read_private_key_pem(fname, alg), key,
+		    "  again");
+
+	key2 = vb2_keyring_read_private_key_pem(fname, alg2);
+	TEST_PTR_NEQ(key2, NULL, "Keyring read pem other algorithm");
+	TEST_PTR_NEQ(key2, key, "  is a separate key");
+	TEST_EQ(key2->hash_alg, VB2_HASH_SHA512, "  hash_alg");
+
+	TEST_PTR_EQ(vb2_keyring_read_private_key_pem(fname, VB2_ALG_COUNT),
+		    NULL, "Keyring read pem bad algorithm");
+
+	/* SignatureBuf() shares the keyring */
+	vb2_keyring_clear();
+	fresh = vb2_read_private_key_pem(fname, alg);
+	sig = vb2_calculate_signature(test_data, sizeof(test_data), fresh);
+	sigbuf = SignatureBuf(test_data, sizeof(test_data), fname, alg);
+	TEST_PTR_NEQ(sigbuf, NULL, "SignatureBuf");
+	if (sig && sigbuf)
+		TEST_EQ(memcmp(sigbuf, vb2_signature_data(sig),
+			       sig->sig_size), 0, "  signature matches");
+	free(sigbuf);
+	sigbuf = SignatureBuf(test_data, sizeof(test_data), fname, alg);
+	TEST_PTR_NEQ(sigbuf, NULL, "SignatureBuf again");
+	check_stats(1, 0, 1, "  key parsed once");
+	free(sigbuf);
+	free(sig);
+	vb2_free_private_key(fresh);
+
+	vb2_keyring_clear();
+}
+
+static void vb21_tests(const char *keys_dir, const char *temp_dir)
+{
+	char fname[1024], tname[1024];
+	struct vb2_private_key *prik;
+	const struct vb2_private_key *key, *key2;
+	struct vb21_signature *sig, *sig2;
+
+	sprintf(fname, "%s/key_rsa2048.pem", keys_dir);
+	sprintf(tname, "%s/keyring_test.vbprik2", temp_dir);
+
+	TEST_SUCC(vb2_private_key_read_pem(&prik, fname), "Read pem");
+	prik->sig_alg = VB2_SIG_RSA2048;
+	prik->hash_alg = VB2_HASH_SHA256;
+	vb2_private_key_set_desc(prik, "keyring test key");
+	TEST_SUCC(vb21_private_key_write(prik, tname), "  write vb21");
+
+	vb2_keyring_clear();
+	TEST_SUCC(vb21_keyring_private_key_read(&key, tname),
+		  "Keyring read vb21");
+	TEST_STR_EQ(key->desc, "keyring test key", "  desc");
+	TEST_SUCC(vb21_keyring_private_key_read(&key2, tname), "  again");
+	TEST_PTR_EQ(key2, key, "  same key");
+	check_stats(1, 0, 1, "  parsed once");
+
+	TEST_SUCC(vb21_sign_data(&sig, test_data, sizeof(test_data), key,
+				 NULL), "  sign with cached key");
+	TEST_SUCC(vb21_sign_data(&sig2, test_data, sizeof(test_data), prik,
+				 NULL), "  sign with fresh key");
+	TEST_EQ(memcmp(sig, sig2, sig->c.total_size), 0,
+		"  signatures match");
+	free(sig);
+	free(sig2);
+
+	TEST_EQ(vb21_keyring_private_key_read(&key, fname),
+		VB2_ERROR_KEYRING_READ, "Keyring read vb21 wrong format");
+	TEST_PTR_EQ(key, NULL, "  no key");
+
+	vb2_private_key_free(prik);
+	unlink(tname);
+	vb2_keyring_clear();
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <keys_dir> <temp_dir>\n", argv[0]);
+		return -1;
+	}
+
+	vbprivk_tests(argv[1], argv[2]);
+	pem_tests(argv[1]);
+	vb21_tests(argv[1], argv[2]);
+
+	return gTestSuccess ? 0 : 255;
+}
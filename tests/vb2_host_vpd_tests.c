@@ -0,0 +1,228 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for the VPD reader
+ */
+
+#include <stdio.h>
+
+#include "fmap.h"
+#include "host_misc.h"
+#include "test_common.h"
+#include "vpd.h"
+
+#define INFO_HEADER(size) \
+	0xfe, 0x09, 0x01, 'g', 'V', 'p', 'd', 'I', 'n', 'f', 'o', 0x04, \
+	(size), 0x00, 0x00, 0x00
+
+static const uint8_t plain[] = {
+	0x01, 0x06, 'r', 'e', 'g', 'i', 'o', 'n', 0x02, 'u', 's',
+	0x01, 0x0e, 'w', 'h', 'i', 't', 'e', 'l', 'a', 'b', 'e', 'l', '_',
+	't', 'a', 'g', 0x02, 'w', 'l',
+	0x01, 0x01, 'e', 0x00,
+	0x00,
+	/* Ignored after the terminator */
+	0x01, 0x01, 'x', 0x01, 'y',
+};
+
+static const uint8_t with_info[] = {
+	INFO_HEADER(9),
+	0x01, 0x01, 'a', 0x01, '1',
+	0xfe, 0x01, 'i', 0x00,
+	/* Past the size in the header */
+	0x01, 0x01, 'b', 0x01, '2',
+};
+
+static const uint8_t duplicate[] = {
+	0x01, 0x01, 'k', 0x05, 'f', 'i', 'r', 's', 't',
+	0x01, 0x01, 'k', 0x06, 's', 'e', 'c', 'o', 'n', 'd',
+	0xff, 0xff, 0xff, 0xff,
+};
+
+static void parse_tests(void)
+{
+	struct vpd vpd;
+	uint8_t buf[512];
+	size_t i;
+
+	TEST_SUCC(vpd_parse(&vpd, plain, sizeof(plain)), "Parse plain");
+	TEST_EQ(vpd.num_entries, 3, "  entries");
+	TEST_STR_EQ(vpd_get_value(&vpd, "region"), "us", "  region");
+	TEST_STR_EQ(vpd_get_value(&vpd, "whitelabel_tag"), "wl", "  wl tag");
+	TEST_STR_EQ(vpd_get_value(&vpd, "e"), "", "  empty value");
+	TEST_PTR_EQ(vpd_get_value(&vpd, "x"), NULL, "  after terminator");
+	TEST_PTR_EQ(vpd_get_value(&vpd, "missing"), NULL, "  missing key");
+	TEST_PTR_EQ(vpd_get_value(&vpd, "regio"), NULL, "  key prefix");
+	vpd_free(&vpd);
+	TEST_EQ(vpd.num_entries, 0, "  freed");
+
+	/* Runs to the end of the data without a terminator */
+	TEST_SUCC(vpd_parse(&vpd, plain, 11), "Parse unterminated");
+	TEST_EQ(vpd.num_entries, 1, "  entries");
+	TEST_STR_EQ(vpd_get_value(&vpd, "region"), "us", "  region");
+	vpd_free(&vpd);
+
+	TEST_SUCC(vpd_parse(&vpd, with_info, sizeof(with_info)),
+		  "Parse with gVpdInfo");
+	TEST_EQ(vpd.num_entries, 1, "  entries");
+	TEST_STR_EQ(vpd_get_value(&vpd, "a"), "1", "  a");
+	TEST_PTR_EQ(vpd_get_value(&vpd, "i"), NULL, "  info entry skipped");
+	TEST_PTR_EQ(vpd_get_value(&vpd, "b"), NULL, "  past info size");
+	vpd_free(&vpd);
+
+	TEST_SUCC(vpd_parse(&vpd, duplicate, sizeof(duplicate)),
+		  "Parse duplicate key");
+	TEST_EQ(vpd.num_entries, 2, "  entries");
+	TEST_STR_EQ(vpd_get_value(&vpd, "k"), "first", "  first one wins");
+	vpd_free(&vpd);
+
+	memset(buf, 0xff, sizeof(buf));
+	TEST_SUCC(vpd_parse(&vpd, buf, sizeof(buf)), "Parse erased");
+	TEST_EQ(vpd.num_entries, 0, "  entries");
+	vpd_free(&vpd);
+
+	TEST_SUCC(vpd_parse(&vpd, buf, 0), "Parse empty");
+	TEST_EQ(vpd.num_entries, 0, "  entries");
+	vpd_free(&vpd);
+
+	/* 300-byte value needs a two-byte length */
+	buf[0] = 0x01;
+	buf[1] = 0x01;
+	buf[2] = 'v';
+	buf[3] = 0x80 | (300 >> 7);
+	buf[4] = 300 & 0x7f;
+	for (i = 0; i < 300; i++)
+		buf[5 + i] = 'a' + i % 26;
+	buf[305] = 0x00;
+	TEST_SUCC(vpd_parse(&vpd, buf, sizeof(buf)), "Parse long value");
+	TEST_EQ(strlen(vpd_get_value(&vpd, "v")), 300, "  length");
+	TEST_EQ(vpd_get_value(&vpd, "v")[299], 'a' + 299 % 26, "  data");
+	vpd_free(&vpd);
+}
+
+static void error_tests(void)
+{
+	static const uint8_t bad_type[] = {
+		0x01, 0x01, 'a', 0x01, '1',
+		0x02, 0x01, 'b', 0x01, '2',
+	};
+	static const uint8_t long_len[] = {
+		0x01, 0x81, 0x82, 0x83, 0x84, 0x85, 0x06,
+	};
+	static const uint8_t big_info[] = {
+		INFO_HEADER(5),
+		0x01, 0x01, 'a', 0x01,
+	};
+	struct vpd vpd;
+
+	TEST_EQ(vpd_parse(&vpd, bad_type, sizeof(bad_type)),
+		VB2_ERROR_VPD_TYPE, "Unknown type");
+	vpd_free(&vpd);
+
+	TEST_EQ(vpd_parse(&vpd, plain, 10), VB2_ERROR_VPD_TRUNCATED,
+		"Truncated value");
+	vpd_free(&vpd);
+	TEST_EQ(vpd_parse(&vpd, plain, 5), VB2_ERROR_VPD_TRUNCATED,
+		"Truncated key");
+	vpd_free(&vpd);
+	TEST_EQ(vpd_parse(&vpd, plain, 1), VB2_ERROR_VPD_TRUNCATED,
+		"Missing key length");
+	vpd_free(&vpd);
+	TEST_EQ(vpd_parse(&vpd, plain, 1 + 1 + 6), VB2_ERROR_VPD_TRUNCATED,
+		"Missing value length");
+	vpd_free(&vpd);
+	TEST_EQ(vpd_parse(&vpd, long_len, sizeof(long_len)),
+		VB2_ERROR_VPD_TRUNCATED, "Length too long");
+	vpd_free(&vpd);
+	TEST_EQ(vpd_parse(&vpd, long_len, 3), VB2_ERROR_VPD_TRUNCATED,
+		"Length past end");
+	vpd_free(&vpd);
+
+	TEST_EQ(vpd_parse(&vpd, big_info, sizeof(big_info)),
+		VB2_ERROR_VPD_INFO_SIZE, "gVpdInfo size too big");
+	vpd_free(&vpd);
+}
+
+/* An image holding an FMAP and a single VPD section */
+struct fmap_image {
+	FmapHeader header;
+	FmapAreaHeader area;
+	uint8_t vpd[sizeof(plain)];
+} __attribute__((packed));
+
+static void section_tests(void)
+{
+	struct fmap_image image;
+	struct vpd vpd;
+
+	memset(&image, 0, sizeof(image));
+	memcpy(image.header.fmap_signature, FMAP_SIGNATURE,
+	       FMAP_SIGNATURE_SIZE);
+	image.header.fmap_ver_major = FMAP_VER_MAJOR;
+	image.header.fmap_size = sizeof(image);
+	image.header.fmap_nareas = 1;
+	strcpy(image.area.area_name, "RO_VPD");
+	image.area.area_offset = offsetof(struct fmap_image, vpd);
+	image.area.area_size = sizeof(image.vpd);
+	memcpy(image.vpd, plain, sizeof(plain));
+
+	TEST_SUCC(vpd_parse_section(&vpd, (uint8_t *)&image, sizeof(image),
+				    "RO_VPD"), "Parse section");
+	TEST_STR_EQ(vpd_get_value(&vpd, "whitelabel_tag"), "wl", "  wl tag");
+	vpd_free(&vpd);
+
+	TEST_EQ(vpd_parse_section(&vpd, (uint8_t *)&image, sizeof(image),
+				  "RW_VPD"), VB2_ERROR_VPD_SECTION,
+		"Missing section");
+	vpd_free(&vpd);
+
+	image.area.area_size++;
+	TEST_EQ(vpd_parse_section(&vpd, (uint8_t *)&image, sizeof(image),
+				  "RO_VPD"), VB2_ERROR_VPD_SECTION,
+		"Section past end of image");
+	vpd_free(&vpd);
+
+	image.area.area_size = 1;
+	image.area.area_offset = 0xffffffff;
+	TEST_EQ(vpd_parse_section(&vpd, (uint8_t *)&image, sizeof(image),
+				  "RO_VPD"), VB2_ERROR_VPD_SECTION,
+		"Section offset past end of image");
+	vpd_free(&vpd);
+}
+
+/* A VPD written by the vpd utility, behind an SMBIOS entry point */
+static void smbios_tests(const char *filename)
+{
+	struct vpd vpd;
+	uint8_t *data;
+	uint32_t size;
+
+	if (!TEST_SUCC(vb2_read_file(filename, &data, &size),
+		       "Read SMBIOS VPD"))
+		return;
+
+	TEST_SUCC(vpd_parse(&vpd, data, size), "Parse SMBIOS VPD");
+	TEST_EQ(vpd.num_entries, 2, "  entries");
+	TEST_STR_EQ(vpd_get_value(&vpd, "serial_number"), "TEST",
+		    "  serial_number");
+	TEST_STR_EQ(vpd_get_value(&vpd, "region"), "us", "  region");
+	vpd_free(&vpd);
+
+	free(data);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <ro_vpd.bin>\n", argv[0]);
+		return -1;
+	}
+
+	parse_tests();
+	error_tests();
+	section_tests();
+	smbios_tests(argv[1]);
+
+	return gTestSuccess ? 0 : 255;
+}
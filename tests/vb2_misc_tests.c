@@ -27,6 +27,7 @@ static struct vb2_secdata_fwmp *fwmp;
 static enum vb2_resource_index mock_resource_index;
 static void *mock_resource_ptr;
 static uint32_t mock_resource_size;
+static int mock_resource_mapped;
 static int mock_tpm_clear_called;
 static int mock_tpm_clear_retval;
 static int allow_recovery_retval;
@@ -51,6 +52,7 @@ static void reset_common_data(void)
 
 	fwmp = (struct vb2_secdata_fwmp *)&ctx->secdata_fwmp;
 
+	mock_resource_mapped = 0;
 	mock_tpm_clear_called = 0;
 	mock_tpm_clear_retval = VB2_SUCCESS;
 	allow_recovery_retval = 0;
@@ -82,6 +84,21 @@ vb2_error_t vb2ex_read_resource(struct vb2_context *c,
 	return VB2_SUCCESS;
 }
 
+vb2_error_t vb2ex_map_resource(struct vb2_context *c,
+			       enum vb2_resource_index index,
+			       const void **buf_ptr, uint32_t *size_ptr)
+{
+	if (!mock_resource_mapped)
+		return VB2_ERROR_EX_UNIMPLEMENTED;
+
+	if (index != mock_resource_index)
+		return VB2_ERROR_EX_READ_RESOURCE_INDEX;
+
+	*buf_ptr = mock_resource_ptr;
+	*size_ptr = mock_resource_size;
+	return VB2_SUCCESS;
+}
+
 vb2_error_t vb2ex_tpm_clear_owner(struct vb2_context *c)
 {
 	mock_tpm_clear_called++;
@@ -276,6 +293,36 @@ static void misc_tests(void)
 	/* Would exit here if it didn't work as intended. */
 }
 
+static void map_resource_tests(void)
+{
+	uint32_t data[8];
+
+	reset_common_data();
+	mock_resource_index = VB2_RES_GBB;
+	mock_resource_ptr = data;
+	mock_resource_size = sizeof(data);
+	TEST_PTR_EQ(vb2_map_resource(ctx, VB2_RES_GBB, 0, sizeof(data)), NULL,
+		    "vb2_map_resource() unimplemented");
+
+	mock_resource_mapped = 1;
+	TEST_PTR_EQ(vb2_map_resource(ctx, VB2_RES_GBB, 0, sizeof(data)), data,
+		    "vb2_map_resource() all");
+	TEST_PTR_EQ(vb2_map_resource(ctx, VB2_RES_GBB, 8, 4), &data[2],
+		    "vb2_map_resource() part");
+	TEST_PTR_EQ(vb2_map_resource(ctx, VB2_RES_GBB, sizeof(data), 0),
+		    &data[8], "vb2_map_resource() empty at end");
+	TEST_PTR_EQ(vb2_map_resource(ctx, VB2_RES_FW_VBLOCK, 0, 4), NULL,
+		    "vb2_map_resource() bad index");
+	TEST_PTR_EQ(vb2_map_resource(ctx, VB2_RES_GBB, 4, sizeof(data)), NULL,
+		    "vb2_map_resource() past end");
+	TEST_PTR_EQ(vb2_map_resource(ctx, VB2_RES_GBB, sizeof(data) + 4, 0),
+		    NULL, "vb2_map_resource() offset past end");
+	TEST_PTR_EQ(vb2_map_resource(ctx, VB2_RES_GBB, 4, 0xfffffffe), NULL,
+		    "vb2_map_resource() size wraps");
+	TEST_PTR_EQ(vb2_map_resource(ctx, VB2_RES_GBB, 2, 4), NULL,
+		    "vb2_map_resource() unaligned");
+}
+
 static void gbb_tests(void)
 {
 	struct vb2_gbb_header gbbsrc = {
@@ -1109,6 +1156,7 @@ int main(int argc, char* argv[])
 {
 	init_workbuf_tests();
 	misc_tests();
+	map_resource_tests();
 	gbb_tests();
 	fail_tests();
 	recovery_tests();
@@ -65,6 +65,8 @@ static struct nv_field nvfields[] = {
 static struct nv_field nv2fields[] = {
 	{VB2_NV_FW_MAX_ROLLFORWARD, 0, VB2_FW_MAX_ROLLFORWARD_V1_DEFAULT,
 	 0x87654321, "firmware max rollforward"},
+	{VB2_NV_KERNEL_LAST_GOOD_PARTITION, 0, 0, 4,
+	 "kernel last good partition"},
 	{0, 0, 0, 0, NULL}
 };
 
@@ -250,6 +252,11 @@ static void nv_storage_test(uint32_t ctxflags)
 	vb2_nv_set(ctx, VB2_NV_LOCALIZATION_INDEX, 0x102);
 	TEST_EQ(vb2_nv_get(ctx, VB2_NV_LOCALIZATION_INDEX),
 		0, "Localization index out of range");
+	if (ctxflags) {
+		vb2_nv_set(ctx, VB2_NV_KERNEL_LAST_GOOD_PARTITION, 0x103);
+		TEST_EQ(vb2_nv_get(ctx, VB2_NV_KERNEL_LAST_GOOD_PARTITION),
+			0, "Kernel last good partition out of range");
+	}
 
 	vb2_nv_set(ctx, VB2_NV_FW_RESULT, 100);
 	TEST_EQ(vb2_nv_get(ctx, VB2_NV_FW_RESULT),
@@ -0,0 +1,131 @@
+#!/bin/bash
+
+# Copyright 2021 The Chromium OS Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+#
+# Run tests for signing with private keys held in a PKCS#11 token, using
+# SoftHSMv2.  PKCS #1 v1.5 signatures are deterministic, so everything signed
+# through the token must match what is signed with the same key from a file.
+
+# Load common constants and variables.
+. "$(dirname "$0")/common.sh"
+
+if ! type softhsm2-util >/dev/null 2>&1; then
+  warning "softhsm2-util not found, skipping PKCS#11 tests."
+  exit 0
+fi
+
+SOFTHSM_LIB=
+for lib in /usr/lib/softhsm/libsofthsm2.so \
+           /usr/lib/*/softhsm/libsofthsm2.so \
+           /usr/local/lib/softhsm/libsofthsm2.so; do
+  if [ -e "${lib}" ]; then
+    SOFTHSM_LIB="${lib}"
+    break
+  fi
+done
+[ -n "${SOFTHSM_LIB}" ] || error "Cannot find libsofthsm2.so."
+
+PKCS11_DIR="${TEST_DIR}/pkcs11"
+rm -rf "${PKCS11_DIR}"
+mkdir -p "${PKCS11_DIR}/tokens"
+export SOFTHSM2_CONF="${PKCS11_DIR}/softhsm2.conf"
+echo "directories.tokendir = ${PKCS11_DIR}/tokens" > "${SOFTHSM2_CONF}"
+export VBOOT_PKCS11_PIN=1234
+
+SLOT="$(softhsm2-util --init-token --free --label vboot \
+  --pin "${VBOOT_PKCS11_PIN}" --so-pin 5678 |
+  sed -n 's/.* to slot \([0-9]*\).*/\1/p')"
+[ -n "${SLOT}" ] || error "Cannot initialize SoftHSM token."
+
+return_code=0
+
+# Imports the test key of each length into the token, labelled by its length.
+function import_test_keys {
+  local id=1
+  for keylen in ${key_lengths[@]}
+  do
+    openssl pkcs8 -topk8 -nocrypt \
+      -in "${TESTKEY_DIR}/key_rsa${keylen}.pem" \
+      -out "${PKCS11_DIR}/key_rsa${keylen}.p8" || return_code=255
+    softhsm2-util --import "${PKCS11_DIR}/key_rsa${keylen}.p8" \
+      --token vboot --label "rsa${keylen}" --id "$(printf '%02x' ${id})" \
+      --pin "${VBOOT_PKCS11_PIN}" >/dev/null || return_code=255
+    let id=id+1
+  done
+}
+
+function test_keyblock_single {
+  local keylen=$1
+  local hashalgo=$2
+  local name="pkcs11:${SOFTHSM_LIB}:${SLOT}:rsa${keylen}:${hashalgo}"
+
+  echo -e "For signing key ${COL_YELLOW}RSA-$keylen/$hashalgo${COL_STOP}:"
+  ${FUTILITY} vbutil_keyblock \
+    --pack "${PKCS11_DIR}/file.keyblock" \
+    --datapubkey "${TESTKEY_DIR}/key_rsa2048.sha256.vbpubk" \
+    --signprivate "${TESTKEY_DIR}/key_rsa${keylen}.${hashalgo}.vbprivk" &&
+  ${FUTILITY} vbutil_keyblock \
+    --pack "${PKCS11_DIR}/pkcs11.keyblock" \
+    --datapubkey "${TESTKEY_DIR}/key_rsa2048.sha256.vbpubk" \
+    --signprivate "${name}" &&
+  cmp "${PKCS11_DIR}/file.keyblock" "${PKCS11_DIR}/pkcs11.keyblock"
+  if [ $? -ne 0 ]
+  then
+    return_code=255
+  fi
+}
+
+function test_keyblock {
+  for keylen in ${key_lengths[@]}
+  do
+    for hashalgo in ${hash_algos[@]}
+    do
+      if [ -e "${TESTKEY_DIR}/key_rsa${keylen}.${hashalgo}.vbprivk" ]
+      then
+        test_keyblock_single ${keylen} ${hashalgo}
+      fi
+    done
+  done
+}
+
+# Kernel partitions need both body and preamble signatures from one key.
+function test_kernel_single {
+  local out=$1
+  local key=$2
+
+  ${FUTILITY} vbutil_kernel \
+    --pack "${out}" \
+    --keyblock "${SRCDIR}/tests/devkeys/kernel.keyblock" \
+    --signprivate "${key}" \
+    --version 1 \
+    --vmlinuz "${PKCS11_DIR}/vmlinuz" \
+    --config "${PKCS11_DIR}/config" \
+    --bootloader "${PKCS11_DIR}/bootloader" \
+    --arch x86
+}
+
+function test_kernel {
+  echo -e "For ${COL_YELLOW}kernel partition${COL_STOP}:"
+  head -c 65536 /dev/urandom > "${PKCS11_DIR}/vmlinuz"
+  echo "console=tty0" > "${PKCS11_DIR}/config"
+  echo "bootloader" > "${PKCS11_DIR}/bootloader"
+  test_kernel_single "${PKCS11_DIR}/file.kernel" \
+    "${TESTKEY_DIR}/key_rsa2048.sha256.vbprivk" &&
+  test_kernel_single "${PKCS11_DIR}/pkcs11.kernel" \
+    "pkcs11:${SOFTHSM_LIB}:${SLOT}:rsa2048" &&
+  cmp "${PKCS11_DIR}/file.kernel" "${PKCS11_DIR}/pkcs11.kernel"
+  if [ $? -ne 0 ]
+  then
+    return_code=255
+  fi
+}
+
+check_test_keys
+import_test_keys
+echo "Testing signing with PKCS#11 keys..."
+test_keyblock
+test_kernel
+
+exit $return_code
@@ -0,0 +1,36 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* FIPS 180-2 Tests for message digest functions. */
+
+#include <stdio.h>
+#include <sys/auxv.h>
+
+#include "sha256_hwcrypto_tests.h"
+
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2 (1 << 6)
+#endif
+
+int main(int argc, char *argv[])
+{
+	if (!(getauxval(AT_HWCAP) & HWCAP_SHA2)) {
+		fprintf(stderr, "ARMv8 SHA-256 instructions not supported, "
+			"skipping.\n");
+		return 0;
+	}
+
+	/* Initialize long_msg with 'a' x 1,000,000 */
+	long_msg = (char *) malloc(1000001);
+	memset(long_msg, 'a', 1000000);
+	long_msg[1000000]=0;
+
+	sha256_tests();
+	known_value_tests();
+
+	free(long_msg);
+
+	return gTestSuccess ? 0 : 255;
+}
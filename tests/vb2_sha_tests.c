@@ -7,6 +7,7 @@
 
 #include <stdio.h>
 
+#include "2common.h"
 #include "2return_codes.h"
 #include "2rsa.h"
 #include "2sha.h"
@@ -130,6 +131,48 @@ static void sha512_tests(void)
 		"vb2_hash_block_size(VB2_HASH_SHA512)");
 }
 
+static void blake3_tests(void)
+{
+	uint8_t digest[VB2_BLAKE3_DIGEST_SIZE];
+	struct vb2_digest_context dc;
+	uint8_t *input;
+	uint32_t size, offset, step;
+	int i;
+
+	input = malloc(BLAKE3_TEST_INPUT_SIZE);
+	for (i = 0; i < BLAKE3_TEST_INPUT_SIZE; i++)
+		input[i] = i % 251;
+
+	for (i = 0; i < ARRAY_SIZE(blake3_lengths); i++) {
+		size = blake3_lengths[i];
+		TEST_SUCC(vb2_digest_buffer(input, size, VB2_HASH_BLAKE3,
+					    digest, sizeof(digest)),
+			  "vb2_digest_buffer() BLAKE3");
+		TEST_EQ(memcmp(digest, blake3_results[i], sizeof(digest)),
+			0, "BLAKE3 digest");
+
+		/* Extends that do not line up with blocks or chunks */
+		step = size / 3 + 1;
+		vb2_digest_init(&dc, VB2_HASH_BLAKE3);
+		for (offset = 0; offset < size; offset += step)
+			vb2_digest_extend(&dc, input + offset,
+					  VB2_MIN(step, size - offset));
+		vb2_digest_finalize(&dc, digest, sizeof(digest));
+		TEST_EQ(memcmp(digest, blake3_results[i], sizeof(digest)),
+			0, "BLAKE3 digest, multiple extends");
+	}
+
+	TEST_EQ(vb2_digest_buffer(input, 1, VB2_HASH_BLAKE3, digest,
+				  sizeof(digest) - 1),
+		VB2_ERROR_SHA_FINALIZE_DIGEST_SIZE,
+		"vb2_digest_buffer() too small");
+
+	TEST_EQ(vb2_hash_block_size(VB2_HASH_BLAKE3), VB2_BLAKE3_BLOCK_SIZE,
+		"vb2_hash_block_size(VB2_HASH_BLAKE3)");
+
+	free(input);
+}
+
 static void misc_tests(void)
 {
 	uint8_t digest[VB2_SHA512_DIGEST_SIZE];
@@ -201,6 +244,10 @@ static void known_value_tests(void)
 		"\xe3\xb0\xc4\x42\x98\xfc\x1c\x14\x9a\xfb\xf4\xc8\x99\x6f\xb9"
 		"\x24\x27\xae\x41\xe4\x64\x9b\x93\x4c\xa4\x95\x99\x1b\x78\x52"
 		"\xb8\x55");
+	TEST_KNOWN_VALUE(VB2_HASH_BLAKE3, "",
+		"\xaf\x13\x49\xb9\xf5\xf9\xa1\xa6\xa0\x40\x4d\xea\x36\xdc\xc9"
+		"\x49\x9b\xcb\x25\xc9\xad\xc1\x12\xb7\xcc\x9a\x93\xca\xe4\x1f"
+		"\x32\x62");
 	TEST_KNOWN_VALUE(VB2_HASH_SHA512, "",
 		"\xcf\x83\xe1\x35\x7e\xef\xb8\xbd\xf1\x54\x28\x50\xd6\x6d\x80"
 		"\x07\xd6\x20\xe4\x05\x0b\x57\x15\xdc\x83\xf4\xa9\x21\xd3\x6c"
@@ -226,6 +273,10 @@ static void known_value_tests(void)
 		"\xcf\x5b\x16\xa7\x78\xaf\x83\x80\x03\x6c\xe5\x9e\x7b\x04\x92"
 		"\x37\x0b\x24\x9b\x11\xe8\xf0\x7a\x51\xaf\xac\x45\x03\x7a\xfe"
 		"\xe9\xd1");
+	TEST_KNOWN_VALUE(VB2_HASH_BLAKE3, long_test_string,
+		"\x55\x3e\x1a\xa2\xa4\x77\xcb\x31\x66\xe6\xab\x38\xc1\x2d\x59"
+		"\xf6\xc5\x01\x7f\x08\x85\xaa\xf0\x79\xf2\x17\xda\x00\xcf\xca"
+		"\x36\x3f");
 	TEST_KNOWN_VALUE(VB2_HASH_SHA512, long_test_string,
 		"\x8e\x95\x9b\x75\xda\xe3\x13\xda\x8c\xf4\xf7\x28\x14\xfc\x14"
 		"\x3f\x8f\x77\x79\xc6\xeb\x9f\x7f\xa1\x72\x99\xae\xad\xb6\x88"
@@ -255,6 +306,7 @@ int main(int argc, char *argv[])
 	sha1_tests();
 	sha256_tests();
 	sha512_tests();
+	blake3_tests();
 	misc_tests();
 	known_value_tests();
 
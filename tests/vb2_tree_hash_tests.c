@@ -0,0 +1,335 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for tree-hashed data signatures
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+
+#include "2api.h"
+#include "2common.h"
+#include "2rsa.h"
+#include "2sha.h"
+#include "2sysincludes.h"
+#include "host_common.h"
+#include "host_key21.h"
+#include "test_common.h"
+
+#define CHUNK_SIZE 4096
+#define NUM_THREADS 4
+
+static uint8_t test_data[CHUNK_SIZE * (VB2_TREE_HASH_BATCH + 3) + 100];
+
+/* Mock data */
+static int mock_chunks_calls;
+static int mock_chunks_threaded;
+static vb2_error_t mock_chunks_retval;
+
+struct hash_job {
+	enum vb2_hash_algorithm hash_alg;
+	const uint8_t *buf;
+	uint32_t size;
+	uint32_t chunk_size;
+	uint8_t *digests;
+	uint32_t digest_size;
+	uint32_t first;
+	uint32_t count;
+	vb2_error_t rv;
+};
+
+static void *hash_thread(void *arg)
+{
+	struct hash_job *job = arg;
+	uint32_t i;
+
+	job->rv = VB2_SUCCESS;
+	for (i = job->first; i < job->first + job->count; i++) {
+		uint32_t offs = i * job->chunk_size;
+		uint32_t len = VB2_MIN(job->chunk_size, job->size - offs);
+
+		job->rv = vb2_digest_buffer(job->buf + offs, len,
+					    job->hash_alg,
+					    job->digests + i * job->digest_size,
+					    job->digest_size);
+		if (job->rv)
+			break;
+	}
+	return NULL;
+}
+
+/* Mocked functions */
+
+/* Hashes the chunks of each batch on NUM_THREADS threads */
+vb2_error_t vb2ex_hwcrypto_digest_chunks(enum vb2_hash_algorithm hash_alg,
+					 const uint8_t *buf, uint32_t size,
+					 uint32_t chunk_size, uint8_t *digests,
+					 uint32_t digests_size)
+{
+	struct hash_job jobs[NUM_THREADS];
+	pthread_t threads[NUM_THREADS];
+	uint32_t digest_size = vb2_digest_size(hash_alg);
+	uint32_t count = (size + chunk_size - 1) / chunk_size;
+	uint32_t per_thread = (count + NUM_THREADS - 1) / NUM_THREADS;
+	uint32_t first = 0;
+	int i;
+
+	mock_chunks_calls++;
+	if (mock_chunks_retval)
+		return mock_chunks_retval;
+	if (!mock_chunks_threaded)
+		return VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
+	if (digests_size < count * digest_size)
+		return VB2_ERROR_SHA_FINALIZE_DIGEST_SIZE;
+
+	for (i = 0; i < NUM_THREADS; i++) {
+		jobs[i] = (struct hash_job){
+			.hash_alg = hash_alg,
+			.buf = buf,
+			.size = size,
+			.chunk_size = chunk_size,
+			.digests = digests,
+			.digest_size = digest_size,
+			.first = first,
+			.count = VB2_MIN(per_thread, count - first),
+		};
+		first += jobs[i].count;
+		pthread_create(&threads[i], NULL, hash_thread, &jobs[i]);
+	}
+
+	for (i = 0; i < NUM_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+		if (jobs[i].rv)
+			return jobs[i].rv;
+	}
+
+	return VB2_SUCCESS;
+}
+
+static void reset_mocks(int threaded)
+{
+	mock_chunks_calls = 0;
+	mock_chunks_threaded = threaded;
+	mock_chunks_retval = VB2_SUCCESS;
+}
+
+/* Straightforward reference implementation of the tree digest */
+static void ref_tree_digest(const uint8_t *data, uint32_t size,
+			    uint32_t chunk_size,
+			    enum vb2_hash_algorithm hash_alg, uint8_t *digest)
+{
+	struct vb2_digest_context dc;
+	uint8_t chunk_digest[VB2_MAX_DIGEST_SIZE];
+	uint32_t digest_size = vb2_digest_size(hash_alg);
+	uint32_t offs;
+
+	vb2_digest_init(&dc, hash_alg);
+	for (offs = 0; offs < size; offs += chunk_size) {
+		vb2_digest_buffer(data + offs, VB2_MIN(chunk_size, size - offs),
+				  hash_alg, chunk_digest, digest_size);
+		vb2_digest_extend(&dc, chunk_digest, digest_size);
+	}
+	vb2_digest_finalize(&dc, digest, digest_size);
+}
+
+static void tree_digest_tests(enum vb2_hash_algorithm hash_alg)
+{
+	const uint32_t sizes[] = {
+		0, 1, CHUNK_SIZE - 1, CHUNK_SIZE, CHUNK_SIZE + 1,
+		CHUNK_SIZE * VB2_TREE_HASH_BATCH,
+		CHUNK_SIZE * VB2_TREE_HASH_BATCH + 1,
+		sizeof(test_data),
+	};
+	uint8_t expect[VB2_MAX_DIGEST_SIZE];
+	uint8_t digest[VB2_MAX_DIGEST_SIZE];
+	uint32_t digest_size = vb2_digest_size(hash_alg);
+	uint8_t workbuf[VB2_VERIFY_DATA_TREE_WORKBUF_BYTES]
+		__attribute__((aligned(VB2_WORKBUF_ALIGN)));
+	struct vb2_workbuf wb;
+	char desc[128];
+	int i;
+
+	vb2_workbuf_init(&wb, workbuf, sizeof(workbuf));
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		ref_tree_digest(test_data, sizes[i], CHUNK_SIZE, hash_alg,
+				expect);
+
+		snprintf(desc, sizeof(desc),
+			 "Tree digest alg %d size %u sequential",
+			 hash_alg, sizes[i]);
+		reset_mocks(0);
+		TEST_SUCC(vb2_tree_digest(test_data, sizes[i], CHUNK_SIZE,
+					  hash_alg, 1, digest, digest_size,
+					  &wb), desc);
+		TEST_EQ(memcmp(digest, expect, digest_size), 0,
+			"  digest matches");
+
+		snprintf(desc, sizeof(desc),
+			 "Tree digest alg %d size %u threaded",
+			 hash_alg, sizes[i]);
+		reset_mocks(1);
+		TEST_SUCC(vb2_tree_digest(test_data, sizes[i], CHUNK_SIZE,
+					  hash_alg, 1, digest, digest_size,
+					  &wb), desc);
+		TEST_EQ(memcmp(digest, expect, digest_size), 0,
+			"  digest matches");
+		TEST_EQ(mock_chunks_calls,
+			(sizes[i] + CHUNK_SIZE * VB2_TREE_HASH_BATCH - 1) /
+			(CHUNK_SIZE * VB2_TREE_HASH_BATCH),
+			"  one call per batch");
+	}
+
+	/* Tree digest differs from the flat digest */
+	vb2_digest_buffer(test_data, sizeof(test_data), hash_alg, expect,
+			  digest_size);
+	TEST_SUCC(vb2_tree_digest(test_data, sizeof(test_data), CHUNK_SIZE,
+				  hash_alg, 1, digest, digest_size, &wb),
+		  "Tree digest");
+	TEST_NEQ(memcmp(digest, expect, digest_size), 0,
+		 "  differs from flat digest");
+}
+
+static void tree_digest_error_tests(void)
+{
+	uint8_t digest[VB2_MAX_DIGEST_SIZE];
+	uint8_t workbuf[VB2_VERIFY_DATA_TREE_WORKBUF_BYTES]
+		__attribute__((aligned(VB2_WORKBUF_ALIGN)));
+	struct vb2_workbuf wb;
+
+	vb2_workbuf_init(&wb, workbuf, sizeof(workbuf));
+
+	reset_mocks(1);
+	TEST_SUCC(vb2_tree_digest(test_data, sizeof(test_data), CHUNK_SIZE,
+				  VB2_HASH_SHA256, 0, digest, sizeof(digest),
+				  &wb), "Tree digest hwcrypto not allowed");
+	TEST_EQ(mock_chunks_calls, 0, "  hook not called");
+
+	reset_mocks(1);
+	mock_chunks_retval = VB2_ERROR_MOCK;
+	TEST_EQ(vb2_tree_digest(test_data, sizeof(test_data), CHUNK_SIZE,
+				VB2_HASH_SHA256, 1, digest, sizeof(digest),
+				&wb),
+		VB2_ERROR_MOCK, "Tree digest hook error");
+
+	reset_mocks(0);
+	TEST_EQ(vb2_tree_digest(test_data, sizeof(test_data), 0,
+				VB2_HASH_SHA256, 1, digest, sizeof(digest),
+				&wb),
+		VB2_ERROR_VDATA_CHUNK_SIZE, "Tree digest chunk size 0");
+	TEST_EQ(vb2_tree_digest(test_data, sizeof(test_data), CHUNK_SIZE,
+				VB2_HASH_INVALID, 1, digest, sizeof(digest),
+				&wb),
+		VB2_ERROR_VDATA_DIGEST_SIZE, "Tree digest bad algorithm");
+
+	wb.size = VB2_TREE_DIGEST_WORKBUF_BYTES - 1;
+	TEST_EQ(vb2_tree_digest(test_data, sizeof(test_data), CHUNK_SIZE,
+				VB2_HASH_SHA512, 1, digest, sizeof(digest),
+				&wb),
+		VB2_ERROR_VDATA_WORKBUF_CHUNKS,
+		"Tree digest workbuf too small");
+
+	/* Chunks as large as the data size allows must not overflow */
+	vb2_workbuf_init(&wb, workbuf, sizeof(workbuf));
+	reset_mocks(0);
+	TEST_SUCC(vb2_tree_digest(test_data, sizeof(test_data), 0x80000000,
+				  VB2_HASH_SHA256, 1, digest, sizeof(digest),
+				  &wb), "Tree digest huge chunk size");
+}
+
+static void verify_tests(const char *keys_dir)
+{
+	char fname[1024];
+	struct vb2_private_key *prik;
+	struct vb2_packed_key *pubk;
+	struct vb2_public_key key;
+	struct vb2_signature *sig, *sig2;
+	uint8_t workbuf[VB2_VERIFY_DATA_TREE_WORKBUF_BYTES]
+		__attribute__((aligned(VB2_WORKBUF_ALIGN)));
+	struct vb2_workbuf wb;
+
+	vb2_workbuf_init(&wb, workbuf, sizeof(workbuf));
+
+	snprintf(fname, sizeof(fname), "%s/key_rsa2048.sha256.vbprivk",
+		 keys_dir);
+	prik = vb2_read_private_key(fname);
+	snprintf(fname, sizeof(fname), "%s/key_rsa2048.sha256.vbpubk",
+		 keys_dir);
+	pubk = vb2_read_packed_key(fname);
+	TEST_PTR_NEQ(prik, NULL, "Read private key");
+	TEST_PTR_NEQ(pubk, NULL, "Read public key");
+	if (!prik || !pubk)
+		return;
+	TEST_SUCC(vb2_unpack_key(&key, pubk), "Unpack public key");
+
+	sig = vb2_calculate_tree_signature(test_data, sizeof(test_data),
+					   CHUNK_SIZE, prik);
+	TEST_PTR_NEQ(sig, NULL, "Calculate tree signature");
+	TEST_EQ(sig->data_size, sizeof(test_data), "  data size");
+	sig2 = vb2_alloc_signature(sig->sig_size, sig->data_size);
+
+	vb2_copy_signature(sig2, sig);
+	reset_mocks(0);
+	TEST_SUCC(vb2_verify_data_tree(test_data, sizeof(test_data), sig2,
+				       &key, CHUNK_SIZE, &wb),
+		  "Verify tree signature");
+
+	vb2_copy_signature(sig2, sig);
+	reset_mocks(1);
+	key.allow_hwcrypto = 1;
+	TEST_SUCC(vb2_verify_data_tree(test_data, sizeof(test_data), sig2,
+				       &key, CHUNK_SIZE, &wb),
+		  "Verify tree signature threaded");
+	TEST_NEQ(mock_chunks_calls, 0, "  hook called");
+	key.allow_hwcrypto = 0;
+
+	vb2_copy_signature(sig2, sig);
+	TEST_NEQ(vb2_verify_data_tree(test_data, sizeof(test_data), sig2,
+				      &key, CHUNK_SIZE * 2, &wb),
+		 VB2_SUCCESS, "Verify tree signature wrong chunk size");
+
+	vb2_copy_signature(sig2, sig);
+	TEST_NEQ(vb2_verify_data(test_data, sizeof(test_data), sig2, &key,
+				 &wb),
+		 VB2_SUCCESS, "Verify tree signature as flat");
+
+	vb2_copy_signature(sig2, sig);
+	test_data[CHUNK_SIZE * 5 + 7] ^= 0x20;
+	TEST_NEQ(vb2_verify_data_tree(test_data, sizeof(test_data), sig2,
+				      &key, CHUNK_SIZE, &wb),
+		 VB2_SUCCESS, "Verify tree signature modified chunk");
+	test_data[CHUNK_SIZE * 5 + 7] ^= 0x20;
+
+	vb2_copy_signature(sig2, sig);
+	TEST_EQ(vb2_verify_data_tree(test_data, sizeof(test_data) - 1, sig2,
+				     &key, CHUNK_SIZE, &wb),
+		VB2_ERROR_VDATA_NOT_ENOUGH_DATA,
+		"Verify tree signature not enough data");
+
+	free(sig);
+	free(sig2);
+	free(pubk);
+	vb2_free_private_key(prik);
+}
+
+int main(int argc, char *argv[])
+{
+	int i;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <keys_dir>\n", argv[0]);
+		return -1;
+	}
+
+	for (i = 0; i < sizeof(test_data); i++)
+		test_data[i] = (uint8_t)(i * 7 + (i >> 8));
+
+	tree_digest_tests(VB2_HASH_SHA1);
+	tree_digest_tests(VB2_HASH_SHA256);
+	tree_digest_tests(VB2_HASH_SHA512);
+	tree_digest_error_tests();
+	verify_tests(argv[1]);
+
+	return gTestSuccess ? 0 : 255;
+}
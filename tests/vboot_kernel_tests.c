@@ -28,6 +28,10 @@ struct mock_part {
 #define MOCK_PART_COUNT 8
 static struct mock_part mock_parts[MOCK_PART_COUNT];
 static int mock_part_next;
+static int mock_parts_read;
+static int mock_prefer_ok;
+static int mock_prefer_index;
+static uint64_t mock_sectors_read;
 
 /* Mock data */
 static uint8_t kernel_buffer[80000];
@@ -38,6 +42,7 @@ static int preamble_verify_fail;
 static int verify_data_fail;
 static int unpack_key_fail;
 static int gpt_flag_external;
+static uint32_t mock_gpt_flags;
 
 static struct vb2_gbb_header gbb;
 static VbSelectAndLoadKernelParams lkp;
@@ -66,6 +71,7 @@ static void ResetMocks(void)
 	unpack_key_fail = 0;
 
 	gpt_flag_external = 0;
+	mock_gpt_flags = 0;
 
 	memset(&gbb, 0, sizeof(gbb));
 	gbb.major_version = VB2_GBB_MAJOR_VER;
@@ -99,6 +105,10 @@ static void ResetMocks(void)
 	mock_parts[0].start = 100;
 	mock_parts[0].size = 150;  /* 75 KB */
 	mock_part_next = 0;
+	mock_parts_read = 0;
+	mock_prefer_ok = 1;
+	mock_prefer_index = -1;
+	mock_sectors_read = 0;
 
 	memset(&mock_key, 0, sizeof(mock_key));
 
@@ -155,14 +165,24 @@ vb2_error_t vb2_gbb_read_recovery_key(struct vb2_context *c,
 vb2_error_t VbExDiskRead(VbExDiskHandle_t h, uint64_t lba_start,
 			 uint64_t lba_count, void *buffer)
 {
+	int i;
+
+	/* Count partitions by reads of their first sector */
+	for (i = 0; i < MOCK_PART_COUNT && mock_parts[i].size; i++) {
+		if (lba_start == mock_parts[i].start)
+			mock_parts_read++;
+	}
+
 	if ((int)lba_start == disk_read_to_fail)
 		return VB2_ERROR_MOCK;
 
+	mock_sectors_read += lba_count;
 	return VB2_SUCCESS;
 }
 
 int AllocAndReadGptData(VbExDiskHandle_t disk_handle, GptData *gptdata)
 {
+	mock_gpt_flags = gptdata->flags;
 	return GPT_SUCCESS;
 }
 
@@ -188,6 +208,21 @@ int GptNextKernelEntry(GptData *gpt, uint64_t *start_sector, uint64_t *size)
 	return GPT_SUCCESS;
 }
 
+int GptPreferKernelEntry(GptData *gpt, uint32_t index,
+			 uint64_t *start_sector, uint64_t *size)
+{
+	struct mock_part *p = mock_parts + index;
+
+	mock_prefer_index = index;
+	if (!mock_prefer_ok || index >= MOCK_PART_COUNT || !p->size)
+		return GPT_ERROR_NO_VALID_KERNEL;
+
+	gpt->current_kernel = index;
+	*start_sector = p->start;
+	*size = p->size;
+	return GPT_SUCCESS;
+}
+
 int GptUpdateKernelEntry(GptData *gpt, uint32_t update_type)
 {
 	return GPT_SUCCESS;
@@ -601,10 +636,158 @@ static void LoadKernelTest(void)
 	TestLoadKernel(0, "Can't read disk");
 }
 
+/**
+ * Kernel partition scan policies
+ */
+static void BootPolicyTest(void)
+{
+	uint64_t full_scan_sectors;
+
+	/* Default policy reads every vblock to roll forward */
+	ResetMocks();
+	kbh.data_key.key_version = 3;
+	mock_parts[1].start = 300;
+	mock_parts[1].size = 150;
+	TestLoadKernel(0, "Default policy");
+	TEST_EQ(lkp.partition_number, 1, "  part num");
+	TEST_EQ(mock_parts_read, 2, "  examined both");
+	TEST_EQ(sd->kernel_version, 0x30001, "  SD version");
+	full_scan_sectors = mock_sectors_read;
+
+	ResetMocks();
+	kbh.data_key.key_version = 3;
+	mock_parts[1].start = 300;
+	mock_parts[1].size = 150;
+	lkp.policy.flags = VB_BOOT_POLICY_STOP_AT_FIRST_VERIFIED;
+	TestLoadKernel(0, "Stop at first verified");
+	TEST_EQ(lkp.partition_number, 1, "  part num");
+	TEST_EQ(mock_parts_read, 1, "  examined one");
+	TEST_TRUE(mock_sectors_read < full_scan_sectors, "  read less");
+	TEST_EQ(sd->kernel_version, 0x20001, "  no roll forward");
+
+	/* Limit on partitions examined */
+	ResetMocks();
+	mock_parts[1].start = 300;
+	mock_parts[1].size = 150;
+	disk_read_to_fail = 100;
+	TestLoadKernel(0, "No partition limit");
+	TEST_EQ(lkp.partition_number, 2, "  part num");
+	TEST_EQ(mock_parts_read, 2, "  examined both");
+
+	ResetMocks();
+	mock_parts[1].start = 300;
+	mock_parts[1].size = 150;
+	disk_read_to_fail = 100;
+	lkp.policy.max_partitions = 1;
+	TestLoadKernel(VB2_ERROR_LK_INVALID_KERNEL_FOUND,
+		       "Partition limit reached");
+	TEST_EQ(mock_parts_read, 1, "  examined one");
+
+	ResetMocks();
+	kbh.data_key.key_version = 3;
+	mock_parts[1].start = 300;
+	mock_parts[1].size = 150;
+	lkp.policy.max_partitions = 1;
+	TestLoadKernel(0, "Partition limit with good kernel");
+	TEST_EQ(lkp.partition_number, 1, "  part num");
+	TEST_EQ(mock_parts_read, 1, "  examined one");
+	TEST_TRUE(mock_sectors_read < full_scan_sectors, "  read less");
+	TEST_EQ(sd->kernel_version, 0x20001, "  no roll forward");
+
+	/* Last good partition hint */
+	ResetMocks();
+	ctx->flags |= VB2_CONTEXT_NVDATA_V2;
+	vb2_nv_init(ctx);
+	vb2_nv_set(ctx, VB2_NV_KERNEL_LAST_GOOD_PARTITION, 2);
+	disk_info.flags = VB_DISK_FLAG_FIXED;
+	mock_parts[1].start = 300;
+	mock_parts[1].size = 150;
+	lkp.policy.flags = VB_BOOT_POLICY_PREFER_LAST_GOOD;
+	TestLoadKernel(0, "Prefer last good");
+	TEST_EQ(mock_prefer_index, 1, "  tried hint");
+	TEST_EQ(lkp.partition_number, 2, "  part num");
+	TEST_EQ(mock_parts_read, 1, "  examined one");
+	TEST_EQ(vb2_nv_get(ctx, VB2_NV_KERNEL_LAST_GOOD_PARTITION), 2,
+		"  hint kept");
+
+	ResetMocks();
+	ctx->flags |= VB2_CONTEXT_NVDATA_V2;
+	vb2_nv_init(ctx);
+	vb2_nv_set(ctx, VB2_NV_KERNEL_LAST_GOOD_PARTITION, 2);
+	disk_info.flags = VB_DISK_FLAG_FIXED;
+	mock_parts[1].start = 300;
+	mock_parts[1].size = 150;
+	mock_prefer_ok = 0;
+	lkp.policy.flags = VB_BOOT_POLICY_PREFER_LAST_GOOD;
+	TestLoadKernel(0, "Last good not acceptable");
+	TEST_EQ(lkp.partition_number, 1, "  part num");
+	TEST_EQ(vb2_nv_get(ctx, VB2_NV_KERNEL_LAST_GOOD_PARTITION), 1,
+		"  hint updated");
+
+	ResetMocks();
+	ctx->flags |= VB2_CONTEXT_NVDATA_V2;
+	vb2_nv_init(ctx);
+	vb2_nv_set(ctx, VB2_NV_KERNEL_LAST_GOOD_PARTITION, 2);
+	disk_info.flags = VB_DISK_FLAG_FIXED;
+	mock_parts[1].start = 300;
+	mock_parts[1].size = 150;
+	disk_read_to_fail = 300;
+	lkp.policy.flags = VB_BOOT_POLICY_PREFER_LAST_GOOD;
+	TestLoadKernel(0, "Last good fails");
+	TEST_EQ(lkp.partition_number, 1, "  part num");
+	TEST_EQ(mock_parts_read, 2, "  examined both");
+
+	ResetMocks();
+	ctx->flags |= VB2_CONTEXT_NVDATA_V2;
+	vb2_nv_init(ctx);
+	vb2_nv_set(ctx, VB2_NV_KERNEL_LAST_GOOD_PARTITION, 2);
+	disk_info.flags = VB_DISK_FLAG_FIXED;
+	mock_parts[1].start = 300;
+	mock_parts[1].size = 150;
+	keyblock_verify_fail = 1;
+	lkp.policy.flags = VB_BOOT_POLICY_PREFER_LAST_GOOD;
+	TestLoadKernel(VB2_ERROR_LK_INVALID_KERNEL_FOUND,
+		       "Last good not examined twice");
+	TEST_EQ(mock_parts_read, 2, "  examined both once");
+	TEST_EQ(mock_part_next, 2, "  scanned past hint");
+
+	ResetMocks();
+	ctx->flags |= VB2_CONTEXT_NVDATA_V2;
+	vb2_nv_init(ctx);
+	vb2_nv_set(ctx, VB2_NV_KERNEL_LAST_GOOD_PARTITION, 2);
+	disk_info.flags = VB_DISK_FLAG_REMOVABLE;
+	mock_parts[1].start = 300;
+	mock_parts[1].size = 150;
+	lkp.policy.flags = VB_BOOT_POLICY_PREFER_LAST_GOOD;
+	TestLoadKernel(0, "Last good ignored on removable disk");
+	TEST_EQ(mock_prefer_index, -1, "  hint not tried");
+	TEST_EQ(lkp.partition_number, 1, "  part num");
+	TEST_EQ(vb2_nv_get(ctx, VB2_NV_KERNEL_LAST_GOOD_PARTITION), 2,
+		"  hint not updated");
+
+	ResetMocks();
+	ctx->flags |= VB2_CONTEXT_NVDATA_V2;
+	vb2_nv_init(ctx);
+	disk_info.flags = VB_DISK_FLAG_FIXED;
+	TestLoadKernel(0, "Default policy doesn't record last good");
+	TEST_EQ(mock_prefer_index, -1, "  hint not tried");
+	TEST_EQ(vb2_nv_get(ctx, VB2_NV_KERNEL_LAST_GOOD_PARTITION), 0,
+		"  hint not set");
+	TEST_EQ(mock_gpt_flags & GPT_FLAG_LAZY_SECONDARY, 0,
+		"  secondary GPT read");
+
+	ResetMocks();
+	lkp.policy.flags = VB_BOOT_POLICY_LAZY_SECONDARY_GPT;
+	TestLoadKernel(0, "Lazy secondary GPT");
+	TEST_EQ(mock_gpt_flags, GPT_FLAG_LAZY_SECONDARY, "  GPT flags");
+	TEST_EQ(lkp.partition_number, 1, "  part num");
+}
+
 int main(void)
 {
 	InvalidParamsTest();
 	LoadKernelTest();
+	BootPolicyTest();
 
 	return gTestSuccess ? 0 : 255;
 }
@@ -269,13 +269,53 @@ static uint32_t HandlerWrite(void) {
   return TlclWrite(index, value, size);
 }
 
+/* PCRs read by "tpmc pcrread all" */
+#define PCR_COUNT 24
+
+static uint32_t PCRReadAll(void) {
+  uint16_t bank = TPM_MODE_SELECT(TPM_ALG_SHA1, TPM_ALG_SHA256);
+  uint8_t values[PCR_COUNT * TPM_PCR_DIGEST];
+  uint32_t digest_size;
+  uint32_t result;
+  int i, j;
+  if (nargs == 4) {
+    if (!strcmp(args[3], "sha1")) {
+      bank = TPM_ALG_SHA1;
+#ifdef TPM2_MODE
+    } else if (!strcmp(args[3], "sha256")) {
+      bank = TPM_ALG_SHA256;
+#endif
+    } else {
+      fprintf(stderr, "<bank> must be one of: sha1"
+              TPM_MODE_SELECT("", " sha256") "\n");
+      exit(OTHER_ERROR);
+    }
+  }
+  result = TlclPCRReadMultiple((1 << PCR_COUNT) - 1, bank, values,
+                               sizeof(values), &digest_size);
+  if (result == 0) {
+    for (i = 0; i < PCR_COUNT; i++) {
+      printf("%2d: ", i);
+      for (j = 0; j < digest_size; j++) {
+        printf("%02x", values[i * digest_size + j]);
+      }
+      printf("\n");
+    }
+  }
+  return result;
+}
+
 static uint32_t HandlerPCRRead(void) {
   uint32_t index;
   uint8_t value[TPM_PCR_DIGEST];
   uint32_t result;
   int i;
+  if ((nargs == 3 || nargs == 4) && !strcmp(args[2], "all")) {
+    return PCRReadAll();
+  }
   if (nargs != 3) {
-    fprintf(stderr, "usage: tpmc pcrread <index>\n");
+    fprintf(stderr, "usage: tpmc pcrread <index>\n"
+            "   or: tpmc pcrread all [<bank>]\n");
     exit(OTHER_ERROR);
   }
   if (HexStringToUint32(args[2], &index) != 0) {
@@ -631,7 +671,8 @@ command_record command_table[] = {
     HandlerWrite },
   { "read", "read", "read from a space (read <index> <size>)",
     HandlerRead },
-  { "pcrread", "pcr", "read from a PCR (pcrread <index>)",
+  { "pcrread", "pcr",
+    "read from a PCR (pcrread <index>), or all of them (pcrread all [<bank>])",
     HandlerPCRRead },
   { "pcrextend", "extend", "extend a PCR (extend <index> <extend_hash>)",
     HandlerPCRExtend },